@@ -82,6 +82,13 @@ function CSVReader( array $t_args, array $output ) {
     $maxLines = get_default($t_args, 'n', -1);
     grokit_assert( is_int($maxLines), 'Got ' . gettype($maxLines) . ' instead of int for template argument "n"');
 
+    // Large files can be split in ranges read in parallel unless the lines
+    // are counted.
+    $splittable = $maxLines < 0 && !$lineNumber;
+
+    grokit_assert( !$simple || count($my_output) > 0,
+        'Simple CSVReader needs at least one output' );
+
     $nullArg = get_first_key_default($t_args, ['nullable'], false);
 
     $nullable = [];
@@ -151,12 +158,20 @@ function CSVReader( array $t_args, array $output ) {
 class <?=$className?> {
     std::istream& my_stream;
     std::string fileName;
+<?  if( $simple ) { ?>
+
+    // The range of the file we read, if the stream is one. The lines are
+    // then parsed in place.
+    GIFileRange * my_range;
+<?  } ?>
 
     // Template parameters
     static constexpr size_t MAX_LINES = <?=$maxLines?>;
     static constexpr size_t HEADER_LINES = <?=$headerLines?>;
     static constexpr char DELIMITER = '<?=$separator?>';
-<?  if( !$simple ) { ?>
+<?  if( $simple ) { ?>
+    static constexpr size_t N_FIELDS = <?=count($my_output)?>;
+<?  } else { ?>
     static constexpr char QUOTE_CHAR = '<?=$quotechar?>';
     static constexpr char ESCAPE_CHAR = '<?=$escapeChar?>';
 
@@ -179,18 +194,38 @@ public:
     <?=$className?> ( GIStreamProxy& _stream ) :
         my_stream(_stream.get_stream())
         , fileName(_stream.get_file_name())
-<?  if( !$simple ) { ?>
+<?  if( $simple ) { ?>
+        , my_range(_stream.get_range())
+<?  } else { ?>
         , my_separator(ESCAPE_CHAR, DELIMITER, QUOTE_CHAR)
         , my_tokenizer(std::string(""))
 <?  } ?>
         , count(0)
     {
 <?  if( $headerLines > 0 ) { ?>
-        for( size_t i = 0; i < HEADER_LINES; ++i ) {
-            FATALIF( !getline( my_stream, line ), "CSV Reader reached end of file before finishing header.\n" );
+        // The header is only in the first range of a split file
+        if( _stream.at_file_start() ) {
+            for( size_t i = 0; i < HEADER_LINES; ++i ) {
+                FATALIF( !getline( my_stream, line ), "CSV Reader reached end of file before finishing header.\n" );
+            }
         }
 <?  } // If headerLines > 0 ?>
     }
+<?  if( $simple ) { ?>
+
+    // Gives the next line, terminated by '\0'
+    bool NextRecord( char *& record, size_t & length ) {
+        if( my_range != NULL )
+            return my_range->NextRecord( record, length );
+
+        if( !getline( my_stream, line ) )
+            return false;
+
+        record = &line[0];
+        length = line.size();
+        return true;
+    }
+<?  } // if simple reader ?>
 
 // >
 
@@ -204,13 +239,13 @@ public:
             return false;
         }
 
+<?  if( !$simple ) { ?>
         if( getline( my_stream, line ) ) {
-<?  if( $trimCR ) { ?>
+<?      if( $trimCR ) { ?>
             if( line.back() == '\r' ) {
                 line.pop_back();
             }
-<? } // if trimCR ?>
-<?  if( !$simple ) { ?>
+<?      } // if trimCR ?>
 <?      if( $debug >= 1 ) { ?>
             try {
 <?      } // if debug >= 1 ?>
@@ -240,27 +275,28 @@ public:
 <?  } // if complex reader
     else {
 ?>
-            for( char & c : line ) {
-                if( c == DELIMITER )
-                    c = '\0';
+        char * record;
+        size_t length;
+        if( NextRecord( record, length ) ) {
+<?      if( $trimCR ) { ?>
+            if( length > 0 && record[length - 1] == '\r' ) {
+                record[--length] = '\0';
             }
+<?      } // if trimCR ?>
+            char * fields[N_FIELDS];
+            size_t nFields = SplitFields( record, record + length, DELIMITER, fields, N_FIELDS );
+            FATALIF( nFields < N_FIELDS, "CSVReader for file %s got %zu fields instead of %zu on line: %s",
+                fileName.c_str(), nFields, N_FIELDS, record );
 
-            const char * ptr = line.c_str();
 <?
-        $first = true;
+        $i = 0;
         foreach( $my_output as $name => $type ) {
-            if( $first ) {
-                $first = false;
-            }
-            else {
+            $field = 'fields[' . $i++ . ']';
 ?>
-            while( *(ptr++) != '\0' )
-                ; // Advance past next delimiter
-<?          } // not first output ?>
 <?          if( $nullable[$name] ) { ?>
-            <?=\grokit\fromStringNullable($name, $type, 'ptr', true, $nullStr[$name]); ?>
+            <?=\grokit\fromStringNullable($name, $type, $field, true, $nullStr[$name]); ?>
 <?          } else { // not nullable ?>
-            <?=\grokit\fromStringDict($name, $type, 'ptr')?>;
+            <?=\grokit\fromStringDict($name, $type, $field)?>;
 <?          } // if nullable ?>
 <?      } // foreach output ?>
 <?  } // if simple reader ?>
@@ -280,16 +316,17 @@ public:
     if( !$simple )
         $sys_headers[] = 'boost/tokenizer.hpp';
 
+    $user_headers = [ 'GIStreamInfo.h', 'Dictionary.h', 'DictionaryManager.h' ];
+    if( $simple )
+        $user_headers[] = 'CharScan.h';
+
     return [
         'name' => $className,
         'kind' => 'GI',
         'output' => $output,
+        'properties' => $splittable ? [ 'splittable' ] : [],
         'system_headers' => $sys_headers,
-        'user_headers' => [
-            'GIStreamInfo.h',
-            'Dictionary.h',
-            'DictionaryManager.h'
-        ]
+        'user_headers' => $user_headers
     ];
 }
 
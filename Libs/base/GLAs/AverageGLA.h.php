@@ -62,6 +62,17 @@ public:
 <?  } // foreach input ?>
     }
 
+    void AddItems(size_t n<?=array_template(', const {val} * {key}', '', $input)?>) {
+        count += n;
+
+<?  foreach($input as $name => $type) { ?>
+        <?=$internalTypes[$name]?> acc_<?=$name?> = sum_<?=$name?>;
+        for( size_t i = 0; i < n; i++ )
+            acc_<?=$name?> += <?=$name?>[i];
+        sum_<?=$name?> = acc_<?=$name?>;
+<?  } // foreach input ?>
+    }
+
     void AddState(<?=$className?>& o){
         count += o.count;
 <?  foreach($input as $name => $type) { ?>
@@ -100,6 +111,7 @@ public:
             'input'          => $input,
             'output'         => $output,
             'result_type'    => 'single',
+            'batch'          => true,
         );
 
 }
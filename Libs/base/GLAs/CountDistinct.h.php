@@ -21,7 +21,7 @@ function CountDistinct( array $t_args, array $input, array $output ) {
 
     $useMCT = get_default($t_args, 'use.mct', true);
     $keepHashes = get_default($t_args, 'mct.keep.hashes', false);
-    $initSize = get_default($t_args, 'init.size', 65536);
+    $initSize = get_default($t_args, 'init.size', estimated_distinct(array_keys($input), 65536));
     $nullCheck = get_default($t_args, 'null.check', false);
 
     grokit_assert(is_bool($useMCT), 'CountDistinct use.mct argument must be boolean');
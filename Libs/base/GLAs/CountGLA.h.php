@@ -24,6 +24,7 @@ class <?=$name?> {
 public:
     <?=$name?>() : count(0) {}
     void AddItem( <?=const_typed_ref_args($input)?> ) { count++; }
+    void AddItems( size_t n ) { count += n; }
     void AddState( <?=$name?> & o ) { count += o.count; }
     void GetResult(<?=$oType?> & _count ) const {
 <?  if( $asJson) { ?>
@@ -42,6 +43,7 @@ public:
         'input'       => $input,
         'output'      => $output,
         'result_type' => 'single',
+        'batch'       => 'count',
         ];
 }
 ?>
@@ -16,7 +16,7 @@ function Distinct(array $t_args, array $input, array $output) {
     }
 
     $useMCT = get_default($t_args, 'use.mct', true);
-    $initSize = get_default($t_args, 'init.size', 65536);
+    $initSize = get_default($t_args, 'init.size', estimated_distinct(array_keys($input), 65536));
     $keepHashes = get_default($t_args, 'mct.keep.hashes', false);
     $fragmentSize = get_default($t_args, 'fragment.size', 100000);
     $nullCheck = get_default($t_args, 'null.check', false);
@@ -160,6 +160,23 @@ struct <?=$className?> {
  *      [R] 'group':        A list of string corresponding to the names of input expressions
  *                          that are to be used as grouping attributes.
  *      [R] 'aggregate':    A GLA to be used as the aggregate.
+ *      [O] 'partitions':   Number of hash partitions of the groups (default 1,
+ *                          16 with a memory limit). With more than one
+ *                          partition the states are merged in parallel, one
+ *                          partition per job, and GetMap() is not available.
+ *      [O] 'memory.limit': Memory budget in bytes for the groups of a state
+ *                          (default 0, no limit). Once the groups take the
+ *                          whole budget, a new group goes to disk along with
+ *                          the later new groups of its partition, and the
+ *                          spilled partitions are aggregated when finalized,
+ *                          each one on its own. The groups already in memory
+ *                          stay there, so partitions without new groups never
+ *                          spill. Needs more than one partition, and a
+ *                          partition has to fit in memory.
+ *      [O] 'state.size':   Estimated bytes of memory each group state owns
+ *                          outside of the map, counted against the budget
+ *                          along with what the keys own (default 0).
+ *      [O] 'spill.dir':    Directory for the spill files (default /tmp).
  *
  *  Any expressions used as grouping attributes must be named.
  */
@@ -200,11 +217,25 @@ function GroupBy( array $t_args, array $inputs, array $outputs, array $states )
 
     $debug = get_default( $t_args, 'debug', 0);
 
-    $init_size = get_default( $t_args, 'init.size', 1024);
+    $init_size = get_default( $t_args, 'init.size', estimated_distinct($gbyAttNames, 1024));
     $use_mct = get_default( $t_args, 'use.mct', true);
     $keepHashes = get_default($t_args, 'mct.keep.hashes', false);
     grokit_assert(is_bool($keepHashes), 'GroupBy mct.keep.hashes argument must be boolean');
 
+    $memLimit = get_default($t_args, 'memory.limit', 0);
+    $stateSize = get_default($t_args, 'state.size', 0);
+    $spillDir = get_default($t_args, 'spill.dir', '/tmp');
+    grokit_assert(is_int($memLimit) && $memLimit >= 0, 'GroupBy memory.limit argument must be a non-negative integer');
+    grokit_assert(is_int($stateSize) && $stateSize >= 0, 'GroupBy state.size argument must be a non-negative integer');
+    grokit_assert(is_string($spillDir), 'GroupBy spill.dir argument must be a string');
+    $spillDir = '"' . addcslashes($spillDir, "\"'\n\r\t\\\0") . '"';
+    $spill = $memLimit > 0;
+
+    // partitioning is only done on request, the groups of a single partition
+    // can be accessed directly through GetMap()
+    $partitions = get_default($t_args, 'partitions', $spill ? 16 : 1);
+    grokit_assert(is_int($partitions) && $partitions > 0, 'GroupBy partitions argument must be a positive integer');
+
     // determine the result type
     $use_fragments = get_default( $t_args, 'use.fragments', true);
     $resType = $use_fragments ? [ 'fragment', 'multi' ] : [ 'multi' ];
@@ -285,8 +316,19 @@ function GroupBy( array $t_args, array $inputs, array $outputs, array $states )
 
     $iterable = $innerGLA->iterable();
 
+    if( $spill ) {
+        grokit_assert($partitions > 1, 'GroupBy needs more than one partition to spill to disk');
+        grokit_assert(!$iterable, 'GroupBy cannot spill to disk the groups of an iterable GLA');
+    }
+
     // need to keep track of system includes needed
     $extraHeaders = array();
+    $extraUserHeaders = array();
+
+    if( $spill ) {
+        $extraHeaders = array_merge($extraHeaders, ['cstdio', 'algorithm']);
+        $extraUserHeaders[] = 'SpillFile.h';
+    }
 
     $allocatorText = "std::allocator<std::pair<const Key, {$innerGLA}> >";
     if($use_mct) {
@@ -319,30 +361,104 @@ public:
     typedef <?=$map?> MapType;
     static const size_t INIT_SIZE = <?=$init_size?>;
 
+    // The groups are split by hash into independent maps so that the states
+    // can be merged one partition at a time by different threads.
+    static const size_t NUM_PARTITIONS = <?=$partitions?>;
+
+    typedef std::pair<MapType::iterator, MapType::iterator> Range;
+
+<?  if( $spill ) { ?>
+    // Groups take about this much memory (the maps have some overhead), plus
+    // what their keys own
+    static const size_t MEMORY_LIMIT = <?=$memLimit?>;
+    static const size_t GROUP_SIZE = sizeof(MapType::value_type) + 2 * sizeof(void *) + <?=$stateSize?>;
+
+    // used by the iterator when there is no spilled partition loaded
+    static const size_t NO_PARTITION = NUM_PARTITIONS;
+
+    // The tuples of a partition that went to disk. A partition spills when
+    // one of its new groups does not fit: from then on, the tuples of the
+    // groups not already in memory are written to the spill file instead.
+    // The files of the states merged in are kept as well (see SpillFile.h).
+    struct Spill {
+        FILE * out; // the file we write to, NULL if we do not spill
+        std::vector<FILE *> files; // all the files with tuples of the partition
+        bool spilled; // did the partition ever spill?
+
+        Spill() : out(NULL), files(), spilled(false) { }
+
+        void Clear() {
+            for( FILE * file : files ) {
+                fclose(file);
+            }
+            files.clear();
+            out = NULL;
+        }
+    };
+
+<?  } // if spilling ?>
 public:
     class Iterator {
-        MapType::iterator it; // current value
-        MapType::iterator end; // last value in the fragment
+        std::vector<Range> ranges; // the pieces of the maps to go over
+        size_t next; // next range to start
+        bool valid; // it points to a value
 
-    public:
-        Iterator() { }
+        MapType::iterator it; // current value
+        MapType::iterator end; // last value in the current range
+
+<?  if( $spill ) { ?>
+        <?=$className?> * owner; // loads the spilled partitions
+        std::vector<size_t> toLoad; // spilled partitions to go over after the ranges
+        size_t nextLoad; // next spilled partition to load
+        size_t loaded; // spilled partition we are going over
+
+<?  } // if spilling ?>
+        // move to the next non-empty range, if any
+        void NextRange() {
+            valid = false;
+<?  if( $spill ) { ?>
+            while( !valid ) {
+                // done with the spilled partition, free it
+                if( loaded != NO_PARTITION ) {
+                    owner->ReleasePartition(loaded);
+                    loaded = NO_PARTITION;
+                }
 
-        Iterator(MapType::iterator _it, MapType::iterator _end):
-            it(_it), end(_end)
-        {
-            if( it != end ) {
+                if( next < ranges.size() ) {
+                    it = ranges[next].first;
+                    end = ranges[next].second;
+                    ++next;
+                } else if( nextLoad < toLoad.size() ) {
+                    loaded = toLoad[nextLoad++];
+                    Range range = owner->LoadPartition(loaded);
+                    it = range.first;
+                    end = range.second;
+                } else {
+                    break;
+                }
+                valid = it != end;
+            }
+<?  } else { ?>
+            while( !valid && next < ranges.size() ) {
+                it = ranges[next].first;
+                end = ranges[next].second;
+                ++next;
+                valid = it != end;
+            }
+<?  } // if not spilling ?>
 
+            if( valid ) {
 <?
         switch( $innerRes ) {
         case 'multi':
 ?>
-            it->second.Finalize();
+                it->second.Finalize();
 <?
             break;
         case 'state':
             if( $innerGLA->finalize_as_state() ) {
 ?>
-            it->second.FinalizeState();
+                it->second.FinalizeState();
 <?
             } // if we need to finalize as a state
             break;
@@ -351,9 +467,43 @@ public:
             }
         }
 
+        void Advance() {
+            ++it;
+            if( it == end ) {
+                NextRange();
+            }
+<?  if( $innerRes == 'multi' ) { ?>
+            else {
+                it->second.Finalize();
+            }
+<?  } // if inner GLA is multi ?>
+        }
+
+    public:
+<?  if( $spill ) { ?>
+        Iterator() : ranges(), next(0), valid(false), owner(NULL), toLoad(),
+            nextLoad(0), loaded(NO_PARTITION) { }
+
+        Iterator(const std::vector<Range> & _ranges, <?=$className?> * _owner,
+                const std::vector<size_t> & _toLoad):
+            ranges(_ranges), next(0), valid(false), owner(_owner), toLoad(_toLoad),
+            nextLoad(0), loaded(NO_PARTITION)
+        {
+            NextRange();
+        }
+<?  } else { ?>
+        Iterator() : ranges(), next(0), valid(false) { }
+
+        Iterator(const std::vector<Range> & _ranges):
+            ranges(_ranges), next(0), valid(false)
+        {
+            NextRange();
+        }
+<?  } // if not spilling ?>
+
         bool GetNextResult( <?=typed_ref_args($outputs)?> ) {
             bool gotResult = false;
-            while( it != end && !gotResult ) {
+            while( valid && !gotResult ) {
                 <?=$innerGLA?> & gla = it->second;
 <?  foreach( $gbyAttMap as $in => $out ) { ?>
                 <?=$out?> = it->first.<?=$in?>;
@@ -363,16 +513,13 @@ public:
             case 'multi': ?>
                 gotResult = gla.GetNextResult( <?=args($innerOutputs)?>);
                 if( !gotResult ) {
-                    ++it;
-                    if( it != end ) {
-                        it->second.Finalize();
-                    }
+                    Advance();
                 }
 <?              break;
             case 'single': ?>
                 gotResult = true;
                 gla.GetResult(<?=args($innerOutputs)?>);
-                ++it;
+                Advance();
 <?              break;
             case 'state':
                 reset($innerOutputs);
@@ -383,7 +530,7 @@ public:
 ?>
                 gotResult = true;
                 <?=$oName?> = <?=$oType?>( &gla );
-                ++it;
+                Advance();
 <?      } // switch inner result type ?>
             }
 
@@ -400,11 +547,156 @@ private:
 
     size_t count;
 
-    MapType groupByMap;
+    std::vector<MapType> groupByMaps; // one map per partition
 
-    std::vector<MapType::iterator> theIterators;  // the iterators, only 2 elements if multi, many if fragment
+    std::vector<std::vector<Range> > theFragments;  // the ranges of each fragment
     Iterator multiIterator;
 
+<?  if( $spill ) { ?>
+    size_t inMemory; // estimated bytes taken by the groups in the maps
+    size_t numGroups; // groups counted in inMemory
+    std::vector<Spill> spills; // one per partition
+    std::vector<std::vector<size_t> > theLoads; // the spilled partitions of each fragment
+    std::vector<char> spillBuffer; // serialization buffer
+
+    // memory taken by a new group: the entry in the map and what the key owns
+    static size_t GroupBytes(<?=array_template('const {val} & {key}', ', ', $gbyAtts)?>) {
+        size_t bytes = GROUP_SIZE;
+<?      foreach( $gbyAtts as $name => $type ) {
+            if( !$type->is('_primative_') ) {
+?>
+        bytes += SerializedSize(<?=$name?>);
+<?          } // if not native
+        } // foreach group attribute ?>
+        return bytes;
+    }
+
+    size_t AverageGroupBytes() const {
+        return numGroups > 0 ? inMemory / numGroups : GROUP_SIZE;
+    }
+
+    // After a merge, the groups in memory are assumed to take the larger of
+    // the average sizes of the two states
+    void MergeMemory(const <?=$className?> & other) {
+        size_t bytes = std::max(AverageGroupBytes(), other.AverageGroupBytes());
+        numGroups = size();
+        inMemory = numGroups * bytes;
+    }
+
+    // Called when a new group of the partition does not fit. Spilling other
+    // partitions would not make room for it since the groups already in
+    // memory cannot be written out, so this partition starts writing its new
+    // groups to disk
+    void SpillPartition(Spill & spill) {
+        spill.out = NewSpillFile(<?=$spillDir?>, "grokit_groupby");
+        spill.files.push_back(spill.out);
+        spill.spilled = true;
+    }
+
+    // adds a tuple read back from a spill file to the map
+    void LoadItem(MapType & groupByMap, <?=array_template('const {val} & {key}', ', ', $inputs)?>) {
+        Key key(<?=array_template('{key}', ', ', $gbyAtts)?>);
+
+        MapType::iterator it = groupByMap.find(key);
+        if (it == groupByMap.end()) { // group does not exist
+<?      if( $innerGLA->has_state() ) { ?>
+            const InnerState & innerState = constState.getConstState(key);
+<?      } // if gla has state ?>
+            InnerGLA gla<?=$constructorString?>;
+            auto ret = groupByMap.insert(MapType::value_type(key, gla));
+            it = ret.first; // reposition
+        }
+        it->second.AddItem(<?=array_template('{key}', ', ', $glaInputAtts)?>);
+    }
+
+    // moves the spill files of other into ours
+    static void MergeSpills(Spill & into, Spill & from) {
+        into.files.insert(into.files.end(), from.files.begin(), from.files.end());
+        into.spilled = into.spilled || from.spilled;
+        from.files.clear();
+        from.out = NULL;
+    }
+
+    // the groups of the partitions that did not spill
+    std::vector<Range> InMemoryRanges() {
+        std::vector<Range> ranges;
+        for( size_t p = 0; p < NUM_PARTITIONS; p++ ) {
+            if( spills[p].files.empty() ) {
+                ranges.push_back( Range(groupByMaps[p].begin(), groupByMaps[p].end()) );
+            }
+        }
+        return ranges;
+    }
+
+    std::vector<size_t> SpilledPartitions() {
+        std::vector<size_t> parts;
+        for( size_t p = 0; p < NUM_PARTITIONS; p++ ) {
+            if( !spills[p].files.empty() ) {
+                parts.push_back(p);
+            }
+        }
+        return parts;
+    }
+
+    // Aggregates the tuples spilled by partition p into the groups already
+    // in memory. Different partitions can be loaded at the same time.
+    Range LoadPartition(size_t p) {
+        MapType & groupByMap = groupByMaps[p];
+        Spill & spill = spills[p];
+        std::vector<char> record;
+
+        for( FILE * file : spill.files ) {
+            RewindSpillFile(file);
+
+            while( ReadSpillRecord(file, record) ) {
+<?      foreach( $inputs as $name => $type ) { ?>
+                <?=$type?> <?=$name?>;
+<?      } // foreach input ?>
+                DeserializeValues(record.data(), <?=args($inputs)?>);
+
+                LoadItem(groupByMap, <?=args($inputs)?>);
+            }
+        }
+        spill.Clear();
+
+        return Range(groupByMap.begin(), groupByMap.end());
+    }
+
+    // Frees the groups of a spilled partition once they were produced
+    void ReleasePartition(size_t p) {
+        MapType empty;
+        groupByMaps[p].swap(empty);
+    }
+
+<?  } // if spilling ?>
+
+    static size_t PartitionOf(const Key & key) {
+        if( NUM_PARTITIONS == 1 )
+            return 0;
+
+        // the low bits are used by the maps, use the high ones
+        uint64_t hash = key.hash_value();
+        return (hash >> 32) % NUM_PARTITIONS;
+    }
+
+    // merge the groups of from into into
+    static void MergeMaps(MapType & into, MapType & from) {
+        // scan other hash and insert or update content in this one
+        for (MapType::iterator it = from.begin(); it != from.end(); ++it) {
+            const Key& okey = it->first;
+            <?=$innerGLA?>& ogla = it->second;
+
+            MapType::iterator itt = into.find(okey);
+            if (itt != into.end()) { // found the group
+                <?=$innerGLA?>& gla = itt->second;
+                gla.AddState(ogla);
+            } else {
+                // add the other group to this hash
+                into.insert(MapType::value_type(okey, ogla));
+            }
+        }
+    }
+
 public:
 
     <?=$className?>(<? if($configurable) {?>const Json::Value & _jsonInit, <? } ?>const ConstantState & _constState ) :
@@ -413,17 +705,48 @@ public:
         , jsonInit(_jsonInit)
 <?  } // if configurable ?>
         , count(0)
-        , groupByMap( INIT_SIZE )
-        , theIterators()
+        , groupByMaps()
+        , theFragments()
         , multiIterator()
-    { }
+<?  if( $spill ) { ?>
+        , inMemory(0)
+        , numGroups(0)
+        , spills(NUM_PARTITIONS)
+        , theLoads()
+        , spillBuffer()
+<?  } // if spilling ?>
+    {
+        groupByMaps.reserve(NUM_PARTITIONS);
+        for( size_t i = 0; i < NUM_PARTITIONS; i++ ) {
+            groupByMaps.emplace_back( INIT_SIZE / NUM_PARTITIONS + 1 );
+        }
+    }
 
+<?  if( $spill ) { ?>
+    ~<?=$className?>() {
+        for( Spill & spill : spills ) {
+            spill.Clear();
+        }
+    }
+<?  } else { ?>
     ~<?=$className?>() {}
+<?  } // if not spilling ?>
 
     void Reset(void) {
         count = 0;
-        groupByMap.clear();
-        theIterators.clear();
+        for( MapType & groupByMap : groupByMaps ) {
+            groupByMap.clear();
+        }
+        theFragments.clear();
+<?  if( $spill ) { ?>
+        inMemory = 0;
+        numGroups = 0;
+        for( Spill & spill : spills ) {
+            spill.Clear();
+            spill.spilled = false;
+        }
+        theLoads.clear();
+<?  } // if spilling ?>
     }
 
     void AddItem(<?=array_template('const {val} & {key}', ', ', $inputs)?>) {
@@ -431,9 +754,28 @@ public:
         // check if _key is already in the map; if yes, add _value; else, add a new
         // entry (_key, _value)
         Key key(<?=array_template('{key}', ', ', $gbyAtts)?>);
+        MapType & groupByMap = groupByMaps[PartitionOf(key)];
 
         MapType::iterator it = groupByMap.find(key);
         if (it == groupByMap.end()) { // group does not exist
+<?  if( $spill ) { ?>
+            Spill & spill = spills[PartitionOf(key)];
+            if( spill.out == NULL ) {
+                size_t bytes = GroupBytes(<?=args($gbyAtts)?>);
+                if( inMemory + bytes > MEMORY_LIMIT ) {
+                    SpillPartition(spill);
+                } else {
+                    inMemory += bytes;
+                    numGroups++;
+                }
+            }
+
+            if( spill.out != NULL ) {
+                WriteSpillRecord(spill.out, spillBuffer, <?=args($inputs)?>);
+                return;
+            }
+
+<?  } // if spilling ?>
             // create an empty GLA and insert
             // better to not add the item here so we do not have
             // to transport a large state
@@ -450,22 +792,38 @@ public:
 
     void AddState(<?=$className?>& other) {
         count += other.count;
-        // scan other hash and insert or update content in this one
-        for (MapType::iterator it = other.groupByMap.begin(); it != other.groupByMap.end();
-                ++it) {
-            const Key& okey = it->first;
-            <?=$innerGLA?>& ogla = it->second;
-
-            MapType::iterator itt = groupByMap.find(okey);
-            if (itt != groupByMap.end()) { // found the group
-                <?=$innerGLA?>& gla = itt->second;
-                gla.AddState(ogla);
-            } else {
-                // add the other group to this hash
-                groupByMap.insert(MapType::value_type(okey, ogla));
-            }
+        for( size_t p = 0; p < NUM_PARTITIONS; p++ ) {
+            MergeMaps(groupByMaps[p], other.groupByMaps[p]);
+<?  if( $spill ) { ?>
+            MergeSpills(spills[p], other.spills[p]);
+<?  } // if spilling ?>
         }
+<?  if( $spill ) { ?>
+        MergeMemory(other);
+<?  } // if spilling ?>
+    }
+
+<?  if( $partitions > 1 ) { ?>
+    // Partitioned merge. Job part out of numParts merges our partitions
+    // part, part + numParts, ... of the other state. The jobs touch disjoint
+    // maps so they can run at the same time on the same states.
+    void MergePartition(size_t part, size_t numParts, <?=$className?>& other) {
+        for( size_t p = part; p < NUM_PARTITIONS; p += numParts ) {
+            MergeMaps(groupByMaps[p], other.groupByMaps[p]);
+<?  if( $spill ) { ?>
+            MergeSpills(spills[p], other.spills[p]);
+<?  } // if spilling ?>
+        }
+    }
+
+    // Called once for each other state after all the partitions are merged
+    void FinishMerge(<?=$className?>& other) {
+        count += other.count;
+<?  if( $spill ) { ?>
+        MergeMemory(other);
+<?  } // if spilling ?>
     }
+<?  } // if partitioned merge ?>
 
 <?  if( $iterable ) { ?>
     bool ShouldIterate(ConstantState& modibleState) {
@@ -473,19 +831,21 @@ public:
         fprintf(stderr, "<?=$className?>: ==== ShouldIterate ====\n");
 <?      } // if debugging enabled ?>
         bool shouldIterate = false;
-        for( MapType::iterator it = groupByMap.begin(); it != groupByMap.end(); ++it ) {
-            const Key & key = it->first;
-            InnerGLA & gla = it->second;
+        for( MapType & groupByMap : groupByMaps ) {
+            for( MapType::iterator it = groupByMap.begin(); it != groupByMap.end(); ++it ) {
+                const Key & key = it->first;
+                InnerGLA & gla = it->second;
 <?  if( $innerGLA->has_state() ) { ?>
-            InnerState & innerState = modibleState.getModibleState(key);
+                InnerState & innerState = modibleState.getModibleState(key);
 <?  } // if gla has state ?>
-            bool glaRet = gla.ShouldIterate(innerState);
-            shouldIterate = shouldIterate || glaRet;
+                bool glaRet = gla.ShouldIterate(innerState);
+                shouldIterate = shouldIterate || glaRet;
 <?      if( $debug > 0 ) { ?>
-            fprintf(stderr, "<?=$className?>: Key(%s) shouldIterate(%s)\n",
-                key.to_string().c_str(),
-                glaRet ? "true" : "false");
+                fprintf(stderr, "<?=$className?>: Key(%s) shouldIterate(%s)\n",
+                    key.to_string().c_str(),
+                    glaRet ? "true" : "false");
 <?      } // if debugging enabled ?>
+            }
         }
 
         return shouldIterate;
@@ -497,33 +857,60 @@ public:
 ?>
 
     int GetNumFragments(void){
-        int size = groupByMap.size();
         int sizeFrag = <?=$fragSize?>;
         // setup the fragment boundaries
-        // scan via iterator and count
-        int frag=0;
-        int pos=0;
-        MapType::iterator it = groupByMap.begin();
-        theIterators.clear();
-        theIterators.push_back( it );
+        // scan via iterator and count. Fragments do not span partitions
+        theFragments.clear();
+<?  if( $spill ) { ?>
+        theLoads.clear();
+<?  } // if spilling ?>
         // special case when size < num_fragments
         // >
         if (sizeFrag == 0){
-            it = groupByMap.end();
-            theIterators.push_back( it );
+<?  if( $spill ) { ?>
+            theFragments.push_back( InMemoryRanges() );
+            theLoads.push_back( SpilledPartitions() );
+<?  } else { ?>
+            std::vector<Range> all;
+            for( MapType & groupByMap : groupByMaps ) {
+                all.push_back( Range(groupByMap.begin(), groupByMap.end()) );
+            }
+            theFragments.push_back( all );
+<?  } // if not spilling ?>
             return 1; // one fragment
         }
 
-        while(it!=groupByMap.end()){
-            while(it!=groupByMap.end() && pos<( frag + 1 )*sizeFrag){
+<?  if( $spill ) { ?>
+        for( size_t p = 0; p < NUM_PARTITIONS; p++ ) {
+            // the spilled partitions are loaded when finalized, one fragment each
+            if( !spills[p].files.empty() ) {
+                theFragments.push_back( std::vector<Range>() );
+                theLoads.push_back( std::vector<size_t>(1, p) );
+                continue;
+            }
+
+            MapType & groupByMap = groupByMaps[p];
+<?  } else { ?>
+        for( MapType & groupByMap : groupByMaps ) {
+<?  } // if not spilling ?>
+            MapType::iterator it = groupByMap.begin();
+            while(it!=groupByMap.end()){
+                MapType::iterator start = it;
+                int pos = 0;
+                while(it!=groupByMap.end() && pos<sizeFrag){
 //>
-                ++it;
-                pos++;
+                    ++it;
+                    pos++;
+                }
+                theFragments.push_back( std::vector<Range>(1, Range(start, it)) );
+<?  if( $spill ) { ?>
+                theLoads.push_back( std::vector<size_t>() );
+<?  } // if spilling ?>
             }
-            theIterators.push_back( it );
-            frag++;
         }
 
+        int frag = theFragments.size();
+
 <?php if($debug > 0) { ?>
         fprintf(stderr, "<?=$className?>: fragments(%d)\n", frag);
 <?php } ?>
@@ -533,12 +920,12 @@ public:
     }
 
     Iterator* Finalize(int fragment){
-        // Call finalize on all inner GLAs in this fragment.
-        MapType::iterator iter = theIterators[fragment];
-        MapType::iterator iterEnd = theIterators[fragment+1];
-
         Iterator* rez
-            = new Iterator(theIterators[fragment], theIterators[fragment+1] );
+<?  if( $spill ) { ?>
+            = new Iterator( theFragments[fragment], this, theLoads[fragment] );
+<?  } else { ?>
+            = new Iterator( theFragments[fragment] );
+<?  } // if not spilling ?>
         return rez;
     }
 
@@ -550,10 +937,18 @@ public:
 ?>
 
     void Finalize() {
-        multiIterator = Iterator( groupByMap.begin(), groupByMap.end() );
+<?  if( $spill ) { ?>
+        multiIterator = Iterator( InMemoryRanges(), this, SpilledPartitions() );
+<?  } else { ?>
+        std::vector<Range> all;
+        for( MapType & groupByMap : groupByMaps ) {
+            all.push_back( Range(groupByMap.begin(), groupByMap.end()) );
+        }
+        multiIterator = Iterator( all );
+<?  } // if not spilling ?>
 
 <?  if( $debug >= 1 ) { ?>
-        fprintf(stderr, "<?=$className?>: groups(%lu) tuples(%lu)\n", groupByMap.size(), count);
+        fprintf(stderr, "<?=$className?>: groups(%lu) tuples(%lu)\n", size(), count);
 <?  } ?>
     }
 
@@ -562,29 +957,41 @@ public:
     }
 
     std::size_t size() const {
-        return groupByMap.size();
+        std::size_t total = 0;
+        for( const MapType & groupByMap : groupByMaps ) {
+            total += groupByMap.size();
+        }
+        return total;
     }
 
+<?  if( $partitions == 1 ) { ?>
     const MapType& GetMap() const {
-      return groupByMap;
+      return groupByMaps[0];
     }
 
+<?  } // if there is a single partition ?>
     bool Contains(<?=const_typed_ref_args($gbyAtts)?>) const {
       Key key(<?=args($gbyAtts)?>);
-      return groupByMap.count(key) > 0;
+      return Contains(key);
     }
 
     const InnerGLA& Get(<?=const_typed_ref_args($gbyAtts)?>) const {
       Key key(<?=args($gbyAtts)?>);
-      return groupByMap.at(key);
+      return Get(key);
     }
 
     bool Contains(Key key) const {
-      return groupByMap.count(key) > 0;
+<?  if( $spill ) { ?>
+      FATALIF(spills[PartitionOf(key)].spilled, "GroupBy: lookup in a partition spilled to disk");
+<?  } // if spilling ?>
+      return groupByMaps[PartitionOf(key)].count(key) > 0;
     }
 
     const InnerGLA& Get(Key key) const {
-      return groupByMap.at(key);
+<?  if( $spill ) { ?>
+      FATALIF(spills[PartitionOf(key)].spilled, "GroupBy: lookup in a partition spilled to disk");
+<?  } // if spilling ?>
+      return groupByMaps[PartitionOf(key)].at(key);
     }
 };
 
@@ -593,13 +1000,13 @@ typedef <?=$className?>::Iterator <?=$className?>_Iterator;
 <?  } ?>
 
 <?
-    $sys_headers = array_merge(['iomanip', 'iostream', 'cstring'], $extraHeaders);
+    $sys_headers = array_merge(['iomanip', 'iostream', 'cstring', 'vector', 'utility'], $extraHeaders);
 
     return array(
         'kind'             => 'GLA',
         'name'             => $className,
         'system_headers'   => $sys_headers,
-        'user_headers'     => array('HashFunctions.h'),
+        'user_headers'     => array_merge(array('HashFunctions.h'), $extraUserHeaders),
         'input'            => $inputs,
         'output'           => $outputs,
         'result_type'      => $resType,
@@ -607,6 +1014,7 @@ typedef <?=$className?>::Iterator <?=$className?>_Iterator;
         'generated_state'  => $constState,
         'required_states'  => $reqStates,
         'iterable'         => $iterable,
+        'partitioned_merge' => $partitions > 1,
         'properties'       => [ 'resettable', 'finite container' ],
         'libraries'        => $libraries,
         'extra'            => [ 'inner_gla' => $innerGLA, 'keys' => $gbyAtts ],
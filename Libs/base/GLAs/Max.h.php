@@ -47,6 +47,24 @@ public:
 
         count++;
     }
+
+    void AddItems( size_t n<?=array_template(', const {val} * {key}', '', $input)?> ) {
+        if( n == 0 )
+            return;
+
+<?  for($index = 0; $index < $nValues; $index++) {
+        $oName = $outputNames[$index];
+        $iName = $inputNames[$index];
+?>
+        <?=$output[$oName]?> acc_<?=$oName?> = count > 0 ? _<?=$oName?> : <?=$iName?>[0];
+        for( size_t i = 0; i < n; i++ )
+            acc_<?=$oName?> = std::max(acc_<?=$oName?>, <?=$iName?>[i]);
+        _<?=$oName?> = acc_<?=$oName?>;
+<?  } // foreach value ?>
+
+        count += n;
+    }
+
     void AddState( <?=$name?> & o ) {
         if (count > 0 && o.count > 0) {
 <?  for($index = 0; $index < $nValues; $index++) { ?>
@@ -76,6 +94,7 @@ public:
         'output'      => $output,
         'result_type' => 'single',
         'system_headers' => [ 'algorithm', 'cstdint' ],
+        'batch'       => true,
         ];
 }
 ?>
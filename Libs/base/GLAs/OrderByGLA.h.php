@@ -14,6 +14,23 @@
  *                      Default is approx 4 billion
  *      [O] 'rank':     Attribute to store the position of the tuple in the
  *                      sorted order.
+ *      [O] 'memory.limit': Memory budget in bytes for the tuples of a state
+ *                      (default 0, everything is kept in memory). With a
+ *                      budget, the tuples are sorted in runs that go to disk
+ *                      when the budget is exceeded, and the runs are merged
+ *                      when the result is produced (external merge sort).
+ *      [O] 'spill.dir': Directory for the sorted runs (default /tmp).
+ *      [O] 'use.fragments': With a memory budget, produce the result in
+ *                      fragments that are merged in parallel (default true).
+ *                      Each fragment is a range of the sorted order, so the
+ *                      chunks of different fragments can come out of order;
+ *                      use the rank to get the global order back.
+ *      [O] 'fragment.size': Approximate number of tuples per fragment
+ *                      (default 2000000).
+ *      [O] 'radix.sort': Sort the tuples with a radix sort on the first
+ *                      ordering attribute instead of std::sort (default
+ *                      false). The first ordering attribute has to be a
+ *                      native number.
  */
 function OrderBy( array $t_args, array $inputs, array $outputs ) {
     if( \count($inputs) == 0 ) {
@@ -109,6 +126,36 @@ function OrderBy( array $t_args, array $inputs, array $outputs ) {
     $className = generate_name('OrderBy');
 
     $debug = get_default( $t_args, 'debug', 0 );
+
+    $memLimit = get_default( $t_args, 'memory.limit', 0 );
+    $spillDir = get_default( $t_args, 'spill.dir', '/tmp' );
+    grokit_assert( is_int($memLimit) && $memLimit >= 0, 'The OrderBy memory.limit must be a non-negative integer');
+    grokit_assert( is_string($spillDir), 'The OrderBy spill.dir must be a string');
+    $spillDir = '"' . addcslashes($spillDir, "\"'\n\r\t\\\0") . '"';
+    $spill = $memLimit > 0;
+
+    $useFragments = get_default( $t_args, 'use.fragments', true );
+    $fragSize = get_default( $t_args, 'fragment.size', 2000000 );
+    grokit_assert( is_int($fragSize) && $fragSize > 0, 'The OrderBy fragment.size must be a positive integer');
+    $resType = $spill && $useFragments ? [ 'fragment', 'multi' ] : 'multi';
+
+    // On request, the tuples are radix sorted on a normalized key of the
+    // first ordering attribute: an unsigned integer with the same order.
+    $radixSort = get_default( $t_args, 'radix.sort', false );
+    grokit_assert( is_bool($radixSort), 'The OrderBy radix.sort must be a boolean');
+    reset($orderAtts);
+    $keyAtt = key($orderAtts);
+    $keyType = current($orderAtts);
+    $normKey = null;
+    if( $radixSort ) {
+        if( $keyType->is('_primative_') && $keyType->is('integral') ) {
+            $normKey = 'integral';
+        } else if( $keyType->is('_primative_') && $keyType->is('real') ) {
+            $normKey = 'real';
+        } else {
+            grokit_error('OrderBy radix sort needs a native number as the first ordering attribute, ' . $keyAtt . ' is not one');
+        }
+    }
 ?>
 
 class <?=$className?> {
@@ -126,8 +173,12 @@ class <?=$className?> {
 
         { }
 
+        Tuple( Tuple && other ) = default;
+
         Tuple & operator = (const Tuple & other ) = default;
 
+        Tuple & operator = (Tuple && other ) = default;
+
         bool operator > ( const Tuple & other ) const {
 <?  foreach($orderAtts as $name => $type )  {
         $op1 = $ascending[$name] ? '<' : '>';
@@ -175,6 +226,544 @@ class <?=$className?> {
     }; // struct Tuple
 
     typedef std::vector<Tuple> TupleVector;
+
+    typedef std::greater<Tuple> TupleCompare;
+
+    // K, as in Top-K
+    static constexpr size_t K = <?=$limit?>;
+
+<?  if( !is_null($normKey) ) { ?>
+    // Below this many tuples, std::sort is used directly
+    static constexpr size_t RADIX_THRESHOLD = 1024;
+
+    // Unsigned integer with the same order as the first ordering attribute
+    static uint64_t NormalizedKey( const Tuple & t ) {
+<?      if( $normKey == 'integral' ) { ?>
+        uint64_t key = uint64_t(int64_t(t.<?=$keyAtt?>)) ^ (uint64_t(1) << 63);
+<?      } else { ?>
+        double val = t.<?=$keyAtt?>;
+        uint64_t key;
+        memcpy(&key, &val, sizeof(key));
+        // negative numbers have all the bits flipped, positive ones the sign
+        key = (key >> 63) ? ~key : key ^ (uint64_t(1) << 63);
+<?      } // if real ?>
+<?      if( !$ascending[$keyAtt] ) { ?>
+        key = ~key;
+<?      } // if descending ?>
+        return key;
+    }
+
+<?  } // if normalized key ?>
+    // Puts the tuples in the output order
+    static void SortTuples( TupleVector & tuples ) {
+        TupleCompare comp;
+<?  if( is_null($normKey) ) { ?>
+        std::sort(tuples.begin(), tuples.end(), comp);
+<?  } else { ?>
+        const size_t n = tuples.size();
+        if( n < RADIX_THRESHOLD ) {
+            std::sort(tuples.begin(), tuples.end(), comp);
+            return;
+        }
+
+        // LSD radix sort of the keys, one byte at a time
+        typedef std::pair<uint64_t, size_t> KeyIndex;
+        std::vector<KeyIndex> keys(n);
+        std::vector<KeyIndex> temp(n);
+        for( size_t i = 0; i < n; i++ ) {
+            keys[i] = KeyIndex(NormalizedKey(tuples[i]), i);
+        }
+
+        for( int shift = 0; shift < 64; shift += 8 ) {
+            size_t counts[256] = { 0 };
+            for( const KeyIndex & k : keys ) {
+                counts[(k.first >> shift) & 0xFF]++;
+            }
+            // all the keys have the same byte, nothing to do
+            if( counts[(keys[0].first >> shift) & 0xFF] == n )
+                continue;
+
+            size_t pos = 0;
+            for( size_t & count : counts ) {
+                size_t c = count;
+                count = pos;
+                pos += c;
+            }
+            for( const KeyIndex & k : keys ) {
+                temp[counts[(k.first >> shift) & 0xFF]++] = k;
+            }
+            keys.swap(temp);
+        }
+
+<?      if( \count($orderAtts) > 1 ) { ?>
+        // the keys only cover the first attribute, sort the ties
+        auto before = [&tuples, &comp] ( const KeyIndex & a, const KeyIndex & b ) {
+            return comp(tuples[a.second], tuples[b.second]);
+        };
+        for( size_t i = 0; i < n; ) {
+            size_t j = i + 1;
+            while( j < n && keys[j].first == keys[i].first ) // >
+                j++;
+            if( j - i > 1 )
+                std::sort(keys.begin() + i, keys.begin() + j, before);
+            i = j;
+        }
+
+<?      } // if more ordering attributes ?>
+        TupleVector sorted;
+        sorted.reserve(n);
+        for( const KeyIndex & k : keys ) {
+            sorted.push_back(std::move(tuples[k.second]));
+        }
+        tuples.swap(sorted);
+<?  } // if normalized key ?>
+    }
+
+<?  if( $spill ) { ?>
+    // Memory budget of a state, in bytes
+    static constexpr size_t MEMORY_LIMIT = <?=$memLimit?>;
+
+    // One tuple in this many is kept as a sample of a run
+    static constexpr size_t SAMPLE_STEP = 1024;
+
+    // Size of the read buffer of a run on disk
+    static constexpr size_t READ_BUFFER = 1 << 16;
+
+    static constexpr size_t FRAGMENT_SIZE = <?=$fragSize?>;
+
+    // A sample of a run on disk: the tuple and where it starts
+    struct Mark {
+        Tuple tuple;
+        uint64_t offset;
+        size_t index;
+
+        Mark( const Tuple & _tuple, uint64_t _offset, size_t _index ) :
+            tuple(_tuple), offset(_offset), index(_index)
+        { }
+    };
+
+    // Sorted tuples. A run starts in memory and goes to disk when the
+    // state is over its memory budget. On disk, each record is the size of
+    // the tuple followed by the serialized tuple.
+    struct Run {
+        TupleVector tuples; // the tuples, if in memory
+        FILE * file; // the spill file, NULL if in memory
+        size_t count; // number of tuples
+        size_t bytes; // memory used by the tuples, if in memory
+        uint64_t size; // size of the file
+        std::vector<Mark> marks; // samples of the tuples on disk
+
+        Run() : tuples(), file(NULL), count(0), bytes(0), size(0), marks() { }
+    };
+
+    typedef std::vector<Run> RunVector;
+
+    // A place in a run: the index of a tuple and, on disk, where it starts
+    struct Position {
+        size_t index;
+        uint64_t offset;
+
+        Position() : index(0), offset(0) { }
+        Position( size_t _index, uint64_t _offset ) : index(_index), offset(_offset) { }
+    };
+
+    typedef std::vector<Position> PositionVector;
+
+    // Reads the tuples of a run between two positions, in order. The tuples
+    // of a run on disk only live until the next one is read.
+    class RunReader {
+        const Run * run;
+        size_t index; // index of the next tuple
+        size_t end; // index past the last tuple
+
+        // for runs on disk
+        uint64_t offset; // file offset of the first byte after the buffer
+        std::vector<char> buffer;
+        size_t bufPos; // start of the next record in the buffer
+        size_t bufEnd; // end of the data in the buffer
+        Tuple current;
+
+        // makes sure the next need bytes are in the buffer
+        void Fill( size_t need ) {
+            if( bufEnd - bufPos >= need )
+                return;
+
+            memmove(buffer.data(), buffer.data() + bufPos, bufEnd - bufPos);
+            bufEnd -= bufPos;
+            bufPos = 0;
+            if( buffer.size() < need )
+                buffer.resize(need);
+
+            while( bufEnd < need ) { // >
+                ssize_t got = pread(fileno(run->file), buffer.data() + bufEnd,
+                    buffer.size() - bufEnd, offset);
+                FATALIF(got <= 0, "OrderBy: could not read back spill file");
+                bufEnd += got;
+                offset += got;
+            }
+        }
+
+    public:
+        RunReader( const Run & _run, const Position & begin, const Position & _end ) :
+            run(&_run), index(begin.index), end(_end.index), offset(begin.offset),
+            buffer(), bufPos(0), bufEnd(0), current()
+        {
+            if( run->file != NULL )
+                buffer.resize(READ_BUFFER);
+        }
+
+        // moves to the next tuple, false if there are no more
+        bool Next() {
+            if( index >= end )
+                return false;
+            index++;
+
+            if( run->file == NULL )
+                return true;
+
+            uint32_t size;
+            Fill(sizeof(size));
+            memcpy(&size, buffer.data() + bufPos, sizeof(size));
+            bufPos += sizeof(size);
+
+            Fill(size);
+            DeserializeValues(buffer.data() + bufPos, <?=array_template('current.{key}', ', ', $inputs)?>);
+            bufPos += size;
+
+            return true;
+        }
+
+        // the tuple we moved to
+        const Tuple & Head() const {
+            return run->file == NULL ? run->tuples[index - 1] : current;
+        }
+
+        // position of the next tuple
+        Position Current() const {
+            return Position(index, offset - (bufEnd - bufPos));
+        }
+    };
+
+public:
+
+    // Merges the runs between two sets of positions
+    class Iterator {
+        std::vector<RunReader> readers;
+        std::vector<size_t> heap; // readers with tuples, the next tuple on top
+        size_t last; // reader of the last tuple produced, to move forward
+        uint64_t rank; // number of tuples before the next one
+
+        static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+        // heap order, the tuple that comes first on top
+        struct Later {
+            const std::vector<RunReader> & readers;
+
+            Later( const std::vector<RunReader> & _readers ) : readers(_readers) { }
+
+            bool operator () ( size_t a, size_t b ) const {
+                return readers[b].Head() > readers[a].Head();
+            }
+        };
+
+    public:
+        Iterator( const RunVector & runs, const PositionVector & begin,
+                const PositionVector & end, uint64_t _rank ) :
+            readers(), heap(), last(NONE), rank(_rank)
+        {
+            // the readers cannot move, the tuples point to their buffers
+            readers.reserve(runs.size());
+            for( size_t r = 0; r < runs.size(); r++ ) {
+                readers.emplace_back(runs[r], begin[r], end[r]);
+                if( readers[r].Next() )
+                    heap.push_back(r);
+            }
+            std::make_heap(heap.begin(), heap.end(), Later(readers));
+        }
+
+        Iterator( const Iterator & ) = delete;
+        Iterator & operator = ( const Iterator & ) = delete;
+
+        bool GetNextResult(<?=typed_ref_args($outputs)?>) {
+            // the last tuple was used, move its run forward
+            if( last != NONE ) {
+                if( readers[last].Next() ) {
+                    heap.push_back(last);
+                    std::push_heap(heap.begin(), heap.end(), Later(readers));
+                }
+                last = NONE;
+            }
+
+            if( heap.empty() || rank >= K )
+                return false;
+
+            std::pop_heap(heap.begin(), heap.end(), Later(readers));
+            last = heap.back();
+            heap.pop_back();
+
+            const Tuple & curr = readers[last].Head();
+<?  foreach($outputPassthroughAtts as $name => $type ) { ?>
+            <?=$name?> = curr.<?=$outToIn[$name]?>;
+<?  } ?>
+            rank++;
+<?  if( ! is_null($rankAtt) ) { ?>
+            <?=$rankAtt?> = rank;
+<?  } // if we need to output the rank ?>
+            return true;
+        }
+    };
+
+private:
+
+    uintmax_t __count;  // number of tuples covered
+
+    TupleVector tuples; // tuples not in a run yet
+    size_t bufferBytes; // memory used by tuples
+
+    RunVector runs;
+    size_t memoryBytes; // memory used by the runs in memory
+
+    std::vector<char> spillBuffer; // serialization buffer
+
+    // For each fragment, where it starts in each run, plus the end of the runs
+    std::vector<PositionVector> theBounds;
+    std::vector<uint64_t> theRanks; // number of tuples before each fragment
+
+    // Iterator for multi output type
+    std::unique_ptr<Iterator> multiIterator;
+
+    // memory used by a tuple
+    static size_t TupleBytes( const Tuple & t ) {
+        size_t bytes = sizeof(Tuple);
+<?      foreach( $inputs as $name => $type ) {
+            if( !$type->is('_primative_') ) {
+?>
+        bytes += SerializedSize(t.<?=$name?>);
+<?          } // if not native
+        } // foreach input ?>
+        return bytes;
+    }
+
+    // Writes a run in memory to disk, keeping a sample of the tuples
+    void WriteRun( Run & run ) {
+        FILE * file = NewSpillFile(<?=$spillDir?>, "grokit_orderby");
+        uint64_t offset = 0;
+
+        for( size_t i = 0; i < run.tuples.size(); i++ ) {
+            const Tuple & t = run.tuples[i];
+            if( i % SAMPLE_STEP == 0 )
+                run.marks.push_back(Mark(t, offset, i));
+
+            offset += WriteSpillRecord(file, spillBuffer, <?=array_template('t.{key}', ', ', $inputs)?>);
+        }
+        FATALIF(fflush(file) != 0, "OrderBy: could not write to spill file");
+
+        run.file = file;
+        run.size = offset;
+        run.bytes = 0;
+        TupleVector empty;
+        run.tuples.swap(empty);
+    }
+
+    // Sorts the buffered tuples into a new run
+    Run MakeRun() {
+        SortTuples(tuples);
+        if( tuples.size() > K )
+            tuples.resize(K);
+
+        Run run;
+        run.count = tuples.size();
+        run.bytes = bufferBytes;
+        run.tuples.swap(tuples);
+        bufferBytes = 0;
+        return run;
+    }
+
+    // Called when the buffer is over budget, the tuples go straight to disk
+    void SpillBuffer() {
+        runs.push_back(MakeRun());
+        WriteRun(runs.back());
+    }
+
+    // Makes a run in memory out of the buffered tuples
+    void SealBuffer() {
+        if( tuples.empty() )
+            return;
+
+        runs.push_back(MakeRun());
+        memoryBytes += runs.back().bytes;
+        EnforceLimit();
+    }
+
+    // Writes the largest runs to disk until the rest fits in memory
+    void EnforceLimit() {
+        while( memoryBytes > MEMORY_LIMIT ) {
+            Run * largest = NULL;
+            for( Run & run : runs ) {
+                if( run.file == NULL && (largest == NULL || run.bytes > largest->bytes) )
+                    largest = &run;
+            }
+
+            memoryBytes -= largest->bytes;
+            WriteRun(*largest);
+        }
+    }
+
+    // Where the tuples that come after the splitter start in a run
+    Position FindPosition( const Run & run, const Tuple & splitter ) const {
+        if( run.file == NULL ) {
+            auto it = std::partition_point(run.tuples.begin(), run.tuples.end(),
+                [&splitter] ( const Tuple & t ) { return t > splitter; });
+            return Position(it - run.tuples.begin(), 0);
+        }
+
+        // read forward from the last sample before the splitter
+        auto mark = std::partition_point(run.marks.begin(), run.marks.end(),
+            [&splitter] ( const Mark & m ) { return m.tuple > splitter; });
+        if( mark == run.marks.begin() )
+            return Position(0, 0);
+        --mark;
+
+        RunReader reader(run, Position(mark->index, mark->offset), Position(run.count, run.size));
+        Position pos = reader.Current();
+        while( reader.Next() && reader.Head() > splitter )
+            pos = reader.Current();
+
+        return pos;
+    }
+
+    PositionVector Begins() const {
+        return PositionVector(runs.size());
+    }
+
+    PositionVector Ends() const {
+        PositionVector ends;
+        for( const Run & run : runs ) {
+            ends.push_back(Position(run.count, run.size));
+        }
+        return ends;
+    }
+
+public:
+
+    <?=$className?>() : __count(0), tuples(), bufferBytes(0), runs(), memoryBytes(0),
+        spillBuffer(), theBounds(), theRanks(), multiIterator()
+    { }
+
+    ~<?=$className?>() {
+        for( Run & run : runs ) {
+            if( run.file != NULL )
+                fclose(run.file);
+        }
+    }
+
+    void AddItem(<?=const_typed_ref_args($inputs)?>) {
+        __count++;
+        tuples.emplace_back(<?=args($inputs)?>);
+        bufferBytes += TupleBytes(tuples.back());
+
+        if( bufferBytes + memoryBytes > MEMORY_LIMIT )
+            SpillBuffer();
+    }
+
+    // The buffers of both states are sorted here, so each worker sorts its
+    // own tuples in parallel with the others
+    void AddState( <?=$className?> & other ) {
+        __count += other.__count;
+        SealBuffer();
+        other.SealBuffer();
+
+        for( Run & run : other.runs ) {
+            runs.push_back(std::move(run));
+        }
+        other.runs.clear();
+        memoryBytes += other.memoryBytes;
+        other.memoryBytes = 0;
+
+        EnforceLimit();
+    }
+
+<?      if( $spill && $useFragments ) { ?>
+    // Sample tuples of the runs split the sorted order in ranges of about
+    // FRAGMENT_SIZE tuples. Each fragment merges its range of all the runs.
+    int GetNumFragments(void) {
+        SealBuffer();
+
+        uint64_t total = 0;
+        std::vector<const Tuple *> samples;
+        for( const Run & run : runs ) {
+            total += run.count;
+            if( run.file == NULL ) {
+                for( size_t i = 0; i < run.count; i += SAMPLE_STEP )
+                    samples.push_back(&run.tuples[i]);
+            } else {
+                for( const Mark & mark : run.marks )
+                    samples.push_back(&mark.tuple);
+            }
+        }
+
+        size_t numFrags = (total + FRAGMENT_SIZE - 1) / FRAGMENT_SIZE;
+        if( numFrags > samples.size() )
+            numFrags = samples.size();
+        if( numFrags == 0 )
+            numFrags = 1;
+
+        std::sort(samples.begin(), samples.end(),
+            [] ( const Tuple * a, const Tuple * b ) { return *a > *b; });
+
+        theBounds.clear();
+        theRanks.clear();
+        theBounds.push_back(Begins());
+        for( size_t f = 1; f < numFrags; f++ ) {
+            const Tuple & splitter = *samples[f * samples.size() / numFrags];
+            PositionVector bounds;
+            for( const Run & run : runs ) {
+                bounds.push_back(FindPosition(run, splitter));
+            }
+            theBounds.push_back(bounds);
+        }
+        theBounds.push_back(Ends());
+
+        for( size_t f = 0; f < numFrags; f++ ) {
+            uint64_t rank = 0;
+            for( const Position & pos : theBounds[f] ) {
+                rank += pos.index;
+            }
+            theRanks.push_back(rank);
+        }
+
+<?  if( $debug >= 1 ) { ?>
+        fprintf(stderr, "<?=$className?>: tuples(%lu) runs(%lu) fragments(%lu)\n",
+            (unsigned long) total, (unsigned long) runs.size(), (unsigned long) numFrags);
+<?  } ?>
+
+        return numFrags;
+    }
+
+    Iterator * Finalize( int fragment ) {
+        return new Iterator(runs, theBounds[fragment], theBounds[fragment + 1], theRanks[fragment]);
+    }
+
+    bool GetNextResult( Iterator * it, <?=typed_ref_args($outputs)?> ) {
+        return it->GetNextResult(<?=args($outputs)?>);
+    }
+
+<?      } // if fragments ?>
+    void Finalize() {
+        SealBuffer();
+        multiIterator.reset(new Iterator(runs, Begins(), Ends(), 0));
+    }
+
+    bool GetNextResult( <?=typed_ref_args($outputs)?> ) {
+        return multiIterator->GetNextResult(<?=args($outputs)?>);
+    }
+};
+
+<?      if( $useFragments ) { ?>
+typedef <?=$className?>::Iterator <?=$className?>_Iterator;
+
+<?      } // if fragments ?>
+<?  } else { // not spilling ?>
 public:
 
     class Iterator {
@@ -213,16 +802,11 @@ private:
 
     uintmax_t __count;  // number of tuples covered
 
-    // K, as in Top-K
-    static constexpr size_t K = <?=$limit?>;
-
     TupleVector tuples;
 
     // Iterator for multi output type
     Iterator multiIterator;
 
-    typedef std::greater<Tuple> TupleCompare;
-
     // Function to force sorting so that GetNext gets the tuples in order.
     void Sort(void) {
         TupleCompare comp;
@@ -231,7 +815,7 @@ private:
         if( tuples.size() >= K ) {
             std::sort_heap(tuples.begin(), tuples.end(), comp);
         } else {
-            std::sort(tuples.begin(), tuples.end(), comp);
+            SortTuples(tuples);
         }
     }
 
@@ -325,19 +909,27 @@ public:
     }
 };
 
+<?  } // if not spilling ?>
+
 <?
-    $system_headers = [ 'vector', 'algorithm', 'cinttypes' ];
+    $system_headers = [ 'vector', 'algorithm', 'cinttypes', 'cstring', 'utility' ];
+    $user_headers = [];
     if( $debug > 0 ) {
         $system_headers = array_merge($system_headers, [ 'iostream', 'sstream', 'string' ] );
     }
+    if( $spill ) {
+        $system_headers = array_merge($system_headers, [ 'cstdio', 'unistd.h', 'limits', 'memory' ] );
+        $user_headers[] = 'SpillFile.h';
+    }
 
     return array(
         'kind'           => 'GLA',
         'name'           => $className,
         'input'          => $inputs,
         'output'         => $outputs,
-        'result_type'    => 'multi',
+        'result_type'    => $resType,
         'system_headers' => $system_headers,
+        'user_headers'   => $user_headers,
     );
 } // end function OrderBy
 ?>
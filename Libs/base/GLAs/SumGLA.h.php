@@ -56,6 +56,15 @@ public:
         <?=array_template('{key} += _{key};' . PHP_EOL, '        ', $inputs)?>
     }
 
+    void AddItems(size_t n<?=array_template(', const {val} * _{key}', '', $inputs)?>) {
+<?  foreach( $storage as $name => $type ) { ?>
+        <?=$type?> acc_<?=$name?> = <?=$name?>;
+        for( size_t i = 0; i < n; i++ )
+            acc_<?=$name?> += _<?=$name?>[i];
+        <?=$name?> = acc_<?=$name?>;
+<?  } // foreach input ?>
+    }
+
     void AddState( <?=$className?> & other ) {
         <?=array_template('{key} += other.{key};' . PHP_EOL, '        ', $inputs)?>
     }
@@ -83,6 +92,7 @@ public:
       'input'       => $inputs,
       'output'      => $outputs,
       'result_type' => 'single',
+      'batch'       => true,
   );
 
 }
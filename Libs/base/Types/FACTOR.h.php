@@ -39,6 +39,7 @@ function FACTOR( array $t_args ) {
     $className = generate_name('FACTOR_' . ensure_identifier($dict));
 
     $stringType = lookupType('base::STRING');
+    $prefixType = lookupType('base::FACTOR_PREFIX', ['dictionary' => $rawDict]);
 
     $globalContent = '';
 
@@ -112,6 +113,12 @@ public:
 <?  $methods[] = [ 'Invalid', [], 'base::bool', true ];    ?>
     bool Invalid( void ) const;
 
+    // Returns whether or not the string of the Factor starts with the prefix.
+    // The prefix holds the range of ranks of the strings that start with it,
+    // so each call is two integer comparisons.
+<?  $methods[] = [ 'StartsWith', [ $prefixType ], 'base::bool', true ];    ?>
+    bool StartsWith( const <?=$prefixType?> & ) const;
+
     // Translate the content
     void Translate( const Dictionary::TranslationTable& );
 
@@ -122,7 +129,7 @@ public:
 
     // The dictionary keeps track of what the sorted order of the strings is.
     // These methods are based on the lexicographical ordering of the strings
-    // the factors represent
+    // the factors represent, and compare the ranks of the IDs in that order.
     bool operator ==( const <?=$className?> & ) const;
     bool operator !=( const <?=$className?> & ) const;
     bool operator <( const <?=$className?> & ) const;
@@ -221,6 +228,11 @@ bool <?=$className?> :: Invalid(void) const {
     return myID == InvalidID;
 }
 
+inline
+bool <?=$className?> :: StartsWith( const <?=$prefixType?> & prefix ) const {
+    return Valid() && prefix.Contains(globalDictionary.Rank(myID));
+}
+
 // Translate the content
 inline
 void <?=$className?> :: Translate( const Dictionary::TranslationTable & tbl ) {
@@ -255,22 +267,22 @@ bool <?=$className?> :: operator !=( const <?=$className?> & o ) const {
 
 inline
 bool <?=$className?> :: operator <( const <?=$className?> & o ) const {
-    return Valid() && o.Valid() && globalDictionary.Compare(myID, o.myID) < 0;
+    return Valid() && o.Valid() && globalDictionary.Rank(myID) < globalDictionary.Rank(o.myID);
 }
 
 inline
 bool <?=$className?> :: operator <=( const <?=$className?> & o ) const {
-    return Valid() && o.Valid() && globalDictionary.Compare(myID, o.myID) <= 0;
+    return Valid() && o.Valid() && globalDictionary.Rank(myID) <= globalDictionary.Rank(o.myID);
 }
 
 inline
 bool <?=$className?> :: operator >( const <?=$className?> & o ) const {
-    return Valid() && o.Valid() && globalDictionary.Compare(myID, o.myID) > 0;
+    return Valid() && o.Valid() && globalDictionary.Rank(myID) > globalDictionary.Rank(o.myID);
 }
 
 inline
 bool <?=$className?> :: operator >=( const <?=$className?> & o ) const {
-    return Valid() && o.Valid() && globalDictionary.Compare(myID, o.myID) >= 0;
+    return Valid() && o.Valid() && globalDictionary.Rank(myID) >= globalDictionary.Rank(o.myID);
 }
 
 // Implicit conversion to storage type
@@ -338,7 +350,7 @@ bool IsNull( const @type f ) {
         'kind'              => 'TYPE',
         'name'              => $className,
         'dictionary'        => $dict,
-        'system_headers'    => [ 'limits', 'cstring', 'cinttypes' ],
+        'system_headers'    => [ 'limits', 'cstring', 'cinttypes', 'string' ],
         'user_headers'      => [ 'Dictionary.h', 'DictionaryManager.h', 'ColumnIteratorDict.h' ],
         'properties'        => [ 'categorical' ],
         'extras'            => [ 'cardinality' => $cardinality, 'size.bytes' => $storageBytes ],
@@ -0,0 +1,50 @@
+<?
+// Copyright 2015 Tera Insights, LLC. All Rights Reserved.
+
+// This type is the argument of the StartsWith method of FACTOR. A prefix is
+// turned into the range of ranks of the strings of the dictionary that start
+// with it. The prefix is almost always a string literal, so the conversion is
+// a constant of the predicate and the range is looked up once per chunk
+// instead of once per tuple.
+
+function FACTOR_PREFIX( array $t_args ) {
+    $rawDict = get_first_key( $t_args, ['dictionary', 'dict', 0] );
+
+    // Same escaping as FACTOR
+    $dict = addcslashes(\grokit\doubleChars($rawDict, '"'), '"\\');
+
+    $className = generate_name('FACTOR_PREFIX_' . ensure_identifier($dict));
+
+    $constructors = [];
+?>
+
+class <?=$className?> {
+    // Ranks of the strings that start with the prefix
+    Dictionary::RankRange range;
+
+public:
+<?  $constructors[] = [ [ 'base::STRING_LITERAL' ], true ]; ?>
+    <?=$className?>( const char * prefix ):
+        range(Dictionary::GetDictionary("<?=$dict?>").PrefixRange(prefix))
+    { }
+
+    <?=$className?>( const <?=$className?> & ) = default;
+
+    // Whether the string with the given rank starts with the prefix
+    bool Contains( Dictionary::IntType rank ) const {
+        return rank >= range.first && rank < range.second;
+    }
+};
+
+<?
+    return [
+        'kind'              => 'TYPE',
+        'name'              => $className,
+        'system_headers'    => [ 'utility' ],
+        'user_headers'      => [ 'Dictionary.h' ],
+        'constructors'      => $constructors,
+        'complex'           => false,
+    ];
+} // end function FACTOR_PREFIX
+
+?>
@@ -25,6 +25,10 @@
 #include "Message.h"
 #include "PerfCounter.h" // perfrormance counters
 #include "Timer.h"
+#include "ID.h"
+#include "WorkDescription.h"
+#include "ExecEngineData.h"
+#include "WorkFuncs.h"
 
 class CPUWorker;
 
@@ -68,6 +72,12 @@ public:
 	// this handles a request to actually do some work
 	MESSAGE_HANDLER_DECLARATION(DoSomeWork);
 
+	// runs the work function on the work description and puts the result in
+	// computationResult (with profiling and diagnosis around it). Returns what
+	// the work function returned. Also used by the work stealing workers
+	static int RunWork (WayPointID &currentPos, WorkFunc myFunc, WorkDescription &workDescription,
+		ExecEngineData &computationResult);
+
 };
 
 /////////// INLINE METHODS ////////////
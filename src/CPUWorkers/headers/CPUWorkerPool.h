@@ -17,14 +17,61 @@
 #ifndef CPU_WORKER_POOL_H
 #define CPU_WORKER_POOL_H
 
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <pthread.h>
+
 #include "CPUWorker.h"
 #include "CPUWorkerImp.h"
+#include "EventGeneratorImp.h"
 #include "ID.h"
 #include "History.h"
 #include "Tokens.h"
 #include "WorkDescription.h"
 #include "WorkFuncs.h"
 
+/** A piece of work waiting in the deques of the pool (work stealing mode).
+    Holds the same things as a WorkRequestMsg.
+*/
+struct CPUWorkItem {
+	WayPointID currentPos;
+	WorkFunc myFunc;
+	QueryExitContainer dest;
+	HistoryList lineage;
+	GenericWorkToken token;
+	WorkDescription workDescription;
+
+	// the arguments are swapped in (like the factory of WorkRequestMsg does)
+	CPUWorkItem (WayPointID &_currentPos, WorkFunc _myFunc, QueryExitContainer &_dest,
+		HistoryList &_lineage, GenericWorkToken &_token, WorkDescription &_workDescription) :
+		currentPos (_currentPos), myFunc (_myFunc) {
+		dest.swap (_dest);
+		lineage.swap (_lineage);
+		token.swap (_token);
+		workDescription.swap (_workDescription);
+	}
+};
+
+/** The CPU workers can be run in two modes, selected by CPU_WORK_STEALING.
+
+	In the message mode, each worker is a CPUWorker (an EventProcessor).
+	A free worker is taken out of myWorkers and the work is sent to it as a
+	WorkRequestMsg. The worker puts itself back in the pool when done.
+
+	In the work stealing mode, each worker is a thread with its own deque of
+	work. DoSomeWork appends the work to the deques in round robin fashion.
+	A worker takes work from the front of its own deque and, when that is
+	empty, steals from the back of the deques of the others. Workers without
+	anything to do sleep until new work comes in. There can be more work in
+	the deques than workers since the execution engine gives out more CPU
+	tokens than threads in this mode (see CPU_TOKENS_PER_WORKER).
+
+	In both modes the result goes back to the execution engine with the token
+	so the admission control (priority cutoffs) is unchanged.
+
+	The work stealing mode is experimental and off by default.
+*/
 class CPUWorkerPool {
 
 private:
@@ -34,6 +81,53 @@ private:
 
 	CPUWorkerList myWorkers;
 
+	// the work stealing mode
+
+	// the deque of one worker. The owner pops from the front, thieves from the back
+	struct WorkDeque {
+		pthread_mutex_t lock;
+		std::deque<CPUWorkItem*> items;
+	};
+
+	// thread that runs the work in the deques
+	class StealingWorkerImp : public EventGeneratorImp {
+		CPUWorkerPool& pool;
+		int myIndex; // index of our deque
+
+		public:
+			StealingWorkerImp(CPUWorkerPool& _pool, int _myIndex):pool(_pool), myIndex(_myIndex){}
+
+			virtual int ProduceMessage(void) override;
+	};
+
+	bool stealing; // are we in work stealing mode?
+
+	std::vector<WorkDeque*> deques;
+	std::vector<StealingWorkerImp*> stealers;
+
+	// next deque to put work in
+	std::atomic<uint64_t> nextDeque;
+
+	// number of work items in all the deques
+	std::atomic<int64_t> numQueued;
+
+	// the idle workers wait on workAvailable. Protected by idleLock
+	pthread_mutex_t idleLock;
+	pthread_cond_t workAvailable;
+	int numIdle;
+
+	// statistics
+	std::atomic<uint64_t> numSteals;
+
+	// takes an item from the deque, from the front if owner, from the back otherwise
+	CPUWorkItem* TakeWork(int which, bool owner);
+
+	// blocks until some work is found for the worker, own deque first
+	CPUWorkItem* GetWork(int myIndex);
+
+	// runs the work and sends the result to the execution engine
+	void ExecuteWork(CPUWorkItem* item);
+
 public:
 
 	// set up all of the worker threads and puts them into the list myWorkers
@@ -62,7 +156,10 @@ public:
 	void AddWorker (CPUWorker &addMe);
 
 	// returns the number of available threads
-	int NumAvailable(void){ return myWorkers.Length(); }
+	int NumAvailable(void);
+
+	// number of times a worker took work from the deque of another (work stealing mode)
+	uint64_t NumSteals(void){ return numSteals; }
 };
 
 // myWorkers actually lives in CPUWorkerPool.cc
@@ -24,6 +24,10 @@
 #include "Profiling.h"
 #include "Logging.h"
 #include "Diagnose.h"
+#include "Tracer.h"
+#include "MemoryAccounting.h"
+#include "QueryManager.h"
+#include "QueryExit.h"
 #include "WorkerMessages.h"
 
 /** How oftern the system should have context swithes? Need this to determine if we have
@@ -69,13 +73,11 @@ CPUWorkerImp :: CPUWorkerImp ()
 
 CPUWorkerImp :: ~CPUWorkerImp () {}
 
-MESSAGE_HANDLER_DEFINITION_BEGIN(CPUWorkerImp, DoSomeWork, WorkRequestMsg) {
-
-    // this is where the result of the computation will go
-    ExecEngineData computationResult;
+int CPUWorkerImp :: RunWork (WayPointID &currentPos, WorkFunc myFunc, WorkDescription &workDescription,
+        ExecEngineData &computationResult) {
 
-    LOG_ENTRY_P(1, " Function of waypoint %s started\n", msg.currentPos.getName().c_str());
-    DIAG_ID dID = DIAGNOSE_ENTRY("CPUWORKER", msg.currentPos.getName().c_str(), "CPUWORK");
+    LOG_ENTRY_P(1, " Function of waypoint %s started\n", currentPos.getName().c_str());
+    DIAG_ID dID = DIAGNOSE_ENTRY("CPUWORKER", currentPos.getName().c_str(), "CPUWORK");
     // NOT USED uint64_t effort = PREFERED_TUPLES_PER_CHUNK; // function fills in the effort
 
 #ifdef PER_CPU_PROFILE
@@ -93,7 +95,9 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(CPUWorkerImp, DoSomeWork, WorkRequestMsg) {
 #endif // PER_CPU_PROFILE
 
     // now, call the work function to actually produce the output data
-    int returnVal = msg.myFunc (msg.workDescription, computationResult);
+    TRACE_START;
+    int returnVal = myFunc (workDescription, computationResult);
+    TRACE_END("worker", currentPos.getName().c_str(), returnVal);
 
 #ifdef PER_CPU_PROFILE
     PROFILING2_END;
@@ -103,7 +107,7 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(CPUWorkerImp, DoSomeWork, WorkRequestMsg) {
 
     // Read performance counters
     PCounterList waypointList;
-    const string waypointGroup = msg.currentPos.getName();
+    const string waypointGroup = currentPos.getName();
     for( size_t i = 0; i < eventsPC_size; ++i ) {
         // Create one counter for global aggregation and one for waypoint aggregation
         std::string name = PerfCounter::names[eventsPC[i]];
@@ -120,6 +124,23 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(CPUWorkerImp, DoSomeWork, WorkRequestMsg) {
 
     DIAGNOSE_EXIT(dID);
 
+    return returnVal;
+}
+
+MESSAGE_HANDLER_DEFINITION_BEGIN(CPUWorkerImp, DoSomeWork, WorkRequestMsg) {
+
+    // this is where the result of the computation will go
+    ExecEngineData computationResult;
+
+    int returnVal;
+    {
+        // the memory allocated by the work is charged to its queries
+        QueryIDSet queries = QueryExitsToQueries(msg.dest);
+        MemoryOwnerScope owner(QueryManager::MemoryOwner(queries));
+        TraceQueriesScope traceQueries(queries);
+        returnVal = RunWork (msg.currentPos, msg.myFunc, msg.workDescription, computationResult);
+    }
+
     // and finally, store outselves in the queue for future use
     CPUWorker me;
     me.copy(evProc.me);
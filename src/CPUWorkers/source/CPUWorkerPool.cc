@@ -16,12 +16,46 @@
 
 #include "CPUWorkerPool.h"
 #include "WorkerMessages.h"
+#include "EEExternMessages.h"
+#include "ExecEngine.h"
+#include "Constants.h"
+#include "Errors.h"
+#include "MemoryAccounting.h"
+#include "QueryManager.h"
+#include "QueryExit.h"
+#include "Tracer.h"
 
 void CPUWorkerPool :: AddWorker (CPUWorker &addMe) {
     myWorkers.Add (addMe);
 }
 
-CPUWorkerPool :: CPUWorkerPool (int numWorkers, size_t stack_size) {
+CPUWorkerPool :: CPUWorkerPool (int numWorkers, size_t stack_size) :
+    stealing (CPU_WORK_STEALING && numWorkers > 0),
+    nextDeque (0),
+    numQueued (0),
+    numIdle (0),
+    numSteals (0) {
+
+    pthread_mutex_init (&idleLock, NULL);
+    pthread_cond_init (&workAvailable, NULL);
+
+    if (stealing) {
+
+        // create all the deques first, the workers steal from each other
+        for (int i = 0; i < numWorkers; i++) {
+            WorkDeque* deque = new WorkDeque;
+            pthread_mutex_init (&deque->lock, NULL);
+            deques.push_back (deque);
+        }
+
+        for (int i = 0; i < numWorkers; i++) {
+            StealingWorkerImp* worker = new StealingWorkerImp (*this, i);
+            stealers.push_back (worker);
+            worker->Run (stack_size);
+        }
+
+        return;
+    }
 
     for (int i = 0; i < numWorkers; i++) {
 
@@ -43,6 +77,19 @@ CPUWorkerPool :: ~CPUWorkerPool () {
         myWorkers.AtomicRemove (temp);
         KillEvProc (temp);
     }
+
+    for (size_t i = 0; i < stealers.size (); i++) {
+        stealers[i]->Kill ();
+        delete stealers[i];
+    }
+
+    for (size_t i = 0; i < deques.size (); i++) {
+        pthread_mutex_destroy (&deques[i]->lock);
+        delete deques[i];
+    }
+
+    pthread_cond_destroy (&workAvailable);
+    pthread_mutex_destroy (&idleLock);
 }
 
 void CPUWorkerPool :: DoSomeWork (WayPointID &requestor, HistoryList &lineage, QueryExitContainer &dest,
@@ -51,6 +98,27 @@ void CPUWorkerPool :: DoSomeWork (WayPointID &requestor, HistoryList &lineage, Q
     // check if the token is forged
     FATALIF(myToken.Type() != CPUWorkToken::type, "I got a fake CPU token");
 
+    if (stealing) {
+
+        // queue the work in the next deque, whoever is free first will do it
+        CPUWorkItem* item = new CPUWorkItem (requestor, myFunc, dest, lineage, myToken, workDescription);
+
+        WorkDeque* deque = deques[nextDeque++ % deques.size ()];
+        pthread_mutex_lock (&deque->lock);
+        deque->items.push_back (item);
+        pthread_mutex_unlock (&deque->lock);
+
+        numQueued++;
+
+        // wake up a worker if anybody sleeps
+        pthread_mutex_lock (&idleLock);
+        if (numIdle > 0)
+            pthread_cond_signal (&workAvailable);
+        pthread_mutex_unlock (&idleLock);
+
+        return;
+    }
+
     // first, go to the queue and take a worker out
     CPUWorker worker;
     if (!myWorkers.AtomicRemove (worker)) {
@@ -63,3 +131,94 @@ void CPUWorkerPool :: DoSomeWork (WayPointID &requestor, HistoryList &lineage, Q
     // done!
 }
 
+int CPUWorkerPool :: NumAvailable (void) {
+    if (stealing) {
+        pthread_mutex_lock (&idleLock);
+        int rez = numIdle;
+        pthread_mutex_unlock (&idleLock);
+        return rez;
+    }
+
+    return myWorkers.Length ();
+}
+
+CPUWorkItem* CPUWorkerPool :: TakeWork (int which, bool owner) {
+    WorkDeque* deque = deques[which];
+    CPUWorkItem* item = NULL;
+
+    pthread_mutex_lock (&deque->lock);
+    if (!deque->items.empty ()) {
+        if (owner) {
+            item = deque->items.front ();
+            deque->items.pop_front ();
+        } else {
+            item = deque->items.back ();
+            deque->items.pop_back ();
+        }
+    }
+    pthread_mutex_unlock (&deque->lock);
+
+    if (item != NULL)
+        numQueued--;
+
+    return item;
+}
+
+CPUWorkItem* CPUWorkerPool :: GetWork (int myIndex) {
+    int numDeques = deques.size ();
+
+    while (true) {
+
+        // our own work first
+        CPUWorkItem* item = TakeWork (myIndex, true);
+        if (item != NULL)
+            return item;
+
+        // then steal, starting with our neighbor so the thieves spread out
+        for (int i = 1; i < numDeques; i++) {
+            item = TakeWork ((myIndex + i) % numDeques, false);
+            if (item != NULL) {
+                numSteals++;
+                return item;
+            }
+        }
+
+        // nothing anywhere, sleep until somebody queues more work
+        // numQueued is checked under the lock so that we do not miss the signal
+        pthread_mutex_lock (&idleLock);
+        if (numQueued == 0) {
+            numIdle++;
+            pthread_cond_wait (&workAvailable, &idleLock);
+            numIdle--;
+        }
+        pthread_mutex_unlock (&idleLock);
+    }
+}
+
+void CPUWorkerPool :: ExecuteWork (CPUWorkItem* item) {
+
+    // this is where the result of the computation will go
+    ExecEngineData computationResult;
+
+    int returnVal;
+    {
+        // the memory allocated by the work is charged to its queries
+        QueryIDSet queries = QueryExitsToQueries(item->dest);
+        MemoryOwnerScope owner(QueryManager::MemoryOwner(queries));
+        TraceQueriesScope traceQueries(queries);
+        returnVal = CPUWorkerImp :: RunWork (item->currentPos, item->myFunc, item->workDescription, computationResult);
+    }
+
+    // now, send the result back
+    HoppingDataMsg result (item->currentPos, item->dest, item->lineage, computationResult);
+    HoppingDataMsgMessage_Factory (executionEngine, returnVal, item->token, result);
+
+    delete item;
+}
+
+int CPUWorkerPool :: StealingWorkerImp :: ProduceMessage (void) {
+    CPUWorkItem* item = pool.GetWork (myIndex);
+    pool.ExecuteWork (item);
+
+    return 0;
+}
@@ -174,6 +174,16 @@ class Catalog {
         // it.
         void AddSchema(Schema &inSchema);
 
+        // Replaces the number of tuples and the column statistics of a
+        // relation, then saves the catalog. Returns false if the relation
+        // is not in the catalog
+        bool SetStatistics(std::string relName, long long int numTuples,
+                const ColumnStatsList& stats);
+
+        // Returns the statistics of the columns of a relation, false if the
+        // relation is not in the catalog
+        bool GetColumnStats(std::string relName, ColumnStatsList& where);
+
         // Adds an alias to a table name
         void AddSchemaAlias(std::string from, std::string to);
 
@@ -0,0 +1,122 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef _COLUMN_STATS_H
+#define _COLUMN_STATS_H
+
+#include <string>
+#include <vector>
+#include <cinttypes>
+
+/** Statistics of a column of a relation: number of values and nulls,
+ * min/max and a HyperLogLog sketch for the number of distinct values.
+ *
+ * The statistics are collected by the ChunkReaderWriter for each chunk it
+ * writes and merged into the ones of the relation, so everything here has
+ * to be mergeable. The HyperLogLog registers merge exactly.
+ *
+ * Only the columns whose raw values are integers get statistics (see
+ * ZoneMap.h). The values are the raw ones, nulls are counted apart.
+ **/
+class ColumnStats {
+
+    public:
+        // the sketch has 2^SKETCH_BITS registers, for a standard error of
+        // about 3%
+        static const int SKETCH_BITS = 10;
+        static const int SKETCH_SIZE = 1 << SKETCH_BITS;
+
+    private:
+        // number of non null values seen
+        uint64_t numValues;
+
+        // number of nulls seen
+        uint64_t numNulls;
+
+        // range of the non null values, valid if numValues > 0
+        int64_t minValue;
+        int64_t maxValue;
+
+        // HyperLogLog registers, empty until the first value
+        std::vector<uint8_t> sketch;
+
+    public:
+        ColumnStats();
+
+        // no values seen at all
+        bool IsEmpty() const { return numValues == 0 && numNulls == 0; }
+
+        // adds one non null value
+        void Add(int64_t value);
+
+        // adds one null
+        void AddNull() { numNulls++; }
+
+        // merges the statistics of other (usually a new chunk) into these
+        void Merge(const ColumnStats& other);
+
+        uint64_t GetNumValues() const { return numValues; }
+        uint64_t GetNumNulls() const { return numNulls; }
+        int64_t GetMin() const { return minValue; }
+        int64_t GetMax() const { return maxValue; }
+
+        // fraction of the values that are null, 0 if nothing seen
+        double NullFraction() const;
+
+        // estimate of the number of distinct non null values
+        uint64_t EstimateDistinct() const;
+
+        // Sets the counts and the range, used when loaded from the catalog
+        void SetCounts(uint64_t numValues, uint64_t numNulls, int64_t minValue, int64_t maxValue);
+
+        // Text form of the sketch used to store it in the catalog.
+        // SketchFromString returns false if the text is not valid, leaving
+        // the sketch empty
+        std::string SketchToString() const;
+        bool SketchFromString(const char* text);
+};
+
+// the statistics of the columns of a relation, by column number
+typedef std::vector<ColumnStats> ColumnStatsList;
+
+
+// Inlined methods
+
+inline void ColumnStats::Add(int64_t value) {
+    if (numValues == 0) {
+        minValue = maxValue = value;
+        if (sketch.empty())
+            sketch.resize(SKETCH_SIZE, 0);
+    } else {
+        if (value < minValue) minValue = value;
+        if (value > maxValue) maxValue = value;
+    }
+    numValues++;
+
+    // mix the bits of the value (splitmix64 finalizer), the top bits pick
+    // the register and the rest give the rank
+    uint64_t hash = (uint64_t) value;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    hash = hash ^ (hash >> 31);
+
+    uint64_t reg = hash >> (64 - SKETCH_BITS);
+    uint64_t rest = hash << SKETCH_BITS;
+    uint8_t rank = rest == 0 ? (64 - SKETCH_BITS + 1) : (__builtin_clzll(rest) + 1);
+    if (rank > sketch[reg])
+        sketch[reg] = rank;
+}
+
+#endif // _COLUMN_STATS_H
@@ -19,6 +19,7 @@
 #define _SCHEMA_H
 
 #include "Attribute.h"
+#include "ColumnStats.h"
 #include "Debug.h"
 #include "Errors.h"
 #include "TwoWayList.h"
@@ -30,7 +31,7 @@
 /** This class stores schema infromation about a particular relation.
  * Essentially, the attributes that compose it (a collection of Attribute
  * objects), the name of the relation, the path to the metadata file
- * and the number of tuples in the relation.
+ * the number of tuples in the relation and the statistics of its columns.
  *
  * Additionally, functionality for projection and schema union is provided.
  **/
@@ -52,6 +53,10 @@ class Schema {
         // Attribute the relation is clustered upon
         Attribute clusterAttribute;
 
+        // Statistics of the columns, by column number. Columns past the end
+        // have none
+        ColumnStatsList columnStats;
+
         // Find an attribute based on its name
         bool FindAttByName(std::string name);
 
@@ -95,6 +100,13 @@ class Schema {
         int GetNumTuples();
         void SetNumTuples(long long int tuples);
 
+        // Returns the statistics of a column, false if it has none
+        bool GetColumnStats(int colNo, ColumnStats& where) const;
+
+        // Replaces the statistics of all the columns. The unique values of
+        // the attributes are set to the estimates of the statistics
+        void SetColumnStats(const ColumnStatsList& stats);
+
         // Returns a *copy* of the entire collection of attributes
         void GetAttributes(AttributeContainer &attsIn);
 
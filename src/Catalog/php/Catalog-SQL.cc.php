@@ -61,6 +61,15 @@ using namespace std;
         relID: INTEGER PRIMARY KEY, corresponds to CatalogRelations.relID
         attID: INTEGER corresponds to CatalogAttributes.attID,
 
+     CatalogColumnStats:
+        relID: INTEGER corresponds to CatalogRelations.relID,
+        colNo: INTEGER corresponds to CatalogAttributes.colNo,
+        numValues: INTEGER, number of non null values
+        numNulls: INTEGER,
+        minValue: INTEGER,
+        maxValue: INTEGER,
+        sketch: TEXT, HyperLogLog registers in hex
+
  */
 
 Catalog::Catalog() :
@@ -120,6 +129,18 @@ grokit\sql_statements_norez( <<<'EOT'
     FOREIGN KEY(relID) REFERENCES CatalogRelations(relID),
     FOREIGN KEY(attID) REFERENCES CatalogAttributes(colNo)
   );
+
+  CREATE TABLE IF NOT EXISTS CatalogColumnStats (
+    /* statistics collected when the relation is written (see ColumnStats.h) */
+    relID     INTEGER,
+    colNo     INTEGER,
+    numValues INTEGER,
+    numNulls  INTEGER,
+    minValue  INTEGER,
+    maxValue  INTEGER,
+    sketch    TEXT,
+    FOREIGN KEY(relID) REFERENCES CatalogRelations(relID)
+  );
 "
 EOT
 , [ ] );
@@ -275,9 +296,42 @@ grokit\sql_end_statement_table();
 ;
 
 
+    // get the column statistics, if any
+
+    ColumnStatsList curStats;
+<?  grokit\sql_statement_table(<<<'EOT'
+"
+  SELECT colNo, numValues, numNulls, minValue, maxValue, sketch
+  FROM CatalogColumnStats
+  WHERE relID=%d;
+"
+EOT
+, [
+  'statColNo' => 'int',
+  'statValues' => 'int',
+  'statNulls' => 'int',
+  'statMin' => 'int',
+  'statMax' => 'int',
+  'statSketch' => 'text',
+], [ '(*it)', ]);
+?>
+{
+      if (statColNo >= 0) {
+        if ((size_t) statColNo >= curStats.size())
+          curStats.resize(statColNo + 1);
+
+        ColumnStats& stats = curStats[statColNo];
+        stats.SetCounts(statValues, statNulls, statMin, statMax);
+        WARNINGIF(!stats.SketchFromString(statSketch),
+            "Invalid statistics for column %d of relation %s", statColNo, relName.c_str());
+      }
+    }<?  grokit\sql_end_statement_table(); ?>
+;
+
     // build the schema and add it to the catalog
     string nothing;
     Schema newSch(curAtts, relName, nothing, numTuples, clusterAtt);
+    newSch.SetColumnStats(curStats);
     schemas.Insert(newSch);
 
   }
@@ -368,6 +422,16 @@ grokit\sql_statements_norez(<<<'EOT'
 EOT
 , []);
 ?>
+;
+
+<?php
+grokit\sql_statements_norez(<<<'EOT'
+"
+  DELETE FROM CatalogColumnStats;
+"
+EOT
+, []);
+?>
 ;
 
     schemas.MoveToStart();
@@ -447,6 +511,32 @@ EOT
 <?  grokit\sql_parametric_end(); ?>
     }
 
+<?
+grokit\sql_statement_parametric_norez(<<<'EOT'
+"
+  INSERT INTO CatalogColumnStats(relID, colNo, numValues, numNulls, minValue, maxValue, sketch)
+  VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7)
+"
+EOT
+, ['int', 'int', 'int', 'int', 'int', 'int', 'text']);
+?>
+
+    for (int _colNo = 0; _colNo < attCont.Length(); _colNo++) {
+        ColumnStats stats;
+        if (!sch.GetColumnStats(_colNo, stats))
+            continue;
+
+        long int _values = stats.GetNumValues();
+        long int _nulls = stats.GetNumNulls();
+        long int _min = stats.GetMin();
+        long int _max = stats.GetMax();
+        string _sketch = stats.SketchToString();
+
+<?  grokit\sql_instantiate_parameters(['_relID', '_colNo', '_values', '_nulls', '_min', '_max', '(_sketch).c_str()']); ?>
+
+    }
+<?  grokit\sql_parametric_end(); ?>
+
     schemas.Advance();
     }
 <?php
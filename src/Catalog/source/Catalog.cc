@@ -339,6 +339,38 @@ void Catalog::RemoveSchema(std::string name) {
     SendUpdate();
 }
 
+bool Catalog::SetStatistics(string relName, long long int numTuples,
+        const ColumnStatsList& stats) {
+    {
+        // lock up
+        scoped_lock_t schemaGuard(schemaMutex);
+
+        if (!FindSchemaByName(relName))
+            return false;
+
+        Schema& schema = schemas.Current();
+        schema.SetNumTuples(numTuples);
+        schema.SetColumnStats(stats);
+    }
+
+    SaveCatalog();
+
+    SendUpdate();
+
+    return true;
+}
+
+bool Catalog::GetColumnStats(string relName, ColumnStatsList& where) {
+    // lock up
+    scoped_lock_t schemaGuard(schemaMutex);
+
+    if (!FindSchemaByName(relName))
+        return false;
+
+    where = schemas.Current().columnStats;
+    return true;
+}
+
 void Catalog::AddSchemaAlias(string alias, string table) {
 
     // lock
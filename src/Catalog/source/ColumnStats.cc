@@ -0,0 +1,143 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#include "ColumnStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+ColumnStats::ColumnStats():
+    numValues(0), numNulls(0), minValue(0), maxValue(0), sketch()
+{
+}
+
+void ColumnStats::Merge(const ColumnStats& other) {
+    if (other.numValues == 0) {
+        numNulls += other.numNulls;
+        return;
+    }
+
+    if (numValues == 0) {
+        numValues = other.numValues;
+        numNulls += other.numNulls;
+        minValue = other.minValue;
+        maxValue = other.maxValue;
+        sketch = other.sketch;
+        return;
+    }
+
+    // the registers merge exactly
+    if (sketch.empty() || other.sketch.empty()) {
+        sketch.clear();
+    } else {
+        for (int i = 0; i < SKETCH_SIZE; i++)
+            sketch[i] = max(sketch[i], other.sketch[i]);
+    }
+
+    numValues += other.numValues;
+    numNulls += other.numNulls;
+    minValue = min(minValue, other.minValue);
+    maxValue = max(maxValue, other.maxValue);
+}
+
+double ColumnStats::NullFraction() const {
+    uint64_t total = numValues + numNulls;
+    return total == 0 ? 0.0 : (double) numNulls / total;
+}
+
+uint64_t ColumnStats::EstimateDistinct() const {
+    if (numValues == 0)
+        return 0;
+
+    // no sketch, the values themselves are the upper bound
+    if (sketch.empty())
+        return numValues;
+
+    double m = SKETCH_SIZE;
+    double sum = 0.0;
+    int zeros = 0;
+    for (int i = 0; i < SKETCH_SIZE; i++) {
+        sum += ldexp(1.0, -sketch[i]);
+        if (sketch[i] == 0)
+            zeros++;
+    }
+
+    double alpha = 0.7213 / (1.0 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+
+    // small cardinalities are better estimated by linear counting
+    if (estimate <= 2.5 * m && zeros > 0)
+        estimate = m * log(m / zeros);
+
+    uint64_t distinct = (uint64_t) (estimate + 0.5);
+    if (distinct < 1)
+        distinct = 1;
+    if (distinct > numValues)
+        distinct = numValues;
+
+    // and there cannot be more than the integers in the range
+    uint64_t range = (uint64_t) maxValue - (uint64_t) minValue;
+    if (range < distinct - 1)
+        distinct = range + 1;
+
+    return distinct;
+}
+
+void ColumnStats::SetCounts(uint64_t _numValues, uint64_t _numNulls, int64_t _minValue, int64_t _maxValue) {
+    numValues = _numValues;
+    numNulls = _numNulls;
+    minValue = _minValue;
+    maxValue = _maxValue;
+}
+
+string ColumnStats::SketchToString() const {
+    static const char hexDigits[] = "0123456789abcdef";
+
+    string ret;
+    ret.reserve(2 * sketch.size());
+    for (uint8_t reg : sketch) {
+        ret.push_back(hexDigits[reg >> 4]);
+        ret.push_back(hexDigits[reg & 0xf]);
+    }
+
+    return ret;
+}
+
+bool ColumnStats::SketchFromString(const char* text) {
+    sketch.clear();
+    if (text == NULL || *text == '\0')
+        return true;
+
+    vector<uint8_t> regs(SKETCH_SIZE);
+    for (int i = 0; i < SKETCH_SIZE; i++) {
+        char pair[3] = { text[0], text[0] == '\0' ? '\0' : text[1], '\0' };
+        char* end;
+        long val = strtol(pair, &end, 16);
+        if (end != pair + 2)
+            return false;
+
+        regs[i] = (uint8_t) val;
+        text += 2;
+    }
+
+    if (*text != '\0')
+        return false;
+
+    sketch.swap(regs);
+    return true;
+}
@@ -27,7 +27,7 @@ using namespace std;
 Schema::Schema(AttributeContainer &_atts, string _relName, string _metadataPath,
         long int _numTuples, Attribute & _clusterAtt):
     relName(_relName), metadataPath(_metadataPath), numTuples(_numTuples), 
-    clusterAttribute()
+    clusterAttribute(), columnStats()
     {
         _clusterAtt.CopyTo(clusterAttribute);
         // suck in all the attributes
@@ -303,6 +303,8 @@ void Schema::swap(Schema &with) {
     with.numTuples = auxTuples;
 
     clusterAttribute.swap(with.clusterAttribute);
+
+    columnStats.swap(with.columnStats);
 }
 
 void Schema::CopyTo(Schema &here) {
@@ -324,6 +326,24 @@ void Schema::CopyTo(Schema &here) {
     here.relName = relName;
     here.metadataPath = metadataPath;
     here.numTuples = numTuples;
+    here.columnStats = columnStats;
+}
+
+bool Schema::GetColumnStats(int colNo, ColumnStats& where) const {
+    if (colNo < 0 || (size_t) colNo >= columnStats.size() || columnStats[colNo].IsEmpty())
+        return false;
+
+    where = columnStats[colNo];
+    return true;
+}
+
+void Schema::SetColumnStats(const ColumnStatsList& stats) {
+    columnStats = stats;
+
+    for (size_t i = 0; i < columnStats.size(); i++) {
+        if (!columnStats[i].IsEmpty() && FindAttByIndex(i))
+            attributes.Current().SetUniques(columnStats[i].EstimateDistinct());
+    }
 }
 
 void Schema::toJson(Json::Value & dest) const {
@@ -35,6 +35,7 @@ final class NodeKey {
     const SLOT          = 'slot';
     const STATE         = 'state';
     const ALIAS         = 'alias';
+    const DISTINCT      = 'distinct';
 
     // Hold-overs from old parser
     const C_EXPR        = 'c_expr';
@@ -21,10 +21,14 @@ namespace grokit {
 
         private $type = null;
 
-        public function __construct( $name, $type_ast, $slot ) {
+        // Estimate of the number of distinct values, null if unknown.
+        private $distinct = null;
+
+        public function __construct( $name, $type_ast, $slot, $distinct = null ) {
             $this->name = $name;
             $this->type_ast = $type_ast;
             $this->slot = $slot;
+            $this->distinct = $distinct;
         }
 
         public function __toString() {
@@ -54,6 +58,10 @@ namespace grokit {
             return $this->slot;
         }
 
+        public function distinct() {
+            return $this->distinct;
+        }
+
         // Force the evaluation of the type.
         public function evalType() {
             parseType($this->type_ast);
@@ -64,11 +72,11 @@ namespace grokit {
         // Mapping of attribute name to information
         private static $att_map = [];
 
-        public static function addAttribute( $name, $type, $slot ) {
+        public static function addAttribute( $name, $type, $slot, $distinct = null ) {
             grokit_logic_error_if(isset(self::$att_map[$name]),
                 'Attempting to add attribute ' . $name . ' twice');
 
-            $info = new AttributeInfo($name, $type, $slot);
+            $info = new AttributeInfo($name, $type, $slot, $distinct);
             self::$att_map[$name] = $info;
         }
 
@@ -103,6 +111,32 @@ namespace grokit {
         }
     }
 
+    /*
+     * Estimates of the number of distinct values of the inputs of the GLA
+     * being looked up, by input name. Only the inputs that are attributes
+     * read from a column with statistics have one.
+     */
+    class InputStatistics {
+        private static $distinct = [];
+
+        public static function set( array $distinct ) {
+            self::$distinct = $distinct;
+        }
+
+        // Estimate of the number of distinct combinations of the inputs,
+        // null if one of them has no estimate.
+        public static function distinct( array $names ) {
+            $ret = 1;
+            foreach( $names as $name ) {
+                if( !array_key_exists($name, self::$distinct) )
+                    return null;
+                $ret *= self::$distinct[$name];
+            }
+
+            return $ret;
+        }
+    }
+
 }
 namespace {
     // Dispatching function so we can change the implementation later without
@@ -112,8 +146,22 @@ namespace {
         return \grokit\AttributeManager::lookupAttribute($name);
     }
 
-    function addAttribute( $name, $type, $slot ) {
-        \grokit\AttributeManager::addAttribute($name, $type, $slot);
+    function addAttribute( $name, $type, $slot, $distinct = null ) {
+        \grokit\AttributeManager::addAttribute($name, $type, $slot, $distinct);
+    }
+
+    // Initial size for a hash table keyed on the given inputs of a GLA: the
+    // estimated number of distinct keys, within [$default, $max]. Without an
+    // estimate, $default.
+    // Every worker thread has its own state, and only the one they are merged
+    // into ends up with all the keys, so the estimate is only a hint and the
+    // cap is kept low; the tables grow past it when needed.
+    function estimated_distinct( array $names, $default, $max = 65536 ) {
+        $distinct = \grokit\InputStatistics::distinct($names);
+        if( is_null($distinct) )
+            return $default;
+
+        return intval(min(max($distinct, $default), $max));
     }
 
     function is_attribute( $obj ) {
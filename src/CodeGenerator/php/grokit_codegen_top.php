@@ -246,10 +246,11 @@ EOT
         $name = ast_get($ast, NodeKey::NAME);
         $type = ast_get($ast, NodeKey::TYPE);
         $slot = ast_get($ast, NodeKey::SLOT);
+        $distinct = ast_has($ast, NodeKey::DISTINCT) ? ast_get($ast, NodeKey::DISTINCT) : null;
 
         // Give entire type AST to attribute manager, it will be parsed
         // only when needed.
-        addAttribute( $name, $type, $slot );
+        addAttribute( $name, $type, $slot, $distinct );
     }
 
     function parseProgramAttributes( $ast ) {
@@ -372,7 +373,20 @@ EOT
                 $reqStates[$val->name()] = $val->type();
             }
 
+            // Let the GLA size its hash tables from the inputs read straight
+            // from attributes with statistics
+            $distinct = [];
+            foreach( $exprs as $eName => $expr ) {
+                if( AttributeManager::attributeExists($expr->value()) ) {
+                    $attDistinct = lookupAttribute($expr->value())->distinct();
+                    if( !is_null($attDistinct) )
+                        $distinct[$eName] = $attDistinct;
+                }
+            }
+
+            InputStatistics::set($distinct);
             $gla = $glaSpec->apply($exprs, extractTypes($output), $reqStates);
+            InputStatistics::set([]);
             //fwrite(STDERR, "GLA outputs: " . print_r($gla->output()) . PHP_EOL);
             correlateAttributes($output, $gla->output());
 
@@ -746,6 +746,8 @@ namespace grokit {
         private $pre_chunk = false;
         private $chunk_boundary = false;
         private $intermediates = false;
+        private $batch = false;
+        private $partitioned_merge = false;
 
         public function __construct( $hash, $name, $value, array $args, array $oArgs ) {
             $args['req_states'] = $oArgs[3];
@@ -796,6 +798,18 @@ namespace grokit {
             if( array_key_exists( 'post_finalize', $args ) ) {
                 $this->post_finalize = $args['post_finalize'];
             }
+
+            // GLAs with batch support provide AddItems(n, in1[], in2[], ...),
+            // or AddItems(n) if batch is 'count' (only the number of tuples)
+            if( array_key_exists( 'batch', $args ) ) {
+                $this->batch = $args['batch'];
+            }
+
+            // GLAs with partitioned merge provide MergePartition(part, nParts, other)
+            // and FinishMerge(other)
+            if( array_key_exists( 'partitioned_merge', $args ) ) {
+                $this->partitioned_merge = $args['partitioned_merge'];
+            }
         }
 
         public function summary() {
@@ -809,6 +823,8 @@ namespace grokit {
             $ret['post_finalize'] = $this->post_finalize;
             $ret['chunk_boundary'] = $this->chunk_boundary;
             $ret['intermediates'] = $this->intermediates;
+            $ret['batch'] = $this->batch;
+            $ret['partitioned_merge'] = $this->partitioned_merge;
 
             return $ret;
         }
@@ -823,6 +839,8 @@ namespace grokit {
         public function pre_chunk() { return $this->pre_chunk; }
         public function chunk_boundary() { return $this->chunk_boundary; }
         public function intermediates() { return $this->intermediates; }
+        public function batch() { return $this->batch; }
+        public function partitioned_merge() { return $this->partitioned_merge; }
 
         /*
          * $outputs should be an array of TypeInfo objects giving the types of
@@ -24,6 +24,7 @@
 #include <ctime>
 #include <cstdio>
 #include <cstdlib>
+#include <climits>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <dlfcn.h>
@@ -65,6 +66,19 @@ class CodeLoaderImp: public EventProcessorImp {
         // called by Load before loading the main library
         void LoadDependencies(std::string dirName);
 
+        // map with already loaded waypoint modules. The key is the path of
+        // the module in the cache of compiled modules. The path is content
+        // addressed so a module that is already loaded can be reused as is
+        std::map<std::string, void*> moduleMap;
+
+        // reads the module of each waypoint from the file Modules in dirName
+        // returns false if the file does not exist (code compiled as a single
+        // Generated.so)
+        bool ReadModules(std::string dirName, std::map<std::string, std::string>& wpToModule);
+
+        // opens the module (if not already open) and returns its handle
+        void* LoadModule(std::string fileName);
+
     public:
         /** Need the path to the source tree so that we can load the correct code.
           Need to know where to send the generated message (coordinator)
@@ -23,11 +23,19 @@
 
 using namespace std;
 
-/** This version of the code loader loads the code from the Generated.so library
- * previously generated by the code generator. The path to the library needs to
- * be known.
+/** This version of the code loader loads the code from the modules (one
+ * shared object per waypoint) previously generated by the code generator.
+ * The modules are listed in the file Modules of the directory of the code.
+ * If the file is not there, the code is loaded from the Generated.so library.
  **/
 
+// the name of a file in the directory of the code
+static string CodeFile(string dirName, string fileName){
+    if (!dirName.empty() && dirName[dirName.size()-1] != '/')
+        dirName += '/';
+    return dirName + fileName;
+}
+
 
 // constructor for the implementation class
 CodeLoaderImp::CodeLoaderImp(const char* _srcDir, EventProcessor& _coordinator):
@@ -56,14 +64,14 @@ MESSAGE_HANDLER_DEFINITION_END
 
 
 /** Function to load extra dependencies.
-  They are read from file Generated/ExtraLibs
+  They are read from file ExtraLibs of the directory of the code
 
 */
 void CodeLoaderImp::LoadDependencies(string dirName){
-    string modFname = /*dirName +*/ "./Generated/ExtraLibs";
+    string modFname = CodeFile(dirName, "ExtraLibs");
 
     // read the libs from file
-    ifstream file("./Generated/ExtraLibs", ifstream::in);
+    ifstream file(modFname.c_str(), ifstream::in);
     while (file.good()){
         string lib;
         file >> lib;
@@ -85,22 +93,72 @@ void CodeLoaderImp::LoadDependencies(string dirName){
     file.close();
 }
 
-void CodeLoaderImp::Load(string dirName, WayPointConfigurationList &configMessages){
+bool CodeLoaderImp::ReadModules(string dirName, map<string, string>& wpToModule){
+    string modFname = CodeFile(dirName, "Modules");
+    ifstream file(modFname.c_str(), ifstream::in);
+    if (!file.good())
+        return false;
 
+    while (file.good()){
+        string wpname, module;
+        file >> wpname >> module;
 
-    void *module = NULL;
+        if (wpname.empty())
+            continue;
 
-    // make the file name for our module
-    string modFname = /*dirName +*/ "./Generated/Generated.so";
+        wpToModule[wpname] = CodeFile(dirName, module);
+    }
 
-    LoadDependencies(dirName);
+    file.close();
+    return true;
+}
+
+void* CodeLoaderImp::LoadModule(string fileName){
+    // the modules are links in the cache, resolve them so that
+    // the same code is loaded only once
+    char resolved[PATH_MAX];
+    if (realpath(fileName.c_str(), resolved) != NULL)
+        fileName = resolved;
 
-    // open up the module, lazy mode
-    module = dlopen(modFname.c_str(), RTLD_LAZY);
+    map<string, void*>::iterator it = moduleMap.find(fileName);
+    if (it != moduleMap.end())
+        return it->second;
+
+    // open up the module, lazy mode. The symbols are global so that the
+    // inline and template statics of the libraries (and the thread local
+    // state they keep) are shared by all the modules instead of each module
+    // having its own copy. The work functions have unique names
+    void* module = dlopen(fileName.c_str(), RTLD_LAZY | RTLD_GLOBAL);
 
     if (module == NULL){
         FATAL("Unable to load generated code from file %s!\nThe error is %s.\n",
-                modFname.c_str(), dlerror());
+                fileName.c_str(), dlerror());
+    }
+
+    moduleMap[fileName] = module;
+    return module;
+}
+
+void CodeLoaderImp::Load(string dirName, WayPointConfigurationList &configMessages){
+
+    LoadDependencies(dirName);
+
+    map<string, string> wpToModule;
+    bool perWaypoint = ReadModules(dirName, wpToModule);
+
+    void *module = NULL;
+
+    if (!perWaypoint){
+        // make the file name for our module
+        string modFname = CodeFile(dirName, "Generated.so");
+
+        // open up the module, lazy mode
+        module = dlopen(modFname.c_str(), RTLD_LAZY);
+
+        if (module == NULL){
+            FATAL("Unable to load generated code from file %s!\nThe error is %s.\n",
+                    modFname.c_str(), dlerror());
+        }
     }
 
     // now, we will add the code for all our waypoints!
@@ -130,6 +188,14 @@ void CodeLoaderImp::Load(string dirName, WayPointConfigurationList &configMessag
                 funName += "_";
                 funName += wpname;
 
+                // the functions of the waypoint live in its own module
+                if (perWaypoint){
+                    map<string, string>::iterator it = wpToModule.find(wpname);
+                    FATALIF(it == wpToModule.end(), "No module was generated for waypoint %s",
+                            wpname.c_str());
+                    module = LoadModule(it->second);
+                }
+
                 wFunc = (WorkFunc) dlsym(module, funName.c_str());
                 FATALIF(wFunc == NULL, "Unable to obtain function %s from module!", funName.c_str());
 #ifdef DEBUG
@@ -21,6 +21,7 @@
 #include "RawStorageDesc.h"
 #include "FileMetadata.h"
 #include "DistributedCounter.h"
+#include "ColumnCodec.h"
 #include <functional>
 
 class MMappedStorage;
@@ -62,7 +63,9 @@ public:
     // compression happens in a single go (no incremental compression)
     // the storage state cannot be changed after this
     // if deleteDecompress is true, the decompressed version should be eliminated
-    void Compress(bool deleteDecompressed);
+    // codec is the preferred compression method (see ColumnCodec.h). Columns
+    // that are already compressed (read compressed from the disk) stay as they are
+    void Compress(const ColumnCodec& codec, bool deleteDecompressed);
 
     // give access to the compressed data to hte caller and put a
     // description of where the data is in "where". Returns the size in
@@ -73,6 +76,7 @@ public:
     off_t GetCompressedSizeBytes();
     off_t GetCompressedSizePages();
     bool GetIsCompressed();
+    ColumnCodecID GetCodec();
 
 
     // access to uncompressed data. Should return the size of
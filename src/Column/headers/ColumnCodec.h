@@ -0,0 +1,82 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef _COLUMN_CODEC_H_
+#define _COLUMN_CODEC_H_
+
+#include <cinttypes>
+
+/** Codecs used to compress the columns before they go to disk.
+
+    The codec of a column is decided when the chunk is written (based on
+    the type of the column) and kept in the ColumnMetaData so the reader
+    knows how to deal with the compressed part.
+
+    Except for QuickLZ (the original format, a stream with its own
+    headers), the compressed data is a sequence of self describing blocks
+    of at most COMPRESSION_UNIT decompressed bytes:
+
+    | header | payload |
+
+    The header says how the block was encoded so the codec of the column
+    is only a hint for the writer: a block that does not compress is
+    stored as is and the integer codec picks frame of reference or delta
+    encoding for each block.
+*/
+
+enum ColumnCodecID {
+    COLUMN_CODEC_NONE = 0,    // not compressed
+    COLUMN_CODEC_QUICKLZ = 1, // QuickLZ stream, what we always had
+    COLUMN_CODEC_LZ = 2,      // fast LZ77 on bytes (LZ4 like)
+    COLUMN_CODEC_INTEGER = 3  // frame of reference or delta + bit packing
+};
+
+// The codec of a physical column
+struct ColumnCodec {
+    ColumnCodecID id;
+    int width; // size in bytes of the values (integer codec only)
+    bool isSigned; // are the values signed (integer codec only)
+
+    ColumnCodec(ColumnCodecID _id = COLUMN_CODEC_NONE, int _width = 0, bool _isSigned = false):
+        id(_id), width(_width), isSigned(_isSigned) {}
+};
+
+// name of the codec, for the logs
+const char* ColumnCodecName(ColumnCodecID id);
+
+/** Maximum size of the compressed form of size bytes, when they come in
+    numPieces pieces chopped in blocks separately (each piece can end with
+    a partial block). Does not apply to QuickLZ */
+uint64_t ColumnCodecBound(uint64_t size, uint64_t numPieces = 1);
+
+/** Compresses size bytes (at most COMPRESSION_UNIT) into one block.
+    dest needs room for ColumnCodecBound(size) bytes.
+
+    Returns the size of the block.
+*/
+uint64_t ColumnCodecCompressBlock(const ColumnCodec& codec, const char* src,
+        uint64_t size, char* dest);
+
+// size of the block that starts at src (header included)
+uint64_t ColumnCodecBlockSize(const char* src);
+
+// decompressed size of the block that starts at src
+uint64_t ColumnCodecBlockDecompressedSize(const char* src);
+
+/** Decompresses the block that starts at src in dest. Returns the number
+    of bytes produced. Fails if the block is corrupt. */
+uint64_t ColumnCodecDecompressBlock(const char* src, char* dest);
+
+#endif // _COLUMN_CODEC_H_
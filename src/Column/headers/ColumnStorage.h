@@ -19,6 +19,7 @@
 
 #include "RawStorageDesc.h"
 #include "DistributedCounter.h"
+#include "ColumnCodec.h"
 
 #include <utility>
 
@@ -102,7 +103,7 @@ public:
 
 	// API to compress and get access to the raw data. This is used by the IO subsystem
 	// see Column.h for the explanation of how they behave
-	virtual void Compress(bool deleteDecompressed)=0;
+	virtual void Compress(const ColumnCodec& codec, bool deleteDecompressed)=0;
 
 	// Get the handle of the compressed storage
 	virtual void GetCompressed(RawStorageList& where)=0;
@@ -125,6 +126,9 @@ public:
 	// If this storage is compressed, which is true if we receive compressed storage from outside
 	virtual bool GetIsCompressed () = 0;
 
+	// codec of the compressed data
+	virtual ColumnCodecID GetCodec () = 0;
+
 	// get if it is readonly or writeonly
 	virtual bool IsWriteMode () = 0;
 
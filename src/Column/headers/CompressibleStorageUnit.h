@@ -19,6 +19,7 @@
 
 #include <cstring>
 #include <cstdlib>
+#include <atomic>
 
 #include <iostream>
 
@@ -26,6 +27,8 @@
 #include "Errors.h"
 #include "Constants.h"
 #include "StorageUnit.h"
+#include "DistributedCounter.h"
+#include "ColumnCodec.h"
 
 // Compression algorithm
 #define QLZ_COMPRESSION_LEVEL 3
@@ -33,38 +36,51 @@
 #define QLZ_EXTRA_SPACE 1000 /** extra space qlz needs to compress */
 #include "quicklz.h"
 
-//#define COMPRESS_ALL_AT_ONCE 1
-
 // this structure is used by the mmapped storage to store all of its chunks of memory in compressed form
 // which is received from user
+//
+// The compressed buffer is shared by all the shallow copies of the
+// storage (the copies are made with memmove so the sharing is done
+// through the Shared structure). The data is decompressed only once, by
+// the first copy that needs it, in the buffer of the sister StorageUnit.
 struct CompressedStorageUnit {
 
     private:
-        // start location of decompressed data
+        // bookkeeping shared by all the copies
+        struct Shared {
+            DistributedCounter refCount; // number of copies, the lock protects the decompression
+            std::atomic<bool> decompressed; // is the sister storage unit filled in?
+
+            Shared(): refCount(1), decompressed(false) {}
+        };
+
+        // start location of decompressed data (owned by the sister storage unit)
         char* decompressedBytes;
-        uint64_t nextDecompress; // last byte decompressed in decompressedBytes buffer
 
         // start location of compressed data
         char *compressedBytes;
-        uint64_t nextCompress; // last byte compressed in compressedBytes buffer up to which we are done with decompression
+        uint64_t nextCompress; // last byte compressed in compressedBytes buffer
 
         // total decompressed size
         uint64_t decompressedSize;
         // total compressed size
         uint64_t compressedSize;
 
-        // how much we decompressed in last call
-        uint64_t lastDecompressedLength;
+        // how the data is compressed
+        ColumnCodec codec;
 
-        // state needs to be passed to compress and decompress quicklz functions
+        // state needs to be passed to compress quicklz functions
         qlz_state_compress *state_compress;
 
-        // These are states used by quicklz compresser and decompresser
-        qlz_state_decompress *state_decompress;
+        // NULL if there is no compressed data
+        Shared* shared;
 
         // numa node
         uint64_t numa;
 
+        // decrements the reference count and frees the compressed data if last
+        void Clean();
+
     public:
 
         /// -------------------- Functions ------------------//
@@ -72,17 +88,19 @@ struct CompressedStorageUnit {
         // numa not needed here since this is supposed to be used only for swapping
         CompressedStorageUnit ();
 
-        // decompressed data constructor
-        CompressedStorageUnit(uint64_t _dataSize, uint64_t _numa = 0);
+        // decompressed data constructor. The data comes in _numUnits storage
+        // units, each compressed separately
+        CompressedStorageUnit(uint64_t _dataSize, uint64_t _numUnits, const ColumnCodec& _codec, uint64_t _numa = 0);
         // compressed data constructor, where is the sister storage unit
         // that accesses teh decompressed data
-        CompressedStorageUnit(char* _data, uint64_t _dataSize, uint64_t _compressedSize, StorageUnit& where, uint64_t _numa = 0);
+        CompressedStorageUnit(char* _data, uint64_t _dataSize, uint64_t _compressedSize,
+                ColumnCodecID _codec, StorageUnit& where, uint64_t _numa = 0);
 
-        // states are local to object and are created and destroyed with object.
-        // in case of deep and shallow copies, they are created new and not copied
+        // the compression state is local to object and is created and destroyed with object.
+        // in case of shallow copies, it is created new and not copied
         ~CompressedStorageUnit () {
-            if (state_decompress) free(state_decompress), state_decompress = NULL;
             if (state_compress) free(state_compress), state_compress = NULL;
+            Clean();
         }
 
         void swap (CompressedStorageUnit &withMe);
@@ -90,45 +108,31 @@ struct CompressedStorageUnit {
         // funciton to add info on raw storage of compressed data to a list
         void AddCompressedRawStorage(RawStorageList& out);
 
-        // Compress a Storage Unit and add it to compressed
-        void CompressThisStorageUnit(StorageUnit& unit);
-
-        // decompress at least up to given position, but actual decompression could be much
-        // more depending on decompression algorithm used by quicklz stream decompression
-        uint64_t DecompressUpTo(uint64_t decompress_position);
+        // Compress the first size bytes of a Storage Unit and add it to compressed
+        void CompressThisStorageUnit(StorageUnit& unit, uint64_t size);
 
-        // same function as above but the decompression is always at the
-        // beggining of the buffer. The new decompressed data overrides the
-        // old one
-        // Note: the caller has to know that we always write from the
-        // beggining of the buffer, not continuously
-        uint64_t DecompressInPlace(uint64_t posToStartFrom, uint64_t decompress_position);
+        // decompress everything in the sister storage unit. Only the first call
+        // does any work, the others wait for it to finish
+        void Decompress();
 
         // does a simple copy
         void copy (CompressedStorageUnit &fromMe);
 
-        // does a deep copy
-        //void Detach(CompressedStorageUnit &withMe);
-        void CreateDeepCopy(CompressedStorageUnit &withMe);
-
-        // frees the memory pointed to
-        void Kill ();
-
-
         // Get the size of original decompressed data reading the header info in the compressed data
         uint64_t GetDecompressedSize();
 
         // Get the current compressed size reading the header of compressed data
         uint64_t GetCompressedSize();
 
+        ColumnCodecID GetCodec(){ return codec.id; }
+
         bool GetIsCompressed(){ return compressedSize>0; }
 };
 
 //////////////////// inline Definitions ///////////////////////////////
 
-// This gives raw handle of data to the external world and it may happen that this raw
-// data storage is used to create new Column and in that case both column will destory
-// the storage and hence double free !! Take care.
+// This gives raw handle of data to the external world. The data stays
+// valid as long as one of the copies is alive
 inline 	void CompressedStorageUnit::AddCompressedRawStorage(RawStorageList& out){
     // nextCompressed has the size of compressed not compressedSize
     // shich should be 0
@@ -137,50 +141,53 @@ inline 	void CompressedStorageUnit::AddCompressedRawStorage(RawStorageList& out)
 }
 
 // For default constructor as below, it is very important to set vars to NULL, otherwise
-// they all will be copied in shallow/deep copy unnecessarily
+// they all will be copied in shallow copy unnecessarily
 inline
-CompressedStorageUnit::CompressedStorageUnit() : decompressedBytes(NULL), nextDecompress(0),
+CompressedStorageUnit::CompressedStorageUnit() : decompressedBytes(NULL),
     compressedBytes(NULL), nextCompress(0), decompressedSize(0), compressedSize(0),
-    state_compress(NULL), state_decompress(NULL){}
-
-    inline /* data is decompressed, we'll compress */
-    CompressedStorageUnit::CompressedStorageUnit(uint64_t _decompressedSize, uint64_t _numa):
-        decompressedBytes(NULL),
-        nextDecompress(0),
-        compressedBytes((char*) mmap_alloc(_decompressedSize + QLZ_EXTRA_SPACE, _numa)),
-        nextCompress(0),
-        decompressedSize(_decompressedSize),
-        compressedSize(0),
-        state_compress((qlz_state_compress *)malloc(sizeof(qlz_state_compress))),
-        state_decompress(NULL),
-        numa(_numa)
+    codec(), state_compress(NULL), shared(NULL), numa(0){}
+
+inline /* data is decompressed, we'll compress */
+CompressedStorageUnit::CompressedStorageUnit(uint64_t _decompressedSize, uint64_t _numUnits, const ColumnCodec& _codec, uint64_t _numa):
+    decompressedBytes(NULL),
+    compressedBytes(NULL),
+    nextCompress(0),
+    decompressedSize(_decompressedSize),
+    compressedSize(0),
+    codec(_codec),
+    state_compress(NULL),
+    shared(new Shared),
+    numa(_numa)
 {
-    // zero out the state_compress
-    memset(state_compress, 0, sizeof(qlz_state_compress));
+    if (codec.id == COLUMN_CODEC_QUICKLZ){
+        compressedBytes = (char*) mmap_alloc(decompressedSize + QLZ_EXTRA_SPACE, numa);
+        state_compress = (qlz_state_compress *)malloc(sizeof(qlz_state_compress));
+        // zero out the state_compress
+        memset(state_compress, 0, sizeof(qlz_state_compress));
+    } else {
+        compressedBytes = (char*) mmap_alloc(ColumnCodecBound(decompressedSize, _numUnits), numa);
+    }
 }
 
 inline /** data is compressed */
 CompressedStorageUnit::CompressedStorageUnit(char* _data, uint64_t _decompressedSize,
-        uint64_t _compressedSize, StorageUnit& where, uint64_t _numa):
+        uint64_t _compressedSize, ColumnCodecID _codec, StorageUnit& where, uint64_t _numa):
     decompressedBytes((char*) mmap_alloc(_decompressedSize, _numa)),
-    nextDecompress(0),
     compressedBytes(_data),
-    nextCompress(0),
+    nextCompress(_compressedSize),
     decompressedSize(_decompressedSize),
-    //decompressedSize(qlz_size_decompressed(_data)),
     compressedSize(_compressedSize),
+    codec(_codec),
     state_compress(NULL),
-    state_decompress((qlz_state_decompress *)malloc(sizeof(qlz_state_decompress))),
+    shared(new Shared),
     numa(_numa)
 {
+    FATALIF(codec.id == COLUMN_CODEC_NONE, "Compressed column without a codec");
+
     // create sister storage unit
     where.bytes=decompressedBytes;
     where.start=0;
     where.end=decompressedSize - 1;
-    // zero out the state_compress
-    memset(state_decompress, 0, sizeof(qlz_state_decompress));
-
-    assert(decompressedSize == qlz_size_decompressed(_data));
 }
 
 inline
@@ -202,188 +209,102 @@ void CompressedStorageUnit::swap (CompressedStorageUnit &withMe) {
 }
 
 inline
-void CompressedStorageUnit::CreateDeepCopy(CompressedStorageUnit &withMe) {
-
-    // create shallow copy of everything, then correct desired one's
-    memmove (&withMe, this, sizeof (CompressedStorageUnit));
-
-    // create a new state (no need to deep copy), if previous one existed
-    if (state_decompress) {
-        withMe.state_decompress = (qlz_state_decompress *)malloc(sizeof(qlz_state_decompress));
-        memmove(withMe.state_decompress, state_decompress, sizeof(qlz_state_decompress));
-    }
-
-    // create a new state (no need to deep copy), if previous one existed
-    if (state_compress) {
-        withMe.state_compress = (qlz_state_compress *)malloc(sizeof(qlz_state_compress));
-        memmove(withMe.state_compress, state_compress, sizeof(qlz_state_decompress));
-    }
-
-    // create a deep copy of decompressed bytes
-    if (decompressedBytes) {
-        // If we have compressed data, we always allocate decompressed bytes in advance
-        withMe.decompressedBytes = (char*) mmap_alloc (decompressedSize, withMe.numa);
-
-        // We don't need to copy decompressed bytes because it may be partially decompressed.
-        // In case it is already fully decompressed, probably we might want to pay cost of
-        // decompressing it again instead of copy operation below.
-        // And for decompress in place, we dont need this copy anyway since it is always
-        // recomputed, and mostly we will be decompressing in place in future.
-        //memmove(withMe.decompressedBytes, decompressedBytes, nextDecompress);
-
-        // reset the variables so that decompression can start again
-        withMe.nextDecompress = 0;
-        withMe.nextCompress = 0;
-        withMe.lastDecompressedLength = 0;
-    }
-
-    // create a deep copy of compressed bytes
-    if (compressedBytes) {
-        withMe.compressedBytes = (char*) mmap_alloc (decompressedSize+QLZ_EXTRA_SPACE, withMe.numa);
-        memmove(withMe.compressedBytes, compressedBytes, nextCompress);
+void CompressedStorageUnit::Clean() {
+    if (shared != NULL && shared->refCount.Decrement(1) == 0){
+        // last copy, the decompressed bytes are taken over by StorageUnit
+        delete shared;
+        if (compressedBytes != NULL)
+            mmap_free(compressedBytes);
     }
+    shared = NULL;
+    compressedBytes = NULL;
 }
 
-// This works in streaming mode internally, see quicklz.h flags
 inline
-uint64_t CompressedStorageUnit::DecompressUpTo(uint64_t decompress_position) {
-    // we assume that the decompression process proceeds linearly and
-    // does not get restarted
-    FATALIF( nextCompress==0 && nextDecompress!=0, "The decompression process is not linear");
-
-    // we go in a loop until we stream-decompressed enough
-    while (decompress_position > nextDecompress){
-        uint64_t csize = qlz_size_compressed(compressedBytes+nextCompress);
-
-        nextDecompress += qlz_decompress(compressedBytes+nextCompress,
-                decompressedBytes+nextDecompress,
-                state_decompress);
-        nextCompress+=csize;
-    }
-
-    return nextDecompress;
-}
+void CompressedStorageUnit::Decompress() {
+    // fast path, somebody did the work already
+    if (shared == NULL || shared->decompressed.load(std::memory_order_acquire))
+        return;
+
+    shared->refCount.Lock();
+    if (!shared->decompressed.load(std::memory_order_relaxed)){
+        uint64_t nextDecompress = 0; // next byte to decompress in decompressedBytes
+        uint64_t nextCompr = 0; // next block in compressedBytes
+
+        if (codec.id == COLUMN_CODEC_QUICKLZ){
+            // the state is too big for the stack
+            qlz_state_decompress* state =
+                (qlz_state_decompress *)malloc(sizeof(qlz_state_decompress));
+            memset(state, 0, sizeof(qlz_state_decompress));
+
+            while (nextDecompress < decompressedSize){
+                uint64_t csize = qlz_size_compressed(compressedBytes+nextCompr);
+                nextDecompress += qlz_decompress(compressedBytes+nextCompr,
+                        decompressedBytes+nextDecompress, state);
+                nextCompr += csize;
+            }
+
+            free(state);
+        } else {
+            while (nextDecompress < decompressedSize){
+                FATALIF(nextCompr >= compressedSize, "Compressed column is truncated");
+                FATALIF(nextDecompress + ColumnCodecBlockDecompressedSize(compressedBytes+nextCompr) > decompressedSize,
+                        "Compressed column decompresses past its size");
+                nextDecompress += ColumnCodecDecompressBlock(compressedBytes+nextCompr,
+                        decompressedBytes+nextDecompress);
+                nextCompr += ColumnCodecBlockSize(compressedBytes+nextCompr);
+            }
+        }
 
-// This works in streaming mode internally, see quicklz.h flags
-inline
-uint64_t CompressedStorageUnit::DecompressInPlace(uint64_t posToStartFrom, uint64_t decompress_position) {
+        FATALIF(nextDecompress != decompressedSize,
+                "Compressed column has %lu bytes instead of %lu", nextDecompress, decompressedSize);
 
-    // In case we restart the iteration from start, we need to reset all variables.
-    if (posToStartFrom == 0) {
-        nextDecompress = 0;
-        nextCompress = 0;
-        lastDecompressedLength = 0;
+        shared->decompressed.store(true, std::memory_order_release);
     }
-
-    // Compute the last portion of buffer length which is already decompressed, but was not
-    // used in last shot. We need to keep things contiguous starting from posToStartFrom.
-    // We will start decompressing from startbuffer + dNext, since we already copied up to dNext
-    // in the start decompressed buffer. SO overall, just copy last unused portion to the start
-    // and start decompressing after that.
-    uint64_t dNext = nextDecompress - posToStartFrom;
-
-
-    // If it is positive amount, do the copy. It should not be negative until posToStart takes
-    // sudden forward jump arbitrarily (which could be the case in deep copy where we assume
-    // nothing is decompressed, but to user he has to start from posToStart, for us it is a
-    // forward jump). There should not be case where it takes backward jump, because in that case
-    // dNext will be too high, and our assumption is that it will not be high (we only are supposed
-    // to copy last remaining portion). If it is too high, it may exceed the start point and hence
-    // corruption !!
-    if (dNext > 0) {
-
-        // If this is not the case, our source will go beyond the start of decompressed buffer. In theory
-        // check should be (lastDecompressedLength/2 > dNext), since we are using memcpy, and hence source
-        // and destination should not overlap. This will fail only if posToStart takes back jump, which is
-        // not possible since all iterators ensures it.
-        assert(lastDecompressedLength > dNext);
-
-        char* source = decompressedBytes + lastDecompressedLength - dNext;
-        // copy the last remaining portion of data to create continuous pool
-        // As we see, source and destination overlap here and it is recommended
-        // to use memmove for those cases, but I assume it should not be problem
-        // here as they may not overlap in almost all cases. Few bytes of end part
-        // is copied to the start
-        //memcpy(decompressedBytes, source, dNext);
-        memmove(decompressedBytes, source, dNext);
-        //} else if (dNext < 0) { // comment it since we dont really need to set any other var
-} else {
-    // posToStartFrom has taken forward jump, did not arrive in continuous fashion
-    // But in this case, we can assume all variables are set to zero already, hence
-    // we will be decompressing all from start.
-    dNext = 0;
-}
-// we go in a loop until we stream-decompressed enough, this will be done
-// everytime posToStartFrom is starting from zero again. Hence we have
-// this drawback to decompress in every pass once we have fully decompressed
-// in first pass. But this is significantly useful in single pass case.
-while (decompress_position > nextDecompress){
-    // printf("\ndnexxxxxxxxxxxxxttttttttttttttttttttttttttttttttttt of decompressed buffer = %d %lx\n", dNext, decompressedBytes);
-
-    uint64_t csize = qlz_size_compressed(compressedBytes+nextCompress);
-
-
-    uint64_t dsize = qlz_decompress(compressedBytes+nextCompress,
-            decompressedBytes+dNext,
-            state_decompress);
-    nextCompress+=csize;
-    nextDecompress +=dsize;
-    dNext +=dsize;
-}
-// remember the length of our buffer to be used in next iteration copy operation
-lastDecompressedLength = dNext;
-
-return nextDecompress;
+    shared->refCount.Unlock();
 }
 
 // does a simple copy
 inline
 void CompressedStorageUnit::copy (CompressedStorageUnit &fromMe) {
+    if (state_compress) free(state_compress);
+    Clean();
 
     // do shallow copy and then correct desired states
     memmove (this, &fromMe, sizeof (CompressedStorageUnit));
 
-    // create a new state (no need to deep copy), if previous one existed
-    if (fromMe.state_decompress) {
-        state_decompress = (qlz_state_decompress *)malloc(sizeof(qlz_state_decompress));
-        memmove(state_decompress, fromMe.state_decompress, sizeof(qlz_state_decompress));
-    }
+    if (shared != NULL)
+        shared->refCount.Increment(1);
 
     // create a new state (no need to deep copy), if previous one existed
     if (fromMe.state_compress) {
         state_compress = (qlz_state_compress *)malloc(sizeof(qlz_state_compress));
-        memmove(state_compress, fromMe.state_compress, sizeof(qlz_state_decompress));
+        memmove(state_compress, fromMe.state_compress, sizeof(qlz_state_compress));
     }
 }
 
-// frees the memory pointed to
 inline
-void CompressedStorageUnit::Kill () {
-    // decompressBytes are taken over by StorageUnit
-    if (compressedBytes != NULL) 	mmap_free (compressedBytes), compressedBytes = NULL;
-    //if (decompressedBytes != NULL) 	mmap_free (decompressedBytes), decompressedBytes = NULL;
-}
-
-inline
-void CompressedStorageUnit::CompressThisStorageUnit(StorageUnit& unit){
+void CompressedStorageUnit::CompressThisStorageUnit(StorageUnit& unit, uint64_t size){
     // we chop the storage unit into COMPRESSION_UNIT parts that we
     // compress. This way, when we decompress, we only get this much
     // thus conserving L2 cache
     //
     // Note: we assume that the ritht amount of space was allocated
     // already in constructor
+    FATALIF(size > unit.Size(), "Compressing more than the storage unit has");
+
     uint64_t num = 0; // how much we compressed from this unit
-#ifndef COMPRESS_ALL_AT_ONCE
     uint64_t sizeToCompress = COMPRESSION_UNIT;
-#else
-    uint64_t sizeToCompress = unit.Size();
-#endif
-    uint64_t size = unit.Size();
     while (num < size) {
         if (num + sizeToCompress > size)
             sizeToCompress = size - num;
-        uint64_t cSize = qlz_compress((const char*)unit.bytes + num, compressedBytes+nextCompress,
-                sizeToCompress, state_compress);
+        uint64_t cSize;
+        if (codec.id == COLUMN_CODEC_QUICKLZ)
+            cSize = qlz_compress((const char*)unit.bytes + num, compressedBytes+nextCompress,
+                    sizeToCompress, state_compress);
+        else
+            cSize = ColumnCodecCompressBlock(codec, (const char*)unit.bytes + num,
+                    sizeToCompress, compressedBytes+nextCompress);
         nextCompress += cSize;
         num += sizeToCompress;
     }
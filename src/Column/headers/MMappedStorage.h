@@ -20,6 +20,7 @@
 #include "ColumnStorage.h"
 #include "StorageUnit.h"
 #include "CompressibleStorageUnit.h"
+#include "ColumnCodec.h"
 #include "quicklz.h"
 #include "RawStorageDesc.h"
 #include "FileMetadata.h"
@@ -28,9 +29,6 @@
 #include <list>
 #include <utility>
 
-// this macro controls in-place decompression
-//#define DECOMPRESS_IN_PLACE 1
-
 // Number of objects that have to fit in an allocaion unit
 #define MIN_DATA_IN_ALLOC_UNIT 20
 
@@ -96,8 +94,11 @@ public:
 	static DistributedCounter* storeCount; // REMOVE
 	static DistributedCounter* createCount; // REMOVE
 
-	// Compress the storage
-	void Compress(bool);
+	// Compress the storage with the given codec
+	void Compress(const ColumnCodec& codec, bool deleteDecompressed);
+
+	// codec of the compressed storage (COLUMN_CODEC_NONE if not compressed)
+	ColumnCodecID GetCodec();
 
 	// Get the handle of the compressed storage
 	void GetCompressed(RawStorageList&);
@@ -126,7 +127,9 @@ public:
 	// This receives storage from outside, either compressed or uncompressed
 	// Hence it is read only storage. Passing allocated space considering it blank
 	// will not work
-	MMappedStorage (void *myData, uint64_t numBytes, uint64_t numCompressedBytes, uint64_t numaNode = 0);
+	// If compressed, codec says how (the data gets decompressed the first time it is used)
+	MMappedStorage (void *myData, uint64_t numBytes, uint64_t numCompressedBytes,
+			ColumnCodecID codec = COLUMN_CODEC_QUICKLZ, uint64_t numaNode = 0);
 
 	// Special constructor to read a partial chunk
 	// Arguments:
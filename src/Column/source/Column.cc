@@ -55,8 +55,8 @@ char *Column :: GetNewData (uint64_t posToStartFrom, uint64_t &numBytesRequested
     return myData->GetData (posToStartFrom, numBytesRequested);
 }
 
-void Column :: Compress (bool deleteDecompressed) {
-    myData->Compress (deleteDecompressed);
+void Column :: Compress (const ColumnCodec& codec, bool deleteDecompressed) {
+    myData->Compress (codec, deleteDecompressed);
 }
 
 void Column :: GetCompressed(RawStorageList& where) {
@@ -87,6 +87,10 @@ bool Column :: GetIsCompressed() {
     return myData->GetIsCompressed();
 }
 
+ColumnCodecID Column :: GetCodec() {
+    return myData->GetCodec();
+}
+
 /*
    void Column :: Detach () {
 
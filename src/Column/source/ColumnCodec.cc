@@ -0,0 +1,562 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#include <string.h>
+
+#include "ColumnCodec.h"
+#include "Constants.h"
+#include "Errors.h"
+
+/** Layout of a block
+
+    0  uint32 size of the block, header included
+    4  uint32 size of the decompressed data
+    8  uint8  encoding (BlockEncoding below)
+    9  uint8  width of the values (integer encodings)
+    10 uint8  bits per packed value (integer encodings)
+    11 .. 15  unused
+
+    RAW:   the bytes
+    LZ:    sequences of literals and matches, see LZCompress
+    FOR:   uint64 base, the values - base packed on bits, leftover bytes
+    DELTA: uint64 first value, the zigzag encoded differences packed on
+           bits, leftover bytes
+
+    The packed values are followed by 8 bytes of slack so the unpacking
+    can always load 8 bytes at a time.
+*/
+
+enum BlockEncoding {
+    BLOCK_RAW = 0,
+    BLOCK_LZ = 1,
+    BLOCK_FOR = 2,
+    BLOCK_DELTA = 3
+};
+
+#define BLOCK_HEADER_SIZE 16
+#define BLOCK_SLACK 8
+
+// more bits than this and the values can span 9 bytes. Not worth it anyway
+#define MAX_PACKED_BITS 56
+
+// values unpacked at a time before they are stored with the right width
+#define UNPACK_BATCH 256
+
+static inline uint32_t Read32(const char* p){
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t Read64(const char* p){
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void Write32(char* p, uint32_t v){
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline void Write64(char* p, uint64_t v){
+    memcpy(p, &v, sizeof(v));
+}
+
+static void WriteHeader(char* dest, uint64_t blockSize, uint64_t size,
+        BlockEncoding enc, int width, int bits){
+    memset(dest, 0, BLOCK_HEADER_SIZE);
+    Write32(dest, blockSize);
+    Write32(dest + 4, size);
+    dest[8] = enc;
+    dest[9] = width;
+    dest[10] = bits;
+}
+
+static uint64_t StoreRaw(const char* src, uint64_t size, char* dest){
+    WriteHeader(dest, BLOCK_HEADER_SIZE + size, size, BLOCK_RAW, 0, 0);
+    memcpy(dest + BLOCK_HEADER_SIZE, src, size);
+    return BLOCK_HEADER_SIZE + size;
+}
+
+const char* ColumnCodecName(ColumnCodecID id){
+    switch (id){
+        case COLUMN_CODEC_NONE: return "none";
+        case COLUMN_CODEC_QUICKLZ: return "quicklz";
+        case COLUMN_CODEC_LZ: return "lz";
+        case COLUMN_CODEC_INTEGER: return "integer";
+        default: return "unknown";
+    }
+}
+
+uint64_t ColumnCodecBound(uint64_t size, uint64_t numPieces){
+    // worst case every block is stored raw. Each piece but the first can
+    // add one more partial block
+    uint64_t numBlocks = (size + COMPRESSION_UNIT - 1) / COMPRESSION_UNIT;
+    if (numPieces > 1)
+        numBlocks += numPieces - 1;
+    return size + numBlocks * BLOCK_HEADER_SIZE;
+}
+
+////////////////////////////////////////
+// LZ codec
+
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 12
+// the offsets are stored on 2 bytes
+#define LZ_MAX_OFFSET 65535
+
+static inline uint32_t LZHash(uint32_t v){
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// lengths over 15 are continued in the following bytes, 255 at a time
+static inline char* LZWriteLength(char* op, uint64_t len){
+    while (len >= 255){
+        *op++ = (char) 255;
+        len -= 255;
+    }
+    *op++ = (char) len;
+    return op;
+}
+
+/* Each sequence is a token (4 bits of literal length, 4 bits of match
+   length - LZ_MIN_MATCH), the rest of the literal length, the literals,
+   the offset of the match (2 bytes), the rest of the match length. The
+   last sequence has only literals.
+
+   Returns the size of the compressed data or 0 if it does not fit in
+   capacity.
+*/
+static uint64_t LZCompress(const char* src, uint64_t size, char* dest, uint64_t capacity){
+    uint32_t table[1 << LZ_HASH_BITS];
+    memset(table, 0, sizeof(table));
+
+    const char* ip = src;
+    const char* anchor = src;
+    const char* iend = src + size;
+    char* op = dest;
+    char* oend = dest + capacity;
+
+    while (ip + LZ_MIN_MATCH <= iend){
+        uint32_t seq = Read32(ip);
+        uint32_t h = LZHash(seq);
+        const char* ref = src + table[h];
+        table[h] = ip - src;
+
+        if (ref >= ip || ip - ref > LZ_MAX_OFFSET || Read32(ref) != seq){
+            // skip faster over data that does not compress
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+
+        // extend the match, 8 bytes at a time while possible
+        const char* mp = ip + LZ_MIN_MATCH;
+        const char* rp = ref + LZ_MIN_MATCH;
+        uint64_t diff = 0;
+        while (mp + 8 <= iend && (diff = Read64(mp) ^ Read64(rp)) == 0){
+            mp += 8;
+            rp += 8;
+        }
+        if (diff != 0){
+            mp += __builtin_ctzll(diff) >> 3;
+        } else {
+            while (mp < iend && *mp == *rp){
+                mp++;
+                rp++;
+            }
+        }
+
+        uint64_t litLen = ip - anchor;
+        uint64_t matchLen = (mp - ip) - LZ_MIN_MATCH;
+
+        // token, lengths, literals and offset
+        if (op + 1 + litLen / 255 + 1 + litLen + 2 + matchLen / 255 + 1 > oend)
+            return 0;
+
+        char* token = op++;
+        *token = (char) (((litLen < 15 ? litLen : 15) << 4) | (matchLen < 15 ? matchLen : 15));
+        if (litLen >= 15)
+            op = LZWriteLength(op, litLen - 15);
+        memcpy(op, anchor, litLen);
+        op += litLen;
+
+        uint16_t offset = ip - ref;
+        memcpy(op, &offset, sizeof(offset));
+        op += sizeof(offset);
+
+        if (matchLen >= 15)
+            op = LZWriteLength(op, matchLen - 15);
+
+        ip = mp;
+        anchor = ip;
+    }
+
+    // the rest are literals
+    uint64_t litLen = iend - anchor;
+    if (op + 1 + litLen / 255 + 1 + litLen > oend)
+        return 0;
+
+    char* token = op++;
+    *token = (char) ((litLen < 15 ? litLen : 15) << 4);
+    if (litLen >= 15)
+        op = LZWriteLength(op, litLen - 15);
+    memcpy(op, anchor, litLen);
+    op += litLen;
+
+    return op - dest;
+}
+
+static inline const char* LZReadLength(const char* ip, const char* iend, uint64_t& len){
+    unsigned char c;
+    do {
+        FATALIF(ip >= iend, "Corrupt LZ block");
+        c = *ip++;
+        len += c;
+    } while (c == 255);
+    return ip;
+}
+
+static void LZDecompress(const char* src, uint64_t srcSize, char* dest, uint64_t size){
+    const char* ip = src;
+    const char* iend = src + srcSize;
+    char* op = dest;
+    char* oend = dest + size;
+
+    while (true){
+        FATALIF(ip >= iend, "Corrupt LZ block");
+        unsigned char token = *ip++;
+
+        uint64_t litLen = token >> 4;
+        if (litLen == 15)
+            ip = LZReadLength(ip, iend, litLen);
+
+        FATALIF(ip + litLen > iend || op + litLen > oend, "Corrupt LZ block");
+        if (litLen <= 16 && ip + 16 <= iend && op + 16 <= oend){
+            // short literals, copy more than needed in one go
+            memcpy(op, ip, 16);
+        } else {
+            memcpy(op, ip, litLen);
+        }
+        op += litLen;
+        ip += litLen;
+
+        if (op == oend)
+            break;
+
+        FATALIF(ip + 2 > iend, "Corrupt LZ block");
+        uint16_t offset;
+        memcpy(&offset, ip, sizeof(offset));
+        ip += sizeof(offset);
+
+        uint64_t matchLen = token & 15;
+        if (matchLen == 15)
+            ip = LZReadLength(ip, iend, matchLen);
+        matchLen += LZ_MIN_MATCH;
+
+        FATALIF(offset == 0 || op - dest < offset || op + matchLen > oend, "Corrupt LZ block");
+
+        const char* ref = op - offset;
+        if (offset >= 16 && matchLen <= 16 && op + 16 <= oend){
+            // short match, copy more than needed in one go
+            memcpy(op, ref, 16);
+            op += matchLen;
+        } else if (offset >= 8){
+            // copy 8 bytes at a time as long as we stay in the buffer
+            char* mend = op + matchLen;
+            while (op + 8 <= mend){
+                memcpy(op, ref, 8);
+                op += 8;
+                ref += 8;
+            }
+            while (op < mend)
+                *op++ = *ref++;
+        } else {
+            // overlapping copy, byte by byte to replicate the pattern
+            for (uint64_t i = 0; i < matchLen; i++)
+                op[i] = ref[i];
+            op += matchLen;
+        }
+    }
+}
+
+////////////////////////////////////////
+// integer codecs
+
+// the value at position i, sign extended if needed
+static inline uint64_t LoadValue(const char* src, uint64_t i, int width, bool isSigned){
+    switch (width){
+        case 1: {
+            int8_t v;
+            memcpy(&v, src + i, 1);
+            return isSigned ? (uint64_t) (int64_t) v : (uint64_t) (uint8_t) v;
+        }
+        case 2: {
+            int16_t v;
+            memcpy(&v, src + 2*i, 2);
+            return isSigned ? (uint64_t) (int64_t) v : (uint64_t) (uint16_t) v;
+        }
+        case 4: {
+            int32_t v;
+            memcpy(&v, src + 4*i, 4);
+            return isSigned ? (uint64_t) (int64_t) v : (uint64_t) (uint32_t) v;
+        }
+        default:
+            return Read64(src + 8*i);
+    }
+}
+
+static inline int BitsNeeded(uint64_t v){
+    return v == 0 ? 0 : 64 - __builtin_clzll(v);
+}
+
+static inline uint64_t ZigZag(int64_t v){
+    return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+}
+
+static inline int64_t UnZigZag(uint64_t v){
+    return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+}
+
+// the difference between two consecutive values of the column, as a
+// signed number of width bytes
+static inline int64_t Delta(uint64_t cur, uint64_t prev, int width){
+    uint64_t d = cur - prev;
+    if (width == 8)
+        return (int64_t) d;
+    int shift = 64 - 8*width;
+    return ((int64_t) (d << shift)) >> shift;
+}
+
+// the packed area has to be zeroed and followed by BLOCK_SLACK bytes
+static inline void PackValue(char* packed, uint64_t i, int bits, uint64_t v){
+    uint64_t bitPos = i * bits;
+    char* p = packed + (bitPos >> 3);
+    Write64(p, Read64(p) | (v << (bitPos & 7)));
+}
+
+template <int BITS>
+static void Unpack(const char* packed, uint64_t first, uint64_t num, uint64_t* out){
+    const uint64_t mask = BITS == 0 ? 0 : (~(uint64_t) 0) >> (64 - BITS);
+    for (uint64_t i = 0; i < num; i++){
+        uint64_t bitPos = (first + i) * BITS;
+        out[i] = BITS == 0 ? 0 : (Read64(packed + (bitPos >> 3)) >> (bitPos & 7)) & mask;
+    }
+}
+
+typedef void (*UnpackFunc)(const char*, uint64_t, uint64_t, uint64_t*);
+
+// one unpacking function per number of bits so the shifts and masks are
+// constants and the loop can be unrolled and vectorized
+#define UNPACK8(b) &Unpack<b>, &Unpack<b+1>, &Unpack<b+2>, &Unpack<b+3>, \
+    &Unpack<b+4>, &Unpack<b+5>, &Unpack<b+6>, &Unpack<b+7>
+static const UnpackFunc unpackFuncs[MAX_PACKED_BITS + 1] = {
+    UNPACK8(0), UNPACK8(8), UNPACK8(16), UNPACK8(24),
+    UNPACK8(32), UNPACK8(40), UNPACK8(48), &Unpack<56>
+};
+#undef UNPACK8
+
+static inline void StoreValue(char* dest, uint64_t i, int width, uint64_t v){
+    switch (width){
+        case 1: {
+            uint8_t x = v;
+            memcpy(dest + i, &x, 1);
+            break;
+        }
+        case 2: {
+            uint16_t x = v;
+            memcpy(dest + 2*i, &x, 2);
+            break;
+        }
+        case 4: {
+            uint32_t x = v;
+            memcpy(dest + 4*i, &x, 4);
+            break;
+        }
+        default:
+            Write64(dest + 8*i, v);
+    }
+}
+
+static uint64_t IntegerCompress(const ColumnCodec& codec, const char* src,
+        uint64_t size, char* dest){
+    int width = codec.width;
+    bool isSigned = codec.isSigned;
+    uint64_t num = size / width;
+    uint64_t rest = size - num * width;
+
+    if (num < 2)
+        return StoreRaw(src, size, dest);
+
+    // one pass to find out what frame of reference and delta need
+    uint64_t first = LoadValue(src, 0, width, isSigned);
+    uint64_t min = first, max = first;
+    uint64_t maxZigZag = 0;
+    uint64_t prev = first;
+    for (uint64_t i = 1; i < num; i++){
+        uint64_t v = LoadValue(src, i, width, isSigned);
+        if (isSigned ? (int64_t) v < (int64_t) min : v < min)
+            min = v;
+        if (isSigned ? (int64_t) v > (int64_t) max : v > max)
+            max = v;
+        uint64_t z = ZigZag(Delta(v, prev, width));
+        if (z > maxZigZag)
+            maxZigZag = z;
+        prev = v;
+    }
+
+    int forBits = BitsNeeded(max - min);
+    int deltaBits = BitsNeeded(maxZigZag);
+
+    // delta only packs num-1 values but has to be strictly better
+    BlockEncoding enc = deltaBits < forBits ? BLOCK_DELTA : BLOCK_FOR;
+    int bits = enc == BLOCK_DELTA ? deltaBits : forBits;
+    uint64_t numPacked = enc == BLOCK_DELTA ? num - 1 : num;
+    uint64_t packedSize = (numPacked * bits + 7) / 8;
+    uint64_t blockSize = BLOCK_HEADER_SIZE + sizeof(uint64_t) + packedSize + BLOCK_SLACK + rest;
+
+    if (bits > MAX_PACKED_BITS || blockSize >= BLOCK_HEADER_SIZE + size)
+        return StoreRaw(src, size, dest);
+
+    WriteHeader(dest, blockSize, size, enc, width, bits);
+    char* packed = dest + BLOCK_HEADER_SIZE + sizeof(uint64_t);
+    memset(packed, 0, packedSize + BLOCK_SLACK);
+
+    if (enc == BLOCK_FOR){
+        Write64(dest + BLOCK_HEADER_SIZE, min);
+        if (bits > 0)
+            for (uint64_t i = 0; i < num; i++)
+                PackValue(packed, i, bits, LoadValue(src, i, width, isSigned) - min);
+    } else {
+        Write64(dest + BLOCK_HEADER_SIZE, first);
+        prev = first;
+        if (bits > 0)
+            for (uint64_t i = 1; i < num; i++){
+                uint64_t v = LoadValue(src, i, width, isSigned);
+                PackValue(packed, i - 1, bits, ZigZag(Delta(v, prev, width)));
+                prev = v;
+            }
+    }
+
+    // the bytes that do not make a full value
+    memcpy(packed + packedSize + BLOCK_SLACK, src + num * width, rest);
+
+    return blockSize;
+}
+
+static void IntegerDecompress(const char* src, char* dest){
+    uint64_t size = Read32(src + 4);
+    BlockEncoding enc = (BlockEncoding) src[8];
+    int width = src[9];
+    int bits = src[10];
+
+    FATALIF(width != 1 && width != 2 && width != 4 && width != 8, "Corrupt integer block");
+    FATALIF(bits > MAX_PACKED_BITS, "Corrupt integer block");
+
+    uint64_t num = size / width;
+    uint64_t rest = size - num * width;
+    uint64_t base = Read64(src + BLOCK_HEADER_SIZE);
+    const char* packed = src + BLOCK_HEADER_SIZE + sizeof(uint64_t);
+    UnpackFunc unpack = unpackFuncs[bits];
+
+    uint64_t tmp[UNPACK_BATCH];
+    uint64_t numPacked;
+
+    if (enc == BLOCK_FOR){
+        numPacked = num;
+        for (uint64_t i = 0; i < num; i += UNPACK_BATCH){
+            uint64_t batch = num - i < UNPACK_BATCH ? num - i : UNPACK_BATCH;
+            unpack(packed, i, batch, tmp);
+            for (uint64_t j = 0; j < batch; j++)
+                StoreValue(dest, i + j, width, base + tmp[j]);
+        }
+    } else {
+        numPacked = num - 1;
+        uint64_t prev = base;
+        StoreValue(dest, 0, width, prev);
+        for (uint64_t i = 0; i < numPacked; i += UNPACK_BATCH){
+            uint64_t batch = numPacked - i < UNPACK_BATCH ? numPacked - i : UNPACK_BATCH;
+            unpack(packed, i, batch, tmp);
+            for (uint64_t j = 0; j < batch; j++){
+                prev += UnZigZag(tmp[j]);
+                StoreValue(dest, i + j + 1, width, prev);
+            }
+        }
+    }
+
+    uint64_t packedSize = (numPacked * bits + 7) / 8;
+    memcpy(dest + num * width, packed + packedSize + BLOCK_SLACK, rest);
+}
+
+////////////////////////////////////////
+// blocks
+
+uint64_t ColumnCodecCompressBlock(const ColumnCodec& codec, const char* src,
+        uint64_t size, char* dest){
+    FATALIF(size > COMPRESSION_UNIT, "Block of %lu bytes is too large to compress", size);
+
+    switch (codec.id){
+        case COLUMN_CODEC_LZ: {
+            // has to beat storing the bytes as they are
+            uint64_t cSize = LZCompress(src, size, dest + BLOCK_HEADER_SIZE, size);
+            if (cSize == 0 || cSize >= size)
+                return StoreRaw(src, size, dest);
+
+            WriteHeader(dest, BLOCK_HEADER_SIZE + cSize, size, BLOCK_LZ, 0, 0);
+            return BLOCK_HEADER_SIZE + cSize;
+        }
+
+        case COLUMN_CODEC_INTEGER:
+            FATALIF(codec.width != 1 && codec.width != 2 && codec.width != 4 && codec.width != 8,
+                    "Invalid width %d for the integer codec", codec.width);
+            return IntegerCompress(codec, src, size, dest);
+
+        default:
+            return StoreRaw(src, size, dest);
+    }
+}
+
+uint64_t ColumnCodecBlockSize(const char* src){
+    return Read32(src);
+}
+
+uint64_t ColumnCodecBlockDecompressedSize(const char* src){
+    return Read32(src + 4);
+}
+
+uint64_t ColumnCodecDecompressBlock(const char* src, char* dest){
+    uint64_t blockSize = Read32(src);
+    uint64_t size = Read32(src + 4);
+
+    switch (src[8]){
+        case BLOCK_RAW:
+            FATALIF(blockSize != BLOCK_HEADER_SIZE + size, "Corrupt raw block");
+            memcpy(dest, src + BLOCK_HEADER_SIZE, size);
+            break;
+
+        case BLOCK_LZ:
+            LZDecompress(src + BLOCK_HEADER_SIZE, blockSize - BLOCK_HEADER_SIZE, dest, size);
+            break;
+
+        case BLOCK_FOR:
+        case BLOCK_DELTA:
+            IntegerDecompress(src, dest);
+            break;
+
+        default:
+            FATAL("Unknown block encoding %d", (int) src[8]);
+    }
+
+    return size;
+}
@@ -161,23 +161,10 @@ char *MMappedStorage :: GetData (uint64_t posToStartFrom, uint64_t &numBytesRequ
 
 char *MMappedStorage :: GetData (uint64_t posToStartFrom, uint64_t &numBytesRequested) {
 
-	/*-------------------- Below new added code for compression ---------------*/
-
-	// below code decompresses data and assign a one big chunk of
-	// storage unit to the decompressed data.
-	uint64_t decompressedbytes = 0;
-	if (decompress) {
-		// We can not decompress in place for writing case, since we need whole data for writing on disk
-		// so just decompress in place for read only case
-		if (!isWriteMode)
-//#ifdef DECOMPRESS_IN_PLACE
-			decompressedbytes = cstorage.DecompressInPlace(posToStartFrom, posToStartFrom+numBytesRequested);
-//#else
-		else
-			decompressedbytes = cstorage.DecompressUpTo(posToStartFrom+numBytesRequested);
-//#endif
-	}
-	/*-------------------- Above new added code for compression ---------------*/
+	// compressed data is decompressed in full the first time anybody
+	// looks at it. From then on the sister storage unit is a regular one
+	if (decompress)
+		cstorage.Decompress();
 
 	// This is special case handled for 80 % of cases where we are reading from disk and size of storage unit is
 	// one. It is fast path. It helps to store pointer while doing CheckpointStore in JoinMerge
@@ -212,26 +199,10 @@ char *MMappedStorage :: GetData (uint64_t posToStartFrom, uint64_t &numBytesRequ
 			if (posToStartFrom + numBytesRequested - 1 <= storage.Current ().end) {
 
 				// tell the caller the actual number of bytes he can use
-	/*-------------------- Below new added code for compression ---------------*/
-				if (decompress && (decompressedbytes < storage.Current ().end))
-					numBytesRequested = decompressedbytes - posToStartFrom;
-				else
-	/*-------------------- Above new added code for compression ---------------*/
-					numBytesRequested = storage.Current ().end - posToStartFrom + 1;
+				numBytesRequested = storage.Current ().end - posToStartFrom + 1;
 
 				// and return them!
-//#ifdef DECOMPRESS_IN_PLACE
-			if (!isWriteMode) {
-				if (decompress)
-					return storage.Current ().bytes;
-				else
-					return storage.Current ().bytes + (posToStartFrom - storage.Current ().start);
-			}
-			else {
-//#else
 				return storage.Current ().bytes + (posToStartFrom - storage.Current ().start);
-			}
-//#endif
 
 
 			// the page does not totally cover the request, so create a bridge
@@ -309,6 +280,11 @@ char *MMappedStorage :: GetData (uint64_t posToStartFrom, uint64_t &numBytesRequ
 
 
 void MMappedStorage :: MakeReadonly(){
+	// the sister storage unit of compressed data gets written when the
+	// data is decompressed, whenever that happens
+	if (decompress)
+		return;
+
 	storage.MoveToStart ();
 	while (storage.RightLength ()) {
 		storage.Current ().MakeReadonly();
@@ -376,6 +352,10 @@ MMappedStorage *MMappedStorage :: CreatePartialDeepCopy (uint64_t position) {
 	MMappedStorage *returnVal = new MMappedStorage(numa);
 	returnVal->numBytes = numBytes;
 
+	// the copy gets the decompressed data, it does not need the compressed one
+	if (decompress)
+		cstorage.Decompress();
+
 	// we just need to make a deep copy of every storage item
 	TwoWayList <StorageUnit> newStorage;
 	storage.MoveToStart ();
@@ -389,12 +369,6 @@ MMappedStorage *MMappedStorage :: CreatePartialDeepCopy (uint64_t position) {
 	// and swap in the new storage
 	returnVal->storage.swap (newStorage);
 
-	// copy compressed storage too
-	CompressedStorageUnit newcs;
-	returnVal->cstorage.CreateDeepCopy (newcs);
-	returnVal->cstorage.swap(newcs);
-	returnVal->decompress = decompress;
-
 	// as soon as we deep copy, our mode changes to writeonly
 	// because that is when we will want deep copy
 	returnVal->isWriteMode = true;
@@ -406,10 +380,23 @@ uint64_t MMappedStorage :: GetNumBytes () {
 	return numBytes;
 }
 
-void MMappedStorage :: Compress(bool deleteDecompressed) {
+void MMappedStorage :: Compress(const ColumnCodec& codec, bool deleteDecompressed) {
+	// already compressed (read compressed from the disk), nothing to do
+	if (cstorage.GetIsCompressed())
+		return;
+
+	// the units are compressed one at a time, so each can end with a partial block
+	uint64_t numUnits = 0;
+	storage.MoveToStart ();
+	while (storage.RightLength ()) {
+		if (storage.Current().start < numBytes)
+			numUnits++;
+		storage.Advance();
+	}
+
 	// create a compressed storage unit and store it into cStorage
 	// compress into same numa until enhanced not to
-	CompressedStorageUnit cUnit(GetNumBytes(), numa);
+	CompressedStorageUnit cUnit(GetNumBytes(), numUnits, codec, numa);
 
 	// it is crucial to check that the storage units are in order
 	int prevPos = -1;
@@ -419,11 +406,12 @@ void MMappedStorage :: Compress(bool deleteDecompressed) {
 	while (storage.RightLength ()) {
 		StorageUnit& unit = storage.Current();
 		FATALIF(unit.start -1 != prevPos, "Storage units not in order");
-		// No need to compress extra unfilled bytes, hence correct the size if it increases numBytes
-		//if (unit.end > numBytes) // sarvesh, commented these, becoz they modify storage !!
-		//	unit.end = numBytes;
 		prevPos = unit.end;
-		cUnit.CompressThisStorageUnit(unit);
+		// No need to compress extra unfilled bytes past numBytes
+		if (unit.start < numBytes) {
+			uint64_t size = unit.end < numBytes ? unit.Size() : numBytes - unit.start;
+			cUnit.CompressThisStorageUnit(unit, size);
+		}
 		storage.Advance();
 	}
 
@@ -445,6 +433,10 @@ bool MMappedStorage :: GetIsCompressed() {
 	return cstorage.GetIsCompressed();
 }
 
+ColumnCodecID MMappedStorage :: GetCodec() {
+	return cstorage.GetIsCompressed() ? cstorage.GetCodec() : COLUMN_CODEC_NONE;
+}
+
 off_t MMappedStorage :: GetCompressedSizeBytes () {
 	// return the actual compressed bytes stored at the time of compression
 	return cstorage.GetCompressedSize();
@@ -474,6 +466,9 @@ void MMappedStorage :: GetUncompressed(RawStorageList& rawUncompressedList) {
 	RawStorageList empty;
 	rawUncompressedList.swap(empty); // clean up the content of the output
 
+	if (decompress)
+		cstorage.Decompress();
+
 	storage.MoveToStart ();
 	while (storage.RightLength ()) {
 		StorageUnit& temp = storage.Current();
@@ -490,7 +485,8 @@ void MMappedStorage :: GetUncompressed(RawStorageList& rawUncompressedList) {
 	}
 }
 
-MMappedStorage :: MMappedStorage (void *myData, uint64_t sizeDecompressed, uint64_t sizeCompressed, uint64_t numaNode) :
+MMappedStorage :: MMappedStorage (void *myData, uint64_t sizeDecompressed, uint64_t sizeCompressed,
+		ColumnCodecID codec, uint64_t numaNode) :
     ColumnStorage(),
     storage(),
     numBytes(sizeDecompressed),
@@ -518,7 +514,7 @@ MMappedStorage :: MMappedStorage (void *myData, uint64_t sizeDecompressed, uint6
 	} else {
 		// create a compressed storage unit
 		StorageUnit temp;
-		CompressedStorageUnit cUnit((char*)myData, sizeDecompressed, sizeCompressed, temp, numa); // compressed or not we get a single storage unit
+		CompressedStorageUnit cUnit((char*)myData, sizeDecompressed, sizeCompressed, codec, temp, numa); // compressed or not we get a single storage unit
 		cstorage.swap(cUnit);
 		decompress = true;
 		// and remember it
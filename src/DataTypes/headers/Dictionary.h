@@ -3,10 +3,26 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
+#include <memory>
+#include <iterator>
+#include <utility>
 #include <cstdint>
 #include <mutex>
 
+#include "Errors.h"
+
 // This class represents a dictionary that maps integer values to strings.
+//
+// The strings are copied in large blocks (the arena) that are never moved, so
+// the pointers given out by Dereference stay valid as the dictionary grows.
+// The reverse lookups go through an open addressing table of IDs that only
+// changes when strings are inserted, which for the global dictionaries only
+// happens while integrating a local dictionary.
+//
+// The IDs are stored in the columns and cannot change, so the sorted order of
+// the strings is kept as the rank of each ID. Comparisons between factors, and
+// the prefix predicates (see PrefixRange), become comparisons between ranks.
 class Dictionary {
 public:
     typedef int32_t         DiffType; // return value of compare function
@@ -14,21 +30,69 @@ public:
     typedef std::string     StringType;
     typedef std::unordered_map<IntType, IntType>    TranslationTable;
 
-private:
-    typedef std::unordered_map<IntType, StringType> IndexMap;
-    typedef std::unordered_map<StringType, IntType> ReverseMap;
+    // Range of ranks [first, second)
+    typedef std::pair<IntType, IntType> RankRange;
 
-public:
-    typedef IndexMap::const_iterator const_iterator;
+    // Iterates over the (ID, string) pairs of the dictionary in ID order
+    class const_iterator : public std::iterator<std::forward_iterator_tag,
+            std::pair<IntType, const char *> > {
+        const std::vector<const char *> * strings;
+        IntType pos;
+        std::pair<IntType, const char *> cur;
+
+        void Skip( void );
+
+    public:
+        const_iterator( void ) : strings(nullptr), pos(0), cur() { }
+        const_iterator( const std::vector<const char *> & _strings, IntType _pos ) :
+            strings(&_strings), pos(_pos), cur()
+        { Skip(); }
+
+        const std::pair<IntType, const char *> & operator *( void ) const { return cur; }
+        const std::pair<IntType, const char *> * operator ->( void ) const { return &cur; }
+
+        const_iterator & operator ++( void ) { ++pos; Skip(); return *this; }
+        const_iterator operator ++( int ) { const_iterator tmp(*this); ++*this; return tmp; }
+
+        bool operator ==( const const_iterator & o ) const { return pos == o.pos; }
+        bool operator !=( const const_iterator & o ) const { return pos != o.pos; }
+    };
 
 private:
+    // Slot of the reverse lookup table. The low 32 bits of the hash of the
+    // string are kept so that most mismatches are found without touching the
+    // string.
+    struct Slot {
+        uint32_t hash;
+        IntType id;
+    };
+
+    // Marks the empty slots and the unused IDs. This is never a valid ID, the
+    // factors use the largest value of their storage type as the invalid ID.
+    static const IntType NO_ID;
+
+    // Size of the first block of the arena. Each block is twice as large as
+    // the previous one, up to ARENA_MAX_BLOCK.
+    static const size_t ARENA_MIN_BLOCK;
+    static const size_t ARENA_MAX_BLOCK;
+
+    // Blocks of the arena, the last one is being filled
+    std::vector<std::unique_ptr<char[]>> blocks;
+    // Space used and size of the last block
+    size_t blockUsed;
+    size_t blockSize;
+
+    // Mapping from ID to String (nullptr for unused IDs)
+    std::vector<const char *> strings;
+    // Mapping from String to ID, the size is a power of 2
+    std::vector<Slot> slots;
+    // Number of strings in the dictionary
+    IntType numStrings;
 
-    // Mapping from ID to String
-    IndexMap indexMap;
-    // Mapping from String to ID
-    ReverseMap reverseMap;
     // Mapping from ID to index in sorted order
-    TranslationTable orderMap;
+    std::vector<IntType> ranks;
+    // IDs in sorted order
+    std::vector<IntType> sorted;
 
     // Next ID to be given
     IntType nextID;
@@ -36,7 +100,7 @@ private:
     // Whether or not the dictionary has been modified since loading.
     bool modified;
 
-    // Whether or not orderMap is valid
+    // Whether or not the ranks are valid
     bool orderValid;
 
 public:
@@ -47,6 +111,12 @@ public:
     // Construct from dictionary name
     Dictionary( const std::string name );
 
+    // Copying makes a new arena, moving keeps the old one.
+    Dictionary( const Dictionary & other );
+    Dictionary( Dictionary && other ) = default;
+    Dictionary & operator =( const Dictionary & other );
+    Dictionary & operator =( Dictionary && other ) = default;
+
     // Destructor
     ~Dictionary( void );
 
@@ -77,6 +147,12 @@ public:
     //  first < second  : retVal < 0
     DiffType Compare( IntType firstID, IntType secondID ) const;
 
+    // Position of the string of a valid ID in the sorted order.
+    IntType Rank( IntType id ) const;
+
+    // Ranks of the strings that start with prefix
+    RankRange PrefixRange( const char * prefix ) const;
+
     const_iterator begin( void) const;
     const_iterator cbegin( void ) const;
 
@@ -84,15 +160,30 @@ public:
     const_iterator cend( void ) const;
 
 private:
-    // Helper method for reverse lookups
-    IntType Lookup( const StringType& str, const IntType invalid ) const;
+    // Hash of the strings in the reverse lookup table
+    static uint32_t HashOf( const char * str, size_t len );
+
+    // Helper method for reverse lookups. Returns NO_ID if not found.
+    IntType Find( const char * str, size_t len, uint32_t hash ) const;
+
+    // Helper method for inserting strings with a given ID
+    void Insert( const char * str, size_t len, uint32_t hash, IntType id );
 
-    // Helper method for inserting strings
-    IntType Insert( StringType& str );
+    // Copies a string in the arena
+    const char * CopyToArena( const char * str, size_t len );
+
+    // Doubles the size of the reverse lookup table
+    void GrowSlots( void );
+
+    // Removes all the strings
+    void Clear( void );
 
     // Helper method to compute the sorted order.
     void ComputeOrder( void );
 
+    // Number of strings smaller than str (the rank str has or would have)
+    IntType LowerRank( const char * str ) const;
+
 /* ***** Static Members ***** */
 private:
     typedef std::unordered_map<std::string, Dictionary> DictionaryMap;
@@ -106,4 +197,38 @@ public:
     static Dictionary & GetDictionary( const std::string name );
 };
 
+/* ***** Inline Methods ***** */
+
+inline
+void Dictionary::const_iterator :: Skip( void ) {
+    while( pos < strings->size() && (*strings)[pos] == nullptr )
+        ++pos;
+
+    if( pos < strings->size() ) {
+        cur.first = pos;
+        cur.second = (*strings)[pos];
+    }
+}
+
+inline
+const char * Dictionary :: Dereference( IntType id ) const {
+    if( id < strings.size() && strings[id] != nullptr )
+        return strings[id];
+    else
+        return "NULL";
+}
+
+inline
+Dictionary::DiffType Dictionary :: Compare( IntType firstID, IntType secondID ) const {
+    FATALIF(firstID >= ranks.size() || secondID >= ranks.size(),
+        "Comparing IDs %u and %u, not in the dictionary", firstID, secondID);
+    return (DiffType) ranks[firstID] - (DiffType) ranks[secondID];
+}
+
+inline
+Dictionary::IntType Dictionary :: Rank( IntType id ) const {
+    FATALIF(id >= ranks.size(), "Rank of ID %u, not in the dictionary", id);
+    return ranks[id];
+}
+
 #endif //_DICTIONARY_H_
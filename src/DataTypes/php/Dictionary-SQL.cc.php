@@ -34,6 +34,7 @@ dictionary to do this. */
 
 #include <sstream>
 #include <iostream>
+#include <cstring>
 
 void Dictionary::Load(const char* name){
 <?php
@@ -55,27 +56,20 @@ EOT
 ?>
 ;
 
-    // Clear existing data from maps
-    indexMap.clear();
-    reverseMap.clear();
+    // Clear existing data
+    Clear();
 
 <?php
 grokit\sql_statement_table( <<<'EOT'
 "
-    SELECT "id", "order", "str" FROM "Dictionary_%s";
+    SELECT "id", "str" FROM "Dictionary_%s";
 "
 EOT
-, [ 'id' => 'int', 'order' => 'int', 'str' => 'text', ], [ 'name', ] );
+, [ 'id' => 'int', 'str' => 'text', ], [ 'name', ] );
 ?>
     {
-        StringType s(str);
-        indexMap[id] = str;
-        reverseMap[str] = id;
-        orderMap[id] = order;
-
-        if (nextID <= id)
-            nextID = id+1;
-
+        size_t len = strlen(str);
+        Insert(str, len, HashOf(str, len), id);
     }
 <?php
 grokit\sql_end_statement_table();
@@ -87,8 +81,10 @@ grokit\sql_close_database();
 ?>
 ;
 
+    // The order is recomputed rather than trusting the stored one, it is
+    // needed in memory anyway.
     modified = false;
-    orderValid = true;
+    ComputeOrder();
 }
 
 void Dictionary::Save(const char* name){
@@ -119,12 +115,13 @@ EOT
 , [ 'int', 'int', 'text', ], [ 'name', ]);
 ?>
 ;
+    ComputeOrder();
+
     // iterate through the dictionary
-    for( IndexMap::const_iterator it = indexMap.begin(); it != indexMap.end(); ++it ) {
+    for( const_iterator it = cbegin(); it != cend(); ++it ) {
         IntType id = it->first;
-        StringType s = it->second;
-        IntType order = orderMap[id];
-        const char * str = s.c_str();
+        IntType order = ranks[id];
+        const char * str = it->second;
 <?php
 grokit\sql_instantiate_parameters( [ 'id', 'order', 'str', ] );
 ?>
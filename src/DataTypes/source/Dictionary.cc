@@ -1,8 +1,9 @@
 #include "Dictionary.h"
 #include "Errors.h"
+#include "HashFunctions.h"
 
-#include <list>
-
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <limits>
 #include <utility>
@@ -13,83 +14,180 @@ using namespace std;
 std::mutex Dictionary::mut_dicts;
 Dictionary::DictionaryMap Dictionary::dicts;
 
+const Dictionary::IntType Dictionary::NO_ID = std::numeric_limits<IntType>::max();
+const size_t Dictionary::ARENA_MIN_BLOCK = 1 << 12; /* 4KB */
+const size_t Dictionary::ARENA_MAX_BLOCK = 1 << 20; /* 1MB */
+
+uint32_t Dictionary :: HashOf( const char * str, size_t len ) {
+    return (uint32_t) HashString(str, (int) len);
+}
+
 // Constructor
 Dictionary :: Dictionary( void ) :
-    indexMap(),
-    reverseMap(),
-    orderMap(),
+    blocks(),
+    blockUsed(0),
+    blockSize(0),
+    strings(),
+    slots(),
+    numStrings(0),
+    ranks(),
+    sorted(),
     nextID(0),
     modified(false),
     orderValid(false)
 { }
 
 Dictionary :: Dictionary( const std::string name ) :
-    indexMap(), reverseMap(), orderMap(),
-    nextID(0), modified(false), orderValid(false)
+    Dictionary()
 {
     Load(name.c_str());
 }
 
+Dictionary :: Dictionary( const Dictionary & other ) :
+    Dictionary()
+{
+    *this = other;
+}
+
+Dictionary & Dictionary :: operator =( const Dictionary & other ) {
+    if( this == &other )
+        return *this;
+
+    Clear();
+
+    // The strings are copied to our own arena, everything else is the same
+    slots.resize(other.slots.size(), Slot{0, NO_ID});
+    strings.resize(other.strings.size(), nullptr);
+    for( const_iterator it = other.cbegin(); it != other.cend(); ++it ) {
+        size_t len = strlen(it->second);
+        Insert(it->second, len, HashOf(it->second, len), it->first);
+    }
+
+    ranks = other.ranks;
+    sorted = other.sorted;
+    nextID = other.nextID;
+    modified = other.modified;
+    orderValid = other.orderValid;
+
+    return *this;
+}
+
 // Destructor
 Dictionary :: ~Dictionary( void ) {
 }
 
-const char * Dictionary :: Dereference( IntType id ) const {
-    IndexMap::const_iterator it = indexMap.find( id );
-    if( it != indexMap.end() )
-        return it->second.c_str();
-    else {
-      return "NULL";
+Dictionary::IntType Dictionary :: Find( const char * str, size_t len, uint32_t hash ) const {
+    if( slots.empty() )
+        return NO_ID;
+
+    size_t mask = slots.size() - 1;
+    for( size_t pos = hash & mask; ; pos = (pos + 1) & mask ) {
+        const Slot & slot = slots[pos];
+        if( slot.id == NO_ID )
+            return NO_ID;
+
+        if( slot.hash == hash ) {
+            const char * cand = strings[slot.id];
+            if( strncmp(cand, str, len) == 0 && cand[len] == '\0' )
+                return slot.id;
+        }
     }
 }
 
-Dictionary::IntType Dictionary :: Lookup( const StringType& s, const IntType invalid ) const {
-    ReverseMap::const_iterator it = reverseMap.find( s );
-    if( it != reverseMap.end() )
-        return it->second;
-    else
-        return invalid;
+Dictionary::IntType Dictionary :: Lookup( const char * str, const IntType invalid ) const {
+    size_t len = strlen(str);
+    IntType id = Find( str, len, HashOf(str, len) );
+    return id != NO_ID ? id : invalid;
 }
 
-Dictionary::IntType Dictionary :: Lookup( const char * str, const IntType invalid ) const {
-    StringType s(str);
-    return Lookup( s, invalid );
+const char * Dictionary :: CopyToArena( const char * str, size_t len ) {
+    if( blocks.empty() || blockUsed + len + 1 > blockSize ) {
+        // Start a new block, large enough for this string
+        size_t newSize = blocks.empty() ? ARENA_MIN_BLOCK : std::min(blockSize * 2, ARENA_MAX_BLOCK);
+        blockSize = std::max(newSize, len + 1);
+        blocks.emplace_back(new char[blockSize]);
+        blockUsed = 0;
+    }
+
+    char * dest = blocks.back().get() + blockUsed;
+    memcpy(dest, str, len);
+    dest[len] = '\0';
+    blockUsed += len + 1;
+
+    return dest;
 }
 
-Dictionary::IntType Dictionary :: Insert( StringType& s ) {
-    modified = true;
-    orderValid = false;
+void Dictionary :: GrowSlots( void ) {
+    std::vector<Slot> oldSlots(slots.size() == 0 ? 16 : slots.size() * 2, Slot{0, NO_ID});
+    oldSlots.swap(slots);
 
-    indexMap[nextID] = s;
-    reverseMap[s] = nextID;
+    size_t mask = slots.size() - 1;
+    for( const Slot & slot : oldSlots ) {
+        if( slot.id == NO_ID )
+            continue;
 
-    return nextID++;
+        size_t pos = slot.hash & mask;
+        while( slots[pos].id != NO_ID )
+            pos = (pos + 1) & mask;
+        slots[pos] = slot;
+    }
+}
+
+void Dictionary :: Insert( const char * str, size_t len, uint32_t hash, IntType id ) {
+    FATALIF( id == NO_ID, "Error: Invalid ID for dictionary value [%s].", str );
+
+    // Keep the table at most half full
+    if( (size_t) (numStrings + 1) * 2 > slots.size() )
+        GrowSlots();
+
+    if( id >= strings.size() )
+        strings.resize((size_t) id + 1, nullptr);
+
+    FATALIF( strings[id] != nullptr, "Error: Dictionary ID %u used by both [%s] and [%s].",
+        id, strings[id], str );
+
+    strings[id] = CopyToArena(str, len);
+    numStrings++;
+
+    size_t mask = slots.size() - 1;
+    size_t pos = hash & mask;
+    while( slots[pos].id != NO_ID )
+        pos = (pos + 1) & mask;
+    slots[pos] = Slot{hash, id};
+
+    if( nextID <= id )
+        nextID = id + 1;
+
+    modified = true;
+    orderValid = false;
 }
 
 Dictionary::IntType Dictionary :: Insert( const char * str, const IntType maxID ) {
     FATALIF( nextID > maxID, "Error: Unable to add new value [%s] to dictionary."
         " Next ID %u greater than specified maximum ID %u.", str, nextID, maxID );
 
-    StringType s(str);
-    return Insert( s );
+    IntType id = nextID;
+    size_t len = strlen(str);
+    Insert( str, len, HashOf(str, len), id );
+    return id;
 }
 
 void Dictionary :: Integrate( Dictionary& other, TranslationTable& trans ) {
-    for( auto el : other.indexMap ) {
-        IntType id = el.first;
+    for( const_iterator it = other.cbegin(); it != other.cend(); ++it ) {
+        IntType id = it->first;
+        const char * str = it->second;
+        size_t len = strlen(str);
+        uint32_t hash = HashOf(str, len);
 
-        StringType str = el.second;
-        auto revit = reverseMap.find(str);
-        if( revit == reverseMap.end() ) {
+        IntType myID = Find( str, len, hash );
+        if( myID == NO_ID ) {
             // This string isn't in my map.
-            IntType myID = Insert( str );
+            myID = nextID;
+            Insert( str, len, hash, myID );
+            trans[id] = myID;
+        } else if( myID != id ) {
+            // The string is in my dictionary, but the IDs are different.
             trans[id] = myID;
-        } else {
-            IntType myID = revit->second;
-            if( myID != id ) {
-                // The string is in my dictionary, but the IDs are different.
-                trans[id] = myID;
-            }
         }
 
         // Otherwise, both IDs are the same and we need no insertions or
@@ -100,46 +198,75 @@ void Dictionary :: Integrate( Dictionary& other, TranslationTable& trans ) {
     ComputeOrder();
 }
 
+void Dictionary :: Clear( void ) {
+    blocks.clear();
+    blockUsed = 0;
+    blockSize = 0;
+    strings.clear();
+    slots.clear();
+    numStrings = 0;
+    ranks.clear();
+    sorted.clear();
+    nextID = 0;
+    orderValid = false;
+}
+
 void Dictionary :: ComputeOrder( void ) {
     if( !orderValid ) {
-        list<StringType> sortList;
-        for( ReverseMap::const_iterator it = reverseMap.begin(); it != reverseMap.end(); ++it ) {
-            const StringType& str = it->first;
-            sortList.push_back(str);
-        }
+        sorted.clear();
+        sorted.reserve(numStrings);
+        for( const_iterator it = cbegin(); it != cend(); ++it )
+            sorted.push_back(it->first);
 
-        sortList.sort();
+        const std::vector<const char *> & strs = strings;
+        std::sort(sorted.begin(), sorted.end(), [&strs] ( IntType a, IntType b ) {
+            return strcmp(strs[a], strs[b]) < 0;
+        });
 
-        IntType curIndex = sortList.size() - 1;
-        for( list<StringType>::const_reverse_iterator it = sortList.rbegin(); it != sortList.rend(); ++it ) {
-            const StringType& str = *it;
-            IntType ID = reverseMap[str];
-
-            orderMap[ID] = curIndex--;
-        }
+        ranks.assign(strings.size(), NO_ID);
+        for( IntType i = 0; i < sorted.size(); i++ )
+            ranks[sorted[i]] = i;
 
         orderValid = true;
     }
 }
 
-Dictionary::DiffType Dictionary::Compare( IntType firstID, IntType secondID ) const {
-    return orderMap.at(firstID) - orderMap.at(secondID);
+Dictionary::IntType Dictionary :: LowerRank( const char * str ) const {
+    const std::vector<const char *> & strs = strings;
+    auto it = std::partition_point(sorted.begin(), sorted.end(), [&strs, str] ( IntType id ) {
+        return strcmp(strs[id], str) < 0;
+    });
+    return it - sorted.begin();
+}
+
+Dictionary::RankRange Dictionary :: PrefixRange( const char * prefix ) const {
+    // The strings starting with the prefix are right after the ones smaller
+    // than it.
+    IntType first = LowerRank(prefix);
+    size_t len = strlen(prefix);
+
+    const std::vector<const char *> & strs = strings;
+    auto it = std::partition_point(sorted.begin() + first, sorted.end(), [&strs, prefix, len] ( IntType id ) {
+        return strncmp(strs[id], prefix, len) == 0;
+    });
+
+    return RankRange(first, it - sorted.begin());
 }
 
 Dictionary::const_iterator Dictionary::cbegin( void ) const {
-    return indexMap.cbegin();
+    return const_iterator(strings, 0);
 }
 
 Dictionary::const_iterator Dictionary::cend( void ) const {
-    return indexMap.cend();
+    return const_iterator(strings, strings.size());
 }
 
 Dictionary::const_iterator Dictionary::begin( void ) const {
-    return indexMap.cbegin();
+    return cbegin();
 }
 
 Dictionary::const_iterator Dictionary::end( void ) const {
-    return indexMap.cend();
+    return cend();
 }
 
 Dictionary & Dictionary :: GetDictionary( const std::string name ) {
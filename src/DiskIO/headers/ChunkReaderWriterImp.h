@@ -26,6 +26,7 @@
 #include "DiskArray.h"
 #include "DiskIOData.h"
 #include "FileMetadata.h"
+#include "ZoneMap.h"
 
 /** Class to implement the mid-level File access.
   Its main job is to coordinate the reading and the writing of chunks
@@ -61,6 +62,10 @@ class ChunkReaderWriterImp : public EventProcessorImp {
         typedef std::pair<int64_t, int64_t> ClusterRange;
         typedef std::vector<ClusterRange> ClusterRangeList;
 
+        // zone ranges of all the columns of a chunk
+        typedef std::vector<ZoneRange> ChunkZoneRanges;
+        typedef std::vector<ChunkZoneRanges> ZoneRangeList;
+
         // the file scanner will get the messages when the job is done
         ChunkReaderWriterImp(const char* _scannerName, uint64_t _numCols, EventProcessor& _execEngine);
         virtual ~ChunkReaderWriterImp();
@@ -81,6 +86,20 @@ class ChunkReaderWriterImp : public EventProcessorImp {
           return ret;
         }
 
+        ZoneRangeList GetZoneRanges(void) {
+          off_t nChunks = metadataMgr.getNumChunks();
+          unsigned long nCols = metadataMgr.getNumCols();
+          ZoneRangeList ret(nChunks);
+
+          for( off_t i = 0; i < nChunks; i++ ) {
+            for( unsigned long j = 0; j < nCols; j++ ) {
+              ret[i].push_back(metadataMgr.getZoneRange(i, j));
+            }
+          }
+
+          return ret;
+        }
+
         //////////////////////////
         // MESSAGE HANDLERS
 
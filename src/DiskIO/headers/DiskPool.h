@@ -46,6 +46,10 @@ class DiskPool {
     public:
         typedef std::pair<int64_t, int64_t> ClusterRange;
         typedef std::vector<ClusterRange> ClusterRangeList;
+
+        // per chunk, the range of every physical column
+        typedef std::pair<int64_t, int64_t> ZoneRange;
+        typedef std::vector< std::vector<ZoneRange> > ZoneRangeList;
     
     private:
         typedef EfficientMap< TableScanID, EventProcessor > EVProcMap;
@@ -59,12 +63,16 @@ class DiskPool {
         typedef std::map< TableScanID, ClusterRangeList > ClusterRangeMap;
         ClusterRangeMap clusterRanges;
 
+        typedef std::map< TableScanID, ZoneRangeList > ZoneRangeMap;
+        ZoneRangeMap zoneRanges;
+
     public:
         // start the disk pool
         DiskPool():
           files(),
           sizes(),
-          clusterRanges()
+          clusterRanges(),
+          zoneRanges()
         {}
 
         // destructor
@@ -124,6 +132,9 @@ class DiskPool {
 
         ClusterRangeList ClusterRanges(TableScanID);
 
+        // zone maps of the chunks that were on disk when the file was started
+        ZoneRangeList ZoneRanges(TableScanID);
+
         void DeleteContent(std::string);
 
         void DeleteRelation(std::string name);
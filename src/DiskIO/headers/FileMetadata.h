@@ -22,6 +22,7 @@
 #include <assert.h>
 #include "Errors.h"
 #include "Swap.h"
+#include "ColumnCodec.h"
 #include <cstdio>
 #include <cinttypes>
 #include <sqlite3.h>
@@ -39,6 +40,10 @@
     Columns -- info on columns/chunk (storage)
     colNo:uint64_t, relID:uint64_t, chunkID:uint64_t, startPage:uint64_t, sizeInPages:uint64_t, columnType:uint64_t,
     varStartPage:uint64_t
+    ZoneMaps -- min/max and null count of the fixed width columns of each chunk
+    relID:uint64_t, chunkID:uint64_t, colNo:uint64_t, minValue:int64_t, maxValue:int64_t, nullCount:uint64_t
+    ColumnCodecs -- codec of the compressed version of the columns (columns without entry use QuickLZ)
+    relID:uint64_t, chunkID:uint64_t, colNo:uint64_t, codec:uint64_t
 
     **/
 
@@ -165,6 +170,11 @@ class FragmentsTuples {
 };
 
 class ColumnMetaData {
+public:
+
+    // range of the values in the column, same convention as the cluster
+    // range: min > max means we know nothing about the column
+    typedef std::pair<int64_t, int64_t> ZoneRange;
 
 private:
     friend class FileMetadata;
@@ -178,6 +188,13 @@ private:
     uint64_t sizeBytesCompr;
     Fragments fragments;
 
+    // how the compressed version is encoded
+    ColumnCodecID codec;
+
+    // zone map of the column
+    ZoneRange zoneRange;
+    uint64_t nullCount;
+
 public:
 
     ColumnMetaData (uint64_t _startPage = -1,
@@ -191,7 +208,10 @@ public:
         startPageCompr(_startPageCompr),
         sizePagesCompr(_sizePagesCompr),
         sizeBytes(_sizeBytes),
-        sizeBytesCompr(_sizeBytesCompr)
+        sizeBytesCompr(_sizeBytesCompr),
+        codec(COLUMN_CODEC_QUICKLZ),
+        zoneRange(1, 0),
+        nullCount(0)
     {}
 
         ColumnMetaData (Fragments& _fragments, uint64_t _startPage = -1,
@@ -206,7 +226,10 @@ public:
                                         sizePagesCompr(_sizePagesCompr),
                                         sizeBytes(_sizeBytes),
                                         sizeBytesCompr(_sizeBytesCompr),
-                                        fragments(_fragments) {}
+                                        fragments(_fragments),
+                                        codec(COLUMN_CODEC_QUICKLZ),
+                                        zoneRange(1, 0),
+                                        nullCount(0) {}
 
         // Load from disk
         void Initialize(long int _startPage, long int _sizePages,
@@ -226,12 +249,22 @@ public:
         off_t getSizeBytesCompr();
 
         Fragments& getFragments();
+
+        // Codec of the compressed version
+        void setCodec(ColumnCodecID _codec);
+        ColumnCodecID getCodec() const;
+
+        // Zone map of the column. Only kept for fixed width columns
+        void setZoneMap(const ZoneRange& _range, uint64_t _nullCount);
+        ZoneRange getZoneRange() const;
+        uint64_t getNullCount() const;
 };
 
 class ChunkMetaD {
 public:
 
     typedef std::pair<int64_t, int64_t> ClusterRange;
+    typedef ColumnMetaData::ZoneRange ZoneRange;
 
 private:
     friend class FileMetadata;
@@ -276,6 +309,9 @@ public:
         off_t getSizeBytes(unsigned long numCol);
         off_t getSizeBytesCompr(unsigned long numCol);
 
+        // Returns the codec of the compressed version of a column
+        ColumnCodecID getCodec(unsigned long numCol) const;
+
         uint64_t getNumTuples ();
         Fragments& getFragments(unsigned long numCol);
         FragmentsTuples& getFragmentsTuples() {return fragTuple;}
@@ -288,18 +324,24 @@ public:
                 off_t _startPageCompr,
                 off_t _sizeByesCompr,
                 off_t _sizePagesCompr,
-                Fragments& _fragments);
+                Fragments& _fragments,
+                ColumnCodecID _codec = COLUMN_CODEC_QUICKLZ);
 
         bool isDirty() const;
 
         void updateClusterRange(const ClusterRange&);
         ClusterRange getClusterRange() const;
+
+        void updateZoneMap(unsigned long numCol, const ZoneRange& range, uint64_t nullCount);
+        ZoneRange getZoneRange(unsigned long numCol) const;
+        uint64_t getNullCount(unsigned long numCol) const;
 };
 
 class FileMetadata {
     public:
 
         typedef ChunkMetaD::ClusterRange ClusterRange;
+        typedef ChunkMetaD::ZoneRange ZoneRange;
 
     private:
         //relation name
@@ -367,12 +409,23 @@ class FileMetadata {
         off_t getSizeBytes(off_t numChunk, unsigned long numCol);
         off_t getSizeBytesCompr(off_t numChunk, unsigned long numCol);
 
+        // Returns the codec of the compressed version of a given chunk and column.
+        ColumnCodecID getCodec(off_t numChunk, unsigned long numCol) const;
+
         Fragments& getFragments(off_t numChunk, unsigned long numCol);
         FragmentsTuples& getFragmentsTuples(off_t numChunk);
 
         ClusterRange getClusterRange(off_t numChunk) const;
         void updateClusterRange(off_t numChunk, const ClusterRange & r);
 
+        // Zone maps: the range of values and the number of nulls of a
+        // column in a chunk. Used to skip chunks that cannot satisfy a
+        // selection predicate.
+        ZoneRange getZoneRange(off_t numChunk, unsigned long numCol) const;
+        uint64_t getNullCount(off_t numChunk, unsigned long numCol) const;
+        void updateZoneMap(off_t numChunk, unsigned long numCol,
+                const ZoneRange & r, uint64_t nullCount);
+
         /** Methods to add a new chunk
 
             In order to avoid exposing the internal structure of the metadata file,
@@ -400,7 +453,8 @@ class FileMetadata {
                 off_t _startPageCompr,
                 off_t _sizeByesCompr,
                 off_t _sizePagesCompr,
-                Fragments& _fragments);
+                Fragments& _fragments,
+                ColumnCodecID _codec = COLUMN_CODEC_QUICKLZ);
 
         // reserve pages in the storage; the return is the index of the first page
         // in the sequence
@@ -581,6 +635,32 @@ inline
 Fragments& ColumnMetaData::getFragments(){
     return fragments;
 }
+
+inline
+void ColumnMetaData::setCodec(ColumnCodecID _codec) {
+    codec = _codec;
+}
+
+inline
+ColumnCodecID ColumnMetaData::getCodec() const {
+    return codec;
+}
+
+inline
+void ColumnMetaData::setZoneMap(const ZoneRange& _range, uint64_t _nullCount) {
+    zoneRange = _range;
+    nullCount = _nullCount;
+}
+
+inline
+ColumnMetaData::ZoneRange ColumnMetaData::getZoneRange() const {
+    return zoneRange;
+}
+
+inline
+uint64_t ColumnMetaData::getNullCount() const {
+    return nullCount;
+}
 // ===========================INLINE methods for ChunkMetaData =================
 inline
 void ChunkMetaD :: Initialize (uint64_t _numCols, long int _numTuples,
@@ -634,6 +714,13 @@ inline off_t ChunkMetaD::getSizeBytesCompr(unsigned long numCol) {
     return colMetaData[numCol].getSizeBytesCompr();
 }
 
+inline ColumnCodecID ChunkMetaD::getCodec(unsigned long numCol) const {
+#ifdef DEBUG
+    assert(numCol < colMetaData.size());
+#endif
+    return colMetaData[numCol].getCodec();
+}
+
 inline Fragments& ChunkMetaD::getFragments(unsigned long numCol) {
 #ifdef DEBUG
     assert(numCol < colMetaData.size());
@@ -652,9 +739,11 @@ inline void ChunkMetaD::addColumn(
                 off_t _startPageCompr,
                 off_t _sizeBytesCompr,
                 off_t _sizePagesCompr,
-                Fragments& _fragments) {
+                Fragments& _fragments,
+                ColumnCodecID _codec) {
 
     ColumnMetaData col (_fragments, _startPage, _sizePages, _startPageCompr, _sizePagesCompr, _sizeBytes, _sizeBytesCompr);
+    col.setCodec(_codec);
     colMetaData.push_back(col);
 }
 
@@ -674,6 +763,30 @@ ChunkMetaD::ClusterRange ChunkMetaD::getClusterRange() const {
     return clusterRange;
 }
 
+inline
+void ChunkMetaD::updateZoneMap(unsigned long numCol, const ZoneRange& range, uint64_t nullCount) {
+#ifdef DEBUG
+    assert(numCol < colMetaData.size());
+#endif
+    colMetaData[numCol].setZoneMap(range, nullCount);
+}
+
+inline
+ChunkMetaD::ZoneRange ChunkMetaD::getZoneRange(unsigned long numCol) const {
+#ifdef DEBUG
+    assert(numCol < colMetaData.size());
+#endif
+    return colMetaData[numCol].getZoneRange();
+}
+
+inline
+uint64_t ChunkMetaD::getNullCount(unsigned long numCol) const {
+#ifdef DEBUG
+    assert(numCol < colMetaData.size());
+#endif
+    return colMetaData[numCol].getNullCount();
+}
+
 // ===========================INLINE methods for FileMetaData =================
 inline uint64_t FileMetadata::getRelID(void){ return relID; }
 
@@ -734,6 +847,13 @@ inline off_t FileMetadata::getSizeBytesCompr(off_t numChunk, unsigned long numCo
     return chunkMetaD[numChunk].getSizeBytesCompr(numCol);
 }
 
+inline ColumnCodecID FileMetadata::getCodec(off_t numChunk, unsigned long numCol) const {
+#ifdef DEBUG
+    assert(numChunk < chunkMetaD.size());
+#endif
+    return chunkMetaD[numChunk].getCodec(numCol);
+}
+
 inline Fragments& FileMetadata::getFragments(off_t numChunk, unsigned long numCol) {
 #ifdef DEBUG
     assert(numChunk < chunkMetaD.size());
@@ -774,6 +894,35 @@ void FileMetadata::updateClusterRange(off_t numChunk, const ClusterRange & range
     modified = true;
 }
 
+inline
+FileMetadata::ZoneRange FileMetadata::getZoneRange(off_t numChunk, unsigned long numCol) const {
+#ifdef DEBUG
+    assert(numChunk < chunkMetaD.size());
+#endif //DEBUG
+
+    return chunkMetaD[numChunk].getZoneRange(numCol);
+}
+
+inline
+uint64_t FileMetadata::getNullCount(off_t numChunk, unsigned long numCol) const {
+#ifdef DEBUG
+    assert(numChunk < chunkMetaD.size());
+#endif //DEBUG
+
+    return chunkMetaD[numChunk].getNullCount(numCol);
+}
+
+inline
+void FileMetadata::updateZoneMap(off_t numChunk, unsigned long numCol,
+        const ZoneRange & range, uint64_t nullCount) {
+#ifdef DEBUG
+    assert(numChunk < chunkMetaD.size());
+#endif //DEBUG
+
+    chunkMetaD[numChunk].updateZoneMap(numCol, range, nullCount);
+    modified = true;
+}
+
 inline off_t FileMetadata::startNewChunk(off_t _numTuples, off_t _numColumns, FragmentsTuples& f){
 
     assert (chkFilled == -1);
@@ -807,12 +956,13 @@ inline void FileMetadata::addColumn(off_t _startPage,
         off_t _startPageCompr,
         off_t _sizeBytesCompr,
         off_t _sizePagesCompr,
-        Fragments& _fragments) {
+        Fragments& _fragments,
+        ColumnCodecID _codec) {
 
     assert (chkFilled == numChunks && colsFilled < numCols);
 
     // We add columns to last newly added chunk
-    chunkMetaD[chunkMetaD.size()-1].addColumn (_startPage, _sizeBytes, _sizePages, _startPageCompr, _sizeBytesCompr, _sizePagesCompr, _fragments);
+    chunkMetaD[chunkMetaD.size()-1].addColumn (_startPage, _sizeBytes, _sizePages, _startPageCompr, _sizeBytesCompr, _sizePagesCompr, _fragments, _codec);
 
     colsFilled++;
 }
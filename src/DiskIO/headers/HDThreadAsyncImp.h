@@ -0,0 +1,124 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef _HD_EVENT_PROC_ASYNC_IMP_H_
+#define _HD_EVENT_PROC_ASYNC_IMP_H_
+
+#include "HDThreadImp.h"
+#include "EventGeneratorImp.h"
+#include "Timer.h"
+
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <pthread.h>
+#include <linux/aio_abi.h>
+
+/** Asynchronous driver for individual hard drives.
+
+  Behaves exactly like HDThreadImp from the point of view of the
+  DiskArray (same stripe format, same messages) but, instead of
+  performing one blocking lseek+read/write per DiskRequestData, all
+  the pages of a MegaJob are submitted as a batch of positional
+  reads/writes through the Linux native AIO interface. Up to
+  queueDepth requests are kept outstanding on the stripe, so devices
+  with deep queues (NVMe, RAID controllers) can serve them in parallel.
+
+  The message handler only submits requests and returns. Completions
+  are collected by a dedicated reaper thread (an EventGenerator) that
+  updates the statistics and, when the last page of a MegaJob
+  finished, decrements the DistributedCounter and sends
+  MegaJobFinished to the requestor exactly like the blocking version.
+
+  The handler never waits: the requests that do not fit in the queue
+  are put on a waiting list and the reaper submits them as the
+  completions free slots. Short reads/writes are resubmitted for the
+  rest of the bytes by the reaper.
+
+  The native AIO interface is only truly asynchronous for files opened
+  with O_DIRECT. If MMAP_IS_MALLOC is defined the requests still work
+  but the kernel serves them synchronously at submit time.
+*/
+class HDThreadAsyncImp : public HDThreadImp {
+    private:
+        // the state of a MegaJob while its pages are in flight
+        struct AsyncJob {
+            off_t requestId;
+            int operation;
+            DistributedCounter* counter;
+            EventProcessor requestor;
+
+            // number of page requests not completed yet
+            std::atomic<int64_t> pending;
+        };
+
+        // a single positional request. The iocb has to live until the
+        // completion is reaped, so it is allocated with the request
+        struct AsyncRequest {
+            iocb cb;
+            AsyncJob* job;
+            off_t numPG;
+            Timer clock;
+            int64_t traceStart; // 0 if not traced
+        };
+
+        // thread that waits for completions on the AIO context
+        class ReaperImp : public EventGeneratorImp {
+            HDThreadAsyncImp& hd;
+
+            public:
+                ReaperImp(HDThreadAsyncImp& _hd):hd(_hd){}
+
+                virtual int ProduceMessage(void) override;
+        };
+
+        aio_context_t context; // the kernel AIO context for this stripe
+        const int queueDepth; // maximum number of outstanding requests
+
+        // number of requests submitted but not reaped yet and the requests
+        // waiting for a slot. Both protected by slotsLock
+        int inFlight;
+        std::deque<AsyncRequest*> waiting;
+        pthread_mutex_t slotsLock;
+
+        ReaperImp* reaper;
+
+        // queues the requests and submits as many as there are free slots
+        void Enqueue(std::vector<AsyncRequest*>& reqs);
+
+        // gives back slots after the requests completed and submits the
+        // waiting requests that fit in them
+        void ReleaseSlots(int num);
+
+        // submits requests that have a slot reserved. Retries on partial
+        // submission; the requests the kernel refuses go back to waiting
+        void Submit(std::vector<AsyncRequest*>& reqs);
+
+        // wait for completions and process them. Runs in the reaper thread
+        void ReapCompletions(void);
+
+        // called when the last page of a job completed
+        void FinishJob(AsyncJob* job);
+
+    public:
+        HDThreadAsyncImp(const char *_fileName, uint64_t arrayHash, EventProcessor &_diskArray,
+                uint64_t _frequencyUpdate, bool isReadOnly, int _queueDepth);
+        virtual ~HDThreadAsyncImp();
+
+        /** Message handler for the MegaJobs. Replaces HDThreadImp::ExecuteJob */
+        MESSAGE_HANDLER_DECLARATION(ExecuteJobAsync)
+};
+
+#endif // _HD_EVENT_PROC_ASYNC_IMP_H_
@@ -78,7 +78,7 @@ class HDThreadImp : public EventProcessorImp {
         /* function to create a stripe. If stripe cannot be created, the system fails.*/
         static void CreateStripe(char* fileName, uint64_t arrayHash, int32_t stripeId, uint64_t offset);
 
-    private:
+    protected:
         uint64_t fileDescriptor;
         Header header;
         char *fileName;
@@ -100,7 +100,9 @@ class HDThreadImp : public EventProcessorImp {
         void UpdateStatistics(double time);
 
     public:
-        HDThreadImp(const char *_fileName, uint64_t arrayHash, EventProcessor &_diskArray, uint64_t _frequencyUpdate, bool isReadOnly = false);
+        // subclasses that process the MegaJobs themselves pass false for blocking
+        HDThreadImp(const char *_fileName, uint64_t arrayHash, EventProcessor &_diskArray, uint64_t _frequencyUpdate,
+                bool isReadOnly = false, bool blocking = true);
         virtual ~HDThreadImp();
 
         // which stripe is this?
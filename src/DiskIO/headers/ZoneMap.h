@@ -0,0 +1,88 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef _ZONE_MAP_H_
+#define _ZONE_MAP_H_
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cinttypes>
+
+#include "RawStorageDesc.h"
+#include "ColumnStats.h"
+
+/** Zone maps are the min/max (and number of nulls) of a column in a
+    chunk. They are computed when the chunk is written and kept in the
+    FileMetadata so that the table scanner can skip chunks that cannot
+    satisfy the ranges pushed down from the selection predicates.
+
+    Only fixed width integer-like columns get a zone map. The values
+    are laid out in the column as an array of native integers so we can
+    scan the raw storage directly without knowing anything else about
+    the type.
+
+    NOTE: the min and max are computed over the raw values, nulls
+    included. The generated code compares the raw values as well (a
+    null INT is -1 and behaves like -1 in comparisons), so skipping a
+    chunk based on the raw range never changes the result of a query.
+*/
+
+enum ZoneMapKind {
+    ZONE_MAP_NONE,  // no zone map for this column
+    ZONE_MAP_INT8,  // BYTE
+    ZONE_MAP_INT16, // SMALLINT
+    ZONE_MAP_INT32, // INT, DATE, DATETIME
+    ZONE_MAP_INT64, // BIGINT
+    ZONE_MAP_UINT32 // UINT
+};
+
+// The zone map description of one physical column
+struct ZoneMapFormat {
+    ZoneMapKind kind;
+    int64_t nullValue; // raw value used by the type to represent null
+
+    ZoneMapFormat(ZoneMapKind _kind = ZONE_MAP_NONE, int64_t _nullValue = -1):
+        kind(_kind), nullValue(_nullValue) {}
+};
+
+typedef std::vector<ZoneMapFormat> ZoneMapFormatList;
+
+// the range of a column, min > max means unknown
+typedef std::pair<int64_t, int64_t> ZoneRange;
+
+/** Returns the format of the zone map for a type as it appears in the
+    catalog. The library prefix and the case of the name are ignored */
+ZoneMapFormat ZoneMapFormatForType(std::string type);
+
+/** Fills in the format of each physical column of the relation, in
+    the order of the columns. Relations unknown to the catalog get an
+    empty list */
+void ZoneMapFormatsForRelation(std::string relName, ZoneMapFormatList& where);
+
+/** Computes the zone map of a column given the raw uncompressed
+    storage. The storage is scanned up to numBytes.
+
+    The statistics of the column (see ColumnStats.h) are added to stats in
+    the same pass. Unlike the zone map, they keep the nulls out of the
+    range and the sketch.
+
+    Returns false if no zone map can be computed (unsupported kind or
+    empty column)
+*/
+bool ComputeZoneMap(const ZoneMapFormat& format, RawStorageList& storage,
+        uint64_t numBytes, ZoneRange& range, uint64_t& nullCount, ColumnStats& stats);
+
+#endif // _ZONE_MAP_H_
@@ -41,5 +41,14 @@ EventProcessor execEngine;
 // total page counter (bookkeeping)
 off_t totalPages;
 
+// zone map format of each physical column. Columns past the end of the
+// list (the bitstring) get no zone map
+ZoneMapFormatList zoneFormats;
+
+// statistics of the columns of the relation, the ones in the catalog merged
+// with the ones of the chunks written since. They go to the catalog on flush
+ColumnStatsList columnStats;
+bool columnStatsChanged;
+
 //////////////// Helper functions
 uint64_t NewRequest(void);
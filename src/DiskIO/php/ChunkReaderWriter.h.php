@@ -47,6 +47,14 @@ grokit\interface_function(
 	'std::vector< std::pair<int64_t, int64_t> >',
 	[]
 );
+?>
+
+<?php
+grokit\interface_function(
+	'GetZoneRanges',
+	'std::vector< std::vector< std::pair<int64_t, int64_t> > >',
+	[]
+);
 ?>
 
 	<?php
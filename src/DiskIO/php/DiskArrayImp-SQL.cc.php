@@ -199,7 +199,11 @@ EOT
 , [ 'fileName' => 'text', ], [ 'meta.arrayID', ] );
 ?>
 {
+#if DISK_IO_QUEUE_DEPTH > 1
+        HDThread hd(fileName, meta.arrayHash, myInterface, DISK_OPERATION_STATISTICS_INTERVAL, isReadOnly, DISK_IO_QUEUE_DEPTH);
+#else
         HDThread hd(fileName, meta.arrayHash, myInterface, DISK_OPERATION_STATISTICS_INTERVAL, isReadOnly);
+#endif
 	uint64_t diskID = hd.DiskNo();
         hd.ForkAndSpin();
 	FATALIF( hds[diskID].IsValid(), "Stripe %d already initized", diskID);
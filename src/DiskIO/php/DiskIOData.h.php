@@ -100,11 +100,12 @@ typedef TwoWayList< DiskRequestData > DiskRequestDataContainer;
 		
 		Arguments:
 				chunkID: id of the chunk we are dealing with
+				startTime: when the request was made, 0 if not traced (see Tracer.h)
 				hMsg: the hopping message to send back to EE
 				token: the token to send back
 */
 <?php
-grokit\create_data_type( "CRWRequest", "Data", [ 'chunkID' => 'off_t', ], [ 'hMsg' => 'HoppingDataMsg', 'token' => 'GenericWorkToken', ] );
+grokit\create_data_type( "CRWRequest", "Data", [ 'chunkID' => 'off_t', 'startTime' => 'int64_t', ], [ 'hMsg' => 'HoppingDataMsg', 'token' => 'GenericWorkToken', ] );
 ?>
 
 
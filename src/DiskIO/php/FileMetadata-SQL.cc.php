@@ -109,6 +109,24 @@ grokit\sql_statements_norez( <<<'EOT'
             chunkID         INTEGER
     );
 
+    /* ZoneMaps */
+    CREATE TABLE IF NOT EXISTS ZoneMaps(
+      relID          INTEGER NOT NULL,
+      chunkID        INTEGER NOT NULL,
+      colNo          INTEGER NOT NULL,
+      minValue       INTEGER NOT NULL,
+      maxValue       INTEGER NOT NULL,
+      nullCount      INTEGER DEFAULT 0
+    );
+
+    /* ColumnCodecs */
+    CREATE TABLE IF NOT EXISTS ColumnCodecs(
+      relID          INTEGER NOT NULL,
+      chunkID        INTEGER NOT NULL,
+      colNo          INTEGER NOT NULL,
+      codec          INTEGER NOT NULL
+    );
+
 "
 EOT
 , [ ] );
@@ -212,6 +230,49 @@ EOT
         }<?php
 grokit\sql_end_statement_table();
 ?>
+;
+
+        // zone maps. Chunks written before zone maps existed have no
+        // entries and keep the "unknown" range
+<?php
+grokit\sql_statement_table( <<<'EOT'
+"
+      SELECT chunkID, colNo, minValue, maxValue, nullCount
+      FROM ZoneMaps
+        WHERE relID=%d;
+    "
+EOT
+, [ '_chunkID4' => 'int', '_colNo3' => 'int', 'zoneMin' => 'int', 'zoneMax' => 'int', 'zoneNulls' => 'int', ], [ 'relID', ] );
+?>
+{
+            FATALIF( _chunkID4 >= numChunks || _colNo3 >= numCols,
+                "Zone map for chunk %ld column %ld is not part of the relation", _chunkID4, _colNo3);
+            ColumnMetaData::ZoneRange zRange(zoneMin, zoneMax);
+            chunkMetaD[_chunkID4].colMetaData[_colNo3].setZoneMap(zRange, zoneNulls);
+        }<?php
+grokit\sql_end_statement_table();
+?>
+;
+
+        // codecs of the compressed columns. Columns without an entry were
+        // compressed with QuickLZ
+<?php
+grokit\sql_statement_table( <<<'EOT'
+"
+      SELECT chunkID, colNo, codec
+      FROM ColumnCodecs
+        WHERE relID=%d;
+    "
+EOT
+, [ '_chunkID5' => 'int', '_colNo4' => 'int', '_codec' => 'int', ], [ 'relID', ] );
+?>
+{
+            FATALIF( _chunkID5 >= numChunks || _colNo4 >= numCols,
+                "Codec for chunk %ld column %ld is not part of the relation", _chunkID5, _colNo4);
+            chunkMetaD[_chunkID5].colMetaData[_colNo4].setCodec((ColumnCodecID) _codec);
+        }<?php
+grokit\sql_end_statement_table();
+?>
 ;
 
     } else { // new relation
@@ -422,6 +483,28 @@ EOT
 ?>
 ;
 
+<?php
+grokit\sql_statements_norez( <<<'EOT'
+"
+        DELETE FROM ZoneMaps
+        WHERE relID=%d;
+"
+EOT
+, [ 'relID', ] );
+?>
+;
+
+<?php
+grokit\sql_statements_norez( <<<'EOT'
+"
+        DELETE FROM ColumnCodecs
+        WHERE relID=%d;
+"
+EOT
+, [ 'relID', ] );
+?>
+;
+
 }
 
 void FileMetadata::Flush(void) {
@@ -547,6 +630,62 @@ grokit\sql_instantiate_parameters( [ 'relID', 'chunkit', 'colit', 'chunkMetaD[ch
 <?php
 grokit\sql_parametric_end();
 ?>
+;
+
+    // Now flush the zone maps. Columns without one are skipped
+<?php
+grokit\sql_statement_parametric_norez( <<<'EOT'
+"
+            INSERT INTO ZoneMaps(relID, chunkID, colNo, minValue, maxValue, nullCount)
+            VALUES (?1, ?2, ?3, ?4, ?5, ?6);
+            "
+EOT
+, [ 'int', 'int', 'int', 'int', 'int', 'int', ], [ ]);
+?>
+;
+            for (uint64_t chunkit = 0; chunkit < chunkMetaD.size(); chunkit++) {
+                for (uint64_t colit = 0; colit < chunkMetaD[chunkit].colMetaData.size(); colit++) {
+                    ColumnMetaData::ZoneRange zRange = chunkMetaD[chunkit].colMetaData[colit].getZoneRange();
+                    uint64_t zNulls = chunkMetaD[chunkit].colMetaData[colit].getNullCount();
+                    if (zRange.first > zRange.second)
+                        continue;
+<?php
+grokit\sql_instantiate_parameters( [ 'relID', 'chunkit', 'colit', 'zRange.first', 'zRange.second', 'zNulls', ] );
+?>
+;
+                }
+            }
+<?php
+grokit\sql_parametric_end();
+?>
+;
+
+    // Now flush the codecs. Only the compressed columns that do not use
+    // QuickLZ need an entry
+<?php
+grokit\sql_statement_parametric_norez( <<<'EOT'
+"
+            INSERT INTO ColumnCodecs(relID, chunkID, colNo, codec)
+            VALUES (?1, ?2, ?3, ?4);
+            "
+EOT
+, [ 'int', 'int', 'int', 'int', ], [ ]);
+?>
+;
+            for (uint64_t chunkit = 0; chunkit < chunkMetaD.size(); chunkit++) {
+                for (uint64_t colit = 0; colit < chunkMetaD[chunkit].colMetaData.size(); colit++) {
+                    int codec = chunkMetaD[chunkit].colMetaData[colit].getCodec();
+                    if (chunkMetaD[chunkit].colMetaData[colit].sizeBytesCompr == 0 || codec == COLUMN_CODEC_QUICKLZ)
+                        continue;
+<?php
+grokit\sql_instantiate_parameters( [ 'relID', 'chunkit', 'colit', 'codec', ] );
+?>
+;
+                }
+            }
+<?php
+grokit\sql_parametric_end();
+?>
 ;
 
     // now ask the diskArray to flush as well
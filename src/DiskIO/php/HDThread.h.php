@@ -2,6 +2,7 @@
 #define _HDTHREAD_H_
 
 #include "EventProcessor.h"
+#include "HDThreadAsyncImp.h"
 
 <?php
 //
@@ -31,6 +32,12 @@ grokit\interface_function('DiskNo', 'int', [ ]);
 
 // custom function 
 ?>
+
+    // Constructor for the asynchronous implementation. queueDepth is the
+    // maximum number of outstanding requests on the stripe
+    HDThread( const char* fileName, uint64_t arrayHash, EventProcessor& dispatcher, int freqUpdate, bool isReadOnly, int queueDepth ) {
+        evProc = new HDThreadAsyncImp( fileName, arrayHash, dispatcher, freqUpdate, isReadOnly, queueDepth );
+    }
     
     static void CreateStripe(char* fileName, uint64_t arrayHash, int32_t stripeId, uint64_t offset){
 	HDThreadImp::CreateStripe(fileName, arrayHash, stripeId, offset);
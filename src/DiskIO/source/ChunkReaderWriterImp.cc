@@ -31,11 +31,16 @@
 #include "ExecEngineData.h"
 #include "EEExternMessages.h"
 #include "Debug.h"
+#include "Catalog.h"
+#include "Tracer.h"
+#include "MemoryAccounting.h"
+#include "QueryManager.h"
 
 
 ChunkReaderWriterImp::ChunkReaderWriterImp(const char* _scannerName, uint64_t _numCols,
         EventProcessor& _execEngine):
-    metadataMgr(_scannerName, _numCols), diskArray(DiskArray::GetDiskArray())
+    metadataMgr(_scannerName, _numCols), diskArray(DiskArray::GetDiskArray()),
+    columnStatsChanged(false)
 #ifdef  DEBUG_EVPROC
     ,EventProcessorImp(true, "ChunkReaderWriter")
 #endif
@@ -45,6 +50,13 @@ ChunkReaderWriterImp::ChunkReaderWriterImp(const char* _scannerName, uint64_t _n
 
     execEngine.copy(_execEngine);
 
+    // the types of the columns decide which ones get zone maps
+    ZoneMapFormatsForRelation(_scannerName, zoneFormats);
+
+    // the statistics of the chunks written are added to the ones we have
+    Catalog::GetCatalog().GetColumnStats(_scannerName, columnStats);
+    columnStats.resize(zoneFormats.size());
+
     nextRequest = 0; // counter to generate independent requests for all
     // disk jobs. Also counts how many requests we
     // processed since starting
@@ -81,6 +93,13 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, ChunkRWJobDone, MegaJobFi
     CRWRequest req;
     evProc.requests.Remove(key, dummy, req);
 
+    // the whole life of the request, from the message to the last page
+    if (req.get_startTime() != 0) {
+        std::string name = (msg.operation == WRITE ? "write " : "read ") + evProc.fileScannerId.getName();
+        Tracer::AsyncSpan("chunk", name.c_str(), req.get_startTime(), Tracer::Now(), req.get_chunkID(),
+                QueryExitsToQueries(req.get_hMsg().get_dest()));
+    }
+
     // chunk will be make readonly in the Table waypoint
 
     // and send it
@@ -106,6 +125,9 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, ReadChunk, ChunkRead){
     //create bitmap
     QueryID queries = QueryExitsToQueries(msg.dest);
 
+    // the columns read are charged to the queries of the scan
+    MemoryOwnerScope owner(QueryManager::MemoryOwner(queries));
+
     MMappedStorage bitStore;
     Column outBitCol(bitStore);
     assert(evProc.metadataMgr.getNumTuples(_chunkId));
@@ -129,7 +151,8 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, ReadChunk, ChunkRead){
         off_t sizeUncompressed;
 
         if (msg.useUncompressed || evProc.metadataMgr.getSizeBytesCompr(_chunkId, index) == 0 ||
-                ( evProc.metadataMgr.getSizeBytesCompr(_chunkId, index) > .75 * evProc.metadataMgr.getSizeBytes(_chunkId, index)) ){
+                ( evProc.metadataMgr.getSizeBytesCompr(_chunkId, index) >
+                  COLUMN_COMPRESSION_MAX_RATIO * evProc.metadataMgr.getSizeBytes(_chunkId, index)) ){
             // uncompressed columns
             startPage = evProc.metadataMgr.getStartPage(_chunkId, index);
             sizePages = evProc.metadataMgr.getSizePages(_chunkId, index);
@@ -145,7 +168,8 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, ReadChunk, ChunkRead){
         // allocate memory
         void* data = mmap_alloc(PAGES_TO_BYTES(sizePages), 1/*, numaNode*/);
         //create the column and load it into the chunk
-        MMappedStorage colStorage(data, sizeUncompressed, sizeCompressed );
+        MMappedStorage colStorage(data, sizeUncompressed, sizeCompressed,
+                evProc.metadataMgr.getCodec(_chunkId, index));
         Column newColumn(colStorage);
         newColumn.SetFragments(evProc.metadataMgr.getFragments(_chunkId, index));
 
@@ -163,7 +187,7 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, ReadChunk, ChunkRead){
     // place chunk in HoppingMessage and message in RequestsMap
     ChunkContainer chkContainer(chunk);
     HoppingDataMsg result (msg.requestor, msg.dest, msg.lineage, chkContainer);
-    CRWRequest req(_chunkId, result, msg.token);
+    CRWRequest req(_chunkId, Tracer::IsEnabled() ? Tracer::Now() : 0, result, msg.token);
     KOff_t key(requestID);
     evProc.requests.Insert(key, req);
 
@@ -177,6 +201,27 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, ReadChunk, ChunkRead){
 
 }MESSAGE_HANDLER_DEFINITION_END
 
+/** helper function to pick the codec of a column based on its type.
+  Integer-like columns get the integer codec, everything else (including
+  the columns we know nothing about) the byte oriented LZ codec
+  */
+static ColumnCodec CodecForZoneMapFormat(const ZoneMapFormat& format){
+    switch (format.kind){
+        case ZONE_MAP_INT8:
+            return ColumnCodec(COLUMN_CODEC_INTEGER, 1, true);
+        case ZONE_MAP_INT16:
+            return ColumnCodec(COLUMN_CODEC_INTEGER, 2, true);
+        case ZONE_MAP_INT32:
+            return ColumnCodec(COLUMN_CODEC_INTEGER, 4, true);
+        case ZONE_MAP_INT64:
+            return ColumnCodec(COLUMN_CODEC_INTEGER, 8, true);
+        case ZONE_MAP_UINT32:
+            return ColumnCodec(COLUMN_CODEC_INTEGER, 4, false);
+        default:
+            return ColumnCodec(COLUMN_CODEC_LZ);
+    }
+}
+
 /** helper function to translate raw lists to disk requests
   will be used twice for compressed and uncompressed data
 
@@ -268,6 +313,13 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, WriteChunk, ChunkWrite){
         Fragments frag;
 
         if (col.IsValid()) {
+#if COLUMN_COMPRESSION
+            unsigned long colNo = index.GetInt();
+            ColumnCodec codec = colNo < evProc.zoneFormats.size() ?
+                CodecForZoneMapFormat(evProc.zoneFormats[colNo]) : ColumnCodec(COLUMN_CODEC_LZ);
+            col.Compress(codec, false);
+#endif
+
             // get the size needed in pages
             sizePages = col.GetUncompressedSizePages();
             sizePagesCompr = col.GetCompressedSizePages();
@@ -288,7 +340,8 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, WriteChunk, ChunkWrite){
                     startPageCompr,
                     col.GetCompressedSizeBytes(),
                     sizePagesCompr,
-                    frag );
+                    frag,
+                    col.GetCodec());
         } else {
             evProc.metadataMgr.addColumn(0,
                     0,
@@ -303,6 +356,20 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, WriteChunk, ChunkWrite){
         RawStorageList rawList;
         if (sizePages != 0) {
             col.GetUncompressed(rawList);
+
+            // zone map and statistics of the column, while we still have the data
+            unsigned long colNo = index.GetInt();
+            if (colNo < evProc.zoneFormats.size()) {
+                ZoneRange zRange;
+                uint64_t nullCount;
+                if (ComputeZoneMap(evProc.zoneFormats[colNo], rawList,
+                            col.GetUncompressedSizeBytes(), zRange, nullCount,
+                            evProc.columnStats[colNo])) {
+                    evProc.metadataMgr.updateZoneMap(_chunkId, colNo, zRange, nullCount);
+                    evProc.columnStatsChanged = true;
+                }
+            }
+
             off_t end = RawListToDiskRequest(startPage, rawList, dRequests);
 
             FATALIF( (end-startPage) > sizePages,
@@ -330,7 +397,7 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, WriteChunk, ChunkWrite){
     KOff_t key(requestID);
     ChunkContainer chkContainer(msg.chunk);
     HoppingDataMsg result (msg.requestor, msg.dest, msg.lineage, chkContainer);
-    CRWRequest req(_chunkId, result, msg.token);
+    CRWRequest req(_chunkId, Tracer::IsEnabled() ? Tracer::Now() : 0, result, msg.token);
     evProc.requests.Insert(key, req);
 
     EventProcessor copy;
@@ -344,10 +411,27 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, WriteChunk, ChunkWrite){
 
 MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, FlushFunc, Flush){
     evProc.metadataMgr.Flush();
+
+    // the catalog only gets the statistics if something was written
+    if (evProc.columnStatsChanged) {
+        long long int numTuples = 0;
+        off_t nChunks = evProc.metadataMgr.getNumChunks();
+        for (off_t i = 0; i < nChunks; i++)
+            numTuples += evProc.metadataMgr.getNumTuples(i);
+
+        Catalog::GetCatalog().SetStatistics(evProc.fileScannerId.getName(),
+                numTuples, evProc.columnStats);
+        evProc.columnStatsChanged = false;
+    }
 }MESSAGE_HANDLER_DEFINITION_END
 
 MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, DeleteContentFunc, DeleteContent) {
     evProc.metadataMgr.DeleteContent();
+
+    size_t nCols = evProc.columnStats.size();
+    evProc.columnStats.clear();
+    evProc.columnStats.resize(nCols);
+    evProc.columnStatsChanged = true;
 }MESSAGE_HANDLER_DEFINITION_END
 
 MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, ClusterUpdateFunc, ChunkClusterUpdate) {
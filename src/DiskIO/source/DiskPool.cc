@@ -43,6 +43,7 @@ TableScanID DiskPool::AddFile(string name, uint64_t numCols){
 
     off_t numChunks = file.GetNumChunks();
     ClusterRangeList cRanges = file.GetClusterRanges();
+    ZoneRangeList zRanges = file.GetZoneRanges();
 
     PDEBUG("Started %s stream with %d chunks and %d columns", name.c_str(), numChunks, numCols);
 
@@ -54,6 +55,7 @@ TableScanID DiskPool::AddFile(string name, uint64_t numCols){
     files.Insert(cID, file);
     sizes[id]=numChunks;
     clusterRanges[id] = cRanges;
+    zoneRanges[id] = zRanges;
 
     return id;
 }
@@ -78,6 +80,14 @@ auto DiskPool::ClusterRanges(TableScanID id) -> ClusterRangeList {
     return it->second;
 }
 
+auto DiskPool::ZoneRanges(TableScanID id) -> ZoneRangeList {
+    FATALIF( !files.IsThere(id), "Why are we asking about the zone maps of a file not started?");
+    auto it = zoneRanges.find(id);
+    FATALIF(it == zoneRanges.end(),
+        "No zone map information found");
+    return it->second;
+}
+
 void DiskPool::ReadRequest(ChunkID& id, WayPointID &requestor, bool useUncompressed,
         HistoryList &lineage, QueryExitContainer &dest,
         GenericWorkToken& token, SlotPairContainer& colsToProcess){
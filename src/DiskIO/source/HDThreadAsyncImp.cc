@@ -0,0 +1,271 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#include <vector>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "Errors.h"
+#include "HDThreadAsyncImp.h"
+#include "DistributedCounter.h"
+#include "MmapAllocator.h"
+#include "Profiling.h"
+#include "Tracer.h"
+
+using namespace std;
+
+// glibc does not provide wrappers for the native AIO system calls and
+// we do not want to depend on libaio just for these four functions
+static inline int io_setup(unsigned nr, aio_context_t* ctxp){
+    return syscall(__NR_io_setup, nr, ctxp);
+}
+
+static inline int io_destroy(aio_context_t ctx){
+    return syscall(__NR_io_destroy, ctx);
+}
+
+static inline int io_submit(aio_context_t ctx, long nr, iocb** iocbpp){
+    return syscall(__NR_io_submit, ctx, nr, iocbpp);
+}
+
+static inline int io_getevents(aio_context_t ctx, long min_nr, long max_nr,
+        io_event* events, timespec* timeout){
+    return syscall(__NR_io_getevents, ctx, min_nr, max_nr, events, timeout);
+}
+
+int HDThreadAsyncImp::ReaperImp::ProduceMessage(void){
+    hd.ReapCompletions();
+    return 0;
+}
+
+HDThreadAsyncImp::HDThreadAsyncImp(const char *_fileName, uint64_t arrayHash, EventProcessor &_dispatcher,
+        uint64_t _frequencyUpdate, bool _isReadOnly, int _queueDepth) :
+    HDThreadImp(_fileName, arrayHash, _dispatcher, _frequencyUpdate, _isReadOnly, false),
+    context(0),
+    queueDepth(_queueDepth),
+    inFlight(0)
+{
+    FATALIF(queueDepth < 1, "Invalid queue depth %d for asynchronous HDThread(%s)", queueDepth, fileName);
+
+    if (io_setup(queueDepth, &context) == -1){
+        perror("HDThreadAsync:");
+        FATAL("Could not set up an AIO context of depth %d for stripe %s\n", queueDepth, fileName);
+    }
+
+    pthread_mutex_init(&slotsLock, NULL);
+
+    reaper = new ReaperImp(*this);
+    reaper->Run();
+
+    // HDThreadImp was told not to register its blocking handler
+    RegisterMessageProcessor(MegaJob::type, &HDThreadAsyncImp::ExecuteJobAsync, 1);
+}
+
+HDThreadAsyncImp::~HDThreadAsyncImp() {
+    reaper->Kill();
+    delete reaper;
+
+    // cancels whatever is still outstanding
+    io_destroy(context);
+
+    pthread_mutex_destroy(&slotsLock);
+}
+
+void HDThreadAsyncImp::Enqueue(vector<AsyncRequest*>& reqs){
+    vector<AsyncRequest*> ready;
+
+    pthread_mutex_lock(&slotsLock);
+    waiting.insert(waiting.end(), reqs.begin(), reqs.end());
+    while (inFlight < queueDepth && !waiting.empty()){
+        ready.push_back(waiting.front());
+        waiting.pop_front();
+        inFlight++;
+    }
+    pthread_mutex_unlock(&slotsLock);
+
+    Submit(ready);
+}
+
+void HDThreadAsyncImp::ReleaseSlots(int num){
+    vector<AsyncRequest*> ready;
+
+    pthread_mutex_lock(&slotsLock);
+    inFlight -= num;
+    while (inFlight < queueDepth && !waiting.empty()){
+        ready.push_back(waiting.front());
+        waiting.pop_front();
+        inFlight++;
+    }
+    pthread_mutex_unlock(&slotsLock);
+
+    Submit(ready);
+}
+
+void HDThreadAsyncImp::Submit(vector<AsyncRequest*>& reqs){
+    vector<iocb*> cbs;
+    for (AsyncRequest* req : reqs) {
+        // the time of a request is the time the device takes
+        req->clock.Restart();
+        req->traceStart = Tracer::IsEnabled() ? Tracer::Now() : 0;
+        cbs.push_back(&req->cb);
+    }
+
+    size_t done = 0;
+    while (done < cbs.size()){
+        int ret = io_submit(context, cbs.size() - done, &cbs[done]);
+        if (ret == -1 && errno == EINTR)
+            continue;
+
+        if (ret == -1 && errno == EAGAIN){
+            // the kernel is out of resources. Put the rest back, the next
+            // completion submits it again
+            pthread_mutex_lock(&slotsLock);
+            waiting.insert(waiting.begin(), reqs.begin() + done, reqs.end());
+            inFlight -= cbs.size() - done;
+            bool stuck = (inFlight == 0);
+            pthread_mutex_unlock(&slotsLock);
+
+            FATALIF(stuck, "The kernel refuses AIO requests for stripe %s with nothing in flight", fileName);
+            return;
+        }
+
+        if (ret == -1){
+            perror("HDThreadAsync:");
+            FATAL("Submission of %d requests to stripe %s failed", (int) (cbs.size() - done), fileName);
+        }
+
+        // the kernel can accept only part of the batch
+        done += ret;
+    }
+}
+
+void HDThreadAsyncImp::FinishJob(AsyncJob* job){
+    //signal the calling thread if these are the last pages to read/write
+    if (job->counter->Decrement(1) == 0) { // decrease the number of threads that finished
+        // last piece, signal ChunkReaderWriter
+        MegaJobFinished_Factory(job->requestor, job->requestId, job->operation, job->counter);
+    }
+
+    delete job;
+}
+
+void HDThreadAsyncImp::ReapCompletions(void){
+    vector<io_event> events(queueDepth);
+
+    int num = io_getevents(context, 1, queueDepth, &events[0], NULL);
+    if (num == -1){
+        FATALIF(errno != EINTR, "Waiting for completions on stripe %s failed: %s",
+                fileName, strerror(errno));
+        return;
+    }
+
+    // short requests keep their slot and go again for the rest
+    vector<AsyncRequest*> again;
+
+    for (int i = 0; i < num; i++){
+        AsyncRequest* req = (AsyncRequest*) events[i].data;
+        AsyncJob* job = req->job;
+        int64_t res = events[i].res;
+
+        if (res <= 0){
+            FATAL("%s of file %s at position %ld of size %ld for job %ld failed: %s",
+                    job->operation == WRITE ? "Writing" : "Reading",
+                    fileName, (off_t) req->cb.aio_offset, (off_t) req->cb.aio_nbytes,
+                    (int64_t) job->requestId, res == 0 ? "end of file" : strerror(-res));
+        }
+
+        if (job->operation == WRITE) {
+            PROFILING2_INSTANT("byw", res, "disk");
+        } else {
+            PROFILING2_INSTANT("byr", res, "disk");
+        }
+
+        // the requests are in flight together, each gets its own track
+        if (req->traceStart != 0) {
+            Tracer::AsyncSpan("disk", job->operation == WRITE ? "write" : "read",
+                    req->traceStart, Tracer::Now(), res);
+        }
+
+        if ((uint64_t) res < req->cb.aio_nbytes){
+            req->cb.aio_buf += res;
+            req->cb.aio_offset += res;
+            req->cb.aio_nbytes -= res;
+            again.push_back(req);
+            continue;
+        }
+
+        UpdateStatistics(req->clock.GetTime()/req->numPG);
+
+        if (job->pending.fetch_sub(1) == 1)
+            FinishJob(job);
+
+        delete req;
+    }
+
+    Submit(again);
+    ReleaseSlots(num - again.size());
+}
+
+MESSAGE_HANDLER_DEFINITION_BEGIN(HDThreadAsyncImp, ExecuteJobAsync, MegaJob){
+
+    FATALIF(!msg.requestor.IsValid(), "Requestor passed in DiskArray is not valid");
+    FATALIF(msg.operation != READ && msg.operation != WRITE,
+            "Invalid operation type(%d) specified\n", msg.operation);
+    FATALIF(msg.operation == WRITE && evProc.isReadOnly, "Attempting to write data to read-only disk");
+
+    AsyncJob* job = new AsyncJob;
+    job->requestId = msg.requestId;
+    job->operation = msg.operation;
+    job->counter = msg.counter;
+    job->requestor.copy(msg.requestor);
+
+    int64_t numRequests = 0;
+    for(msg.requests.MoveToStart(); !msg.requests.AtEnd(); msg.requests.Advance())
+        numRequests++;
+
+    if (numRequests == 0){
+        // nothing for this stripe, just count ourselves as done
+        evProc.FinishJob(job);
+    } else {
+        // the reaper can finish the job as soon as the last request is in so
+        // the count has to be complete before the first submission
+        job->pending = numRequests;
+
+        vector<AsyncRequest*> reqs;
+        reqs.reserve(numRequests);
+
+        for(msg.requests.MoveToStart(); !msg.requests.AtEnd(); msg.requests.Advance()){
+            DiskRequestData& request = msg.requests.Current();
+
+            AsyncRequest* req = new AsyncRequest;
+            memset(&req->cb, 0, sizeof(iocb));
+            req->job = job;
+            req->numPG = request.get_sizePages();
+
+            req->cb.aio_data = (uint64_t) req;
+            req->cb.aio_lio_opcode = (msg.operation == WRITE) ? IOCB_CMD_PWRITE : IOCB_CMD_PREAD;
+            req->cb.aio_fildes = evProc.fileDescriptor;
+            req->cb.aio_buf = (uint64_t) request.get_memLoc();
+            req->cb.aio_nbytes = PAGES_TO_BYTES(req->numPG);
+            req->cb.aio_offset = evProc.header.offset+PAGES_TO_BYTES(request.get_startPage());
+
+            reqs.push_back(req);
+        }
+
+        evProc.Enqueue(reqs);
+    }
+}MESSAGE_HANDLER_DEFINITION_END
@@ -33,6 +33,7 @@
 #include "DiskArray.h"
 #include "MmapAllocator.h"
 #include "Profiling.h"
+#include "Tracer.h"
 
 #ifndef O_DIRECT
 # define O_LARGEFILE 0100000
@@ -70,7 +71,7 @@ void HDThreadImp::CreateStripe(char* fileName, uint64_t arrayHash, int32_t strip
 }
 
 HDThreadImp::HDThreadImp(const char *_fileName, uint64_t arrayHash, EventProcessor &_dispatcher,
-        uint64_t _frequencyUpdate, bool _isReadOnly) :
+        uint64_t _frequencyUpdate, bool _isReadOnly, bool blocking) :
 #ifdef DEBUG_EVPROC
     EventProcessorImp(true, _fileName),
 #endif
@@ -125,7 +126,8 @@ HDThreadImp::HDThreadImp(const char *_fileName, uint64_t arrayHash, EventProcess
         FATAL("Error in HDThreads(%s)\n", _fileName);
     }
 
-    RegisterMessageProcessor(MegaJob::type, &HDThreadImp::ExecuteJob, 1);
+    if (blocking)
+        RegisterMessageProcessor(MegaJob::type, &HDThreadImp::ExecuteJob, 1);
 }
 
 uint64_t HDThreadImp::DiskNo(void){
@@ -181,6 +183,7 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(HDThreadImp, ExecuteJob, MegaJob){
 
             FATALIF(evProc.isReadOnly, "Attempting to write data to read-only disk")
             PROFILING2_START;
+            TRACE_START;
             if (write (evProc.fileDescriptor, where, PAGES_TO_BYTES(numPG) ) == -1){
                 perror("HDThread:");
                 FATAL("Writting of file %s at position %ld of size %ld for job %d failed. Mem: %lx",
@@ -188,16 +191,19 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(HDThreadImp, ExecuteJob, MegaJob){
             }
 
             PROFILING2_END;
+            TRACE_END("disk", "write", PAGES_TO_BYTES(numPG));
             PROFILING2_SINGLE("byw", PAGES_TO_BYTES(numPG), "disk");
         }
         else  if (msg.operation == READ) {
             PROFILING2_START;
+            TRACE_START;
             if (read (evProc.fileDescriptor, where, PAGES_TO_BYTES(numPG)) == -1) {
                 perror("HDThread:");
                 FATAL("Reading of file %s at position %ld of size %d for job %d failed. Mem: %lx",
                         evProc.fileName, page, PAGES_TO_BYTES(numPG), (uint64_t)msg.requestId, where);
             }
             PROFILING2_END;
+            TRACE_END("disk", "read", PAGES_TO_BYTES(numPG));
             PROFILING2_SINGLE("byr", PAGES_TO_BYTES(numPG), "disk");
         }
         else {
@@ -0,0 +1,156 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#include <string.h>
+#include <ctype.h>
+#include <limits>
+
+#include "ZoneMap.h"
+#include "Catalog.h"
+#include "Errors.h"
+
+using namespace std;
+
+ZoneMapFormat ZoneMapFormatForType(string type){
+    // get rid of the library, base::INT and INT are the same thing
+    size_t pos = type.rfind("::");
+    if (pos != string::npos)
+        type = type.substr(pos+2);
+
+    for (size_t i = 0; i < type.size(); i++)
+        type[i] = toupper(type[i]);
+
+    if (type == "BYTE")
+        return ZoneMapFormat(ZONE_MAP_INT8, -1);
+    if (type == "SMALLINT")
+        return ZoneMapFormat(ZONE_MAP_INT16, -1);
+    if (type == "INT" || type == "DATE" || type == "DATETIME")
+        return ZoneMapFormat(ZONE_MAP_INT32, -1);
+    if (type == "BIGINT")
+        return ZoneMapFormat(ZONE_MAP_INT64, -1);
+    if (type == "UINT")
+        return ZoneMapFormat(ZONE_MAP_UINT32, numeric_limits<uint32_t>::max());
+
+    return ZoneMapFormat();
+}
+
+void ZoneMapFormatsForRelation(string relName, ZoneMapFormatList& where){
+    where.clear();
+
+    Catalog& catalog = Catalog::GetCatalog();
+    Schema schema;
+    if (!catalog.GetSchema(relName, schema))
+        return;
+
+    // the attributes come in the order of the columns
+    AttributeContainer attributes;
+    schema.GetAttributes(attributes);
+    for (attributes.MoveToStart(); !attributes.AtEnd(); attributes.Advance()){
+        Attribute& att = attributes.Current();
+        where.push_back(ZoneMapFormatForType(att.GetType()));
+    }
+}
+
+// calls f on each value of one type. A value can be split between two
+// storage units so the leftover bytes are carried over
+template<class T, class F>
+static void ForEachValue(RawStorageList& storage, uint64_t numBytes, F f){
+    char carry[sizeof(T)];
+    size_t carrySize = 0;
+    uint64_t bytesLeft = numBytes;
+
+    FOREACH_TWL(el, storage){
+        const char* data = (const char*) el.data;
+        uint64_t size = el.sizeInBytes < bytesLeft ? el.sizeInBytes : bytesLeft;
+        bytesLeft -= size;
+
+        // finish the value started in the previous unit
+        if (carrySize > 0){
+            size_t need = sizeof(T) - carrySize;
+            if (need > size)
+                need = size;
+            memcpy(carry + carrySize, data, need);
+            carrySize += need;
+            data += need;
+            size -= need;
+
+            if (carrySize == sizeof(T)){
+                T val;
+                memcpy(&val, carry, sizeof(T));
+                f(val);
+                carrySize = 0;
+            }
+        }
+
+        uint64_t num = size / sizeof(T);
+        const T* vals = (const T*) data;
+        for (uint64_t i = 0; i < num; i++)
+            f(vals[i]);
+
+        size_t rest = size - num*sizeof(T);
+        if (rest > 0){
+            memcpy(carry, data + num*sizeof(T), rest);
+            carrySize = rest;
+        }
+    }END_FOREACH;
+}
+
+// scan the values of one type for the zone map and the column statistics
+template<class T>
+static bool ScanZone(RawStorageList& storage, uint64_t numBytes, T nullValue,
+        ZoneRange& range, uint64_t& nullCount, ColumnStats& stats){
+
+    T min = numeric_limits<T>::max();
+    T max = numeric_limits<T>::min();
+    uint64_t numValues = 0;
+    nullCount = 0;
+
+    ForEachValue<T>(storage, numBytes, [&](T val){
+        if (val < min) min = val;
+        if (val > max) max = val;
+        if (val == nullValue) {
+            nullCount++;
+            stats.AddNull();
+        } else {
+            stats.Add(val);
+        }
+        numValues++;
+    });
+
+    if (numValues == 0)
+        return false;
+
+    range = ZoneRange(min, max);
+    return true;
+}
+
+bool ComputeZoneMap(const ZoneMapFormat& format, RawStorageList& storage,
+        uint64_t numBytes, ZoneRange& range, uint64_t& nullCount, ColumnStats& stats){
+
+    switch (format.kind){
+        case ZONE_MAP_INT8:
+            return ScanZone<int8_t>(storage, numBytes, format.nullValue, range, nullCount, stats);
+        case ZONE_MAP_INT16:
+            return ScanZone<int16_t>(storage, numBytes, format.nullValue, range, nullCount, stats);
+        case ZONE_MAP_INT32:
+            return ScanZone<int32_t>(storage, numBytes, format.nullValue, range, nullCount, stats);
+        case ZONE_MAP_INT64:
+            return ScanZone<int64_t>(storage, numBytes, format.nullValue, range, nullCount, stats);
+        case ZONE_MAP_UINT32:
+            return ScanZone<uint32_t>(storage, numBytes, format.nullValue, range, nullCount, stats);
+        default:
+            return false;
+    }
+}
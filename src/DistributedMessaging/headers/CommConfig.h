@@ -49,6 +49,17 @@ namespace comm {
     // Port for local frontend
     CONSTEXPR uint16_t FRONTEND_PORT = 9000;
 
+    // Whether we offer to exchange binary frames with the remote hosts
+    // (see CommFrame.h). Text frames are always accepted.
+    CONSTEXPR bool USE_BINARY_FRAMES = true;
+
+    // Version of the binary frames, first byte of each frame
+    CONSTEXPR uint8_t BINARY_FRAME_VERSION = 1;
+
+    // A binary frame is sent once it is at least this large, even if more
+    // messages are waiting to be sent
+    CONSTEXPR size_t BINARY_BATCH_BYTES = 1 << 16;
+
     /***** Overall websocket++ typedefs *****/
     typedef websocketpp::connection_hdl connection_hdl;
 
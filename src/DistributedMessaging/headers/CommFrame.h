@@ -0,0 +1,40 @@
+// Copyright 2013 Tera Insights, LLC. All Rights Reserved.
+
+#ifndef _COMM_FRAME_H_
+#define _COMM_FRAME_H_
+
+#include "RemoteMessage.h"
+
+#include <string>
+
+/**
+ * Binary frames exchanged between grokit nodes.
+ *
+ * The JSON text frames described in CommListener.cc are parsed and written
+ * by the front end too, so they stay the default. When both ends of a
+ * connection say they accept binary frames in their HELLO messages, the
+ * NORMAL messages are sent in binary frames instead, several of them per
+ * frame if they are queued in the sender at the same time.
+ *
+ * Frame layout (fields in the native byte order, see SerializeBinary.h):
+ *
+ *  <uint8 version> { <uint32 length> <message> }*
+ *
+ *  message: <source hostname> <uint16 port> <dest hostname> <uint16 port>
+ *           <dest mailbox> <int64 type> <payload>
+ *
+ * The payload is the JSON value of the message in a binary form: a one byte
+ * tag followed by the value (variable length integers, doubles, length
+ * prefixed strings, counted arrays and objects).
+ */
+
+// Appends a message to a binary frame. An empty frame is started first.
+void AppendToBinaryFrame( std::string & frame, RemoteMessage & msg );
+
+// Decodes the messages of a binary frame and delivers each of them to the
+// event processor registered for its mailbox. who is used for the errors.
+// Returns false if the frame is malformed; the messages before the error
+// are still delivered.
+bool DeliverBinaryFrame( const std::string & frame, const char * who );
+
+#endif // _COMM_FRAME_H_
@@ -20,6 +20,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <cinttypes>
+#include <set>
 
 #include "CommConfig.h"
 #include "RemoteAddress.h"
@@ -121,6 +122,10 @@ class CommManager {
         typedef EfficientMap <MailboxAddress, ProxyEventProcessor> ProxySenderMap;
         ProxySenderMap proxySenders;
 
+        // Remote hosts that told us they accept binary frames on the current
+        // connection
+        std::set<HostAddress> binaryPeers;
+
     public:
         //default constructor; initializes the manager
         CommManager(void);
@@ -170,6 +175,10 @@ class CommManager {
 
         // An existing connection with a remote host has been closed.
         void ConnectionClosed( const HostAddress & address );
+
+        // The remote host accepts binary frames, so the messages sent to it
+        // use them from now on (until the connection is closed).
+        void BinaryFramesAccepted( const HostAddress & address );
 };
 
 //inline methods
@@ -24,6 +24,7 @@
 
 #include <string>
 #include <memory>
+#include <atomic>
 
 /**
   Communication sender opens a connection with a remote host and sends all the
@@ -57,8 +58,17 @@ class CommSenderImp : public EventProcessorImp {
         // Whether or not the sender is active
         bool isActive;
 
+        // Whether the remote host accepts binary frames
+        std::atomic<bool> binaryFrames;
+
+        // Binary frame being filled with messages
+        std::string batch;
+
         // Helper method to send a message
-        void SendMessage(const std::string & data);
+        void SendMessage(const std::string & data, websocketpp::frame::opcode::value opcode);
+
+        // Send the binary frame being filled, if any
+        void FlushBatch(void);
 
     public:
         //constructor & destructor
@@ -72,6 +82,9 @@ class CommSenderImp : public EventProcessorImp {
         //check to see if the sender is active (it has a connection to the remote host)
         bool IsActive() {return isActive;}
 
+        // switch between binary and JSON text frames
+        void UseBinaryFrames(bool use) {binaryFrames = use;}
+
         // message handler for all remote messages
         MESSAGE_HANDLER_DECLARATION(ProcessRemoteMessage);
 };
@@ -106,6 +119,12 @@ class CommSender : public EventProcessor {
             CommSenderImp* sender = dynamic_cast<CommSenderImp*>(evProc);
             return sender->IsActive();
         }
+
+        //switch between binary and JSON text frames
+        void UseBinaryFrames(bool use) {
+            CommSenderImp* sender = dynamic_cast<CommSenderImp*>(evProc);
+            sender->UseBinaryFrames(use);
+        }
 };
 
 #endif // _COMM_SENDER_H_
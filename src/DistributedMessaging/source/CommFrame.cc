@@ -0,0 +1,362 @@
+// Copyright 2013 Tera Insights, LLC. All Rights Reserved.
+
+#include "CommFrame.h"
+#include "CommManager.h"
+#include "CommConfig.h"
+#include "SerializeBinary.h"
+#include "Errors.h"
+#include "Logging.h"
+
+#include <cinttypes>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+    // Tags of the binary JSON values
+    enum JsonTag : uint8_t {
+        J_NULL = 0,
+        J_FALSE,
+        J_TRUE,
+        J_INT,
+        J_UINT,
+        J_REAL,
+        J_STRING,
+        J_ARRAY,
+        J_OBJECT
+    };
+
+    // Nesting limit when decoding, so a bad frame cannot blow the stack
+    const int MAX_JSON_DEPTH = 256;
+
+    // The integers and the sizes of the strings, arrays and objects are
+    // mostly small, they are written 7 bits at a time (the signed ones zigzag
+    // encoded)
+
+    size_t VarIntSize( uint64_t val ) {
+        size_t size = 1;
+        while( val >= 0x80 ) {
+            val >>= 7;
+            size++;
+        }
+        return size;
+    }
+
+    size_t SerializeVarInt( char * buffer, uint64_t val ) {
+        size_t size = 0;
+        while( val >= 0x80 ) {
+            buffer[size++] = (char) (val | 0x80);
+            val >>= 7;
+        }
+        buffer[size++] = (char) val;
+        return size;
+    }
+
+    uint64_t ZigZag( int64_t val ) {
+        return ((uint64_t) val << 1) ^ (uint64_t) (val >> 63);
+    }
+
+    int64_t UnZigZag( uint64_t val ) {
+        return (int64_t) (val >> 1) ^ -(int64_t) (val & 1);
+    }
+
+    size_t StringSize( const string & val ) {
+        return VarIntSize(val.size()) + val.size();
+    }
+
+    size_t SerializeString( char * buffer, const string & val ) {
+        size_t size = SerializeVarInt(buffer, val.size());
+        memcpy(buffer + size, val.data(), val.size());
+        return size + val.size();
+    }
+
+    size_t JsonSize( const Json::Value & val ) {
+        size_t size = sizeof(uint8_t);
+
+        switch( val.type() ) {
+        case Json::intValue:
+            size += VarIntSize(ZigZag(val.asInt64()));
+            break;
+        case Json::uintValue:
+            size += VarIntSize(val.asUInt64());
+            break;
+        case Json::realValue:
+            size += sizeof(double);
+            break;
+        case Json::stringValue:
+            size += StringSize(val.asString());
+            break;
+        case Json::arrayValue:
+            size += VarIntSize(val.size());
+            for( Json::ArrayIndex i = 0; i < val.size(); i++ )
+                size += JsonSize(val[i]);
+            break;
+        case Json::objectValue:
+            size += VarIntSize(val.size());
+            for( Json::Value::const_iterator it = val.begin(); it != val.end(); ++it ) {
+                size += StringSize(it.name());
+                size += JsonSize(*it);
+            }
+            break;
+        default:
+            break;
+        }
+
+        return size;
+    }
+
+    size_t SerializeJson( char * buffer, const Json::Value & val ) {
+        char * cur = buffer;
+
+        switch( val.type() ) {
+        case Json::nullValue:
+            cur += Serialize(cur, (uint8_t) J_NULL);
+            break;
+        case Json::booleanValue:
+            cur += Serialize(cur, (uint8_t) (val.asBool() ? J_TRUE : J_FALSE));
+            break;
+        case Json::intValue:
+            cur += Serialize(cur, (uint8_t) J_INT);
+            cur += SerializeVarInt(cur, ZigZag(val.asInt64()));
+            break;
+        case Json::uintValue:
+            cur += Serialize(cur, (uint8_t) J_UINT);
+            cur += SerializeVarInt(cur, val.asUInt64());
+            break;
+        case Json::realValue:
+            cur += Serialize(cur, (uint8_t) J_REAL);
+            cur += Serialize(cur, val.asDouble());
+            break;
+        case Json::stringValue:
+            cur += Serialize(cur, (uint8_t) J_STRING);
+            cur += SerializeString(cur, val.asString());
+            break;
+        case Json::arrayValue:
+            cur += Serialize(cur, (uint8_t) J_ARRAY);
+            cur += SerializeVarInt(cur, val.size());
+            for( Json::ArrayIndex i = 0; i < val.size(); i++ )
+                cur += SerializeJson(cur, val[i]);
+            break;
+        case Json::objectValue:
+            cur += Serialize(cur, (uint8_t) J_OBJECT);
+            cur += SerializeVarInt(cur, val.size());
+            for( Json::Value::const_iterator it = val.begin(); it != val.end(); ++it ) {
+                cur += SerializeString(cur, it.name());
+                cur += SerializeJson(cur, *it);
+            }
+            break;
+        }
+
+        return cur - buffer;
+    }
+
+    // Reads the fields of a frame, checking that they are within it
+    class FrameReader {
+        const char * cur;
+        const char * end;
+
+    public:
+        FrameReader( const char * _begin, const char * _end ) : cur(_begin), end(_end) { }
+
+        bool AtEnd( void ) const { return cur == end; }
+
+        template< class T >
+        bool Read( T & dest ) {
+            if( (size_t) (end - cur) < sizeof(T) )
+                return false;
+            cur += Deserialize(cur, dest);
+            return true;
+        }
+
+        bool Read( string & dest ) {
+            if( (size_t) (end - cur) < sizeof(uint32_t)
+                    || (size_t) (end - cur) < SizeFromBuffer<string>(cur) )
+                return false;
+            cur += Deserialize(cur, dest);
+            return true;
+        }
+
+        bool ReadVarInt( uint64_t & dest ) {
+            dest = 0;
+            for( int shift = 0; shift < 64 && cur < end; shift += 7 ) {
+                uint8_t byte = *cur++;
+                dest |= (uint64_t) (byte & 0x7f) << shift;
+                if( (byte & 0x80) == 0 )
+                    return true;
+            }
+            return false;
+        }
+
+        bool ReadString( string & dest ) {
+            uint64_t length;
+            if( !ReadVarInt(length) || (uint64_t) (end - cur) < length )
+                return false;
+            dest.assign(cur, length);
+            cur += length;
+            return true;
+        }
+
+        bool Read( HostAddress & dest ) {
+            return Read(dest.hostname) && Read(dest.port);
+        }
+
+        bool Read( Json::Value & dest, int depth = 0 ) {
+            uint8_t tag;
+            if( depth > MAX_JSON_DEPTH || !Read(tag) )
+                return false;
+
+            switch( tag ) {
+            case J_NULL:
+                dest = Json::Value(Json::nullValue);
+                return true;
+            case J_FALSE:
+            case J_TRUE:
+                dest = Json::Value(tag == J_TRUE);
+                return true;
+            case J_INT: {
+                uint64_t val;
+                if( !ReadVarInt(val) )
+                    return false;
+                dest = Json::Value((Json::Int64) UnZigZag(val));
+                return true;
+            }
+            case J_UINT: {
+                uint64_t val;
+                if( !ReadVarInt(val) )
+                    return false;
+                dest = Json::Value((Json::UInt64) val);
+                return true;
+            }
+            case J_REAL: {
+                double val;
+                if( !Read(val) )
+                    return false;
+                dest = Json::Value(val);
+                return true;
+            }
+            case J_STRING: {
+                string val;
+                if( !ReadString(val) )
+                    return false;
+                dest = Json::Value(val);
+                return true;
+            }
+            case J_ARRAY: {
+                uint64_t n;
+                if( !ReadVarInt(n) )
+                    return false;
+                dest = Json::Value(Json::arrayValue);
+                for( uint64_t i = 0; i < n; i++ ) {
+                    if( !Read(dest[(Json::ArrayIndex) i], depth + 1) )
+                        return false;
+                }
+                return true;
+            }
+            case J_OBJECT: {
+                uint64_t n;
+                if( !ReadVarInt(n) )
+                    return false;
+                dest = Json::Value(Json::objectValue);
+                for( uint64_t i = 0; i < n; i++ ) {
+                    string key;
+                    if( !ReadString(key) || !Read(dest[key], depth + 1) )
+                        return false;
+                }
+                return true;
+            }
+            default:
+                return false;
+            }
+        }
+    };
+}
+
+void AppendToBinaryFrame( std::string & frame, RemoteMessage & msg ) {
+    if( frame.empty() )
+        frame.push_back((char) comm::BINARY_FRAME_VERSION);
+
+    HostAddress source = msg.getSource();
+    MailboxAddress dest = msg.getDest();
+    int64_t type = msg.getPayloadType();
+    Json::Value & payload = msg.getPayload();
+
+    uint32_t length = SerializedSize(source.hostname) + SerializedSize(source.port)
+        + SerializedSize(dest.host.hostname) + SerializedSize(dest.host.port)
+        + SerializedSize(dest.mailbox) + SerializedSize(type)
+        + JsonSize(payload);
+
+    // serialize in place at the end of the frame
+    size_t start = frame.size();
+    frame.resize(start + sizeof(length) + length);
+    char * cur = &frame[start];
+
+    cur += Serialize(cur, length);
+    cur += Serialize(cur, source.hostname);
+    cur += Serialize(cur, source.port);
+    cur += Serialize(cur, dest.host.hostname);
+    cur += Serialize(cur, dest.host.port);
+    cur += Serialize(cur, dest.mailbox);
+    cur += Serialize(cur, type);
+    cur += SerializeJson(cur, payload);
+
+    FATALIF( cur != frame.data() + frame.size(), "Binary frame size mismatch" );
+}
+
+bool DeliverBinaryFrame( const std::string & frame, const char * who ) {
+    FrameReader frameReader(frame.data(), frame.data() + frame.size());
+
+    uint8_t version;
+    if( !frameReader.Read(version) || version != comm::BINARY_FRAME_VERSION ) {
+        COMM_LOG_ERR("%s: Received binary frame of unknown version", who);
+        return false;
+    }
+
+    CommManager & commMan = CommManager::GetManager();
+    const char * cur = frame.data() + sizeof(version);
+    const char * end = frame.data() + frame.size();
+
+    while( cur < end ) {
+        uint32_t length;
+        if( (size_t) (end - cur) < sizeof(length) ) {
+            COMM_LOG_ERR("%s: Received truncated binary frame", who);
+            return false;
+        }
+        cur += Deserialize(cur, length);
+
+        if( (size_t) (end - cur) < length ) {
+            COMM_LOG_ERR("%s: Received truncated binary frame", who);
+            return false;
+        }
+
+        FrameReader reader(cur, cur + length);
+        cur += length;
+
+        HostAddress srcAddress;
+        MailboxAddress destAddress;
+        int64_t msgType;
+        Json::Value msgPayload;
+
+        if( !reader.Read(srcAddress) || !reader.Read(destAddress.host)
+                || !reader.Read(destAddress.mailbox) || !reader.Read(msgType)
+                || !reader.Read(msgPayload) || !reader.AtEnd() ) {
+            COMM_LOG_ERR("%s: Received malformed message in binary frame", who);
+            return false;
+        }
+
+        EventProcessor destProc;
+        int ret = commMan.GetEventProcessor( destAddress.mailbox, destProc );
+
+        if( ret == 0 ) {
+            RemoteMessageContainer_Factory( destProc, srcAddress, destAddress, msgType, msgPayload );
+        }
+        else {
+            COMM_LOG_ERR( "%s: Received message for invalid mailbox %s",
+                    who, destAddress.mailbox.c_str());
+        }
+    }
+
+    return true;
+}
@@ -21,6 +21,7 @@
 #include "RemoteMacros.h"
 #include "RemoteMessage.h"
 #include "CommConfig.h"
+#include "CommFrame.h"
 #include "json.h"
 
 #include <iostream>
@@ -112,13 +113,23 @@ HostAddress CommListenerImp :: GetAddressFromHDL( connection_hdl hdl ) {
  *  {
  *      "source"    : <HostAddress>
  *      "dest"      : <HostAddress>
+ *      "binary"    : <bool> (optional)
  *  }
+ *
+ *  If the HELLO says that the remote host accepts binary frames, we answer
+ *  with a HELLO saying that we do too and the NORMAL messages go in binary
+ *  frames (see CommFrame.h) in both directions.
  */
 void CommListenerImp::OnMessage( connection_hdl hdl, message_ptr msg ) {
     using comm::MessageType;
 
     const string & payload = msg->get_payload();
 
+    if( msg->get_opcode() == websocketpp::frame::opcode::BINARY ) {
+        DeliverBinaryFrame(payload, "CommListener");
+        return;
+    }
+
     Json::Reader jReader;
     Json::Value frame;
 
@@ -165,6 +176,26 @@ void CommListenerImp::OnMessage( connection_hdl hdl, message_ptr msg ) {
             // Tell the CommManager about the new connection.
             CommManager & commMan = CommManager::GetManager();
             commMan.ConnectionOpened(source, newConn);
+
+            if( comm::USE_BINARY_FRAMES && message.get("binary", false).asBool() ) {
+                // Let the remote host know that we accept binary frames too
+                Json::Value reply(Json::objectValue);
+                reply["type"] = static_cast<Json::UInt64>(MessageType::HELLO);
+                ToJson(commMan.GetHostAddress(), reply["msg"]["source"]);
+                ToJson(source, reply["msg"]["dest"]);
+                reply["msg"]["binary"] = true;
+
+                Json::FastWriter writer;
+                websocketpp::lib::error_code ec;
+                server->send(hdl, writer.write(reply), websocketpp::frame::opcode::TEXT, ec);
+
+                if( ec ) {
+                    COMM_LOG_ERR("CommListener: [%s] failed to answer hello message.", source.str().c_str());
+                }
+                else {
+                    commMan.BinaryFramesAccepted(source);
+                }
+            }
         } // message was a HELLO control message
         else {
             COMM_LOG_ERR(
@@ -386,6 +386,7 @@ void CommManager :: ConnectionOpened( const HostAddress & address, const ws_clie
     if( ! senders.IsThere(address) ) {
         HostAddress key = address;
         CommSender newSender(address, connection);
+        newSender.UseBinaryFrames(binaryPeers.count(address) > 0);
         newSender.ForkAndSpin();
 
         senders.Insert(key, newSender);
@@ -420,6 +421,7 @@ void CommManager :: ConnectionOpened( const HostAddress & address, const ws_serv
     if( ! senders.IsThere(address) ) {
         HostAddress key = address;
         CommSender newSender(address, connection);
+        newSender.UseBinaryFrames(binaryPeers.count(address) > 0);
         newSender.ForkAndSpin();
 
         senders.Insert(key, newSender);
@@ -435,7 +437,13 @@ void CommManager :: ConnectionOpened( const HostAddress & address, const ws_serv
 void CommManager :: ConnectionClosed( const HostAddress & address )
 {
     COMM_LOG_MSG("CommManager: Connection to address %s closed", address.str().c_str());
-    unique_lock_type(m_mutex);
+    unique_lock_type guard(m_mutex);
+
+    // The next connection has to say again that it accepts binary frames
+    binaryPeers.erase(address);
+    if( senders.IsThere(address) ) {
+        senders.Find(address).UseBinaryFrames(false);
+    }
 
     // If there was a client connection for this address, delete it
     if( clientConnections.IsThere(address) ) {
@@ -474,3 +482,14 @@ void CommManager :: GetConnection( const HostAddress & address, ws_server_pair &
     ws_server_pair tmp = serverConnections.Find(address);
     here.swap(tmp);
 }
+
+void CommManager :: BinaryFramesAccepted( const HostAddress & address )
+{
+    COMM_LOG_MSG("CommManager: Host [%s] accepts binary frames", address.str().c_str());
+    unique_lock_type guard(m_mutex);
+
+    binaryPeers.insert(address);
+    if( senders.IsThere(address) ) {
+        senders.Find(address).UseBinaryFrames(true);
+    }
+}
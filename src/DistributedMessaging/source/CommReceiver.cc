@@ -8,6 +8,7 @@
 #include "RemoteMacros.h"
 #include "RemoteMessage.h"
 #include "CommConfig.h"
+#include "CommFrame.h"
 #include "SerializeJson.h"
 
 #include <string>
@@ -192,6 +193,7 @@ void CommReceiverImp :: OnConnect( connection_hdl hdl ) {
     frame["type"] = static_cast<Json::UInt64>(comm::MessageType::HELLO);
     ToJson(commMan.GetHostAddress(), frame["msg"]["source"]);
     ToJson(addr, frame["msg"]["dest"]);
+    frame["msg"]["binary"] = comm::USE_BINARY_FRAMES;
 
     Json::FastWriter writer;
     std::string data = writer.write(frame);
@@ -223,6 +225,11 @@ void CommReceiverImp :: OnMessage( connection_hdl hdl, message_ptr msg ) {
 
     const string & payload = msg->get_payload();
 
+    if( msg->get_opcode() == websocketpp::frame::opcode::BINARY ) {
+        DeliverBinaryFrame(payload, "CommReceiver");
+        return;
+    }
+
     Json::Reader jReader;
     Json::Value frame;
 
@@ -254,6 +261,13 @@ void CommReceiverImp :: OnMessage( connection_hdl hdl, message_ptr msg ) {
                 COMM_LOG_ERR( "Received message for invalid mailbox %s", destAddress.mailbox.c_str());
             }
         } // message is standard type
+        else if( mType == MessageType::HELLO && message.get("binary", false).asBool() ) {
+            // The listener answered our hello, it accepts binary frames
+            if( comm::USE_BINARY_FRAMES ) {
+                CommManager & commMan = CommManager::GetManager();
+                commMan.BinaryFramesAccepted( GetAddressFromHDL(hdl) );
+            }
+        } // message was a HELLO answer
         else if( mType == MessageType::HELLO ) {
             COMM_LOG_ERR(
                     "CommReceiver: [%s] "
@@ -19,6 +19,7 @@
 #include "Errors.h"
 #include "Logging.h"
 #include "CommManager.h"
+#include "CommFrame.h"
 
 #include <iostream>
 #include <sstream>
@@ -34,7 +35,8 @@ CommSenderImp::CommSenderImp(const HostAddress & _remoteMachine,
     addr(_remoteMachine),
     client_conn(_conn),
     attachedToServer(false),
-    isActive(false)
+    isActive(false),
+    binaryFrames(false)
 #ifdef DEBUG_EVPROC
     , EventProcessorImp(true, "CommSender") // comment to remove debug
 #endif
@@ -51,7 +53,8 @@ CommSenderImp::CommSenderImp(const HostAddress & _remoteMachine,
     addr(_remoteMachine),
     server_conn(_conn),
     attachedToServer(true),
-    isActive(false)
+    isActive(false),
+    binaryFrames(false)
 #ifdef DEBUG_EVPROC
     , EventProcessorImp(true, "CommSender") // comment to remove debug
 #endif
@@ -63,7 +66,7 @@ CommSenderImp::CommSenderImp(const HostAddress & _remoteMachine,
     RegisterMessageProcessor(RemoteMessage::type, &ProcessRemoteMessage, 1 /*priority*/);
 }
 
-void CommSenderImp :: SendMessage( const std::string & data ) {
+void CommSenderImp :: SendMessage( const std::string & data, websocketpp::frame::opcode::value opcode ) {
     bool sent = false;
     while( !sent ) {
         websocketpp::lib::error_code ec;
@@ -72,10 +75,10 @@ void CommSenderImp :: SendMessage( const std::string & data ) {
             ws_server_ptr & endpoint = server_conn.first;
             connection_hdl & handle = server_conn.second;
 
-            endpoint->send(handle, data, websocketpp::frame::opcode::TEXT, ec);
+            endpoint->send(handle, data, opcode, ec);
         }
         else {
-            ec = client_conn->send(data);
+            ec = client_conn->send(data, opcode);
         }
 
         if( ec ) {
@@ -107,19 +110,37 @@ void CommSenderImp :: SendMessage( const std::string & data ) {
     }
 }
 
+void CommSenderImp :: FlushBatch( void ) {
+    if( !batch.empty() ) {
+        SendMessage(batch, websocketpp::frame::opcode::BINARY);
+        batch.clear();
+    }
+}
+
 MESSAGE_HANDLER_DEFINITION_BEGIN(CommSenderImp, ProcessRemoteMessage, RemoteMessage){
 
-    // Serialize the remote message.
-    Json::Value toSend;
-    toSend["type"] = static_cast<Json::UInt64>(comm::MessageType::NORMAL);
-    msg.ToJson(toSend["msg"]);
+    if( evProc.binaryFrames ) {
+        AppendToBinaryFrame(evProc.batch, msg);
 
-    // Convert to a string
-    Json::FastWriter writer;
-    std::string sData = writer.write(toSend);
+        // Keep filling the frame while there are more messages to send
+        if( evProc.NumPendingMessages() == 0 || evProc.batch.size() >= comm::BINARY_BATCH_BYTES )
+            evProc.FlushBatch();
+    }
+    else {
+        // Keep the order of the messages if we just switched to text frames
+        evProc.FlushBatch();
 
-    evProc.SendMessage(sData);
+        // Serialize the remote message.
+        Json::Value toSend;
+        toSend["type"] = static_cast<Json::UInt64>(comm::MessageType::NORMAL);
+        msg.ToJson(toSend["msg"]);
 
+        // Convert to a string
+        Json::FastWriter writer;
+        std::string sData = writer.write(toSend);
+
+        evProc.SendMessage(sData, websocketpp::frame::opcode::TEXT);
+    }
 
 }MESSAGE_HANDLER_DEFINITION_END
 
@@ -129,6 +150,9 @@ CommSenderImp::~CommSenderImp() {
 }
 
 int CommSenderImp::Close() {
+    if( isActive )
+        FlushBatch();
+
     isActive = false;
 
     return 0;
@@ -76,6 +76,9 @@ private:
     // ask the execution engine to deliver some message
     int DeliverSomeMessage ();
 
+    // puts a token request on the queue of its type and schedules its delivery
+    void QueueTokenRequest (TokenRequest &request, off_t requestType);
+
     // these manipulate the central FIFO queue
     void InsertRequest (int requestID);
     int AreRequests ();
@@ -191,12 +194,16 @@ struct TokenRequest {
     WayPointID whoIsAsking;
     int priority;
 
+    // when the request was made, to trace how long the token took (see Tracer.h)
+    int64_t requestTime;
+
     TokenRequest () {}
     ~TokenRequest () {}
 
-    TokenRequest (WayPointID whoIn, int priorityIn) {
+    TokenRequest (WayPointID whoIn, int priorityIn, int64_t requestTimeIn) {
         whoIsAsking = whoIn;
         priority = priorityIn;
+        requestTime = requestTimeIn;
     }
 
     void swap (TokenRequest &withMe) {
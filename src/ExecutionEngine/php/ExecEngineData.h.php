@@ -39,6 +39,8 @@ require_once('DataFunctions.php');
 #include "ServiceData.h"
 
 #include <cstdint>
+#include <map>
+#include <utility>
 
 // this file has all of the data types that can be sent downstream thru the
 // data path graph
@@ -69,10 +71,17 @@ grokit\create_data_type( "StateContainer", "ExecEngineData", [ ], [ 'source' =>
 ?>
 
 
+// the range of the join key of the RHS tuples of each query (min > max if the
+// query had no tuples)
+typedef std::pair<int64_t, int64_t> JoinKeyRange;
+typedef std::map<QueryID, JoinKeyRange> QueryToJoinKeyRange;
+
 // this is what is returned by a join worker that has put data into the hash table.
-// It lists a small sample of the collisions that were found to happen
+// It lists a small sample of the collisions that were found to happen. For joins on
+// a single integer key, the RHS also returns the key ranges of the queries and the
+// slot of the LHS key they apply to (-1 if none)
 <?php
-grokit\create_data_type( "JoinHashResult", "ExecEngineData", [ ], [ 'sampledQueries' => 'HashSegmentSample', ] );
+grokit\create_data_type( "JoinHashResult", "ExecEngineData", [ 'keySlot' => 'int', 'keyRanges' => 'QueryToJoinKeyRange', ], [ 'sampledQueries' => 'HashSegmentSample', ] );
 ?>
 
 
@@ -109,7 +118,8 @@ grokit\create_data_type(
 	[ ],
 	[
 		'constStates' => 'QueryToGLAStateMap',
-		'produceIntermediates' => 'QueryIDSet'
+		'produceIntermediates' => 'QueryIDSet',
+		'partitionedMerge' => 'QueryIDSet'
 	]
 );
 ?>
@@ -55,6 +55,14 @@ grokit\create_data_type( "StartProducingMsg", "Notification", [ ], [ 'whichOne'
 ?>
 
 
+// this is sent upstream by a join right before it lets the LHS of a query exit start. It
+// has the range of the join key over the RHS tuples of the query; the table scan that
+// produces keySlot uses it to skip chunks, everybody else passes it on
+<?php
+grokit\create_data_type( "JoinKeyRangeMsg", "Notification", [ 'keySlot' => 'int', 'keyRange' => 'JoinKeyRange', ], [ 'whichOne' => 'QueryExit', ] );
+?>
+
+
 // this is used to notify the hash cleaner that some segments were too full... contains
 //  set of sampled entries from all of the too-full segments
 <?php
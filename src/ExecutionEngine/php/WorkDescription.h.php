@@ -32,6 +32,7 @@ require_once('DataFunctions.php');
 #include "Chunk.h"
 #include "AggStorageMap.h"
 #include "HashTable.h"
+#include "JoinFilter.h"
 #include "JoinWayPointID.h"
 #include "ExecEngineData.h"
 #include "GIStreamInfo.h"
@@ -114,15 +115,16 @@ grokit\create_data_type( "FinishAggregate", "WorkDescription", [ ], [ 'whichQuer
 // this one is for the LHS of a join (the probing side)... note that wayPointID is NOT the
 // same thing as the the WayPointID associated with one of the waypoints.  It is a unique int,
 // managed by the JoinWayPointImp class, that is associated with each join way point.  It is
-// put into the central hash table so that we do not mix tuples from different join waypoints
+// put into the central hash table so that we do not mix tuples from different join waypoints.
+// joinFilter is the filter of the RHS hashes of the join waypoint (see JoinFilter.h)
 <?php
-grokit\create_data_type( "JoinLHSWorkDescription", "WorkDescription", [ 'wayPointID' => 'int', ], [ 'whichQueryExits' => 'QueryExitContainer', 'chunkToProcess' => 'Chunk', 'centralHashTable' => 'HashTable', ] );
+grokit\create_data_type( "JoinLHSWorkDescription", "WorkDescription", [ 'wayPointID' => 'int', ], [ 'whichQueryExits' => 'QueryExitContainer', 'chunkToProcess' => 'Chunk', 'centralHashTable' => 'HashTable', 'joinFilter' => 'JoinFilter', ] );
 ?>
 
 
 // this one is for the RHS of a join (the hashing side)
 <?php
-grokit\create_data_type( "JoinRHSWorkDescription", "WorkDescription", [ 'wayPointID' => 'int', ], [ 'whichQueryExits' => 'QueryExitContainer', 'chunkToProcess' => 'Chunk', 'centralHashTable' => 'HashTable', ] );
+grokit\create_data_type( "JoinRHSWorkDescription", "WorkDescription", [ 'wayPointID' => 'int', ], [ 'whichQueryExits' => 'QueryExitContainer', 'chunkToProcess' => 'Chunk', 'centralHashTable' => 'HashTable', 'joinFilter' => 'JoinFilter', ] );
 ?>
 
 
@@ -184,9 +186,13 @@ grokit\create_data_type( "GLAProcessChunkWD", "WorkDescription", [ ], [ 'whichQu
 
 /*** work description for GLAMergeStatesWorkFunc
      glaStates contains a list of states for each query
+     partitions specifies, for the queries merged with the partitioned merge,
+     the partition to merge. The states are not consumed in that case.
+     A partition of -1 means all partitions were merged and the states other
+     than the first one have to be finished and deleted.
 */
 <?php
-grokit\create_data_type( "GLAMergeStatesWD", "WorkDescription", [ ], [ 'whichQueryExits' => 'QueryExitContainer', 'glaStates' => 'QueryToGLASContMap', ] );
+grokit\create_data_type( "GLAMergeStatesWD", "WorkDescription", [ ], [ 'whichQueryExits' => 'QueryExitContainer', 'glaStates' => 'QueryToGLASContMap', 'partitions' => 'QueryIDToInt', ] );
 ?>
 
 
@@ -21,6 +21,7 @@
 #include "Diagnose.h"
 #include "DiskPool.h"
 #include "CommunicationFramework.h"
+#include "Tracer.h"
 
 // these are the codes for the various message types handled by the exec engine
 // these are only used internally, within the exec engine
@@ -92,7 +93,7 @@ ExecEngineImp :: ExecEngineImp (const std::string & _mailbox) :
     RegisterMessageProcessor (ServiceControlMessage::type, &ServiceControlMessage_H, 2);
 
     // create and load up all of the CPU tokens
-    for (int i = 0; i < NUM_EXEC_ENGINE_THREADS; i++) {
+    for (int i = 0; i < NUM_CPU_TOKENS; i++) {
         CPUWorkToken temp(i + 100);
         unusedCPUTokens.Insert (temp);
     }
@@ -362,6 +363,11 @@ int ExecEngineImp :: DeliverSomeMessage () {
                 FATAL ("I could not find a waypoint who had requested a token!");
             }
 
+            if (whoIsAsking.requestTime != 0) {
+                Tracer::AsyncSpan ("token", (whoIsAsking.whoIsAsking.getName () + " cpu").c_str (),
+                    whoIsAsking.requestTime, Tracer::Now (), whoIsAsking.priority);
+            }
+
             WayPoint &thisOne = myWayPoints.Find (whoIsAsking.whoIsAsking);
             thisOne.RequestGranted (workToken);
             return 1;
@@ -395,6 +401,11 @@ int ExecEngineImp :: DeliverSomeMessage () {
                 FATAL ("I could not find a waypoint who had requested a token!");
             }
 
+            if (whoIsAsking.requestTime != 0) {
+                Tracer::AsyncSpan ("token", (whoIsAsking.whoIsAsking.getName () + " disk").c_str (),
+                    whoIsAsking.requestTime, Tracer::Now (), whoIsAsking.priority);
+            }
+
             WayPoint &thisOne = myWayPoints.Find (whoIsAsking.whoIsAsking);
             thisOne.RequestGranted (workToken);
             return 1;
@@ -449,7 +460,11 @@ int ExecEngineImp :: RequestTokenImmediate (WayPointID &whoIsAsking, off_t reque
 void ExecEngineImp :: RequestTokenDelayOK (WayPointID &whoIsAsking, off_t requestType, int priority) {
 
     // create a work request
-    TokenRequest temp (whoIsAsking, priority);
+    TokenRequest temp (whoIsAsking, priority, Tracer::IsEnabled () ? Tracer::Now () : 0);
+    QueueTokenRequest (temp, requestType);
+}
+
+void ExecEngineImp :: QueueTokenRequest (TokenRequest &temp, off_t requestType) {
 
     // we cannot, so shove the request on a queue
     // first, we look to give out a CPU work token
@@ -721,7 +736,8 @@ void ExecEngineImp :: SetPriorityCutoff (off_t requestType, int priority) {
             if (frozenOutFromCPU.Current ().priority <= priority) {
                 TokenRequest temp;
                 frozenOutFromCPU.Remove (temp);
-                RequestTokenDelayOK (temp.whoIsAsking, CPUWorkToken :: type, temp.priority);
+                // requeued as it was so the wait traced includes the time frozen
+                QueueTokenRequest (temp, CPUWorkToken :: type);
             } else {
                 frozenOutFromCPU.Advance ();
             }
@@ -739,7 +755,8 @@ void ExecEngineImp :: SetPriorityCutoff (off_t requestType, int priority) {
             if (frozenOutFromDisk.Current ().priority <= priority) {
                 TokenRequest temp;
                 frozenOutFromDisk.Remove (temp);
-                RequestTokenDelayOK (temp.whoIsAsking, DiskWorkToken :: type, temp.priority);
+                // requeued as it was so the wait traced includes the time frozen
+                QueueTokenRequest (temp, DiskWorkToken :: type);
             } else {
                 frozenOutFromDisk.Advance ();
             }
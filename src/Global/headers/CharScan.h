@@ -0,0 +1,147 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef _CHAR_SCAN_H_
+#define _CHAR_SCAN_H_
+
+/** Character scanning used by the text readers (record and field splitting)
+    and by the string predicates (substring search).
+    The scans look at 16 bytes at a time with SSE2 when it is available, 32
+    with AVX2.
+*/
+
+#include <cstddef>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Returns the first occurrence of c in [begin, end) or end if there is none.
+// memchr is vectorized by the C library.
+inline char* FindChar(char* begin, char* end, char c) {
+    char* found = (char*) memchr(begin, c, end - begin);
+    return found != NULL ? found : end;
+}
+
+// Splits the record [begin, end) at the delimiters. The delimiters are
+// replaced by '\0' and the start of each field is put in fields. At most
+// maxFields (at least 1) fields are found, the delimiter ending the last
+// one is still replaced. The record is expected to be followed by '\0'.
+// Returns the number of fields found.
+inline size_t SplitFields(char* begin, char* end, char delim, char** fields, size_t maxFields) {
+    size_t n = 0;
+    fields[n++] = begin;
+
+    char* p = begin;
+
+#ifdef __SSE2__
+    const __m128i pattern = _mm_set1_epi8(delim);
+    for (; p + 16 <= end; p += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*) p);
+        unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern));
+
+        while (mask != 0) {
+            char* at = p + __builtin_ctz(mask);
+            *at = '\0';
+            if (n == maxFields)
+                return n;
+            fields[n++] = at + 1;
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; p < end; p++) {
+        if (*p == delim) {
+            *p = '\0';
+            if (n == maxFields)
+                return n;
+            fields[n++] = p + 1;
+        }
+    }
+
+    return n;
+}
+
+// Returns the first occurrence of needle (nlen bytes) in hay (hlen bytes) or
+// NULL if there is none.
+// The first and the last byte of the needle are compared with a block of
+// candidate positions at once, and only the positions where both match are
+// checked with memcmp.
+inline const char* FindSubstring(const char* hay, size_t hlen, const char* needle, size_t nlen) {
+    if (nlen == 0)
+        return hay;
+    if (nlen > hlen)
+        return NULL;
+    if (nlen == 1)
+        return (const char*) memchr(hay, needle[0], hlen);
+
+    const char* p = hay;
+    // last position where the needle can start
+    const char* last = hay + hlen - nlen;
+
+#ifdef __AVX2__
+    const __m256i first32 = _mm256_set1_epi8(needle[0]);
+    const __m256i last32 = _mm256_set1_epi8(needle[nlen - 1]);
+    for (; p + 32 <= last + 1; p += 32) {
+        __m256i blockFirst = _mm256_loadu_si256((const __m256i*) p);
+        __m256i blockLast = _mm256_loadu_si256((const __m256i*) (p + nlen - 1));
+        unsigned int mask = _mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(blockFirst, first32), _mm256_cmpeq_epi8(blockLast, last32)));
+
+        while (mask != 0) {
+            const char* at = p + __builtin_ctz(mask);
+            if (memcmp(at + 1, needle + 1, nlen - 2) == 0)
+                return at;
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+#ifdef __SSE2__
+    const __m128i first16 = _mm_set1_epi8(needle[0]);
+    const __m128i last16 = _mm_set1_epi8(needle[nlen - 1]);
+    for (; p + 16 <= last + 1; p += 16) {
+        __m128i blockFirst = _mm_loadu_si128((const __m128i*) p);
+        __m128i blockLast = _mm_loadu_si128((const __m128i*) (p + nlen - 1));
+        unsigned int mask = _mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(blockFirst, first16), _mm_cmpeq_epi8(blockLast, last16)));
+
+        while (mask != 0) {
+            const char* at = p + __builtin_ctz(mask);
+            if (memcmp(at + 1, needle + 1, nlen - 2) == 0)
+                return at;
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; p <= last; p++) {
+        p = (const char*) memchr(p, needle[0], last - p + 1);
+        if (p == NULL)
+            return NULL;
+        if (memcmp(p + 1, needle + 1, nlen - 1) == 0)
+            return p;
+    }
+
+    return NULL;
+}
+
+#endif // _CHAR_SCAN_H_
@@ -0,0 +1,75 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef _LIKE_PATTERN_H_
+#define _LIKE_PATTERN_H_
+
+#include <string>
+#include <vector>
+
+// General LIKE matcher (FastLike.cc). '%' matches any sequence of characters,
+// '_' any single character and '\' escapes the next character.
+bool LikeBody(const char *t, const char *p);
+
+/** SQL LIKE pattern compiled once and matched against many strings.
+
+    The patterns without '_' are the literal segments between the '%'. They
+    are classified so that the common cases are a single comparison or
+    substring search (see FindSubstring in CharScan.h):
+
+      EXACT     'foo'           the whole string
+      PREFIX    'foo%'          start of the string
+      SUFFIX    '%foo'          end of the string
+      CONTAINS  '%foo%'         anywhere
+      SEGMENTS  'a%b%c'         the first segment at the start, the last at
+                                the end and the ones in between in order
+
+    The other patterns go through LikeBody.
+*/
+class LikePattern {
+public:
+    enum Kind {
+        EXACT,
+        PREFIX,
+        SUFFIX,
+        CONTAINS,
+        SEGMENTS,
+        GENERAL
+    };
+
+private:
+    Kind kind;
+
+    // Original pattern, used by GENERAL
+    std::string pattern;
+
+    // Literal segments between the '%' (escapes removed). The first and the
+    // last one are anchored and may be empty.
+    std::vector<std::string> segments;
+
+    // Total length of the segments, no shorter string can match
+    size_t minLength;
+
+    bool MatchSegments( const char * target, size_t length ) const;
+
+public:
+    LikePattern( const char * pattern );
+
+    Kind GetKind( void ) const { return kind; }
+
+    bool Match( const char * target ) const;
+};
+
+#endif // _LIKE_PATTERN_H_
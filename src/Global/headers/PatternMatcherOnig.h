@@ -18,6 +18,7 @@
 #define _PATTERN_MATCHER_ONIG_H_
 
 #include <mutex>
+#include <string>
 #include "Errors.h"
 
 #include <oniguruma.h>
@@ -33,6 +34,16 @@ private:
 
     regex_t* reg;       // The compiled regular expression
 
+    // A literal that every match contains, found when the expression is
+    // compiled (empty if there is none). The targets that do not contain it
+    // are rejected with a substring search, without running the matcher.
+    std::string required;
+
+    // Finds the longest literal that has to appear in the matches of the
+    // expression. Only the top level of the expression is looked at, and
+    // nothing is found if it has alternatives or options.
+    static std::string RequiredLiteral( const char * regexp );
+
 public:
 
     // Constructor
@@ -2,6 +2,9 @@
 #define SERIALIZE_BINARY_H
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
 
 // Default functions for Serialize/Deserialize
 
@@ -29,4 +32,31 @@ size_t Deserialize(const char * buffer, DataType& dest) {
     return sizeof(DataType);
 }
 
+// std::string: 32 bit length followed by the characters
+
+template <>
+inline size_t SizeFromBuffer<std::string>(const char * buffer) {
+    uint32_t length;
+    memcpy(&length, buffer, sizeof(length));
+    return sizeof(length) + length;
+}
+
+inline size_t SerializedSize(const std::string& src) {
+    return sizeof(uint32_t) + src.size();
+}
+
+inline size_t Serialize(char * buffer, const std::string& src) {
+    uint32_t length = src.size();
+    memcpy(buffer, &length, sizeof(length));
+    memcpy(buffer + sizeof(length), src.data(), length);
+    return sizeof(length) + length;
+}
+
+inline size_t Deserialize(const char * buffer, std::string& dest) {
+    uint32_t length;
+    memcpy(&length, buffer, sizeof(length));
+    dest.assign(buffer + sizeof(length), length);
+    return sizeof(length) + length;
+}
+
 #endif // SERIALIZE_BINARY_H
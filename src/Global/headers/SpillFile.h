@@ -0,0 +1,120 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef SPILL_FILE_H
+#define SPILL_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "SerializeBinary.h"
+#include "Errors.h"
+
+/** Temporary files the GLAs write their tuples to when they run out of
+    memory (see GroupBy and OrderBy).
+
+    A spill file is a sequence of records. Each record is the size of the
+    serialized values (32 bits) followed by the values, serialized with the
+    functions of SerializeBinary.h.
+*/
+
+// Creates a spill file in dir. The file has no name, it goes away when closed
+inline FILE * NewSpillFile(const char * dir, const char * prefix) {
+    std::string pattern = std::string(dir) + "/" + prefix + "_XXXXXX";
+    std::vector<char> name(pattern.begin(), pattern.end());
+    name.push_back('\0');
+
+    int fd = mkstemp(name.data());
+    FATALIF(fd < 0, "Could not create a spill file in %s: %s", dir, strerror(errno));
+    unlink(name.data());
+    FILE * file = fdopen(fd, "w+");
+    FATALIF(file == NULL, "Could not open the spill file %s", name.data());
+    return file;
+}
+
+inline size_t SerializedSizeOfValues() {
+    return 0;
+}
+
+template <class Value, class... Values>
+size_t SerializedSizeOfValues(const Value & value, const Values &... values) {
+    return SerializedSize(value) + SerializedSizeOfValues(values...);
+}
+
+inline size_t SerializeValues(char * buffer) {
+    return 0;
+}
+
+template <class Value, class... Values>
+size_t SerializeValues(char * buffer, const Value & value, const Values &... values) {
+    size_t size = Serialize(buffer, value);
+    return size + SerializeValues(buffer + size, values...);
+}
+
+inline size_t DeserializeValues(const char * buffer) {
+    return 0;
+}
+
+template <class Value, class... Values>
+size_t DeserializeValues(const char * buffer, Value & value, Values &... values) {
+    size_t size = Deserialize(buffer, value);
+    return size + DeserializeValues(buffer + size, values...);
+}
+
+/** Appends one record with the values to the file. buffer is scratch space,
+    kept by the caller so that it is not allocated for every record.
+
+    Returns the size of the record in the file.
+*/
+template <class... Values>
+size_t WriteSpillRecord(FILE * file, std::vector<char> & buffer, const Values &... values) {
+    uint32_t size = SerializedSizeOfValues(values...);
+    buffer.resize(sizeof(size) + size);
+    memcpy(buffer.data(), &size, sizeof(size));
+    SerializeValues(buffer.data() + sizeof(size), values...);
+
+    FATALIF(fwrite(buffer.data(), buffer.size(), 1, file) != 1,
+        "Could not write to a spill file: %s", strerror(errno));
+    return buffer.size();
+}
+
+/** Reads the next record of the file in record, without the size.
+    Returns false at the end of the file.
+*/
+inline bool ReadSpillRecord(FILE * file, std::vector<char> & record) {
+    uint32_t size;
+    if( fread(&size, sizeof(size), 1, file) != 1 )
+        return false;
+
+    record.resize(size);
+    FATALIF(size > 0 && fread(record.data(), size, 1, file) != 1,
+        "Truncated spill file");
+    return true;
+}
+
+// Goes back to the start of the file, to read back what was written
+inline void RewindSpillFile(FILE * file) {
+    FATALIF(fflush(file) != 0 || fseek(file, 0, SEEK_SET) != 0,
+        "Could not read back a spill file: %s", strerror(errno));
+}
+
+#endif // SPILL_FILE_H
@@ -39,13 +39,20 @@ require_once('grokit_config.php');
 
 /*
 ==================Central hash table parameters==================
-* - NUM_SLOTS_IN_SEGMENT_BITS: This should not be over 24 bits if the size of a chunk is 2M tuples.
+* - MAX_SLOTS_IN_SEGMENT_BITS: This should not be over 24 bits if the size of a chunk is 2M tuples.
 *     This size works well and Cleaner produces reasonably sized chunks.
+*     The actual size of the segments (NUM_SLOTS_IN_SEGMENT_BITS) is chosen when the hash
+*     table is allocated so that the table fits in HASH_TABLE_MEMORY_FRACTION of the memory
+*     of the machine, between MIN_SLOTS_IN_SEGMENT_BITS and this (see HashTable::Allocate).
 * - NUM_SEGS: This should be manipulated to use most memory in the system (about 70%).
 *     Make sure it is set to a sum of few 2^k numbers so that % operator is implemented
 *     efficiently by the compiler.
 */
-#define NUM_SLOTS_IN_SEGMENT_BITS <?=$__grokit_config_segment_bits?>
+#define MAX_SLOTS_IN_SEGMENT_BITS <?=$__grokit_config_segment_bits?>
+
+#define MIN_SLOTS_IN_SEGMENT_BITS 16
+
+#define HASH_TABLE_MEMORY_FRACTION .6
 
 #define NUM_SEGS <?=$__grokit_config_num_segs?>
 
@@ -69,6 +76,16 @@ require_once('grokit_config.php');
 
 
 
+/*
+==================Tracer Constants==================
+* - TRACE_BUFFER_EVENTS: Number of events kept by each thread when tracing (see Tracer.h). Older events are overwritten
+* - TRACE_NAME_LENGTH: Longer event names are truncated
+*/
+#define TRACE_BUFFER_EVENTS (1<<15)
+#define TRACE_NAME_LENGTH 40
+
+
+
 /*
 ==================Metadata filename==================
 */
@@ -99,11 +116,76 @@ require_once('grokit_config.php');
 #define PREFERED_TUPLES_PER_CHUNK ( 2*1024*1023 )
 
 
+/* Number of tuples buffered by the generated GLA ProcessChunk before they are
+   handed to the AddItems() of GLAs that support batches. The buffers live on
+   the stack so this should stay small enough to fit in the L1/L2 caches.
+*/
+#define GLA_BATCH_SIZE 1024
+
+
+/* Number of parallel jobs used to merge the states of GLAs that support the
+   partitioned merge (each job merges one hash partition of all the states).
+*/
+#define GLA_MERGE_PARTITIONS 16
+
+
+/* Number of tuples whose hash table slots are prefetched together by the
+   LHS of the join. The hashes of a batch are computed first and all the
+   slots are prefetched, so the cache misses overlap.
+*/
+#define JOIN_LHS_PROBE_BATCH 32
+
+
+/* Runtime join filters. If set to 1, the RHS of each join builds a Bloom
+   filter of the join hashes that the LHS checks before probing the hash
+   table, and the range of single integer keys is pushed to the scans of
+   the LHS so they skip the chunks that cannot match (see JoinFilter.h).
+   JOIN_FILTER_BITS is the log2 of the size of the filter in bits, one per
+   join waypoint (2^24 bits is 2MB).
+*/
+#define JOIN_RUNTIME_FILTERS 1
+#define JOIN_FILTER_BITS 24
+
+
+/* Size in bytes of the ranges the GI waypoint splits large regular files in.
+   The ranges are aligned at line boundaries and read in parallel by the GIs
+   that support it (the 'splittable' property). Set to 0 to read each file
+   with a single stream.
+*/
+#define GI_SPLIT_BYTES (1LL<<28) /* 256MB */
+
+
 /* Number of threads available for the execution engine. This should be # Processors x 1.5
 */
 #define NUM_EXEC_ENGINE_THREADS <?=$__grokit_config_exec_threads?>
 
 
+/* Scheduling of the CPU work. If set to 1, the work is queued in per worker
+   deques and idle workers steal work from the others (see CPUWorkerPool).
+   If set to 0, each piece of work is sent to a free CPUWorker as a message.
+   Work stealing is experimental: it has not been run on real workloads yet,
+   so the message mode stays the default.
+*/
+#define CPU_WORK_STEALING 0
+
+
+/* Number of CPU tokens per CPU worker when work stealing is used. With more
+   than one token per worker, work is queued while the execution engine deals
+   with the results of the previous one. The tokens are still given out by the
+   execution engine so the priority cutoffs act as admission control.
+*/
+#define CPU_TOKENS_PER_WORKER 2
+
+
+/* Total number of CPU tokens given out by the execution engine
+*/
+#if CPU_WORK_STEALING
+#define NUM_CPU_TOKENS (NUM_EXEC_ENGINE_THREADS * CPU_TOKENS_PER_WORKER)
+#else
+#define NUM_CPU_TOKENS NUM_EXEC_ENGINE_THREADS
+#endif
+
+
 /* How many disk tokens we allow (this controls the parallelism)
 */
 #define NUM_DISK_TOKENS <?=$__grokit_config_disk_tokens?>
@@ -114,16 +196,79 @@ require_once('grokit_config.php');
 #define FILE_SCANNER_MAX_NO_CHUNKS_REQUEST 5
 
 
+/* Memory budgets in bytes, 0 for no limit (see MemoryAccounting.h). They can be
+   changed with the options -m and -M of datapath.
+   - QUERY_MEMORY_BUDGET: a query above it gets its table scans throttled
+   - GLOBAL_MEMORY_BUDGET: when the queries together use more, all the table
+     scans are throttled and new queries wait for running ones to finish
+     before they start. The memory of no query (hash segments) is not counted
+*/
+#define QUERY_MEMORY_BUDGET 0
+#define GLOBAL_MEMORY_BUDGET 0
+
+
+/* Maximum number of chunks built in parallel by a file scanner that is
+   throttled because its queries are over their memory budget.
+*/
+#define FILE_SCANNER_THROTTLED_NO_CHUNKS_REQUEST 1
+
+
+/* Control of the number of chunks a producer (table scan, GI) has in flight
+   for a query, i.e. produced and not yet acknowledged (see SpeedCtrl.h).
+   - SPEED_CTRL_INITIAL_WINDOW: chunks allowed in flight when a query starts
+   - SPEED_CTRL_MAX_WINDOW: chunks allowed in flight at most
+   - SPEED_CTRL_LATENCY_FACTOR: the window shrinks when the chunks take more
+     than this many times the lowest latency seen to be acknowledged
+*/
+#define SPEED_CTRL_INITIAL_WINDOW 2
+#define SPEED_CTRL_MAX_WINDOW 64
+#define SPEED_CTRL_LATENCY_FACTOR 2.0
+
+
 /* Fraction of threads that need to be available to use compressed data
 */
 #define USE_UNCOMPRESSED_THRESHOLD .1
 
 
+/* If set to 1, the columns are compressed when written and both the compressed
+   and the uncompressed versions go to disk. The codec of each column depends on
+   its type (see ColumnCodec.h). Off by default: the compression runs on the
+   ChunkReaderWriter thread writing the chunk and slows the loading down.
+*/
+#define COLUMN_COMPRESSION 0
+
+
+/* The compressed version of a column is read only if it is at most this
+   fraction of the uncompressed one. Otherwise the decompression is not worth it.
+*/
+#define COLUMN_COMPRESSION_MAX_RATIO .75
+
+
+/* Caches of small blocks kept by each thread in the memory allocator
+   (see NumaMemoryAllocator.h). A block freed by a thread other than the one
+   that allocated it goes back to the shared heap, not in a cache.
+   - NUMA_CACHE_LIST_PAGES: pages cached per thread for each node and size
+   - NUMA_CACHE_THREAD_PAGES: pages cached by a thread over all the sizes
+*/
+#define NUMA_CACHE_LIST_PAGES 16
+#define NUMA_CACHE_THREAD_PAGES 32
+
+
 /* Maximum number of threads running in the ChunkReaderWriter (serving messages).
 */
 #define CHUNK_RW_THREADS 12
 
 
+/* Maximum number of outstanding asynchronous requests per disk stripe.
+   If larger than 1, the stripes are driven by HDThreadAsyncImp that submits all
+   the pages of a request at once through the native AIO interface. Set to 1 to
+   use the blocking HDThreadImp (one read/write at a time per stripe), the
+   default until the asynchronous driver is validated on more devices; 32 is a
+   good value for NVMe drives.
+*/
+#define DISK_IO_QUEUE_DEPTH 1
+
+
 /* Duration between disk operation statistics computation.
    The smaller the value, the more often the statistics are computed.
 */
@@ -0,0 +1,115 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#include "LikePattern.h"
+#include "CharScan.h"
+
+#include <cstring>
+
+using namespace std;
+
+LikePattern :: LikePattern( const char * _pattern ) :
+    kind(GENERAL),
+    pattern(_pattern),
+    segments(1),
+    minLength(0)
+{
+    // Split at the '%', removing the escapes. Any '_' needs the general
+    // matcher.
+    bool afterPercent = false;
+    for( const char * p = _pattern; *p != '\0'; p++ ) {
+        if( *p == '\\' ) {
+            p++;
+            if( *p == '\0' )
+                return; // dangling escape, matches nothing in LikeBody
+            segments.back().push_back(*p);
+            afterPercent = false;
+        }
+        else if( *p == '%' ) {
+            // '%%' is the same as '%'
+            if( !afterPercent )
+                segments.push_back(string());
+            afterPercent = true;
+        }
+        else if( *p == '_' ) {
+            return;
+        }
+        else {
+            segments.back().push_back(*p);
+            afterPercent = false;
+        }
+    }
+
+    for( const string & seg : segments )
+        minLength += seg.size();
+
+    size_t n = segments.size();
+    if( n == 1 )
+        kind = EXACT;
+    else if( n == 2 && segments[1].empty() )
+        kind = PREFIX;
+    else if( n == 2 && segments[0].empty() )
+        kind = SUFFIX;
+    else if( n == 3 && segments[0].empty() && segments[2].empty() )
+        kind = CONTAINS;
+    else
+        kind = SEGMENTS;
+}
+
+bool LikePattern :: MatchSegments( const char * target, size_t length ) const {
+    if( length < minLength )
+        return false;
+
+    const string & first = segments.front();
+    const string & last = segments.back();
+
+    if( memcmp(target, first.data(), first.size()) != 0
+            || memcmp(target + length - last.size(), last.data(), last.size()) != 0 )
+        return false;
+
+    // The middle segments are searched between the anchored ones
+    const char * cur = target + first.size();
+    const char * end = target + length - last.size();
+    for( size_t i = 1; i + 1 < segments.size(); i++ ) {
+        const string & seg = segments[i];
+        const char * found = FindSubstring(cur, end - cur, seg.data(), seg.size());
+        if( found == NULL )
+            return false;
+        cur = found + seg.size();
+    }
+
+    return true;
+}
+
+bool LikePattern :: Match( const char * target ) const {
+    switch( kind ) {
+    case EXACT:
+        return strcmp(target, segments[0].c_str()) == 0;
+    case PREFIX:
+        return strncmp(target, segments[0].data(), segments[0].size()) == 0;
+    case SUFFIX: {
+        size_t length = strlen(target);
+        const string & suffix = segments[1];
+        return length >= suffix.size()
+            && memcmp(target + length - suffix.size(), suffix.data(), suffix.size()) == 0;
+    }
+    case CONTAINS:
+        return FindSubstring(target, strlen(target), segments[1].data(), segments[1].size()) != NULL;
+    case SEGMENTS:
+        return MatchSegments(target, strlen(target));
+    default:
+        return LikeBody(target, pattern.c_str());
+    }
+}
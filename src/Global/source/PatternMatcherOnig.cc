@@ -1,11 +1,120 @@
 #include "PatternMatcherOnig.h"
+#include "CharScan.h"
 
+#include <cctype>
 #include <cstring>
 
 // Static member initiallization
 PatternMatcherOnig::Mutex PatternMatcherOnig::mutex;
 
-PatternMatcherOnig::PatternMatcherOnig( const char * regexp ) {
+std::string PatternMatcherOnig :: RequiredLiteral( const char * regexp ) {
+    if( strstr(regexp, "(?") != NULL )
+        return std::string();
+
+    std::string best;
+    std::string run;
+    // start of the last character of the run, the one a quantifier applies to
+    size_t lastChar = 0;
+    int depth = 0;
+
+    // The run ends at anything that is not a literal. If the last character
+    // is optional it is not part of the run.
+    auto endRun = [&] ( bool dropLast ) {
+        if( dropLast )
+            run.resize(lastChar);
+        if( run.size() > best.size() )
+            best = run;
+        run.clear();
+        lastChar = 0;
+    };
+
+    for( const char * p = regexp; *p != '\0'; ) {
+        unsigned char c = *p;
+
+        if( c == '\\' ) {
+            // The escaped letters and digits are classes, anchors, back
+            // references and character codes
+            unsigned char next = p[1];
+            if( next == '\0' )
+                return std::string();
+            if( depth > 0 || isalnum(next) || next >= 0x80 ) {
+                endRun(false);
+            } else {
+                lastChar = run.size();
+                run.push_back(next);
+            }
+            p += 2;
+        }
+        else if( c == '[' ) {
+            // Skip the class, a ']' right at the start is part of it
+            p++;
+            if( *p == '^' )
+                p++;
+            if( *p == ']' )
+                p++;
+            int nested = 1;
+            while( *p != '\0' && nested > 0 ) {
+                if( *p == '\\' && p[1] != '\0' )
+                    p++;
+                else if( *p == '[' )
+                    nested++;
+                else if( *p == ']' )
+                    nested--;
+                p++;
+            }
+            endRun(false);
+        }
+        else if( c == '(' || c == ')' ) {
+            depth += c == '(' ? 1 : -1;
+            endRun(false);
+            p++;
+        }
+        else if( c == '|' ) {
+            if( depth == 0 )
+                return std::string();
+            p++;
+        }
+        else if( c == '*' || c == '?' ) {
+            endRun(true);
+            p++;
+        }
+        else if( c == '+' ) {
+            endRun(false);
+            p++;
+        }
+        else if( c == '{' ) {
+            // Interval, skip the bounds
+            endRun(true);
+            p++;
+            while( isdigit((unsigned char) *p) || *p == ',' )
+                p++;
+            if( *p == '}' )
+                p++;
+        }
+        else if( c == '.' || c == '^' || c == '$' ) {
+            endRun(false);
+            p++;
+        }
+        else if( depth > 0 ) {
+            p++;
+        }
+        else {
+            // Literal character, with all the bytes of UTF-8 sequences
+            lastChar = run.size();
+            do {
+                run.push_back(*p++);
+            } while( (*p & 0xC0) == 0x80 );
+        }
+    }
+
+    endRun(false);
+    return best;
+}
+
+PatternMatcherOnig::PatternMatcherOnig( const char * regexp ) :
+    reg(NULL),
+    required(RequiredLiteral(regexp))
+{
     int r;
     UChar * pattern = (UChar *) regexp;
     OnigErrorInfo einfo;
@@ -26,6 +135,9 @@ PatternMatcherOnig::PatternMatcherOnig( const char * regexp ) {
 bool PatternMatcherOnig :: Match( const char * target ) const {
     int size = strlen(target);
 
+    if( !required.empty() && FindSubstring(target, size, required.data(), required.size()) == NULL )
+        return false;
+
     int r = onig_search(
         reg,
         (UChar *) target,
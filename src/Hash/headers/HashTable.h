@@ -20,6 +20,8 @@
 #include "HashTableMacros.h"
 #include "HashTableView.h"
 
+#include <atomic>
+
 // this is the central hash table class.  It is assumed that there will be one of these
 // in the system, and that various copies (clones) of the central table will be passed
 // around throughout the system
@@ -27,11 +29,20 @@ class HashTable {
 
 private:
 
-	// each entry is one iff the particular HashTableSegment is write locked
-	int *writeLocked;
+	// each entry is one iff the particular HashTableSegment is write locked; the writers
+	// take and release the locks with atomic operations, without the mutex
+	std::atomic<int> *writeLocked;
 
 	// this is the current version of the hash table
 	HashTableView *currentTable;	
+
+	// the same segments as currentTable, by position.  A segment is only replaced by the
+	// writer that has it locked, so that writer can clone it from here without the mutex
+	HashTableSegment *writerSegments;
+
+	// number of writers that are sleeping on signalWriters because all of the segments
+	// they want are locked; the writers only take the mutex to wake them up if there are any
+	std::atomic<int> *numWaiting;
 	
 	// mutex that protects the hash table
 	pthread_mutex_t *myMutex;
@@ -63,7 +74,8 @@ public:
 	// checkMeOut.  At this point, you lock out any other writers from writing to the hash
 	// table segment, until it goes out of scope and the destructor is called.  Note that
 	// this call blocks if there is not any hash table segment that the caller would accept
-	// that is also available for writing.
+	// that is also available for writing.  Each caller starts at a random one of the
+	// segments, and the mutex is only taken when they are all locked
 	int CheckOutOne (int *theseAreOK, HashTableSegment &checkMeOut);
 
 	// this is called when you want to replace a particular hash table segment with a new one.
@@ -78,6 +90,17 @@ public:
 	// simply releases a write lock on the segment
 	void CheckIn (int whichEntry);
 
+private:
+
+	// tries to lock one of the numWanted segments in goodOnes, starting at a random one;
+	// returns -1 if they are all locked
+	int TryCheckOut (int *goodOnes, int numWanted, HashTableSegment &checkMeOut);
+
+	// wakes up the writers waiting for a segment, if there are any
+	void SignalWriters ();
+
+public:
+
 	// makes a shallow copy of the hash table
 	void Clone (HashTable &fromMe);
 	void copy(HashTable &fromMe){ Clone(fromMe); }
@@ -88,9 +111,15 @@ public:
 	// allocates the hash table having NUM_SEGS segments of specified size; uses the specified
 	// number of threads to zero out and prepare the hash table... this number needs to be at
 	// least 1 (a 1 means that no additional threads other than this one are spawned to do 
-	// the zeroing).
+	// the zeroing). Unless SetSlotBits was called, the size of the segments is the largest
+	// one up to MAX_SLOTS_IN_SEGMENT_BITS that fits in HASH_TABLE_MEMORY_FRACTION of the
+	// physical memory.
 	void Allocate (int numThreads);
 
+	// forces the number of slots in each segment to 2^bits (clamped between
+	// MIN_SLOTS_IN_SEGMENT_BITS and MAX_SLOTS_IN_SEGMENT_BITS); has to be called before Allocate
+	static void SetSlotBits (int bits);
+
 	// tells us if the hash table has been allocated
 	int IsAllocated ();
 
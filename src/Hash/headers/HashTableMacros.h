@@ -37,8 +37,11 @@
 #define HT_INDEX_TYPE uint64_t
 
 
-// this is the number of bits needed to index all of the entried in a hash table segment
-// moved to Constnts.h #define NUM_SLOTS_IN_SEGMENT_BITS 20
+// this is the number of bits needed to index all of the entried in a hash table segment...
+// it is chosen when the central hash table is allocated, and never changes after that
+// (see HashTable::Allocate); the largest value is MAX_SLOTS_IN_SEGMENT_BITS in Constants.h
+extern int hashSlotBits;
+#define NUM_SLOTS_IN_SEGMENT_BITS (hashSlotBits)
 
 // this is the number of entries in a hash table segment
 #define NUM_SLOTS_IN_SEGMENT (1ULL << (NUM_SLOTS_IN_SEGMENT_BITS))
@@ -53,10 +56,15 @@
 // this take a hash value and figures out which segment it is in
 #define WHICH_SEGMENT(hash) ((hash >> NUM_SLOTS_IN_SEGMENT_BITS) % NUM_SEGS)
 
-// this is the absolute limit on the number of entries in a hash table segment... includes
-// some scratch space at the end
+// this is the number of entries in a newly allocated hash table segment... includes
+// some scratch space at the end.  A segment whose scratch space runs out is moved to
+// a larger one (see HashTableSegment::Grow), so use HashTableSegment::Capacity for
+// the actual limit of a segment
 #define ABSOLUTE_HARD_CAP ((HT_INDEX_TYPE)(NUM_SLOTS_IN_SEGMENT * 1.08))
 
+// this is the number of entries added to the scratch space when a segment grows
+#define SCRATCH_GROWTH_SLOTS (NUM_SLOTS_IN_SEGMENT / 4)
+
 // this is the maximum fill rate we allow in a segment when we add data to it
 #define MAX_FILL_RATE .7
 
@@ -73,5 +81,9 @@
 // to identifying which attribute is being stored.  1111111111 is reserved to indicate the bitmap
 #define BITMAP 1023
 
+// this identifies the attribute that holds all of the RHS attributes of a packed tuple, one after
+// the other (see PackedTupleLayout.h).  No attribute can be mapped to this slot
+#define PACKED_TUPLE 1022
+
 #endif
 
@@ -54,6 +54,9 @@ private:
 		// this is the number of bytes in the hash segment
 		HT_INDEX_TYPE numBytes;
 
+		// this is the number of entries in the hash segment (the slots plus the scratch space)
+		HT_INDEX_TYPE capacity;
+
 		// this tells us which slots to probe in the hash table when testing for fullness
 		std::unique_ptr<HT_INDEX_TYPE[]> randomProbeSlots;
 
@@ -65,17 +68,19 @@ private:
 		int privateRHS;
 
 		// this is used to store offsets from one hash entry to another that are more than
-		// 10 bits, and hence cannot be stored within the actual hash table itself
-		Overflow bigOffsets;
+		// 10 bits, and hence cannot be stored within the actual hash table itself... the
+		// offsets are recorded by slot, so a segment that grows keeps using the same ones
+		std::shared_ptr<Overflow> bigOffsets;
 
 		SharedData():
 			myData(nullptr),
-			randomProbeSlots(nullptr),
 			numBytes(0),
+			capacity(0),
+			randomProbeSlots(nullptr),
 			fillRate(0.0),
 			privateLHS(0),
 			privateRHS(0),
-			bigOffsets()
+			bigOffsets(new Overflow)
 		{ }
 
 		~SharedData() { }
@@ -83,11 +88,23 @@ private:
 
 	std::shared_ptr<SharedData> data;
 
+	// allocates the storage for numEntries hash entries
+	static data_ptr_t AllocateEntries (HT_INDEX_TYPE numEntries);
+
+	// moves the data to a new, larger segment, when the scratch space at the end runs out
+	// during an insert (this happens with many tuples having the same hash).  The current
+	// readers keep the old one, so the writer has to put the segment back in the hash table
+	// with HashTable::Replace
+	void Grow ();
+
 public:
 
 	// mark this segment as being overfull; used when someone tries to add data and finds there is too much there
 	void SetOverFull ();
 
+	// number of entries in the segment, including the scratch space at the end
+	HT_INDEX_TYPE Capacity ();
+
 	// check if it is overfull
 	// the optional argument can change the threshold at which the segment is delclared full
 	int CheckOverFull (double max_fill_rate=MAX_FILL_RATE);
@@ -103,13 +120,20 @@ public:
 	// is returned inside of LHS.  Done is set to 1 if the last attribute in the tuple has been found; it is zero otherwise.
 	int Extract (void *serializeHere, HT_INDEX_TYPE &curSlot, HT_INDEX_TYPE goal, int &wayPointID, int whichAtt, int &LHS, int &done);
 
+	// hint the processor that the slot will be probed soon. Used to overlap the cache
+	// misses of many probes
+	void Prefetch (HT_INDEX_TYPE slot);
+
 	// insert the list of serialized tuples into the hash table... in the first, we assume that all inserts are sequential
-	// in terms of hash ID, and we zero out as we go
+	// in terms of hash ID, and we zero out as we go.  If the segment runs out of space it grows (see Grow), and it then
+	// has to be put back in the hash table with HashTable::Replace rather than HashTable::CheckIn
 	void Insert (SerializedSegmentArray &data);
 
 	// in the second, we track the first NUM_TEST_PROBES insert attempts... if more than NUM_TEST_PROBES * MAX_FILL_RATE of them
-	// result in a collision, then a 1 is returned... in any case, a list of the collisions found is returned in mySample
-	int Insert (SerializedSegmentArray &data, HashSegmentSample &mySample);
+	// result in a collision, then a 1 is returned... in any case, a list of the collisions found is returned in mySample.
+	// grew is set to 1 if the segment had to grow, in which case it has to be put back with HashTable::Replace; otherwise
+	// the data went in place and HashTable::CheckIn is enough
+	int Insert (SerializedSegmentArray &data, HashSegmentSample &mySample, int &grew);
 
 	// swap two segments
 	void swap (HashTableSegment &withMe);
@@ -138,6 +162,14 @@ public:
 };
 
 
+inline HT_INDEX_TYPE HashTableSegment :: Capacity () {
+	return data->capacity;
+}
+
+inline void HashTableSegment :: Prefetch (HT_INDEX_TYPE slot) {
+	__builtin_prefetch (&data->myData[slot], 0 /* read */, 1 /* low temporal locality */);
+}
+
 // returns number of bytes extracted on success, 0 otherwise
 inline int HashTableSegment :: Extract (void *serializeHere, HT_INDEX_TYPE &curSlot,
 	HT_INDEX_TYPE goal, int &wayPointID, int whichAtt, int &isLHS, int &done) {
@@ -166,7 +198,7 @@ inline int HashTableSegment :: Extract (void *serializeHere, HT_INDEX_TYPE &curS
 		}
 
 		// if this is the start of a tuple and it has the correct hash and we are looking for a bitmap, add it in
-		if (data->myData[curSlot].IsStartOfTuple () && curSlot - data->myData[curSlot].GetDistFromCorrectPos (curSlot, data->bigOffsets) == goal
+		if (data->myData[curSlot].IsStartOfTuple () && curSlot - data->myData[curSlot].GetDistFromCorrectPos (curSlot, *data->bigOffsets) == goal
 			&& whichAtt == BITMAP && (data->myData[curSlot].GetWayPointID () == wayPointID || wayPointID == -1)) {
 
 			wayPointID = data->myData[curSlot].GetWayPointID ();
@@ -176,7 +208,7 @@ inline int HashTableSegment :: Extract (void *serializeHere, HT_INDEX_TYPE &curS
 		}
 
 		// now we advance... if we are at the end of a tuple and we have been serializing, then advance one
-		if (data->myData[curSlot].GetDisttoNextEntry (curSlot, data->bigOffsets) == 0) {
+		if (data->myData[curSlot].GetDisttoNextEntry (curSlot, *data->bigOffsets) == 0) {
 
 			curSlot += 1;
 			done = 1;
@@ -187,7 +219,7 @@ inline int HashTableSegment :: Extract (void *serializeHere, HT_INDEX_TYPE &curS
 			}
 
 		} else {
-			curSlot += data->myData[curSlot].GetDisttoNextEntry (curSlot, data->bigOffsets);
+			curSlot += data->myData[curSlot].GetDisttoNextEntry (curSlot, *data->bigOffsets);
 		}
 	}
 }
@@ -209,31 +241,31 @@ inline void HashTableSegment :: Insert (SerializedSegmentArray &segments) {
 			// mark that we are no longer at the start of the current tuple
 			startOfTuple = 0;
 
-			// try to find some space to add this thing... this involved hopping along the hash chains
+			// try to find some space to add this thing... this involved hopping along the hash chains;
+			// if we run off the end of the segment, it grows
 			unsigned int counter = 0;
-			while (whichSlot < ABSOLUTE_HARD_CAP && data->myData[whichSlot].IsUsed ()) {
-				int dist = data->myData[whichSlot].GetDisttoNextEntry (whichSlot, data->bigOffsets);
+			while (whichSlot >= data->capacity || data->myData[whichSlot].IsUsed ()) {
+				if (whichSlot >= data->capacity) {
+					Grow ();
+					continue;
+				}
+				int dist = data->myData[whichSlot].GetDisttoNextEntry (whichSlot, *data->bigOffsets);
 				if (dist == 0)
 					dist = 1;
 				whichSlot += dist;
 				counter += dist;
 			}
 
-			// see if we went too far
-			if (whichSlot >= ABSOLUTE_HARD_CAP) {
-				FATAL ("I ran off the end of the hash table segment when I tried to add data.\n");
-			}
-
 			// got an empty space, so add the new data
 			data->myData[whichSlot] = segments.myData[posInArray];
 
 			// if this is the first entry, then set up the back pointer
 			if (data->myData[whichSlot].IsStartOfTuple ())
-				data->myData[whichSlot].SetDistFromCorrectPos (counter, whichSlot, data->bigOffsets);
+				data->myData[whichSlot].SetDistFromCorrectPos (counter, whichSlot, *data->bigOffsets);
 
 			// if it is not, then set up the earlier one's forward pointer
 			else {
-				data->myData[whichSlot - counter].SetDistToNextEntry (counter, whichSlot - counter, data->bigOffsets);
+				data->myData[whichSlot - counter].SetDistToNextEntry (counter, whichSlot - counter, *data->bigOffsets);
 			}
 		}
 	}
@@ -0,0 +1,149 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef JOIN_FILTER_H
+#define JOIN_FILTER_H
+
+#include "HashTableMacros.h"
+#include "DistributedCounter.h"
+
+#include <cstdint>
+
+/** Bloom filter over the join hashes of the RHS tuples of a join waypoint.
+
+    The RHS work functions insert the hash of every tuple they put in the
+    central hash table and the LHS work functions check the hash of each
+    tuple before they go to the hash table. A tuple that is not in the
+    filter cannot have a match, so the probe (and its cache misses) is
+    skipped.
+
+    The filter is split in blocks of 256 bits (8 words of 32 bits). A hash
+    selects one block and sets one bit in each of its words, so a lookup
+    touches a single cache line.
+
+    Like the HashTable, this is a handle: Clone makes a shallow copy that
+    shares the bits and the last copy to go away frees them. Inserts are
+    atomic so several RHS work functions can fill the filter at once.
+*/
+class JoinFilter {
+private:
+    // number of 32 bit words in a block
+    static const int BLOCK_WORDS = 8;
+
+    // the bits of the filter, BLOCK_WORDS words per block
+    uint32_t* bits;
+
+    // number of blocks - 1 (the number of blocks is a power of 2)
+    uint64_t blockMask;
+
+    // tells how many copies of this object are out there
+    DistributedCounter* numCopies;
+
+    // the first word of the block of a hash
+    uint32_t* Block(HT_INDEX_TYPE hash) const;
+
+    // the bit the hash sets in the words of its block
+    static void Masks(HT_INDEX_TYPE hash, uint32_t masks[BLOCK_WORDS]);
+
+    void Release(void);
+
+    JoinFilter(const JoinFilter&) = delete;
+    JoinFilter& operator = (const JoinFilter&) = delete;
+
+public:
+    // creates an empty filter. An unallocated filter contains everything
+    JoinFilter();
+
+    // allocates 2^JOIN_FILTER_BITS bits, all of them zero
+    void Allocate(void);
+
+    // tells us if the filter has been allocated
+    bool IsAllocated(void) const;
+
+    // makes a shallow copy of the filter
+    void Clone(JoinFilter& fromMe);
+    void copy(JoinFilter& fromMe) { Clone(fromMe); }
+
+    // standard swap function
+    void swap(JoinFilter& withMe);
+
+    // adds a hash to the filter. Thread safe
+    void Insert(HT_INDEX_TYPE hash);
+
+    // false if the hash was definitely never inserted
+    bool MayContain(HT_INDEX_TYPE hash) const;
+
+    // brings the block of the hash in the cache
+    void Prefetch(HT_INDEX_TYPE hash) const;
+
+    ~JoinFilter();
+};
+
+inline uint32_t* JoinFilter :: Block(HT_INDEX_TYPE hash) const {
+    // the low bits of the hash pick the slot in the hash table. Mix them
+    // so that the block does not follow the slot
+    uint64_t mixed = hash * 0x9E3779B97F4A7C15ULL;
+    return bits + ((mixed >> 32) & blockMask) * BLOCK_WORDS;
+}
+
+inline void JoinFilter :: Masks(HT_INDEX_TYPE hash, uint32_t masks[BLOCK_WORDS]) {
+    static const uint32_t salts[BLOCK_WORDS] = {
+        0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+        0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+    };
+
+    uint32_t key = (uint32_t) (hash ^ (hash >> 32));
+    for (int i = 0; i < BLOCK_WORDS; i++) {
+        masks[i] = 1U << ((key * salts[i]) >> 27);
+    }
+}
+
+inline void JoinFilter :: Insert(HT_INDEX_TYPE hash) {
+    if (bits == NULL)
+        return;
+
+    uint32_t* block = Block(hash);
+    uint32_t masks[BLOCK_WORDS];
+    Masks(hash, masks);
+
+    for (int i = 0; i < BLOCK_WORDS; i++) {
+        // most keys repeat or collide on some bits, skip the atomic then
+        if ((__atomic_load_n(&block[i], __ATOMIC_RELAXED) & masks[i]) != masks[i])
+            __atomic_fetch_or(&block[i], masks[i], __ATOMIC_RELAXED);
+    }
+}
+
+inline bool JoinFilter :: MayContain(HT_INDEX_TYPE hash) const {
+    if (bits == NULL)
+        return true;
+
+    const uint32_t* block = Block(hash);
+    uint32_t masks[BLOCK_WORDS];
+    Masks(hash, masks);
+
+    bool found = true;
+    for (int i = 0; i < BLOCK_WORDS; i++) {
+        found &= (__atomic_load_n(&block[i], __ATOMIC_RELAXED) & masks[i]) != 0;
+    }
+
+    return found;
+}
+
+inline void JoinFilter :: Prefetch(HT_INDEX_TYPE hash) const {
+    if (bits != NULL)
+        __builtin_prefetch (Block(hash), 0 /* read */, 1 /* low temporal locality */);
+}
+
+#endif // JOIN_FILTER_H
@@ -0,0 +1,99 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef PACKED_TUPLE_LAYOUT_H
+#define PACKED_TUPLE_LAYOUT_H
+
+#include "HashTableMacros.h"
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+/** Layout of the packed RHS tuples of a join waypoint.
+
+    Normally each attribute of a tuple in the central hash table gets its own
+    hash entries, tagged with the slot of the attribute, so a 4 byte integer
+    takes a whole 12 byte entry and the probe extracts the attributes one at a
+    time. When all the hashed RHS attributes of a join have a fixed size, the
+    code generator packs them instead: their bytes are written one after the
+    other, in slot order, as the single attribute PACKED_TUPLE right after the
+    bitmap. Only the attributes used by the queries of the tuple are written.
+
+    A packed tuple starts with a Header that gives the ID of its layout and
+    which of the attributes of the layout it has. The code of a join changes
+    when queries come and go, while the tuples written by the old code are
+    still in the table, so the LHS and the cleaner always read the tuples
+    through the layout they were written with.
+*/
+class PackedTupleLayout {
+public:
+    // identifies a registered layout
+    typedef uint32_t LayoutID;
+
+    // never given to a layout
+    static const LayoutID NO_LAYOUT = UINT32_MAX;
+
+    // start of every packed tuple
+    struct Header {
+        LayoutID layout;
+        // bit i is set if the tuple has the i-th attribute of the layout
+        uint32_t present;
+    };
+
+    // one bit of Header::present per attribute
+    static const int MAX_FIELDS = 32;
+
+    // one attribute of the layout
+    struct Field {
+        int slot;
+        int size;
+    };
+
+private:
+    // the attributes in slot order
+    std::vector<Field> fields;
+
+    // layouts registered so far, by ID. They are never removed, since tuples
+    // written with a layout can stay in the hash table for a long time
+    static std::vector<std::unique_ptr<PackedTupleLayout>> layouts;
+    static std::mutex layoutsMutex;
+
+public:
+    // creates an empty layout
+    PackedTupleLayout ();
+
+    // adds an attribute of size bytes after the ones already there
+    void Add (int slot, int size);
+
+    // offset of the attribute in slot in a tuple with the given present bits,
+    // from the start of the header; -1 if the tuple does not have it
+    int Offset (int slot, uint32_t present) const;
+
+    // number of bytes of a packed tuple with all of the attributes, header included
+    int MaxSize () const;
+
+    bool operator == (const PackedTupleLayout& other) const;
+
+    // the ID of the layout, registering it the first time it is seen. Called by
+    // the RHS each time it hashes a chunk
+    static LayoutID Register (const PackedTupleLayout& layout);
+
+    // the layout with the given ID
+    static const PackedTupleLayout& Get (LayoutID id);
+};
+
+#endif // PACKED_TUPLE_LAYOUT_H
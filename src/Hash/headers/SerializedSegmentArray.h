@@ -57,12 +57,19 @@ class SerializedSegmentArray {
     // forgets the data in the array
     inline void EmptyOut ();
 
+    // tells us if there are no tuples in the array
+    inline bool IsEmpty ();
+
 };
 
 inline void SerializedSegmentArray :: EmptyOut () {
     lastUsedSeg = lastUsedHash = 0;
 }
 
+inline bool SerializedSegmentArray :: IsEmpty () {
+    return lastUsedHash == 0;
+}
+
 inline void SerializedSegmentArray :: Append (unsigned int columnID, void *bytesToWrite, int howManyBytes) {
 
     // loop through and add all of the bytes in
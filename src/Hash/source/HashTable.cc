@@ -15,9 +15,48 @@
 //
 
 #include "HashTable.h"
+#include "HashEntry.h"
 #include "Errors.h"
+#include "Logging.h"
+#include "Random.h"
 
 #include <iostream>
+#include <unistd.h>
+
+// number of bits of the segment size, see NUM_SLOTS_IN_SEGMENT_BITS
+int hashSlotBits = MAX_SLOTS_IN_SEGMENT_BITS;
+
+// set when the size was given on the command line
+static bool hashSlotBitsForced = false;
+
+void HashTable :: SetSlotBits (int bits) {
+
+	if (bits < MIN_SLOTS_IN_SEGMENT_BITS)
+		bits = MIN_SLOTS_IN_SEGMENT_BITS;
+	if (bits > MAX_SLOTS_IN_SEGMENT_BITS)
+		bits = MAX_SLOTS_IN_SEGMENT_BITS;
+
+	hashSlotBits = bits;
+	hashSlotBitsForced = true;
+}
+
+// finds the largest segment size such that the whole table fits in the fraction of the
+// physical memory reserved for it
+static int ChooseSlotBits () {
+
+	long pages = sysconf (_SC_PHYS_PAGES);
+	long pageSize = sysconf (_SC_PAGE_SIZE);
+	if (pages <= 0 || pageSize <= 0)
+		return MAX_SLOTS_IN_SEGMENT_BITS;
+
+	double budget = (double) pages * pageSize * HASH_TABLE_MEMORY_FRACTION;
+	int bits = MAX_SLOTS_IN_SEGMENT_BITS;
+	while (bits > MIN_SLOTS_IN_SEGMENT_BITS &&
+		(double) NUM_SEGS * (1ULL << bits) * 1.08 * sizeof (HashEntry) > budget)
+		bits--;
+
+	return bits;
+}
 
 void HashTable :: EnterReader (HashTableView &myView) {
 
@@ -48,6 +87,29 @@ int HashTable :: CheckOverFull (int *segList, double max_fill_rate) {
 	return count;
 }
 
+int HashTable :: TryCheckOut (int *goodOnes, int numWanted, HashTableSegment &checkMeOut) {
+
+	// the writers start at different segments so that they do not all fight for the same one
+	int start = RandInt (0, numWanted - 1);
+	for (int i = 0; i < numWanted; i++) {
+
+		int whichToChoose = goodOnes[(start + i) % numWanted];
+
+		// try him; a quick look first so that a locked segment's cache line is not written
+		int unlocked = 0;
+		if (writeLocked[whichToChoose].load (std::memory_order_relaxed) == 0 &&
+			writeLocked[whichToChoose].compare_exchange_strong (unlocked, 1)) {
+
+			// he is ours, and no one else can replace him, so clone him and return him
+			HashTableSegment temp (writerSegments[whichToChoose]);
+			temp.swap (checkMeOut);
+			return whichToChoose;
+		}
+	}
+
+	return -1;
+}
+
 int HashTable :: CheckOutOne (int *theseAreOK, HashTableSegment &checkMeOut) {
 
 	FATALIF (!IsAllocated (), "Can't do an op on an un-initialized hash table!");
@@ -62,39 +124,34 @@ int HashTable :: CheckOutOne (int *theseAreOK, HashTableSegment &checkMeOut) {
 		}
 	}
 
-	// now, try them one-at-a-time, in random order
+	FATALIF (numWanted == 0, "Checking out a segment, but none of them is acceptable!");
+
+	// usually one of them is free
+	int whichOne = TryCheckOut (goodOnes, numWanted, checkMeOut);
+	if (whichOne >= 0)
+		return whichOne;
+
+	// if we got here, then every one that we want is write locked.  So we will go to
+	// sleep until one of them is unlocked, at which point we will wake up and try again...
+	// since we are counted as waiting before we try again, whoever unlocks a segment after
+	// that sees us and signals
 	pthread_mutex_lock (myMutex);
-	while (1) {
+	numWaiting->fetch_add (1);
+	while ((whichOne = TryCheckOut (goodOnes, numWanted, checkMeOut)) < 0) {
+		pthread_cond_wait (signalWriters, myMutex);
+	}
+	numWaiting->fetch_sub (1);
+	pthread_mutex_unlock (myMutex);
+
+	return whichOne;
+}
 
-		// try each of the desired hash table segments, in random order
-		for (int i = 0; i < numWanted; i++) {
-		
-			// randomly pick one of the guys in the list
-			int rangeSize = numWanted - i;
-			int whichIndex = i + (lrand48() % rangeSize);
-
-			// move him into the current slot
-			int whichToChoose = goodOnes[whichIndex];
-			goodOnes[whichIndex] = goodOnes[i];
-			goodOnes[i] = whichToChoose;
-
-			// try him
-			if (!writeLocked[whichToChoose]) {
-
-				// he is open, so write lock him
-				writeLocked[whichToChoose] = 1;
-
-				// and return him
-				currentTable->CloneOne (whichToChoose, checkMeOut);
-				pthread_mutex_unlock (myMutex);
-				return whichToChoose;
-			}
-		}			
-			
-		// if we got here, then every one that we want is write locked.  So
-		// we will go to sleep until one of them is unlocked, at which point
-		// we will wake up and try again...
-		pthread_cond_wait (signalWriters, myMutex);	
+void HashTable :: SignalWriters () {
+
+	if (numWaiting->load () > 0) {
+		pthread_mutex_lock (myMutex);
+		pthread_cond_broadcast (signalWriters);
+		pthread_mutex_unlock (myMutex);
 	}
 }
 
@@ -103,23 +160,24 @@ void HashTable :: CheckIn (int whichEntry) {
 	FATALIF (!IsAllocated (), "Can't do an op on an un-initialized hash table!");
 
 	// just note that no one is writing this one, then signal all potential writers
-	pthread_mutex_lock (myMutex);
-	writeLocked[whichEntry] = 0;
-	pthread_cond_broadcast (signalWriters);
-	pthread_mutex_unlock (myMutex);
-
+	writeLocked[whichEntry].store (0);
+	SignalWriters ();
 }
 
 void HashTable :: Replace (int whichEntry, HashTableSegment &replaceWithMe) {
 
 	FATALIF (!IsAllocated (), "Can't do an op on an un-initialized hash table!");
 
-	// add the new one in, then signal all potential writers
+	// add the new one in; the readers copy currentTable under the mutex
+	HashTableSegment forWriters (replaceWithMe);
+	forWriters.swap (writerSegments[whichEntry]);
 	pthread_mutex_lock (myMutex);
-	writeLocked[whichEntry] = 0;
 	currentTable->Replace (whichEntry, replaceWithMe);
-	pthread_cond_broadcast (signalWriters);
 	pthread_mutex_unlock (myMutex);
+
+	// then unlock him and signal all potential writers
+	writeLocked[whichEntry].store (0);
+	SignalWriters ();
 }
 
 HashTable :: HashTable () {
@@ -147,7 +205,9 @@ HashTable :: ~HashTable () {
 	pthread_cond_destroy (signalWriters);
 	delete signalWriters;
 	delete currentTable;
+	delete [] writerSegments;
 	delete [] writeLocked;	
+	delete numWaiting;
 }
 
 // this structure stores all of the zero'ed out segments
@@ -239,6 +299,12 @@ void HashTable :: Allocate (int numThreads) {
 
 	FATALIF (IsAllocated (), "Can't allocate the hash table twice!\n");
 
+	// the segment size has to be fixed before any segment is created
+	if (!hashSlotBitsForced)
+		hashSlotBits = ChooseSlotBits ();
+	LOG_ENTRY_P(1, "Central hash table: %d segments of %llu slots", NUM_SEGS,
+		(unsigned long long) NUM_SLOTS_IN_SEGMENT);
+
 	// set up the concurrency control stuff
 	myMutex = new pthread_mutex_t;
 	signalWriters = new pthread_cond_t;		
@@ -247,10 +313,11 @@ void HashTable :: Allocate (int numThreads) {
 	*numCopies = 1;
 	pthread_mutex_init (myMutex, NULL);
 	pthread_cond_init (signalWriters, NULL);
-	writeLocked = new int[NUM_SEGS];
+	writeLocked = new std::atomic<int>[NUM_SEGS];
 	for (int i = 0; i < NUM_SEGS; i++) {
 		writeLocked[i] = 0;
 	}
+	numWaiting = new std::atomic<int> (0);
 
 	// this struct will mark the progress of the allocating/zeroing
 	WorkToDo temp;
@@ -271,4 +338,8 @@ void HashTable :: Allocate (int numThreads) {
 
 	// and set up the actual hash table!
 	currentTable->AddStorage (temp.allSegments);
+	writerSegments = new HashTableSegment[NUM_SEGS];
+	for (int i = 0; i < NUM_SEGS; i++) {
+		currentTable->CloneOne (i, writerSegments[i]);
+	}
 }
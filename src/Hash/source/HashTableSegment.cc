@@ -63,7 +63,7 @@ int HashTableSegment :: CheckOverFull (double max_fill_rate) {
 }
 
 // this version of insert does not do the sampleing, and it returns the last slot in the segment that it wrote to
-int HashTableSegment :: Insert (SerializedSegmentArray &segments, HashSegmentSample &sampledCollisions) {
+int HashTableSegment :: Insert (SerializedSegmentArray &segments, HashSegmentSample &sampledCollisions, int &grew) {
 
 	// in the future, we might want to and the case where the bitstring spans multiple hash entries
 	FATALIF (sizeof (Bitstring) > sizeof (VAL_TYPE), "Oops! Sampling to check for overfull assumes the bitstring fits in one hash entry!\n");
@@ -71,6 +71,9 @@ int HashTableSegment :: Insert (SerializedSegmentArray &segments, HashSegmentSam
 	// this is the number of collisions in the first NUM_TEST_PROBES hash attempts
 	int numCollisions = 0;
 
+	// so that we can tell the caller if the segment had to grow
+	HT_INDEX_TYPE oldCapacity = data->capacity;
+
 	// first thing we do is probe to see if there are too many over-full entries
 	for (int probeNum = 0; probeNum < NUM_TEST_PROBES; probeNum++) {
 
@@ -110,39 +113,40 @@ int HashTableSegment :: Insert (SerializedSegmentArray &segments, HashSegmentSam
 			// mark that we are no longer at the start of the current tuple
 			startOfTuple = 0;
 
-			// try to find some space to add this thing... this involved hopping along the hash chains
+			// try to find some space to add this thing... this involved hopping along the hash chains;
+			// if we run off the end of the segment (too much data with the same hash key), it grows
 			unsigned int counter = 0;
-			while (whichSlot < ABSOLUTE_HARD_CAP && data->myData[whichSlot].IsUsed ()) {
-				int dist = data->myData[whichSlot].GetDisttoNextEntry (whichSlot, data->bigOffsets);
+			while (whichSlot >= data->capacity || data->myData[whichSlot].IsUsed ()) {
+				if (whichSlot >= data->capacity) {
+					Grow ();
+					continue;
+				}
+				int dist = data->myData[whichSlot].GetDisttoNextEntry (whichSlot, *data->bigOffsets);
 				if (dist == 0)
 					dist = 1;
 				whichSlot += dist;
 				counter += dist;
 			}
 
-			// see if we went too far; we devote 10 bits to pointers, so we can go 1028 slots to find space in the hash table
-			if (whichSlot >= ABSOLUTE_HARD_CAP) {
-                printf("whichSlot=%d\ncounter=%d\n", whichSlot,counter);
-                std::cerr << "(" << data->fillRate << ") (" << numCollisions << ", " << NUM_TEST_PROBES * MAX_FILL_RATE << ")\n";
-                FATAL ("I ran off the end of the hash table segment when I tried to add data.\nYou are probably trying to insert too much data with the same hash key");
-			}
-
 			// got an empty space, so add the new data
 			data->myData[whichSlot] = segments.myData[posInArray];
 
 			// if this is the first entry, then set up the back pointer
 			if (data->myData[whichSlot].IsStartOfTuple ())
-				data->myData[whichSlot].SetDistFromCorrectPos (counter, whichSlot, data->bigOffsets);
+				data->myData[whichSlot].SetDistFromCorrectPos (counter, whichSlot, *data->bigOffsets);
 
 			// if it is not, then set up the earlier one's forward pointer
 			else {
-				data->myData[whichSlot - counter].SetDistToNextEntry (counter, whichSlot - counter, data->bigOffsets);
+				data->myData[whichSlot - counter].SetDistToNextEntry (counter, whichSlot - counter, *data->bigOffsets);
 			}
 		}
 
 	}
 
-	// finally, let the caller know if we get too many collisions
+	grew = (data->capacity != oldCapacity);
+
+	// finally, let the caller know if we get too many collisions... the probes are in the slots, not in the
+	// scratch space, so this is the real occupancy even for a segment that had to grow
 	data->fillRate = 1.0*numCollisions/NUM_TEST_PROBES;
 
 	updateGlobalFillRate(data->fillRate);
@@ -160,7 +164,7 @@ HashTableSegment :: HashTableSegment ():
 { }
 
 void HashTableSegment :: ZeroOut (HT_INDEX_TYPE low, HT_INDEX_TYPE high) {
-	for (HT_INDEX_TYPE i = low; i < ABSOLUTE_HARD_CAP && i < high; i++) {
+	for (HT_INDEX_TYPE i = low; i < data->capacity && i < high; i++) {
 		data->myData[i].EmptyOut ();
 	}
 }
@@ -168,7 +172,7 @@ void HashTableSegment :: ZeroOut (HT_INDEX_TYPE low, HT_INDEX_TYPE high) {
 void HashTableSegment :: ZeroOut () {
     FATALIF(!data, "Attempting to zero out unallocated HashTableSegment");
 #ifdef SLOW_HASH_INIT
-	for (HT_INDEX_TYPE i = 0; i < ABSOLUTE_HARD_CAP; i++) {
+	for (HT_INDEX_TYPE i = 0; i < data->capacity; i++) {
 		data->myData[i].EmptyOut ();
 	}
 #else
@@ -176,23 +180,59 @@ void HashTableSegment :: ZeroOut () {
 #endif
 }
 
-void HashTableSegment :: Allocate () {
+HashTableSegment::data_ptr_t HashTableSegment :: AllocateEntries (HT_INDEX_TYPE numEntries) {
 
-	SharedData *nData = new SharedData;
-
-	// now we see how much storage we need
-	nData->numBytes = ABSOLUTE_HARD_CAP * sizeof(HashEntry);
+	HT_INDEX_TYPE numBytes = numEntries * sizeof(HashEntry);
 
-	// now, actually allocate the data
 	// if this table is small, we will not use big pages
-	if (nData->numBytes < 2097152 /* 2MB */) {
-		nData->myData = data_ptr_t(new HashEntry[ABSOLUTE_HARD_CAP], std::default_delete<HashEntry[]>());
+	if (numBytes < 2097152 /* 2MB */) {
+		return data_ptr_t(new HashEntry[numEntries], std::default_delete<HashEntry[]>());
 	} else {
 		//myData = (HashEntry *) SYS_MMAP_ALLOC (numBytes);
-		nData->myData = data_ptr_t((HashEntry *) mmap_alloc(nData->numBytes, 1),
+		return data_ptr_t((HashEntry *) mmap_alloc(numBytes, 1),
 			[](HashEntry* ptr) { mmap_free(ptr); });
 		//FATALIF( !SYS_MMAP_CHECK((void*)myData), "Could not allocate %ld MB for segments of the large hash", numBytes >> 20);
 	}
+}
+
+void HashTableSegment :: Grow () {
+
+	SharedData *nData = new SharedData;
+
+	nData->capacity = data->capacity + SCRATCH_GROWTH_SLOTS;
+	nData->numBytes = nData->capacity * sizeof(HashEntry);
+	nData->myData = AllocateEntries (nData->capacity);
+
+	// copy the old entries, and empty out the new scratch space
+	memmove (nData->myData.get(), data->myData.get(), data->numBytes);
+	for (HT_INDEX_TYPE i = data->capacity; i < nData->capacity; i++) {
+		nData->myData[i].EmptyOut ();
+	}
+
+	nData->randomProbeSlots.reset(new HT_INDEX_TYPE[NUM_TEST_PROBES]);
+	memmove (nData->randomProbeSlots.get(), data->randomProbeSlots.get(), NUM_TEST_PROBES * sizeof(HT_INDEX_TYPE));
+
+	nData->fillRate = data->fillRate;
+	nData->privateLHS = data->privateLHS;
+	nData->privateRHS = data->privateRHS;
+	nData->bigOffsets = data->bigOffsets;
+
+	LOG_ENTRY_P(2, "Hash table segment grown to %llu slots, too much data with the same hash key",
+		(unsigned long long) nData->capacity);
+
+	data.reset(nData);
+}
+
+void HashTableSegment :: Allocate () {
+
+	SharedData *nData = new SharedData;
+
+	// now we see how much storage we need
+	nData->capacity = ABSOLUTE_HARD_CAP;
+	nData->numBytes = ABSOLUTE_HARD_CAP * sizeof(HashEntry);
+
+	// now, actually allocate the data
+	nData->myData = AllocateEntries (nData->capacity);
 
 	nData->randomProbeSlots.reset(new HT_INDEX_TYPE[NUM_TEST_PROBES]);
 	for (size_t i = 0; i < NUM_TEST_PROBES; i++) {
@@ -0,0 +1,80 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#include "JoinFilter.h"
+#include "MmapAllocator.h"
+#include "Errors.h"
+
+#include <cstring>
+#include <utility>
+
+JoinFilter :: JoinFilter () :
+    bits(NULL),
+    blockMask(0),
+    numCopies(NULL)
+{
+}
+
+void JoinFilter :: Allocate () {
+    FATALIF (bits != NULL, "Allocating a join filter that is already allocated");
+    FATALIF (JOIN_FILTER_BITS < 8, "The join filter needs at least one block");
+
+    uint64_t numBlocks = (1ULL << JOIN_FILTER_BITS) / (BLOCK_WORDS * 32);
+    uint64_t numBytes = numBlocks * BLOCK_WORDS * sizeof (uint32_t);
+
+    bits = (uint32_t *) mmap_alloc (numBytes, 1);
+    FATALIF (bits == NULL, "Could not allocate the join filter");
+    memset (bits, 0, numBytes);
+
+    blockMask = numBlocks - 1;
+    numCopies = new DistributedCounter (1);
+}
+
+bool JoinFilter :: IsAllocated () const {
+    return bits != NULL;
+}
+
+void JoinFilter :: Clone (JoinFilter &fromMe) {
+    Release ();
+
+    if (fromMe.bits == NULL)
+        return;
+
+    fromMe.numCopies->Increment (1);
+    bits = fromMe.bits;
+    blockMask = fromMe.blockMask;
+    numCopies = fromMe.numCopies;
+}
+
+void JoinFilter :: swap (JoinFilter &withMe) {
+    std::swap (bits, withMe.bits);
+    std::swap (blockMask, withMe.blockMask);
+    std::swap (numCopies, withMe.numCopies);
+}
+
+void JoinFilter :: Release () {
+    if (bits != NULL && numCopies->Decrement (1) == 0) {
+        mmap_free (bits);
+        delete numCopies;
+    }
+
+    bits = NULL;
+    blockMask = 0;
+    numCopies = NULL;
+}
+
+JoinFilter :: ~JoinFilter () {
+    Release ();
+}
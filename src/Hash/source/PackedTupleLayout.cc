@@ -0,0 +1,90 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#include "PackedTupleLayout.h"
+#include "Errors.h"
+
+std::vector<std::unique_ptr<PackedTupleLayout>> PackedTupleLayout :: layouts;
+std::mutex PackedTupleLayout :: layoutsMutex;
+
+PackedTupleLayout :: PackedTupleLayout () :
+    fields()
+{
+}
+
+void PackedTupleLayout :: Add (int slot, int size) {
+    FATALIF (slot == PACKED_TUPLE || slot == BITMAP,
+        "Attribute slot %d is reserved in the hash table", slot);
+    FATALIF (!fields.empty () && fields.back ().slot >= slot,
+        "The packed attributes have to be added in slot order");
+    FATALIF (fields.size () >= MAX_FIELDS,
+        "At most %d attributes can be packed", MAX_FIELDS);
+
+    fields.push_back (Field{slot, size});
+}
+
+int PackedTupleLayout :: Offset (int slot, uint32_t present) const {
+    int offset = sizeof (Header);
+    for (size_t i = 0; i < fields.size (); i++) {
+        bool isThere = (present >> i) & 1;
+        if (fields[i].slot == slot)
+            return isThere ? offset : -1;
+        if (isThere)
+            offset += fields[i].size;
+    }
+
+    return -1;
+}
+
+int PackedTupleLayout :: MaxSize () const {
+    int size = sizeof (Header);
+    for (const Field& field : fields)
+        size += field.size;
+
+    return size;
+}
+
+bool PackedTupleLayout :: operator == (const PackedTupleLayout& other) const {
+    if (fields.size () != other.fields.size ())
+        return false;
+
+    for (size_t i = 0; i < fields.size (); i++) {
+        if (fields[i].slot != other.fields[i].slot || fields[i].size != other.fields[i].size)
+            return false;
+    }
+
+    return true;
+}
+
+PackedTupleLayout::LayoutID PackedTupleLayout :: Register (const PackedTupleLayout& layout) {
+    std::lock_guard<std::mutex> guard (layoutsMutex);
+
+    // the joins keep hashing with the same few layouts
+    for (size_t i = 0; i < layouts.size (); i++) {
+        if (*layouts[i] == layout)
+            return i;
+    }
+
+    FATALIF (layouts.size () >= NO_LAYOUT, "Too many packed tuple layouts");
+    layouts.emplace_back (new PackedTupleLayout (layout));
+    return layouts.size () - 1;
+}
+
+const PackedTupleLayout& PackedTupleLayout :: Get (LayoutID id) {
+    std::lock_guard<std::mutex> guard (layoutsMutex);
+
+    FATALIF (id >= layouts.size (), "Unknown packed tuple layout %u", id);
+    return *layouts[id];
+}
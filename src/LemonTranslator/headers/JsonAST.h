@@ -36,6 +36,7 @@
 #define J_SLOT          "slot"
 
 #define J_ALIAS         "alias"
+#define J_DISTINCT      "distinct"
 
 // Used to keep around the C++ expressions generated by the old parser
 #define J_C_EXPR        "c_expr"
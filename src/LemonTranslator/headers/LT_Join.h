@@ -104,6 +104,9 @@ public:
     virtual void GetAccumulatedLHSRHS(std::set<SlotID>& LHS, std::set<SlotID>& RHS, QueryIDSet& queries);
     virtual void GetAccumulatedLHSRHSAtts(std::set<SlotID>& LHS, std::set<SlotID>& RHS);
 
+    // the join attributes of the LHS and, per query, of the RHS
+    void GetJoinKeys(SlotVec& lhs, QueryToSlotVec& rhs) { lhs = LHS_keys; rhs = RHS_keys; }
+
     virtual void GetQueryExitToSlotMapLHS(QueryExitToSlotsMap& qe);
     virtual void GetQueryExitToSlotMapRHS(QueryExitToSlotsMap& qe);
 
@@ -48,13 +48,16 @@ class LT_Scanner : public LT_Waypoint {
 
         QueryToScannerRangeList filters;
 
+        // ranges of the columns pushed down from the selections above
+        QueryToColumnRanges columnFilters;
+
     public:
 
         LT_Scanner(WayPointID id, std::string relName, SlotSet& atts):
             LT_Waypoint(id),
             relation(relName),
             allAttr(atts),
-            dropped(), fromTextLoader(), storeMap(), filters()
+            dropped(), fromTextLoader(), storeMap(), filters(), columnFilters()
     {
         assert(!allAttr.empty());
     }
@@ -71,6 +74,9 @@ class LT_Scanner : public LT_Waypoint {
 
         virtual bool AddScannerRange(QueryID query, int64_t min, int64_t max);
 
+        // replaces the column ranges of the query
+        void SetScannerColumnRanges(QueryID query, ColumnToScannerRange& ranges);
+
         virtual bool PropagateDown(QueryID query, const SlotSet& atts, SlotSet& rez, QueryExit qe);
 
         virtual bool PropagateDownTerminating(QueryID query, const SlotSet& atts/*blank*/, SlotSet& result, QueryExit qe);
@@ -53,6 +53,14 @@ public:
 
     virtual bool PropagateUp(QueryToSlotSet& result) override;
 
+    // Extract from the filter of the query the ranges that the columns of the
+    // scanner below have to intersect. Only conjuncts of the form
+    // att OP integer literal are considered, OP one of ==, <, <=, >, >=.
+    // slotToColumn gives the physical column of the attributes of the scanner
+    // that can be pushed down. Returns false if nothing can be pushed down.
+    bool GetScannerColumnRanges(QueryID query, const std::map<SlotID, int64_t>& slotToColumn,
+            ColumnToScannerRange& where);
+
     // get the content of this waypoint as a large JSON object
     virtual Json::Value GetJson() override;
 
@@ -190,8 +190,12 @@ class LemonTranslator {
         // Params:
         //   dir: the directory where the code is
         //   objects: list of objects that need to be included
-        //   RETURNS: name of the library created
+        //   RETURNS: name of the file listing the modules created
         std::string CompileCode(std::string dir);
+
+        // generate the code of the waypoints from query.json
+        //   dir: the directory where the code goes
+        //   RETURNS: name of the makefile that builds the modules
         std::string GenerateCodeJSON(std::string dir);
 
         // Function to plot the query plan graph in a dot file so it can be plotted
@@ -210,6 +214,15 @@ class LemonTranslator {
         Json::Value GetJson();
         Json::Value GetJsonCleaner();
 
+        // Statistics of the column of a scanned relation an attribute is read
+        // from. Returns false if the attribute has none
+        bool GetAttributeStats(SlotID slot, ColumnStats& where, long long int& relTuples);
+
+        // Estimate of the number of distinct combinations of values of the
+        // attributes, -1 if one of them has no statistics. Used to size the
+        // hash tables of the operators grouping on the attributes
+        int64_t EstimateDistinct(const std::set<SlotID>& atts);
+
         // Saves the catalog always, and sends a schema update message to the
         // frontend if batch mode is not enabled.
         void SaveCatalog();
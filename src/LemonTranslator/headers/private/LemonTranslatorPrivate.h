@@ -56,6 +56,11 @@ private:
     // Stores header commands in a JSON array
     Json::Value headers;
 
+    // statistics of the attributes read straight from the columns of the
+    // scanned relations, and the number of tuples of their relation
+    std::map<SlotID, ColumnStats> attributeStats;
+    std::map<SlotID, long long int> attributeTuples;
+
     // AUX FUNCTIONS
     bool AddGraphNode(WayPointID WPID, WaypointType type, LT_Waypoint*& WP);
 
@@ -70,6 +75,15 @@ private:
 
     bool AnalyzeAttUsageBottomUp(QueryIDSet query);
 
+    // push the simple range predicates of the selections sitting right on
+    // top of scanners down to the scanners, so they can skip the chunks
+    // whose zone maps show nothing can match
+    void PushDownScannerRanges(QueryIDSet queries);
+
+    // get the statistics of the scanned columns from the catalog and use
+    // them to check the sides of the joins
+    void CollectAttributeStats(QueryIDSet queries);
+
 
     // translate from query to queryExit
     QueryExit QueryToQueryExit(TableScanID scanner, QueryID query);
@@ -44,11 +44,12 @@ require_once('MessagesFunctions.php');
         The info for the FileScanners is sent directly.
 
         Arguments:
+            codeDir: directory where the code of the waypoints was generated
             newGraph: the new graph for the execution engine
             wpDesc: symbolic configuration for the WayPoints
 */
 <?php
-grokit\create_message_type( 'SymbolicQueryDescriptions', [ ],
+grokit\create_message_type( 'SymbolicQueryDescriptions', [ 'codeDir' => 'std::string', ],
     [   'newQueries' => 'QueryExitContainer',
     'newGraph' => 'DataPathGraph',
     'wpDesc' => 'WayPointConfigurationList',
@@ -99,6 +99,9 @@ bool LT_Scanner::GetConfig(WayPointConfigureData& where){
     QueryToScannerRangeList filterRanges;
     filterRanges = filters;
 
+    QueryToColumnRanges columnRanges;
+    columnRanges = columnFilters;
+
     /* crap from common inheritance from waypoint*/
     WorkFuncContainer myTableScanWorkFuncs;
 
@@ -140,7 +143,8 @@ bool LT_Scanner::GetConfig(WayPointConfigureData& where){
             queryColumnsMap, columnsToSlotsMap,
             storeColumnsToSlots,
             clusterSlot,
-            filterRanges);
+            filterRanges,
+            columnRanges);
 
     where.swap(scannerConfig);
 
@@ -203,6 +207,13 @@ bool LT_Scanner::AddScannerRange(QueryID query, int64_t min, int64_t max) {
     return true;
 }
 
+void LT_Scanner::SetScannerColumnRanges(QueryID query, ColumnToScannerRange& ranges) {
+    if( ranges.empty() )
+        columnFilters.erase(query);
+    else
+        columnFilters[query] = ranges;
+}
+
 // This is called just before analysis to add all the queries to the scanner waypoint
 bool LT_Scanner::AddScanner(QueryIDSet query)
 {
@@ -231,12 +242,14 @@ bool LT_Scanner::AddScanner(QueryIDSet query)
 void LT_Scanner::DeleteQuery(QueryID query) {
     DeleteQueryCommon(query);
     dropped.erase(query);
+    columnFilters.erase(query);
 }
 
 void LT_Scanner::ClearAllDataStructure() {
     ClearAll();
     allAttr.clear();
     dropped.clear();
+    columnFilters.clear();
 }
 
 void LT_Scanner::GetDroppedQueries(QueryExitContainer& qe) {
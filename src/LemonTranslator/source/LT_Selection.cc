@@ -15,6 +15,10 @@
 //
 
 #include <algorithm>
+#include <limits>
+#include <map>
+#include <cerrno>
+#include <cstdlib>
 
 #include <boost/algorithm/string.hpp>
 
@@ -25,6 +29,117 @@
 
 using namespace std;
 
+namespace {
+
+    // integer literal, possibly negated
+    bool JsonToInteger(const Json::Value& node, int64_t& val) {
+        string nType = node[J_NODE_TYPE].asString();
+        const Json::Value& data = node[J_NODE_DATA];
+
+        if( nType == JN_OP && data[J_NAME].asString() == "-" && data[J_ARGS].size() == 1 ) {
+            if( !JsonToInteger(data[J_ARGS][0u], val) || val == numeric_limits<int64_t>::min() )
+                return false;
+            val = -val;
+            return true;
+        }
+
+        if( nType != JN_LIT )
+            return false;
+
+        string type = data[J_TYPE].asString();
+        if( type != "INT" && type != "BIGINT" )
+            return false;
+
+        string value = data[J_VAL].asString();
+        if( !value.empty() && value[value.size()-1] == 'L' )
+            value.erase(value.size()-1);
+
+        errno = 0;
+        char* end = nullptr;
+        val = strtoll(value.c_str(), &end, 10);
+        return errno == 0 && end != value.c_str() && *end == '\0';
+    }
+
+    // range of att OP val. Inverted ranges are fine, they match nothing
+    ScannerRange OperatorRange(const string& op, int64_t val) {
+        const int64_t min = numeric_limits<int64_t>::min();
+        const int64_t max = numeric_limits<int64_t>::max();
+
+        if( op == "==" )
+            return ScannerRange(val, val);
+        else if( op == "<" )
+            return val == min ? ScannerRange(1, 0) : ScannerRange(min, val - 1);
+        else if( op == "<=" )
+            return ScannerRange(min, val);
+        else if( op == ">" )
+            return val == max ? ScannerRange(1, 0) : ScannerRange(val + 1, max);
+        else // >=
+            return ScannerRange(val, max);
+    }
+
+    // swap the sides of a comparison: lit OP att == att FLIP(OP) lit
+    string FlipOperator(const string& op) {
+        if( op == "<" ) return ">";
+        if( op == "<=" ) return ">=";
+        if( op == ">" ) return "<";
+        if( op == ">=" ) return "<=";
+        return op;
+    }
+
+    void ExtractRanges(const Json::Value& expr, const map<SlotID, int64_t>& slotToColumn,
+            ColumnToScannerRange& where) {
+        if( !expr.isObject() || expr[J_NODE_TYPE].asString() != JN_OP )
+            return;
+
+        const Json::Value& data = expr[J_NODE_DATA];
+        string op = data[J_NAME].asString();
+        const Json::Value& args = data[J_ARGS];
+
+        if( args.size() != 2 )
+            return;
+
+        // both sides of a conjunction have to hold
+        if( op == "&&" ) {
+            ExtractRanges(args[0u], slotToColumn, where);
+            ExtractRanges(args[1u], slotToColumn, where);
+            return;
+        }
+
+        if( op != "==" && op != "<" && op != "<=" && op != ">" && op != ">=" )
+            return;
+
+        const Json::Value* att = &args[0u];
+        const Json::Value* lit = &args[1u];
+        if( (*att)[J_NODE_TYPE].asString() != JN_ATT ) {
+            swap(att, lit);
+            op = FlipOperator(op);
+        }
+
+        if( (*att)[J_NODE_TYPE].asString() != JN_ATT )
+            return;
+
+        int64_t val;
+        if( !JsonToInteger(*lit, val) )
+            return;
+
+        AttributeManager& am = AttributeManager::GetAttributeManager();
+        SlotID slot = am.GetAttributeSlot((*att)[J_NODE_DATA][J_NAME].asString());
+        auto it = slotToColumn.find(slot);
+        if( it == slotToColumn.end() )
+            return;
+
+        ScannerRange range = OperatorRange(op, val);
+        auto cur = where.find(it->second);
+        if( cur == where.end() ) {
+            where[it->second] = range;
+        } else {
+            // several conjuncts on the same column, intersect them
+            cur->second.first = std::max(cur->second.first, range.first);
+            cur->second.second = std::min(cur->second.second, range.second);
+        }
+    }
+}
+
 bool LT_Selection::GetConfig(WayPointConfigureData& where){
 
   // get the ID
@@ -205,6 +320,30 @@ bool LT_Selection::PropagateUp(QueryToSlotSet& result) {
   return true;
 }
 
+bool LT_Selection::GetScannerColumnRanges(QueryID query, const map<SlotID, int64_t>& slotToColumn,
+        ColumnToScannerRange& where) {
+    where.clear();
+
+    if( bypassQueries.Overlaps(query) )
+        return false;
+
+    QueryToJson::iterator it = filters.find(query);
+    if( it == filters.end() )
+        return false;
+
+    // filters with a GF do not have a list of expressions
+    Json::Value& info = it->second;
+    if( !info[J_TYPE].isNull() || !info[J_ARGS].isArray() )
+        return false;
+
+    // the expressions in the list are a conjunction
+    for( Json::ArrayIndex i = 0; i < info[J_ARGS].size(); i++ ) {
+        ExtractRanges(info[J_ARGS][i], slotToColumn, where);
+    }
+
+    return !where.empty();
+}
+
 Json::Value LT_Selection::GetJson(){
     Json::Value out(Json::objectValue);// overall object to be return
 
@@ -19,6 +19,7 @@
 #include <lemon/bfs.h>
 #include <lemon/core.h>
 #include <lemon/connectivity.h>
+#include <boost/algorithm/string.hpp>
 #include "LT_Waypoint.h"
 #include "LT_Scanner.h"
 #include "LT_Selection.h"
@@ -717,6 +718,177 @@ bool LemonTranslator::AddScannerRange(WayPointID wpID, QueryID query,
     return WP->AddScannerRange(query, min, max);
 }
 
+// only the types compared as plain integers by the generated code can
+// be matched against the zone maps
+static bool IsIntegerType(string type) {
+    size_t pos = type.rfind("::");
+    if (pos != string::npos)
+        type = type.substr(pos+2);
+    boost::to_upper(type);
+
+    return type == "BYTE" || type == "SMALLINT" || type == "INT" || type == "BIGINT";
+}
+
+void LemonTranslator::PushDownScannerRanges(QueryIDSet queries)
+{
+    PDEBUG("LemonTranslator::PushDownScannerRanges(QueryIDSet queries = %s)", queries.ToString().c_str());
+    AttributeManager& am = AttributeManager::GetAttributeManager();
+
+    for (ListDigraph::NodeIt n(graph); n != INVALID; ++n) {
+        if (n == topNode || n == bottomNode)
+            continue;
+
+        LT_Waypoint* wp = nodeToWaypointData[n];
+        if (wp == NULL || wp->GetType() != ScannerWaypoint)
+            continue;
+        LT_Scanner* scanner = dynamic_cast<LT_Scanner*>(wp);
+
+        // physical columns of the attributes that can be pushed down
+        map<SlotID, int64_t> slotToColumn;
+        SlotToSlotMap columnsToSlots;
+        am.GetColumnToSlotMapping(scanner->GetId().getName(), columnsToSlots);
+        FOREACH_EM(column, slot, columnsToSlots) {
+            string type = am.GetAttributeType(am.GetAttributeName(slot));
+            if (IsIntegerType(type)) {
+                SlotID slotCopy = slot;
+                slotToColumn[slotCopy] = column.GetInt();
+            }
+        } END_FOREACH;
+
+        QueryIDSet tmp = queries.Clone();
+        while (!tmp.IsEmpty()) {
+            QueryID q = tmp.GetFirst();
+            if (!scanner->queriesCovered.Overlaps(q))
+                continue;
+
+            // The chunks skipped by the scanner are skipped for everybody
+            // reading the query from it, so the selection has to be the
+            // only one doing so
+            LT_Waypoint* consumer = NULL;
+            int numConsumers = 0;
+            for (ListDigraph::OutArcIt arc(graph, n); arc != INVALID; ++arc) {
+                LT_Waypoint* next = nodeToWaypointData[graph.target(arc)];
+                if (next != NULL && next->queriesCovered.Overlaps(q)) {
+                    consumer = next;
+                    numConsumers++;
+                }
+            }
+
+            ColumnToScannerRange ranges;
+            if (numConsumers == 1 && consumer->GetType() == SelectionWaypoint) {
+                LT_Selection* selection = dynamic_cast<LT_Selection*>(consumer);
+                selection->GetScannerColumnRanges(q, slotToColumn, ranges);
+            }
+
+            scanner->SetScannerColumnRanges(q, ranges);
+        }
+    }
+}
+
+void LemonTranslator::CollectAttributeStats(QueryIDSet queries)
+{
+    PDEBUG("LemonTranslator::CollectAttributeStats(QueryIDSet queries = %s)", queries.ToString().c_str());
+    AttributeManager& am = AttributeManager::GetAttributeManager();
+    Catalog& catalog = Catalog::GetCatalog();
+
+    attributeStats.clear();
+    attributeTuples.clear();
+
+    for (ListDigraph::NodeIt n(graph); n != INVALID; ++n) {
+        if (n == topNode || n == bottomNode)
+            continue;
+
+        LT_Waypoint* wp = nodeToWaypointData[n];
+        if (wp == NULL || wp->GetType() != ScannerWaypoint)
+            continue;
+        LT_Scanner* scanner = dynamic_cast<LT_Scanner*>(wp);
+
+        Schema schema;
+        if (!catalog.GetSchema(scanner->relation, schema))
+            continue;
+
+        SlotToSlotMap columnsToSlots;
+        am.GetColumnToSlotMapping(scanner->GetId().getName(), columnsToSlots);
+        FOREACH_EM(column, slot, columnsToSlots) {
+            ColumnStats stats;
+            if (schema.GetColumnStats(column.GetInt(), stats)) {
+                SlotID slotCopy = slot;
+                attributeStats[slotCopy] = stats;
+                attributeTuples[slotCopy] = schema.GetNumTuples();
+            }
+        } END_FOREACH;
+    }
+
+    // The RHS of a join goes in the hash table, so it should be the smaller
+    // side. The sides come from the query so we can only point it out
+    for (ListDigraph::NodeIt n(graph); n != INVALID; ++n) {
+        if (n == topNode || n == bottomNode)
+            continue;
+
+        LT_Waypoint* wp = nodeToWaypointData[n];
+        if (wp == NULL || wp->GetType() != JoinWaypoint)
+            continue;
+        LT_Join* join = dynamic_cast<LT_Join*>(wp);
+
+        LT_Waypoint::SlotVec lhsKeys;
+        LT_Waypoint::QueryToSlotVec rhsKeys;
+        join->GetJoinKeys(lhsKeys, rhsKeys);
+        if (lhsKeys.empty() || attributeTuples.find(lhsKeys[0]) == attributeTuples.end())
+            continue;
+        long long int lhsTuples = attributeTuples[lhsKeys[0]];
+
+        for (auto it = rhsKeys.begin(); it != rhsKeys.end(); ++it) {
+            if (!queries.Overlaps(it->first) || it->second.empty()
+                    || attributeTuples.find(it->second[0]) == attributeTuples.end())
+                continue;
+            long long int rhsTuples = attributeTuples[it->second[0]];
+
+            WARNINGIF(rhsTuples > lhsTuples,
+                "Join %s builds its hash table on %lld tuples and probes it with %lld tuples for query %s. "
+                "Swapping the sides would build a smaller hash table",
+                join->GetId().getName().c_str(), rhsTuples, lhsTuples, it->first.ToString().c_str());
+        }
+    }
+}
+
+bool LemonTranslator::GetAttributeStats(SlotID slot, ColumnStats& where, long long int& relTuples)
+{
+    auto it = attributeStats.find(slot);
+    if (it == attributeStats.end())
+        return false;
+
+    where = it->second;
+    relTuples = attributeTuples[slot];
+    return true;
+}
+
+int64_t LemonTranslator::EstimateDistinct(const set<SlotID>& atts)
+{
+    if (atts.empty())
+        return -1;
+
+    // The combinations are assumed independent, there cannot be more of
+    // them than tuples in the largest relation involved
+    double distinct = 1.0;
+    long long int maxTuples = 0;
+    for (const SlotID& slot : atts) {
+        ColumnStats stats;
+        long long int relTuples;
+        if (!GetAttributeStats(slot, stats, relTuples))
+            return -1;
+
+        // the nulls form a group of their own
+        distinct *= stats.EstimateDistinct() + (stats.GetNumNulls() > 0 ? 1 : 0);
+        if (relTuples > maxTuples)
+            maxTuples = relTuples;
+    }
+
+    if (maxTuples > 0 && distinct > maxTuples)
+        distinct = maxTuples;
+
+    return (int64_t) distinct;
+}
+
 bool LemonTranslator::Run(QueryIDSet queries)
 {
     PDEBUG("LemonTranslator::Run(QueryIDSet queries = %s)", queries.ToString().c_str());
@@ -733,6 +905,11 @@ bool LemonTranslator::Run(QueryIDSet queries)
         return false;
     }
     //ClearAllDataStructure(); otherwise all scanner atts will go away
+
+    PushDownScannerRanges(queries);
+
+    CollectAttributeStats(queries);
+
     // Bottom up traversal required before top down
     AnalyzeAttUsageBottomUp(queries);
 
@@ -1043,7 +1220,7 @@ string LemonTranslator::CompileCode(string dir){
             dir.c_str());
     }
 
-    return dir+"/Generated.so";
+    return dir+"/Modules";
 }
 
 string  LemonTranslator::GenerateCodeJSON( string dir ) {
@@ -1056,7 +1233,8 @@ string  LemonTranslator::GenerateCodeJSON( string dir ) {
                 dir.c_str());
     }
 
-    return dir + "/Generated.so";
+    // only the sources are generated here, CompileCode builds the modules
+    return dir + "/Makefile";
 }
 
 
@@ -1334,6 +1512,18 @@ Json::Value LemonTranslator::GetJson() {
     AttributeManager& am = AttributeManager::GetAttributeManager();
     Json::Value attrs;
     am.GenerateJSON(attrs);
+
+    // the code generator sizes the hash tables of the GLAs from the number
+    // of distinct values of their inputs
+    for (Json::Value& attr : attrs) {
+        SlotID slot = am.GetAttributeSlot(attr[J_NAME].asString());
+        set<SlotID> atts;
+        atts.insert(slot);
+        int64_t distinct = EstimateDistinct(atts);
+        if (distinct >= 0)
+            attr[J_DISTINCT] = (Json::Int64) distinct;
+    }
+
     data[J_ATTRIBUTES] = attrs;
 
     return data;
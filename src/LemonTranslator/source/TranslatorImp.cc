@@ -132,7 +132,7 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(TranslatorImp, Translate,
         execute_command (param);
 #endif
 
-        SymbolicQueryDescriptions_Factory(evProc.coordinator,    newQueries, myGraph, waypoints, tasks);
+        SymbolicQueryDescriptions_Factory(evProc.coordinator, outDir, newQueries, myGraph, waypoints, tasks);
     } else {
         // no plan yet
     }
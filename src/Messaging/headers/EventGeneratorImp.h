@@ -34,7 +34,8 @@ class EventGeneratorImp {
         EventGeneratorImp(): myThread(NULL){}
 
         // infinite loop to call ProduceMessage
-        void Run();
+        // if stack_size is not 0, the thread gets a stack of that size
+        void Run(size_t stack_size = 0);
 
         // This method is called once, right before the first ProduceMessage call.
         // The default implementation does nothing.
@@ -123,6 +123,10 @@ class EventProcessorImp {
         // Makes the event processor stop spinning after the current message.
         void StopSpinning(void);
 
+        // Number of messages waiting in the queue, not counting the one
+        // being processed.
+        int NumPendingMessages(void);
+
         // Method for an event processor to get an interface object for itself.
         EventProcessor Self(void);
 
@@ -105,9 +105,14 @@
 class Message {
     Json::Value dummy;
 
+    // link used by MultiMessageQueue while the message sits in the inbox
+    // of an EventProcessor. Intrusive so that sending does not allocate
+    Message* queueNext;
+    friend class MultiMessageQueue;
+
 public:
 	// constructor doing nothing
-	Message() {}
+	Message() : queueNext(NULL) {}
 
 	virtual ~Message() {}
 
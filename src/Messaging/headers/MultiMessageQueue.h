@@ -19,8 +19,11 @@
 #define _MULTIQUEUE_H_
 
 #include <pthread.h>
+#include <atomic>
+#include <deque>
 #include <list>
 #include <map>
+#include <vector>
 #include <functional>
 
 // maximum number of types that can be handled by a queue
@@ -50,6 +53,18 @@ class EventProcessorImp;
 
   MultiMessageQueue does not look at the messages, just keeps track of their
   type.
+
+  Implementation: the writers never take a lock. A message is pushed with a
+  single compare and swap on the inbox (a lock-free stack linked through the
+  messages themselves). The reader takes the whole inbox with one exchange,
+  restores the order of arrival and moves the messages in the queue of their
+  type. The per-type queues are only touched by the reader. When nothing is
+  available, the reader parks on a futex and the first writer that finds it
+  parked wakes it up.
+
+  The queues of the types are kept sorted on (priority, type) so the default
+  policy just takes the first non-empty one, this is the same choice the
+  scan of all the types made.
   */
 
 class MultiMessageQueue {
@@ -50,7 +50,7 @@ private:
     // bookkeeping for each type used for keeping track of message queues and info about types
     class TypeBookkeeping {
         private:
-            std::list<InternalMessage> queue;
+            std::deque<InternalMessage> queue;
             int priority; // the priority of this type
             off_t type; // the type of the message stored here
 
@@ -67,6 +67,10 @@ private:
             // return false if no message in the queue of this type
             bool GetTypeInfo(int curr_timestamp, TypeInfo* where);
             int GetSize(void){ return queue.size(); }
+            bool IsEmpty(void){ return queue.empty(); }
+
+            int GetPriority(void){ return priority; }
+            off_t GetType(void){ return type; }
     };
 
     // debugging  facility
@@ -77,6 +81,10 @@ private:
     // if NULL, we call our own
     DecisionFunction decFct;
 
+    // true if decFct is not the default one. Only then we build the
+    // TypeInfo array for every message removed
+    bool customPolicy;
+
     // EventProcessor that implements the decision function
     EventProcessorImp& decProcessor;
 
@@ -88,11 +96,38 @@ private:
     // the map stores the priority of each type as well
     std::map<off_t,TypeBookkeeping> typeMap;
 
+    // the bookkeeping of the types sorted on (priority, type)
+    std::vector<TypeBookkeeping*> byPriority;
+
     // List to keep all unregistered messages.
     std::list<InternalMessage> unregisteredMessages;
 
-    int timestamp; // the current timestamp
-    int numMessages; // total number of messages in (for efficiency)
+    int timestamp; // the current timestamp (only used by the reader)
+    int numSorted; // number of messages moved out of the inbox (reader only)
+
+    // messages pushed by the writers and not yet seen by the reader, the
+    // most recent first
+    std::atomic<Message*> inbox;
+
+    // number of messages inserted and removed, maintained for GetSize().
+    // Kept apart so the reader does not write the line of the writers
+    std::atomic<int> numInserted;
+    std::atomic<int> numRemoved;
+
+    // scratch space of SortInbox, kept to avoid allocating every time
+    std::vector< std::pair<Message*, TypeBookkeeping*> > sortBuffer;
+
+    // futex word, 1 if the reader is (about to be) parked
+    std::atomic<int> parked;
+
+    // serializes the readers and the changes of the types. There is normally
+    // a single reader so this is never contended
+    pthread_mutex_t mutex;
+
+    // move the content of the inbox in the queues of the types. Returns
+    // false if the inbox was empty. Has to be called with the mutex held
+    bool SortInbox(void);
 
-    pthread_mutex_t mutex; // mutex to ensure exclusive manipulation of the queue
-    pthread_cond_t condVar; // condition variable for the reader
+    // block until the inbox is not empty. Has to be called with the mutex
+    // held, the mutex is released while parked
+    void Park(void);
@@ -17,7 +17,7 @@
 #include "Errors.h"
 
 
-void EventGeneratorImp::Run(void){
+void EventGeneratorImp::Run(size_t stack_size){
     if (myThread!=NULL){
         WARNING("Method Run() called more than once. Use separage Generators instead.");
         return;
@@ -34,6 +34,8 @@ void EventGeneratorImp::Run(void){
     int ret;
 
     ret = pthread_attr_init(&t_attr);
+    if (stack_size != 0)
+        ret = pthread_attr_setstacksize(&t_attr, stack_size);
     ret = pthread_attr_setdetachstate(&t_attr, PTHREAD_CREATE_DETACHED);
     ret = pthread_create(myThread, &t_attr, EventGeneratorImp::RunInternal, (void *)this);
     FATALIF(ret, "ERROR: return code from pthread_create() is %d.\n", ret);
@@ -133,6 +133,10 @@ void EventProcessorImp::StopSpinning(void) {
     spin_flag.clear(std::memory_order_relaxed);
 }
 
+int EventProcessorImp::NumPendingMessages(void) {
+    return msgQueue.GetSize();
+}
+
 void EventProcessorImp::ProcessMessage(Message& msg) {
     if (!dead)
         msgQueue.InsertMessage(msg);
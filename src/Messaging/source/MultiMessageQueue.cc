@@ -15,6 +15,12 @@
 //
 #include <assert.h>
 #include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <limits.h>
+#include <algorithm>
 
 #include "Errors.h"
 #include "Message.h"
@@ -27,6 +33,15 @@ using namespace std;
 // needed to initialize references in MultiMessageQueue
 EventProcessorImp DummyEventProcessorImp;
 
+// glibc does not provide a wrapper for futex
+static inline void futex_wait(atomic<int>* addr, int val){
+    syscall(SYS_futex, (int*) addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+static inline void futex_wake(atomic<int>* addr){
+    syscall(SYS_futex, (int*) addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
 /////////////////////////
 // Internal Message stuff
 
@@ -79,18 +94,23 @@ bool MultiMessageQueue::TypeBookkeeping::GetTypeInfo(int curr_timestamp, TypeInf
 // MultiMessageQueue stuff
 
 MultiMessageQueue::MultiMessageQueue(bool _debug, const char *_dbgMsg) :
-	debug(_debug), dbgMsg(_dbgMsg), decProcessor(DummyEventProcessorImp) {
+	debug(_debug), dbgMsg(_dbgMsg), decProcessor(DummyEventProcessorImp),
+	inbox(NULL), numInserted(0), numRemoved(0), parked(0) {
 	pthread_mutex_init(&mutex, NULL);
-	pthread_cond_init(&condVar, NULL);
 	timestamp=0;
 	decFct = defaultDecisionFunction;
-	numMessages = 0;
+	customPolicy = false;
+	numSorted = 0;
 }
 
 MultiMessageQueue::~MultiMessageQueue() {
 	// deleate messages in the queue
 	pthread_mutex_destroy(&mutex);
-	pthread_cond_destroy(&condVar);
+}
+
+// order of the types for the default policy
+static bool ComparePriority(MultiMessageQueue::TypeInfo a, MultiMessageQueue::TypeInfo b){
+	return a.priority < b.priority || (a.priority == b.priority && a.type < b.type);
 }
 
 void MultiMessageQueue::AddMessageType(off_t _Type, int Priority) {
@@ -104,98 +124,188 @@ void MultiMessageQueue::AddMessageType(off_t _Type, int Priority) {
 	} else {
 		TypeBookkeeping bk(Priority,_Type);
 		typeMap.insert(pair<off_t,TypeBookkeeping>(_Type,bk));
+
+		// rebuild the priority order, this happens only at registration
+		vector<TypeInfo> order;
+		for (itr = typeMap.begin(); itr != typeMap.end(); itr++){
+			TypeInfo info;
+			info.type = itr->first;
+			info.priority = itr->second.GetPriority();
+			order.push_back(info);
+		}
+		sort(order.begin(), order.end(), ComparePriority);
+
+		byPriority.clear();
+		for (size_t i = 0; i < order.size(); i++)
+			byPriority.push_back(&typeMap.find(order[i].type)->second);
 	}
 
 	pthread_mutex_unlock(&mutex);
 }
 
+void MultiMessageQueue::RegisterDecisionPolicy(EventProcessorImp& _obj, DecisionFunction fct) {
+	pthread_mutex_lock(&mutex);
+
+	// decProcessor cannot be reseated so the processor the policy was
+	// registered with is bound in
+	EventProcessorImp* obj = &_obj;
+	decFct = [obj, fct](EventProcessorImp&, TypeInfo* arrayTypeInfo, int num) {
+		return fct(*obj, arrayTypeInfo, num);
+	};
+	customPolicy = true;
+
+	pthread_mutex_unlock(&mutex);
+}
+
 void MultiMessageQueue::InsertMessage(Message& _Payload) {
 	Message &Payload = _Payload;
 
-	off_t _Type=Payload.Type();
-	pthread_mutex_lock(&mutex);
+	// push on the inbox. No lock, the reader sorts the messages out
+	Message* head = inbox.load(memory_order_relaxed);
+	do {
+		Payload.queueNext = head;
+	} while (!inbox.compare_exchange_weak(head, &Payload,
+				memory_order_seq_cst, memory_order_relaxed));
 
-	map<off_t,TypeBookkeeping>::iterator itr = typeMap.find(_Type);
-    if (itr!=typeMap.end()){
-        // we support this type, insert it
-        TypeBookkeeping& bk = (*itr).second;
-        InternalMessage msg(Payload, timestamp);
-        bk.InsertMessage(msg);
+	// message in
+	int inserted = numInserted.fetch_add(1, memory_order_relaxed) + 1;
+
+	if(debug){
+		printf("MSG IN %25s:%25s, QSize=%3d.\n", dbgMsg, _Payload.TypeName(),
+				inserted - numRemoved.load(memory_order_relaxed));
+	}
+
+	// the push above is a full barrier so either the reader sees the message
+	// before parking or we see it parked
+	if (parked.load(memory_order_seq_cst) != 0 && parked.exchange(0) == 1){
+		futex_wake(&parked);
+	}
+}
 
-    } else {
-        // Message isn't registered, add it to unregistered list.
-        InternalMessage msg(Payload, timestamp);
-        unregisteredMessages.push_back(msg);
-    }
+bool MultiMessageQueue::SortInbox(void) {
+	if (inbox.load(memory_order_seq_cst) == NULL)
+		return false;
+
+	Message* head = inbox.exchange(NULL, memory_order_acquire);
+
+	// the inbox has the most recent message first. One pass over it finds
+	// the queues of the messages, then they are queued backwards so the
+	// messages of the same type come out in the order they came in
+	sortBuffer.clear();
+	while (head != NULL){
+		Message* msg = head;
+		head = msg->queueNext;
+		msg->queueNext = NULL;
 
-    // increment timestamp to advance time
-    timestamp++;
+		map<off_t,TypeBookkeeping>::iterator itr = typeMap.find(msg->Type());
+		TypeBookkeeping* bk = itr != typeMap.end() ? &itr->second : NULL;
+		sortBuffer.push_back(make_pair(msg, bk));
+	}
 
-    // message in
-    numMessages++;
+	for (size_t i = sortBuffer.size(); i > 0; i--){
+		InternalMessage iMsg(*sortBuffer[i-1].first, timestamp);
+		TypeBookkeeping* bk = sortBuffer[i-1].second;
+		if (bk != NULL){
+			// we support this type, insert it
+			bk->InsertMessage(iMsg);
+		} else {
+			// Message isn't registered, add it to unregistered list.
+			unregisteredMessages.push_back(iMsg);
+		}
 
-    if(debug){
-        printf("MSG IN %25s:%25s, Time=%4d.\n", dbgMsg, _Payload.TypeName(), timestamp);
-    }
+		// increment timestamp to advance time
+		timestamp++;
+	}
+	numSorted += sortBuffer.size();
+
+	return true;
+}
+
+void MultiMessageQueue::Park(void) {
+	// announce we are going to sleep, then look again. A writer that pushed
+	// before the announcement is seen by SortInbox, one that pushed after
+	// sees the announcement and wakes us up
+	parked.store(1, memory_order_seq_cst);
+	if (SortInbox()){
+		parked.store(0, memory_order_relaxed);
+		return;
+	}
 
-    pthread_cond_signal(&condVar); // signal the consumer that there is stuff in
-    pthread_mutex_unlock(&mutex);
+	pthread_mutex_unlock(&mutex);
+	while (parked.load(memory_order_acquire) == 1){
+		futex_wait(&parked, 1);
+	}
+	pthread_mutex_lock(&mutex);
 }
 
 Message& MultiMessageQueue::RemoveMessage() {
 	pthread_mutex_lock(&mutex);
 
-	// do we have anything in? if not block
-	while (numMessages == 0){
-		pthread_cond_wait(&condVar, &mutex);
+	// take whatever came in so the priorities are decided over all the
+	// messages available, then block if nothing is there
+	SortInbox();
+	while (numSorted == 0){
+		Park();
+		SortInbox();
 	}
 
 	// now we know something is inside
-	assert(numMessages!=0);
+	assert(numSorted!=0);
 
-	// form the information for the decision function
-	TypeInfo types[MAX_NUM_TYPES];
-	int num = 0;
+	InternalMessage msg;
+	TypeBookkeeping* chosen = NULL;
 
-	for (map<off_t,TypeBookkeeping>::iterator itr = typeMap.begin();
+	if (!customPolicy){
+		// the first non-empty type in the priority order
+		for (size_t i = 0; i < byPriority.size() && chosen == NULL; i++)
+			if (!byPriority[i]->IsEmpty())
+				chosen = byPriority[i];
+	} else {
+		// form the information for the decision function
+		TypeInfo types[MAX_NUM_TYPES];
+		int num = 0;
+
+		for (map<off_t,TypeBookkeeping>::iterator itr = typeMap.begin();
 				itr!=typeMap.end(); itr++){
-		TypeBookkeeping& bk = (*itr).second;
-		if (bk.GetTypeInfo(timestamp,&types[num])){
-			// we have at least one message
-			num++;
+			TypeBookkeeping& bk = (*itr).second;
+			if (bk.GetTypeInfo(timestamp,&types[num])){
+				// we have at least one message
+				num++;
+			}
 		}
-	}
 
-    InternalMessage msg;
+		if( num > 0 ) {
+			// call the decision function to figure out what message to pop
+			off_t typeRet = decFct(decProcessor, types, num);
 
-    if( num > 0 ) {
-        // If we have a registered message, call the decision function to figure out
-        // what message to pop.
-        // call the decision function to figure out what message to pop
-        off_t typeRet = decFct(decProcessor, types, num);
-
-        // get the message of type typeRet
-        map<off_t,TypeBookkeeping>::iterator itr = typeMap.find(typeRet);
-        assert(itr!=typeMap.end());
+			map<off_t,TypeBookkeeping>::iterator itr = typeMap.find(typeRet);
+			assert(itr!=typeMap.end());
+			chosen = &(*itr).second;
+		}
+	}
 
-        TypeBookkeeping& bk = (*itr).second;
-        msg = bk.NextMessage();
-    }
-    else {
-        // Otherwise, we should have an unregistered message to send.
-        FATALIF(unregisteredMessages.size() == 0, "numMessages > 0, but there were no messages to send.");
+	if (chosen != NULL) {
+		// get the message of the chosen type
+		msg = chosen->NextMessage();
+	}
+	else {
+		// Otherwise, we should have an unregistered message to send.
+		FATALIF(unregisteredMessages.size() == 0, "numMessages > 0, but there were no messages to send.");
 
-        msg = unregisteredMessages.front();
-        unregisteredMessages.pop_front();
-    }
+		msg = unregisteredMessages.front();
+		unregisteredMessages.pop_front();
+	}
 
 	// message extracted
-	numMessages--;
+	numSorted--;
+	// only the reader writes this one, no need for an atomic increment
+	int removed = numRemoved.load(memory_order_relaxed) + 1;
+	numRemoved.store(removed, memory_order_relaxed);
 
 	if (debug == true){
 		printf("MSG OUT%25s:%25s, Time=%4d, QSize=%3d.\n",
-						dbgMsg, msg.GetPayload().TypeName(), msg.GetTimestamp(),
-			numMessages);
+				dbgMsg, msg.GetPayload().TypeName(), msg.GetTimestamp(),
+				numInserted.load(memory_order_relaxed) - removed);
 	}
 
 	pthread_mutex_unlock(&mutex);
@@ -204,7 +314,7 @@ Message& MultiMessageQueue::RemoveMessage() {
 }
 
 int MultiMessageQueue::GetSize() {
-	return numMessages;
+	return numInserted.load(memory_order_relaxed) - numRemoved.load(memory_order_relaxed);
 }
 
 off_t MultiMessageQueue::defaultDecisionFunction
@@ -0,0 +1,155 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef _MEMORY_ACCOUNTING_H_
+#define _MEMORY_ACCOUNTING_H_
+
+#include <atomic>
+#include <cinttypes>
+
+#include "Config.h"
+
+/** Accounting of the memory used by each query.
+
+    The owners are the bit indexes of the queries (see QueryManager). A
+    thread sets the owner of the memory it allocates before working for a
+    query, usually with a MemoryOwnerScope, and NumaMemoryAllocator charges
+    the blocks it hands out to that owner and gives the pages back to the
+    same owner when the block is freed, whoever frees it. Work done for
+    several queries at once is charged to the first one.
+
+    Memory allocated outside of the work of a query (hash segments, which
+    are shared by all the joins, buffers of the system) has no owner and
+    only counts in the total, not against the budgets.
+
+    The bit of a query is reused once the query is removed. When the bit
+    goes to a new query (see QueryManager::AddNewQuery) the owner starts a
+    new generation with a clean counter. The blocks remember the generation
+    they were charged to, the ones of the previous query are only taken off
+    the total when freed.
+
+    The budgets are checked by QueryManager for the admission of new
+    queries and by the table scans to slow down the production of chunks.
+    A budget of 0 means no limit.
+*/
+class MemoryAccounting {
+    public:
+        // a QueryIDSet has at most this many queries
+        static const int MAX_OWNERS = 128;
+
+        // memory not allocated for any query
+        static const int NO_OWNER = -1;
+
+    private:
+        static std::atomic<int64_t> ownerBytes[MAX_OWNERS];
+        static std::atomic<uint32_t> generations[MAX_OWNERS];
+        static std::atomic<int64_t> totalBytes;
+
+        // sum of ownerBytes, what the global budget is compared with
+        static std::atomic<int64_t> ownedBytes;
+
+        static int64_t queryBudget;
+        static int64_t globalBudget;
+
+        static THREAD_LOCAL int currentOwner;
+
+    public:
+        // sets the budgets in bytes, at startup
+        static void SetBudgets(int64_t perQuery, int64_t global);
+
+        static int64_t QueryBudget(void) { return queryBudget; }
+        static int64_t GlobalBudget(void) { return globalBudget; }
+
+        // the owner of the memory allocated by the calling thread
+        static int GetOwner(void) { return currentOwner; }
+        static void SetOwner(int owner) { currentOwner = owner; }
+
+        // current generation of the owner, to give back to with Release
+        static uint32_t Generation(int owner);
+
+        // adds bytes (negative to give back) to the owner and to the total
+        static void Charge(int owner, int64_t bytes);
+
+        // gives back bytes charged to the generation of the owner. The owner
+        // only gets them back if it is still the same generation
+        static void Release(int owner, uint32_t generation, int64_t bytes);
+
+        static int64_t OwnerBytes(int owner);
+        static int64_t TotalBytes(void) { return totalBytes.load(std::memory_order_relaxed); }
+        static int64_t OwnedBytes(void) { return ownedBytes.load(std::memory_order_relaxed); }
+
+        // starts a new generation of the owner, for a new query with the same
+        // bit. Returns what the previous one had left
+        static int64_t ResetOwner(int owner);
+
+        // is the owner, or all the owners together, over the budget?
+        static bool OwnerOverBudget(int owner);
+        static bool GlobalOverBudget(void);
+};
+
+/** Sets the owner of the memory allocated by the thread while in scope */
+class MemoryOwnerScope {
+    int previous;
+
+    public:
+        MemoryOwnerScope(int owner):previous(MemoryAccounting::GetOwner()) {
+            MemoryAccounting::SetOwner(owner);
+        }
+
+        ~MemoryOwnerScope() {
+            MemoryAccounting::SetOwner(previous);
+        }
+};
+
+
+// Inlined methods
+
+inline void MemoryAccounting::Charge(int owner, int64_t bytes) {
+    if (owner >= 0 && owner < MAX_OWNERS) {
+        ownerBytes[owner].fetch_add(bytes, std::memory_order_relaxed);
+        ownedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    totalBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+inline uint32_t MemoryAccounting::Generation(int owner) {
+    if (owner < 0 || owner >= MAX_OWNERS)
+        return 0;
+    return generations[owner].load(std::memory_order_relaxed);
+}
+
+inline void MemoryAccounting::Release(int owner, uint32_t generation, int64_t bytes) {
+    if (owner >= 0 && owner < MAX_OWNERS && generation == Generation(owner)) {
+        ownerBytes[owner].fetch_sub(bytes, std::memory_order_relaxed);
+        ownedBytes.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+    totalBytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+inline int64_t MemoryAccounting::OwnerBytes(int owner) {
+    if (owner < 0 || owner >= MAX_OWNERS)
+        return 0;
+    return ownerBytes[owner].load(std::memory_order_relaxed);
+}
+
+inline bool MemoryAccounting::OwnerOverBudget(int owner) {
+    return queryBudget > 0 && OwnerBytes(owner) > queryBudget;
+}
+
+inline bool MemoryAccounting::GlobalOverBudget(void) {
+    return globalBudget > 0 && OwnedBytes() > globalBudget;
+}
+
+#endif // _MEMORY_ACCOUNTING_H_
@@ -20,9 +20,13 @@
 #include <set>
 #include <list>
 #include <vector>
+#include <atomic>
+#include <cinttypes>
 #include <pthread.h>
 
+#include "Config.h"
 #include "MmapAllocator.h"
+#include "MemoryAccounting.h"
 // Below 3 headers need for constant used for defining fixed hash size HASH_SEG_SIZE
 #include "HashTableMacros.h"
 #include "Constants.h"
@@ -69,6 +73,23 @@
  * 10. Splitting of chunks is also some assignment of pointers if header is stored in
  *     chunks. And if not stored within chunk, we have to pay little search penalty.
  * 11. Header is 40 bytes long (void*) aligned.
+ * 12. Small blocks (up to NUMA_CACHE_MAX_PAGES pages) are cached per thread,
+ *     per numa node and per size. Allocations and frees of such blocks are
+ *     served from the cache of the calling thread without taking the global
+ *     mutex. The cache is refilled from (and returned to) the shared heap
+ *     in batches, so the mutex is taken once per batch instead of once per block.
+ *     These sizes are never coalesced, so caching them does not fragment the heap.
+ *     A block sitting in a cache is still allocated from the point of view of
+ *     the shared heap. A block goes back only in the cache of the thread that
+ *     allocated it; freed by any other thread, it goes to the shared heap, so
+ *     that the memory does not pile up in the caches of the consuming threads.
+ *     The sizes of the caches are set in Constants.h.
+ * 13. The map of allocated blocks (used to find the size of a block when it is
+ *     freed) is split in NUMA_SIZE_MAP_SHARDS pieces, each with its own lock,
+ *     so that the cached path only contends with threads touching the same piece.
+ * 14. Each allocated block is charged to the query the allocating thread works
+ *     for (see MemoryAccounting.h). The owner is kept in the map of allocated
+ *     blocks so that the free gives the memory back to the same query.
 
  This allocator is thread safe.
 
@@ -89,6 +110,12 @@
 // Grow heap during run by this size if needed
 #define HEAP_GROW_BY_SIZE 256*16
 
+// Blocks up to this size (in pages) are kept in the per thread caches
+#define NUMA_CACHE_MAX_PAGES NO_COALESCE_MAXPAGESIZE
+
+// Number of independently locked pieces of the map of allocated blocks
+#define NUMA_SIZE_MAP_SHARDS 64
+
 // This checks memory leaks.
 class MemoryCheck {
 
@@ -110,10 +137,26 @@ class MemoryCheck {
     void Print();
 };
 
+// Counters describing the behavior of the allocator
+struct NumaAllocatorStats {
+    uint64_t lockAcquisitions; // number of times the global mutex was taken
+    uint64_t lockContentions; // number of times the global mutex was already taken by somebody else
+    uint64_t cacheHits; // allocations served from the thread caches
+    uint64_t cacheMisses; // allocations that needed a refill of the thread cache
+    int64_t cachedPages; // pages sitting in the thread caches
+};
+
 class NumaMemoryAllocator {
 
     pthread_mutex_t mutex; // to guard the implementation
 
+    // counters, see NumaAllocatorStats
+    std::atomic<uint64_t> lockAcquisitions;
+    std::atomic<uint64_t> lockContentions;
+    std::atomic<uint64_t> cacheHits;
+    std::atomic<uint64_t> cacheMisses;
+    std::atomic<int64_t> cachedPages;
+
 #ifdef MMAP_CHECK
     MemoryCheck memChk;
 #endif
@@ -147,12 +190,50 @@ class NumaMemoryAllocator {
 
     // This keeps track of all freelists per numa node
     struct NumaNode{
+        int number; // position in mNumaNumberToNumaNode
         std::map<int, std::set<void*>*> mSizeToFreeListMap;
     };
 
+    struct ThreadCache;
+
+    // what we know about an allocated block
+    struct BlockInfo{
+        int size; // size in pages
+        int node; // numa node the block was carved from
+        bool cached; // true if the block sits in a thread cache
+        int owner; // who the block is charged to (see MemoryAccounting.h)
+        uint32_t generation; // generation of the owner it is charged to
+        ThreadCache* cache; // cache of the thread that allocated the block, if any
+    };
+
     // map to keep track of allocated data to verify double free error
-    typedef std::map< void*, int > SizeMap;
-    SizeMap sizeMap; // the map from pointers to the size allocated (in pages)
+    typedef std::map< void*, BlockInfo > SizeMap;
+
+    // one piece of the map from pointers to the size allocated
+    struct SizeMapShard{
+        pthread_mutex_t lock;
+        SizeMap sizeMap;
+    };
+    SizeMapShard sizeMaps[NUMA_SIZE_MAP_SHARDS];
+
+    // cached blocks of one size on one node (used as a stack)
+    struct CacheList{
+        int count;
+        void* blocks[NUMA_CACHE_LIST_PAGES];
+    };
+
+    // the cache of a thread. Plain data so that it can be __thread
+    struct ThreadCache{
+        int numNodes;
+        int pages; // pages held in all the lists
+        CacheList* lists; // numNodes x (NUMA_CACHE_MAX_PAGES+1) lists
+    };
+
+    // cache of the current thread, created on first use
+    static THREAD_LOCAL ThreadCache* threadCache;
+
+    // used to return the cache to the heap when the thread exits
+    pthread_key_t cacheKey;
 
 
 #ifndef STORE_HEADER_IN_CHUNK
@@ -203,6 +284,50 @@ class NumaMemoryAllocator {
     void SearchFreeListSmallestFirst(NumaNode*, int pSize, bool& exactListFound, bool& biggerListFound,
             std::map<int, std::set<void*>*>::iterator& iter);
 
+    // Takes the global mutex and counts the contention
+    void Lock(void);
+    void Unlock(void);
+
+    // Carves a chunk of pSize pages from the heap of the node (or of another node).
+    // Must be called with the mutex held. numaNo is set to the node used
+    void* HeapAlloc(int pSize, int node, int& numaNo);
+
+    // the piece of the size map that holds ptr
+    SizeMapShard& ShardOf(void* ptr);
+
+    // Records an allocated block in the size map and charges it to the
+    // owner of the thread if it is not cached
+    void RegisterBlock(void* ptr, int pSize, int node, bool cached);
+
+    // Deletes the block from the size map and returns its size in pages
+    // Returns false if the block is not there. The block goes back to its owner
+    bool UnregisterBlock(void* ptr, int& pSize);
+
+    // Returns the cache of the current thread, creates it if needed
+    ThreadCache* GetThreadCache(void);
+
+    // The list of cached blocks of size pSize for the node
+    CacheList& GetCacheList(ThreadCache* cache, int node, int pSize);
+
+    // Serves an allocation of pSize pages from the cache of the current thread
+    void* CacheAlloc(int pSize, int node);
+
+    // Tries to put the block in the cache of the current thread
+    // Returns false if the block is not a candidate (unknown or too big)
+    bool CacheFree(void* ptr);
+
+    // Moves a batch of blocks from the heap to the list
+    void RefillCacheList(CacheList& list, int pSize, int node);
+
+    // Gives num blocks of the list back to the heap
+    void FlushCacheList(ThreadCache* cache, CacheList& list, int pSize, int num);
+
+    // Gives all the blocks back to the heap and deletes the cache
+    void ReleaseThreadCache(ThreadCache* cache);
+
+    // destructor of cacheKey
+    static void ThreadCacheDestructor(void* arg);
+
     public:
     // default constructor; initializes the allocator
     NumaMemoryAllocator(void);
@@ -226,6 +351,9 @@ class NumaMemoryAllocator {
     size_t AllocatedPages();
     size_t FreePages();
 
+    // Fills in the counters of the allocator
+    void GetStatistics(NumaAllocatorStats& where);
+
 #ifdef MMAP_CHECK
     void Diagnose();
 #endif
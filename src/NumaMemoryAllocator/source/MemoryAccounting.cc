@@ -0,0 +1,44 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#include "MemoryAccounting.h"
+#include "Constants.h"
+
+std::atomic<int64_t> MemoryAccounting :: ownerBytes[MAX_OWNERS];
+std::atomic<uint32_t> MemoryAccounting :: generations[MAX_OWNERS];
+std::atomic<int64_t> MemoryAccounting :: totalBytes(0);
+std::atomic<int64_t> MemoryAccounting :: ownedBytes(0);
+
+int64_t MemoryAccounting :: queryBudget = QUERY_MEMORY_BUDGET;
+int64_t MemoryAccounting :: globalBudget = GLOBAL_MEMORY_BUDGET;
+
+THREAD_LOCAL int MemoryAccounting :: currentOwner = MemoryAccounting :: NO_OWNER;
+
+void MemoryAccounting :: SetBudgets(int64_t perQuery, int64_t global) {
+    queryBudget = perQuery;
+    globalBudget = global;
+}
+
+int64_t MemoryAccounting :: ResetOwner(int owner) {
+    if (owner < 0 || owner >= MAX_OWNERS)
+        return 0;
+
+    // the blocks of the previous generation no longer give back to the
+    // counter, what they hold goes out of the sum with it
+    generations[owner].fetch_add(1, std::memory_order_relaxed);
+    int64_t left = ownerBytes[owner].exchange(0, std::memory_order_relaxed);
+    ownedBytes.fetch_sub(left, std::memory_order_relaxed);
+    return left;
+}
@@ -113,15 +113,86 @@ void MemoryCheck::Print() {
 	printf("\n");
 }
 
-NumaMemoryAllocator::NumaMemoryAllocator(void)
+THREAD_LOCAL NumaMemoryAllocator::ThreadCache* NumaMemoryAllocator::threadCache = NULL;
+
+NumaMemoryAllocator::NumaMemoryAllocator(void):
+	lockAcquisitions(0),
+	lockContentions(0),
+	cacheHits(0),
+	cacheMisses(0),
+	cachedPages(0)
 {
 	// initialize the mutex
 	pthread_mutex_init(&mutex, NULL);
+	for (int i = 0; i < NUMA_SIZE_MAP_SHARDS; i++)
+		pthread_mutex_init(&sizeMaps[i].lock, NULL);
+	pthread_key_create(&cacheKey, ThreadCacheDestructor);
 	mHeapInitialized = false;
 }
 
-int NumaMemoryAllocator::SizeAlloc(void* ptr){ 
-	return sizeMap[ptr]; 
+void NumaMemoryAllocator::Lock(void){
+	if (pthread_mutex_trylock(&mutex) != 0) {
+		lockContentions++;
+		pthread_mutex_lock(&mutex);
+	}
+	lockAcquisitions++;
+}
+
+void NumaMemoryAllocator::Unlock(void){
+	pthread_mutex_unlock(&mutex);
+}
+
+NumaMemoryAllocator::SizeMapShard& NumaMemoryAllocator::ShardOf(void* ptr){
+	// blocks are page aligned, the low bits carry no information
+	return sizeMaps[(((uintptr_t) ptr) >> ALLOC_PAGE_SIZE_EXPONENT) % NUMA_SIZE_MAP_SHARDS];
+}
+
+void NumaMemoryAllocator::RegisterBlock(void* ptr, int pSize, int node, bool cached){
+	SizeMapShard& shard = ShardOf(ptr);
+	pthread_mutex_lock(&shard.lock);
+	// look up the new page to ensure it is not already out
+	SizeMap::iterator it = shard.sizeMap.find(ptr);
+	FATALIF(it!=shard.sizeMap.end(), "Allocating already allocated pointer %p.", ptr);
+	BlockInfo info;
+	info.size = pSize;
+	info.node = node;
+	info.cached = cached;
+	info.owner = cached ? MemoryAccounting::NO_OWNER : MemoryAccounting::GetOwner();
+	info.generation = MemoryAccounting::Generation(info.owner);
+	info.cache = NULL;
+	shard.sizeMap.insert(pair<void*, BlockInfo>(ptr, info));
+	pthread_mutex_unlock(&shard.lock);
+
+	if (!cached)
+		MemoryAccounting::Charge(info.owner, PageSizeToBytes(pSize));
+}
+
+bool NumaMemoryAllocator::UnregisterBlock(void* ptr, int& pSize){
+	SizeMapShard& shard = ShardOf(ptr);
+	pthread_mutex_lock(&shard.lock);
+	SizeMap::iterator it = shard.sizeMap.find(ptr);
+	bool found = (it != shard.sizeMap.end());
+	BlockInfo info;
+	if (found) {
+		info = it->second;
+		pSize = info.size;
+		shard.sizeMap.erase(it);
+	}
+	pthread_mutex_unlock(&shard.lock);
+
+	// the cached blocks were given back when they went in the cache
+	if (found && !info.cached)
+		MemoryAccounting::Release(info.owner, info.generation, PageSizeToBytes(pSize));
+	return found;
+}
+
+int NumaMemoryAllocator::SizeAlloc(void* ptr){
+	SizeMapShard& shard = ShardOf(ptr);
+	pthread_mutex_lock(&shard.lock);
+	SizeMap::iterator it = shard.sizeMap.find(ptr);
+	int rez = (it != shard.sizeMap.end() && !it->second.cached) ? it->second.size : 0;
+	pthread_mutex_unlock(&shard.lock);
+	return rez;
 }
 
 int NumaMemoryAllocator::BytesToPageSize(size_t bytes){
@@ -151,6 +222,7 @@ void NumaMemoryAllocator::HeapInit()
 		nodeMask = 0;
 		nodeMask |= (1 << node);
 		NumaNode* numa = new NumaNode;
+		numa->number = node;
 		//mNumaNumberToNumaNodeMap[node] = numa;
 		mNumaNumberToNumaNode.push_back(numa);
 		int pageFD = 0;
@@ -259,21 +331,9 @@ void* NumaMemoryAllocator::MmapAlloc(size_t noBytes, int node, const char* f, in
 	if (noBytes == 0)
 		return NULL;
 
-	pthread_mutex_lock(&mutex);
-
-	//printf("\n Allocated size = %ld, Free pages size = %ld", AllocatedPages(), FreePages()); fflush(stdout);
-
-	if (!mHeapInitialized)
-	HeapInit();
 #ifndef USE_NUMA
 	node = 0;
 #endif
-	NumaNode* numa = NULL;
-	numa = mNumaNumberToNumaNode[node];
-	ASSERT(numa);
-	//map<int, NumaNode*>::iterator itNuma= mNumaNumberToNumaNodeMap.find(node);
-	//ASSERT (itNuma != mNumaNumberToNumaNodeMap.end());
-	//numa = itNuma->second;
 
 #ifndef STORE_HEADER_IN_CHUNK
 	int pSize = BytesToPageSize(noBytes);
@@ -282,6 +342,20 @@ void* NumaMemoryAllocator::MmapAlloc(size_t noBytes, int node, const char* f, in
 #endif
 
 	int hash_seg_size = BytesToPageSize(HASH_SEG_SIZE);
+
+#ifndef MMAP_CHECK
+	// small blocks come from the cache of the thread, no global lock needed
+	if (pSize <= NUMA_CACHE_MAX_PAGES && pSize != hash_seg_size)
+		return CacheAlloc(pSize, node);
+#endif
+
+	Lock();
+
+	//printf("\n Allocated size = %ld, Free pages size = %ld", AllocatedPages(), FreePages()); fflush(stdout);
+
+	if (!mHeapInitialized)
+	HeapInit();
+
 	if (pSize == hash_seg_size) {
 		if (fixedSizeList.empty()) {
 			//int pageFD = 0;
@@ -292,7 +366,9 @@ void* NumaMemoryAllocator::MmapAlloc(size_t noBytes, int node, const char* f, in
 			}
       SYS_MMAP_PROT(newChunk, PageSizeToBytes(hash_seg_size), PROT_READ | PROT_WRITE);
 			fixedSizeOccupiedList.insert(newChunk);
-			pthread_mutex_unlock(&mutex);
+			Unlock();
+			// hash segments are shared by all the queries
+			MemoryAccounting::Charge(MemoryAccounting::NO_OWNER, PageSizeToBytes(hash_seg_size));
 			return newChunk;
 		}
 		set<void*>::iterator is = fixedSizeList.begin();
@@ -300,10 +376,36 @@ void* NumaMemoryAllocator::MmapAlloc(size_t noBytes, int node, const char* f, in
 		fixedSizeList.erase(is);
 		fixedSizeOccupiedList.insert(res);
     SYS_MMAP_PROT(res, PageSizeToBytes(hash_seg_size), PROT_READ | PROT_WRITE);
-		pthread_mutex_unlock(&mutex);
+		Unlock();
+		MemoryAccounting::Charge(MemoryAccounting::NO_OWNER, PageSizeToBytes(hash_seg_size));
 		return res;
 	}
 
+	int numaNo;
+	void* rezPtr = HeapAlloc(pSize, node, numaNo);
+
+	// record the allocation in sizeMap
+	RegisterBlock(rezPtr, pSize, numaNo, false);
+	// now mark the page as Write-Only
+	WARNINGIF(SYS_MMAP_PROT(rezPtr, PageSizeToBytes(pSize), PROT_READ | PROT_WRITE) == -1, 
+		"Changing protection of page at address %p size %d failed with message %s", rezPtr, pSize, strerror(errno));
+
+#ifdef MMAP_CHECK
+	memChk.Insert(rezPtr, noBytes, f, l);
+#endif
+	Unlock();
+
+	return rezPtr;
+}
+
+void* NumaMemoryAllocator::HeapAlloc(int pSize, int node, int& numaNo){
+	NumaNode* numa = NULL;
+	numa = mNumaNumberToNumaNode[node];
+	ASSERT(numa);
+	//map<int, NumaNode*>::iterator itNuma= mNumaNumberToNumaNodeMap.find(node);
+	//ASSERT (itNuma != mNumaNumberToNumaNodeMap.end());
+	//numa = itNuma->second;
+
 	bool exactListFound = false;
 	bool biggerListFound = false;
 	//map<int, set<void*>*>::reverse_iterator r_iter;
@@ -467,25 +569,10 @@ void* NumaMemoryAllocator::MmapAlloc(size_t noBytes, int node, const char* f, in
 		FATALIF(true, "Page size not found = %d", pSize);
 	}
 
-	// test code
-	// look up the new page to ensure it is not already out
-	SizeMap::iterator it=sizeMap.find(rezPtr);
-	FATALIF(it!=sizeMap.end(), "Allocating already allocated pointer %p.", rezPtr);
-	// record the allocation in sizeMap
-	sizeMap.insert(pair<void*, int>(rezPtr, pSize));
-	// now mark the page as Write-Only
-	WARNINGIF(SYS_MMAP_PROT(rezPtr, PageSizeToBytes(pSize), PROT_READ | PROT_WRITE) == -1, 
-		"Changing protection of page at address %p size %d failed with message %s", rezPtr, pSize, strerror(errno));
-
-#ifdef MMAP_CHECK
-	memChk.Insert(rezPtr, noBytes, f, l);
-#endif
-	pthread_mutex_unlock(&mutex);
-
+	numaNo = numa->number;
 	return rezPtr;
 }
 
-
 void NumaMemoryAllocator::MmapChangeProt(void* ptr, int prot) {
   // Uncomment the line below to bypass the protection
   // return;
@@ -493,23 +580,28 @@ void NumaMemoryAllocator::MmapChangeProt(void* ptr, int prot) {
 	if (ptr==NULL) {
 		return;
     }
-    pthread_mutex_lock(&mutex);
-    set<void*>::iterator is = fixedSizeOccupiedList.find(ptr);
-    if (is != fixedSizeOccupiedList.end()) {
-    	SYS_MMAP_PROT(ptr, PageSizeToBytes(BytesToPageSize(HASH_SEG_SIZE)), prot);
-	} else {
-   	    // must be in the siseMap then
-   	    // see if the pointer is allocated
-		FATALIF(sizeMap.size()==0, "I found the size map in MmapProt to be 0. This means that mmap_free was called before mmap_alloc");
 
-     	// find the size and insert the freed memory in the
-		SizeMap::iterator it=sizeMap.find(ptr);
-		FATALIF(it==sizeMap.end(), "Changing the protection of unallocated pointer %p.", ptr);
+	// most pointers are regular blocks, the shard is enough for them
+	SizeMapShard& shard = ShardOf(ptr);
+	pthread_mutex_lock(&shard.lock);
+	SizeMap::iterator it=shard.sizeMap.find(ptr);
+	if (it != shard.sizeMap.end()) {
+		FATALIF(it->second.cached, "Changing the protection of unallocated pointer %p.", ptr);
+		int pSize = it->second.size;
+		pthread_mutex_unlock(&shard.lock);
     	// change protection
-		WARNINGIF( SYS_MMAP_PROT(ptr, PageSizeToBytes(it->second), prot) == -1,
-			"Changing protection of page at address %p size %d failed with message %s", ptr, it->second, strerror(errno));
+		WARNINGIF( SYS_MMAP_PROT(ptr, PageSizeToBytes(pSize), prot) == -1,
+			"Changing protection of page at address %p size %d failed with message %s", ptr, pSize, strerror(errno));
+		return;
 	}
-	pthread_mutex_unlock(&mutex);
+	pthread_mutex_unlock(&shard.lock);
+
+	// must be a hash segment then
+    Lock();
+    set<void*>::iterator is = fixedSizeOccupiedList.find(ptr);
+	FATALIF(is == fixedSizeOccupiedList.end(), "Changing the protection of unallocated pointer %p.", ptr);
+	SYS_MMAP_PROT(ptr, PageSizeToBytes(BytesToPageSize(HASH_SEG_SIZE)), prot);
+	Unlock();
 }
 
 void NumaMemoryAllocator::MmapFree(void* ptr){
@@ -517,34 +609,205 @@ void NumaMemoryAllocator::MmapFree(void* ptr){
 		return;
     }
 
-	pthread_mutex_lock(&mutex);
+#ifndef MMAP_CHECK
+	// small blocks go in the cache of the thread, no global lock needed
+	if (CacheFree(ptr))
+		return;
+#endif
+
+	Lock();
 
 	set<void*>::iterator is = fixedSizeOccupiedList.find(ptr);
 	if (is != fixedSizeOccupiedList.end()) {
 		fixedSizeList.insert(ptr);
 		fixedSizeOccupiedList.erase(is);
-		pthread_mutex_unlock(&mutex);
+		Unlock();
+		MemoryAccounting::Charge(MemoryAccounting::NO_OWNER,
+			-(int64_t) PageSizeToBytes(BytesToPageSize(HASH_SEG_SIZE)));
 		return;
 	}
 #ifdef MMAP_CHECK
 	memChk.Delete(ptr);
 #endif
-	// see if the pointer is allocated
-	FATALIF(sizeMap.size()==0, "I found the size map in MmapFree to be 0. This means that mmap_free was called before mmap_alloc");
 
-	// find the size and insert the freed memory in the
-	SizeMap::iterator it=sizeMap.find(ptr);
-	FATALIF(it==sizeMap.end(), "Deallocating unallocated pointer %p.", ptr);
+	// find the size and delete the element from the sizeMap.
+	int pSize;
+	FATALIF(!UnregisterBlock(ptr, pSize), "Deallocating unallocated pointer %p.", ptr);
 
 	// change the protectin to NONE to make sure nobody uses it without allocating
-	SYS_MMAP_PROT(ptr, it->second, PROT_NONE);
-
-	// delete the element from the sizeMap.
-	sizeMap.erase(it);
+	SYS_MMAP_PROT(ptr, PageSizeToBytes(pSize), PROT_NONE);
 
 	Coalesce(ptr);
 
-	pthread_mutex_unlock(&mutex);
+	Unlock();
+}
+
+NumaMemoryAllocator::ThreadCache* NumaMemoryAllocator::GetThreadCache(void){
+	if (threadCache != NULL)
+		return threadCache;
+
+	Lock();
+	if (!mHeapInitialized)
+		HeapInit();
+	int numNodes = mNumaNumberToNumaNode.size();
+	Unlock();
+
+	ThreadCache* cache = new ThreadCache;
+	cache->numNodes = numNodes;
+	cache->pages = 0;
+	cache->lists = new CacheList[numNodes * (NUMA_CACHE_MAX_PAGES+1)];
+	for (int i = 0; i < numNodes * (NUMA_CACHE_MAX_PAGES+1); i++)
+		cache->lists[i].count = 0;
+
+	threadCache = cache;
+	// the key only serves to give the blocks back when the thread exits
+	pthread_setspecific(cacheKey, cache);
+
+	return cache;
+}
+
+NumaMemoryAllocator::CacheList& NumaMemoryAllocator::GetCacheList(ThreadCache* cache, int node, int pSize){
+	// no preference (or a node we do not know about) goes to the first node
+	if (node < 0 || node >= cache->numNodes)
+		node = 0;
+	return cache->lists[node * (NUMA_CACHE_MAX_PAGES+1) + pSize];
+}
+
+void* NumaMemoryAllocator::CacheAlloc(int pSize, int node){
+	ThreadCache* cache = GetThreadCache();
+	CacheList& list = GetCacheList(cache, node, pSize);
+
+	if (list.count == 0) {
+		cacheMisses++;
+		RefillCacheList(list, pSize, node);
+	} else {
+		cacheHits++;
+	}
+
+	ASSERT(list.count > 0);
+	void* rezPtr = list.blocks[--list.count];
+	cache->pages -= pSize;
+	cachedPages -= pSize;
+
+	// the block is allocated for real now
+	SizeMapShard& shard = ShardOf(rezPtr);
+	pthread_mutex_lock(&shard.lock);
+	SizeMap::iterator it = shard.sizeMap.find(rezPtr);
+	FATALIF(it == shard.sizeMap.end() || !it->second.cached,
+		"Allocating already allocated pointer %p.", rezPtr);
+	it->second.cached = false;
+	it->second.owner = MemoryAccounting::GetOwner();
+	it->second.generation = MemoryAccounting::Generation(it->second.owner);
+	it->second.cache = cache;
+	pthread_mutex_unlock(&shard.lock);
+
+	MemoryAccounting::Charge(MemoryAccounting::GetOwner(), PageSizeToBytes(pSize));
+
+	// now mark the page as Write-Only
+	WARNINGIF(SYS_MMAP_PROT(rezPtr, PageSizeToBytes(pSize), PROT_READ | PROT_WRITE) == -1,
+		"Changing protection of page at address %p size %d failed with message %s", rezPtr, pSize, strerror(errno));
+
+	return rezPtr;
+}
+
+bool NumaMemoryAllocator::CacheFree(void* ptr){
+	SizeMapShard& shard = ShardOf(ptr);
+	pthread_mutex_lock(&shard.lock);
+	SizeMap::iterator it = shard.sizeMap.find(ptr);
+	if (it == shard.sizeMap.end() || it->second.size > NUMA_CACHE_MAX_PAGES) {
+		// hash segment or big block, the heap deals with it
+		pthread_mutex_unlock(&shard.lock);
+		return false;
+	}
+	FATALIF(it->second.cached, "Deallocating unallocated pointer %p.", ptr);
+	if (threadCache == NULL || it->second.cache != threadCache) {
+		// allocated by another thread (or outside the caches), the heap takes it
+		pthread_mutex_unlock(&shard.lock);
+		return false;
+	}
+	it->second.cached = true;
+	int pSize = it->second.size;
+	int node = it->second.node;
+	int owner = it->second.owner;
+	uint32_t generation = it->second.generation;
+	pthread_mutex_unlock(&shard.lock);
+
+	MemoryAccounting::Release(owner, generation, PageSizeToBytes(pSize));
+
+	// change the protectin to NONE to make sure nobody uses it without allocating
+	SYS_MMAP_PROT(ptr, PageSizeToBytes(pSize), PROT_NONE);
+
+	ThreadCache* cache = threadCache;
+	CacheList& list = GetCacheList(cache, node, pSize);
+	int capacity = NUMA_CACHE_LIST_PAGES / pSize;
+
+	// make room by giving half of the list back
+	if (list.count >= capacity)
+		FlushCacheList(cache, list, pSize, list.count - capacity/2);
+
+	list.blocks[list.count++] = ptr;
+	cache->pages += pSize;
+	cachedPages += pSize;
+
+	// the thread holds too much memory overall, give this list back entirely
+	if (cache->pages > NUMA_CACHE_THREAD_PAGES)
+		FlushCacheList(cache, list, pSize, list.count);
+
+	return true;
+}
+
+void NumaMemoryAllocator::RefillCacheList(CacheList& list, int pSize, int node){
+	// half the list, so that a following free does not flush right away
+	int capacity = NUMA_CACHE_LIST_PAGES / pSize;
+	int num = capacity/2 > 0 ? capacity/2 : 1;
+
+	Lock();
+	for (int i = 0; i < num; i++) {
+		int numaNo;
+		void* ptr = HeapAlloc(pSize, node, numaNo);
+		RegisterBlock(ptr, pSize, numaNo, true);
+		list.blocks[list.count++] = ptr;
+	}
+	Unlock();
+
+	threadCache->pages += num * pSize;
+	cachedPages += num * pSize;
+}
+
+void NumaMemoryAllocator::FlushCacheList(ThreadCache* cache, CacheList& list, int pSize, int num){
+	if (num <= 0)
+		return;
+
+	Lock();
+	for (int i = 0; i < num; i++) {
+		void* ptr = list.blocks[--list.count];
+		int size;
+		FATALIF(!UnregisterBlock(ptr, size), "Cached pointer %p is not allocated.", ptr);
+		ASSERT(size == pSize);
+		Coalesce(ptr);
+	}
+	Unlock();
+
+	cache->pages -= num * pSize;
+	cachedPages -= num * pSize;
+}
+
+void NumaMemoryAllocator::ReleaseThreadCache(ThreadCache* cache){
+	for (int node = 0; node < cache->numNodes; node++) {
+		for (int pSize = 1; pSize <= NUMA_CACHE_MAX_PAGES; pSize++) {
+			CacheList& list = GetCacheList(cache, node, pSize);
+			FlushCacheList(cache, list, pSize, list.count);
+		}
+	}
+	delete [] cache->lists;
+	delete cache;
+}
+
+void NumaMemoryAllocator::ThreadCacheDestructor(void* arg){
+	ThreadCache* cache = (ThreadCache*) arg;
+	if (threadCache == cache)
+		threadCache = NULL;
+	GetAllocator().ReleaseThreadCache(cache);
 }
 
 // Update the freelist if some chunk is freed or allocated. If allocated, remove from freelist.
@@ -688,6 +951,9 @@ void NumaMemoryAllocator::Coalesce(void* ptr)
 NumaMemoryAllocator::~NumaMemoryAllocator(void){
 	// dealocate the mutex
 	pthread_mutex_destroy(&mutex);
+	for (int i = 0; i < NUMA_SIZE_MAP_SHARDS; i++)
+		pthread_mutex_destroy(&sizeMaps[i].lock);
+	pthread_key_delete(cacheKey);
 	// it would be nice to deallocate the memory with munmap as well
 }
 
@@ -697,6 +963,8 @@ size_t NumaMemoryAllocator::AllocatedPages() {
 		if (!((it->second)->sizeInfo).sizeStruct.isFree)
 			Size += ((it->second)->sizeInfo).sizeStruct.size;
 	}
+	// the blocks in the thread caches are not used by anybody
+	Size -= cachedPages;
 	return Size;
 }
 
@@ -711,11 +979,21 @@ size_t NumaMemoryAllocator::FreePages() {
 	return totalFreelistSize;
 }
 
+void NumaMemoryAllocator::GetStatistics(NumaAllocatorStats& where) {
+	where.lockAcquisitions = lockAcquisitions;
+	where.lockContentions = lockContentions;
+	where.cacheHits = cacheHits;
+	where.cacheMisses = cacheMisses;
+	where.cachedPages = cachedPages;
+}
+
 #ifdef MMAP_CHECK
 void NumaMemoryAllocator::Diagnose() {
-	pthread_mutex_lock(&mutex);
+	Lock();
 	memChk.Print();
 	printf("\n =================  %ld\n", AllocatedPages());
-	pthread_mutex_unlock(&mutex);
+	printf("\n lock acquisitions = %lu, contended = %lu", (unsigned long) lockAcquisitions, (unsigned long) lockContentions);
+	printf("\n cache hits = %lu, misses = %lu\n", (unsigned long) cacheHits, (unsigned long) cacheMisses);
+	Unlock();
 }
 #endif
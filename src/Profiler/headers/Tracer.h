@@ -0,0 +1,118 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef _TRACER_H_
+#define _TRACER_H_
+
+#include <cinttypes>
+#include <string>
+
+#include "Constants.h"
+#include "QueryID.h"
+
+/** Timeline of what the threads of the system did, in the Chrome trace
+    format (chrome://tracing or https://ui.perfetto.dev can open it).
+
+    The profiler only keeps counters, this keeps the individual spans: which
+    work function ran on which worker and when, how long the waypoints waited
+    for their tokens, the reads and writes of each disk and how long the
+    chunk requests took end to end.
+
+    Each thread records its events in its own ring buffer of
+    TRACE_BUFFER_EVENTS events, so only the recent history is kept. The
+    buffer has a lock of its own, taken for each event so that a dump can
+    copy it at the same time; only the dumps contend for it. The buffers are
+    dumped to a file per query when the query finishes (see CoordinatorImp).
+
+    Tracing is off unless Enable is called at startup (option -T of
+    datapath). When off, the cost of a trace point is the test of a flag.
+
+    The events are tagged with the queries the thread is working for (see
+    TraceQueriesScope), the trace of a query only has the events of that
+    query. The events not done for particular queries (disk requests, token
+    waits) are left out of the query traces.
+
+    Spans on a thread have to nest. The ones that overlap (token waits, disk
+    requests in flight, chunk requests) are recorded as asynchronous spans,
+    shown on tracks of their own.
+*/
+class Tracer {
+    public:
+        // starts recording. The traces of the queries go in directory
+        static void Enable(const char* directory);
+
+        static bool IsEnabled(void) { return enabled; }
+
+        // current time in microseconds, the timestamp of all the events
+        static int64_t Now(void);
+
+        // a span of the calling thread. category has to be a string literal,
+        // it also names the thread in the trace
+        static void Span(const char* category, const char* name, int64_t start, int64_t end, int64_t arg = 0);
+
+        // a span that can overlap others, recorded by the calling thread but
+        // not belonging to it
+        static void AsyncSpan(const char* category, const char* name, int64_t start, int64_t end, int64_t arg = 0);
+
+        // same, for an operation done for queries other than the ones of the
+        // calling thread
+        static void AsyncSpan(const char* category, const char* name, int64_t start, int64_t end, int64_t arg,
+                const QueryIDSet& queries);
+
+        // the queries the events of the calling thread are tagged with
+        static void SetQueries(const QueryIDSet& queries);
+        static QueryIDSet GetQueries(void);
+
+        // writes the events overlapping [from, to] to fileName, only the ones
+        // of queries if not empty. Returns false if the file cannot be written
+        static bool Dump(const char* fileName, int64_t from, int64_t to,
+                const QueryIDSet& queries = QueryIDSet());
+
+        // dumps the events of query overlapping [from, to] to
+        // trace_<queryName>.json in the trace directory
+        static bool DumpQuery(const std::string& queryName, QueryID query, int64_t from, int64_t to);
+
+    private:
+        static bool enabled;
+        static std::string directory;
+};
+
+/** Tags the events recorded by the calling thread with queries while in
+    scope, in the style of MemoryOwnerScope.
+*/
+class TraceQueriesScope {
+    QueryIDSet previous;
+
+    public:
+        TraceQueriesScope(const QueryIDSet& queries) : previous(Tracer::GetQueries()) {
+            Tracer::SetQueries(queries);
+        }
+
+        ~TraceQueriesScope() {
+            Tracer::SetQueries(previous);
+        }
+};
+
+// Macros to trace a span of code, in the style of PROFILING2_START/END.
+// The name is only evaluated if tracing is on
+#define TRACE_START \
+    int64_t _dp_trace_start_ = Tracer::IsEnabled() ? Tracer::Now() : 0;
+
+#define TRACE_END(category, name, arg) \
+    if (_dp_trace_start_ != 0) { \
+        Tracer::Span((category), (name), _dp_trace_start_, Tracer::Now(), (arg)); \
+    }
+
+#endif // _TRACER_H_
@@ -0,0 +1,261 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#include "Tracer.h"
+#include "Errors.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <ctime>
+
+#include <unistd.h>
+#include <sys/syscall.h>
+
+using namespace std;
+
+bool Tracer :: enabled = false;
+string Tracer :: directory;
+
+namespace {
+
+    struct TraceEvent {
+        int64_t start;
+        int64_t end;
+        int64_t arg;
+
+        // 0 for the spans of the thread, unique otherwise
+        int64_t asyncID;
+
+        // the queries it was done for, empty if none in particular
+        QueryIDSet queries;
+
+        const char* category;
+        char name[TRACE_NAME_LENGTH];
+    };
+
+    // The events of one thread. Only the thread writes in it, the lock is
+    // only contended while a dump copies the events
+    struct TraceBuffer {
+        mutex lock;
+        pid_t tid;
+
+        // category of the first event, names the thread
+        const char* category;
+
+        // number of events recorded so far, the last one is at
+        // (recorded - 1) % TRACE_BUFFER_EVENTS
+        uint64_t recorded;
+
+        vector<TraceEvent> events;
+    };
+
+    // all the buffers ever created. The threads live as long as the
+    // process so the buffers are never freed
+    mutex buffersLock;
+    vector<TraceBuffer*> buffers;
+
+    atomic<int64_t> nextAsyncID(1);
+
+    thread_local TraceBuffer* myBuffer = nullptr;
+
+    // the queries the calling thread works for (see TraceQueriesScope)
+    thread_local QueryIDSet myQueries;
+
+    TraceBuffer* GetBuffer(const char* category) {
+        if (myBuffer == nullptr) {
+            TraceBuffer* buffer = new TraceBuffer;
+            buffer->tid = syscall(SYS_gettid);
+            buffer->category = category;
+            buffer->recorded = 0;
+            buffer->events.resize(TRACE_BUFFER_EVENTS);
+
+            lock_guard<mutex> guard(buffersLock);
+            buffers.push_back(buffer);
+            myBuffer = buffer;
+        }
+
+        return myBuffer;
+    }
+
+    void Record(const char* category, const char* name, int64_t start, int64_t end,
+            int64_t arg, int64_t asyncID, const QueryIDSet& queries) {
+        TraceBuffer* buffer = GetBuffer(category);
+
+        lock_guard<mutex> guard(buffer->lock);
+        TraceEvent& event = buffer->events[buffer->recorded % TRACE_BUFFER_EVENTS];
+        event.start = start;
+        event.end = end;
+        event.arg = arg;
+        event.asyncID = asyncID;
+        event.queries = queries;
+        event.category = category;
+        strncpy(event.name, name, TRACE_NAME_LENGTH - 1);
+        event.name[TRACE_NAME_LENGTH - 1] = '\0';
+
+        buffer->recorded++;
+    }
+
+    // the names come from the queries, keep the JSON valid
+    void WriteString(FILE* out, const char* str) {
+        fputc('"', out);
+        for (; *str != '\0'; str++) {
+            if (*str == '"' || *str == '\\')
+                fputc('\\', out);
+            fputc((unsigned char) *str < ' ' ? ' ' : *str, out);
+        }
+        fputc('"', out);
+    }
+
+    // the query names become file names, keep only the safe characters
+    string FileNameOf(const string& name) {
+        string fileName = name;
+        for (char& c : fileName) {
+            if (!isalnum((unsigned char) c) && c != '-' && c != '_')
+                c = '_';
+        }
+        return fileName;
+    }
+
+    void WriteEvent(FILE* out, bool& first, char phase, const TraceEvent& event,
+            int64_t ts, int pid, pid_t tid) {
+        fprintf(out, "%s\n{\"ph\":\"%c\",\"cat\":", first ? "" : ",", phase);
+        WriteString(out, event.category);
+        fprintf(out, ",\"name\":");
+        WriteString(out, event.name);
+        fprintf(out, ",\"ts\":%" PRId64 ",\"pid\":%d,\"tid\":%d", ts, pid, (int) tid);
+
+        if (phase == 'X')
+            fprintf(out, ",\"dur\":%" PRId64, event.end - event.start);
+        else
+            fprintf(out, ",\"id\":%" PRId64, event.asyncID);
+
+        if (phase != 'e')
+            fprintf(out, ",\"args\":{\"arg\":%" PRId64 "}", event.arg);
+
+        fprintf(out, "}");
+        first = false;
+    }
+}
+
+void Tracer :: Enable(const char* _directory) {
+    directory = _directory;
+    enabled = true;
+}
+
+int64_t Tracer :: Now(void) {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec * 1000000LL) + (now.tv_nsec / 1000LL);
+}
+
+void Tracer :: Span(const char* category, const char* name, int64_t start, int64_t end, int64_t arg) {
+    if (!enabled)
+        return;
+
+    Record(category, name, start, end, arg, 0, myQueries);
+}
+
+void Tracer :: AsyncSpan(const char* category, const char* name, int64_t start, int64_t end, int64_t arg) {
+    if (!enabled)
+        return;
+
+    Record(category, name, start, end, arg, nextAsyncID.fetch_add(1), myQueries);
+}
+
+void Tracer :: AsyncSpan(const char* category, const char* name, int64_t start, int64_t end, int64_t arg,
+        const QueryIDSet& queries) {
+    if (!enabled)
+        return;
+
+    Record(category, name, start, end, arg, nextAsyncID.fetch_add(1), queries);
+}
+
+void Tracer :: SetQueries(const QueryIDSet& queries) {
+    myQueries = queries;
+}
+
+QueryIDSet Tracer :: GetQueries(void) {
+    return myQueries;
+}
+
+bool Tracer :: Dump(const char* fileName, int64_t from, int64_t to, const QueryIDSet& queries) {
+    FILE* out = fopen(fileName, "w");
+    if (out == NULL) {
+        WARNING("Could not write the trace %s", fileName);
+        return false;
+    }
+
+    int pid = getpid();
+    bool first = true;
+    fprintf(out, "{\"traceEvents\":[");
+
+    // copy the buffers of the threads so they are not stopped while writing
+    vector<TraceBuffer*> allBuffers;
+    {
+        lock_guard<mutex> guard(buffersLock);
+        allBuffers = buffers;
+    }
+
+    vector<TraceEvent> events;
+    for (TraceBuffer* buffer : allBuffers) {
+        events.clear();
+        {
+            lock_guard<mutex> guard(buffer->lock);
+            uint64_t num = buffer->recorded < TRACE_BUFFER_EVENTS ? buffer->recorded : TRACE_BUFFER_EVENTS;
+            for (uint64_t i = buffer->recorded - num; i < buffer->recorded; i++) {
+                const TraceEvent& event = buffer->events[i % TRACE_BUFFER_EVENTS];
+                if (event.end < from || event.start > to)
+                    continue;
+                if (!queries.IsEmpty() && !event.queries.Overlaps(queries))
+                    continue;
+                events.push_back(event);
+            }
+        }
+
+        if (events.empty())
+            continue;
+
+        fprintf(out, "%s\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+                first ? "" : ",", pid, (int) buffer->tid);
+        char threadName[64];
+        snprintf(threadName, sizeof(threadName), "%s %d", buffer->category, (int) buffer->tid);
+        WriteString(out, threadName);
+        fprintf(out, "}}");
+        first = false;
+
+        for (const TraceEvent& event : events) {
+            if (event.asyncID == 0) {
+                WriteEvent(out, first, 'X', event, event.start, pid, buffer->tid);
+            } else {
+                WriteEvent(out, first, 'b', event, event.start, pid, buffer->tid);
+                WriteEvent(out, first, 'e', event, event.end, pid, buffer->tid);
+            }
+        }
+    }
+
+    fprintf(out, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(out);
+
+    return true;
+}
+
+bool Tracer :: DumpQuery(const string& queryName, QueryID query, int64_t from, int64_t to) {
+    string fileName = directory + "/trace_" + FileNameOf(queryName) + ".json";
+    return Dump(fileName.c_str(), from, to, query);
+}
@@ -72,6 +72,20 @@ public:
     bool GetQueryName(QueryID query, std::string& fillMe);
 
     bool GetQueryShortName(QueryID query, std::string &fillMe);
+
+    // Memory budgets (see MemoryAccounting.h)
+
+    // the owner the memory allocated for the queries is charged to: the
+    // bit of the first query, MemoryAccounting::NO_OWNER for no query
+    static int MemoryOwner(const QueryIDSet& queries);
+
+    // false while the queries use more than the global budget; new queries
+    // wait until some finish
+    bool CanAdmitQueries(void);
+
+    // true if the global budget or the budget of one of the queries is
+    // exceeded, the producers of data for them should slow down
+    bool ShouldThrottle(const QueryIDSet& queries);
 };
 
 #endif
@@ -17,6 +17,7 @@
 #include "Logging.h"
 #include "Errors.h"
 #include "Bitstring.h"
+#include "MemoryAccounting.h"
 
 #include <iostream>
 #include <string>
@@ -115,6 +116,13 @@ bool QueryManager :: AddNewQuery(string queryName, QueryID& returnMe) {
         FATALIF(mapping == -1,"QueryManager: No more empty slot left. \
                 The number of queries running reaches the upper bound.");
 
+        // the bit may have belonged to a finished query, whose memory is
+        // not the new query's. Its blocks still out only leave the total
+        int64_t leftBytes = MemoryAccounting::ResetOwner(mapping);
+        if (leftBytes != 0)
+            LOG_ENTRY_P(2, "Query %s reuses bit %d, %" PRId64 " bytes of the previous query still out",
+                    queryName.c_str(), mapping, leftBytes);
+
         //get new QueryID
         returnMe.Empty(); // to make sure nothing is left
         returnMe.AddMember(mapping);
@@ -339,3 +347,30 @@ int QueryManager :: QueryBitIndex(QueryID queryMe) {
 // 		PrintBinary();
 // 	}
 // }
+
+////////////////////////////////////////////////////////////////////////////////
+int QueryManager :: MemoryOwner(const QueryIDSet& queries) {
+    for (int i = 0; i < QueryIDSet::MaxSize(); i++)
+        if (queries.IsMember(i))
+            return i;
+
+    return MemoryAccounting::NO_OWNER;
+}
+
+bool QueryManager :: CanAdmitQueries(void) {
+    return !MemoryAccounting::GlobalOverBudget();
+}
+
+bool QueryManager :: ShouldThrottle(const QueryIDSet& queries) {
+    if (MemoryAccounting::GlobalOverBudget())
+        return true;
+
+    if (MemoryAccounting::QueryBudget() == 0)
+        return false;
+
+    for (int i = 0; i < QueryIDSet::MaxSize(); i++)
+        if (queries.IsMember(i) && MemoryAccounting::OwnerOverBudget(i))
+            return true;
+
+    return false;
+}
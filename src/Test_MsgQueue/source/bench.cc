@@ -0,0 +1,186 @@
+// Copyright 2013 Tera Insights, LLC. All Rights Reserved.
+
+// Microbenchmark for MultiMessageQueue. A number of writers push messages
+// of a few types into one queue and a single reader takes them out, as the
+// event processors do. The same run is done against LockedMessageQueue, the
+// mutex/condition variable queue MultiMessageQueue used to be, so the two
+// can be compared on the same machine.
+//
+// Usage: bench [writers] [messages per writer] [types]
+//
+// The reader checks that the messages of the same type from the same writer
+// come out in order.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <list>
+#include <map>
+#include <vector>
+
+#include "Message.h"
+#include "MultiMessageQueue.h"
+#include "Errors.h"
+
+using namespace std;
+
+// first type used by the benchmark, far from the types of the system
+#define BENCH_FIRST_TYPE 1000000
+
+class BenchMessage : public Message {
+    public:
+        off_t type;
+        int writer;
+        int seq;
+
+        BenchMessage(off_t _type, int _writer, int _seq) :
+            type(_type), writer(_writer), seq(_seq) {}
+
+        virtual off_t Type(void) const { return type; }
+        virtual const char* TypeName(void) const { return "BenchMessage"; }
+};
+
+// The queue before the lock-free inbox: every insert and remove takes the
+// mutex and the remove scans all the types for the highest priority
+class LockedMessageQueue {
+    private:
+        struct TypeBookkeeping {
+            int priority;
+            list<Message*> queue;
+        };
+
+        map<off_t, TypeBookkeeping> typeMap;
+        int numMessages;
+
+        pthread_mutex_t mutex;
+        pthread_cond_t condVar;
+
+    public:
+        LockedMessageQueue() : numMessages(0) {
+            pthread_mutex_init(&mutex, NULL);
+            pthread_cond_init(&condVar, NULL);
+        }
+
+        ~LockedMessageQueue() {
+            pthread_mutex_destroy(&mutex);
+            pthread_cond_destroy(&condVar);
+        }
+
+        void AddMessageType(off_t type, int priority) {
+            pthread_mutex_lock(&mutex);
+            typeMap[type].priority = priority;
+            pthread_mutex_unlock(&mutex);
+        }
+
+        void InsertMessage(Message& msg) {
+            pthread_mutex_lock(&mutex);
+            typeMap[msg.Type()].queue.push_back(&msg);
+            numMessages++;
+            pthread_cond_signal(&condVar);
+            pthread_mutex_unlock(&mutex);
+        }
+
+        Message& RemoveMessage() {
+            pthread_mutex_lock(&mutex);
+            while (numMessages == 0)
+                pthread_cond_wait(&condVar, &mutex);
+
+            TypeBookkeeping* best = NULL;
+            for (map<off_t, TypeBookkeeping>::iterator itr = typeMap.begin();
+                    itr != typeMap.end(); itr++){
+                TypeBookkeeping& bk = itr->second;
+                if (!bk.queue.empty() && (best == NULL || bk.priority < best->priority))
+                    best = &bk;
+            }
+
+            Message* msg = best->queue.front();
+            best->queue.pop_front();
+            numMessages--;
+            pthread_mutex_unlock(&mutex);
+
+            return *msg;
+        }
+};
+
+struct WriterArgs {
+    void* queue;
+    int writer;
+    int numMessages;
+    int numTypes;
+};
+
+template <class Queue>
+static void* Writer(void* aux) {
+    WriterArgs* args = (WriterArgs*) aux;
+    Queue& queue = *(Queue*) args->queue;
+
+    for (int i = 0; i < args->numMessages; i++){
+        off_t type = BENCH_FIRST_TYPE + i % args->numTypes;
+        queue.InsertMessage(*new BenchMessage(type, args->writer, i));
+    }
+
+    return NULL;
+}
+
+static double Now(void) {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+template <class Queue>
+static void Run(const char* name, int numWriters, int numMessages, int numTypes) {
+    Queue queue;
+    for (int t = 0; t < numTypes; t++)
+        queue.AddMessageType(BENCH_FIRST_TYPE + t, t);
+
+    vector<pthread_t> threads(numWriters);
+    vector<WriterArgs> args(numWriters);
+    // last sequence number seen for each writer and type
+    vector<int> last(numWriters * numTypes, -1);
+
+    double start = Now();
+
+    for (int w = 0; w < numWriters; w++){
+        args[w].queue = &queue;
+        args[w].writer = w;
+        args[w].numMessages = numMessages;
+        args[w].numTypes = numTypes;
+        pthread_create(&threads[w], NULL, Writer<Queue>, &args[w]);
+    }
+
+    long total = (long) numWriters * numMessages;
+    for (long i = 0; i < total; i++){
+        BenchMessage& msg = (BenchMessage&) queue.RemoveMessage();
+
+        int& prev = last[msg.writer * numTypes + (msg.type - BENCH_FIRST_TYPE)];
+        FATALIF(msg.seq <= prev, "%s: message %d of writer %d out of order",
+                name, msg.seq, msg.writer);
+        prev = msg.seq;
+
+        delete &msg;
+    }
+
+    double elapsed = Now() - start;
+
+    for (int w = 0; w < numWriters; w++)
+        pthread_join(threads[w], NULL);
+
+    printf("%-20s %d writers %8.3f s %12.0f messages/s\n",
+            name, numWriters, elapsed, total / elapsed);
+}
+
+int main(int argc, char** argv) {
+    int numWriters = argc > 1 ? atoi(argv[1]) : 4;
+    int numMessages = argc > 2 ? atoi(argv[2]) : 1000000;
+    int numTypes = argc > 3 ? atoi(argv[3]) : 4;
+
+    FATALIF(numWriters < 1 || numMessages < 1 || numTypes < 1,
+            "Usage: %s [writers] [messages per writer] [types]", argv[0]);
+
+    Run<LockedMessageQueue>("LockedMessageQueue", numWriters, numMessages, numTypes);
+    Run<MultiMessageQueue>("MultiMessageQueue", numWriters, numMessages, numTypes);
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+#!/bin/bash
+
+# Copyright 2013 Tera Insights, LLC. All Rights Reserved.
+
+# This script compiles the generated files of one waypoint into a shared
+# object, going through the cache of compiled modules.
+#
+# Usage: compileModule.sh module.so file1.cc [file2.cc ...]
+#
+# The compiler and the flags come from the environment (exported by the
+# generated Makefile): CXX, CXXFLAGS, CXXOPTS, CXXINCLUDE, CXXLINKFLAGS,
+# CXXLIBS. The cache lives in GROKIT_CODE_CACHE. Modules unused for
+# GROKIT_CODE_CACHE_DAYS days (30 by default) are evicted.
+#
+# The cache is content addressed: the key is the hash of everything that
+# can change the object code, i.e. the compiler version, the flags, the
+# preprocessed sources (so changes in the headers of the libraries are
+# caught) and the libraries we link against. On a hit nothing is compiled.
+# In both cases module.so ends up being a link to the cached object.
+
+OUT=$1
+shift
+SOURCES="$@"
+
+CACHE=${GROKIT_CODE_CACHE:-../CodeCache}
+[ -e $CACHE ] || mkdir -p $CACHE
+CACHE=$(readlink -f $CACHE)
+
+TMP_DIR=$(mktemp -d ./${OUT}.XXXXXX)
+trap "rm -rf $TMP_DIR" EXIT
+
+# preprocess all the sources, if this fails the compilation will fail as well
+for src in $SOURCES; do
+    $CXX $CXXFLAGS $CXXOPTS $CXXINCLUDE -E -P $src -o $TMP_DIR/$src.ii &
+done
+
+failed=0
+for job in $(jobs -p); do
+    wait $job || failed=1
+done
+
+if [ $failed == 0 ]; then
+    KEY=$( {
+        $CXX --version
+        echo "$CXXFLAGS $CXXOPTS $CXXLINKFLAGS $CXXLIBS"
+        for lib in $CXXLIBS; do
+            libFile=$($CXX -print-file-name=lib${lib#-l}.so)
+            [ -e "$libFile" ] && stat -L -c '%n %s %Y' "$libFile"
+        done
+        for src in $SOURCES; do
+            cat $TMP_DIR/$src.ii
+        done
+    } | sha1sum | cut -d ' ' -f 1 )
+
+    CACHED=$CACHE/$KEY.so
+
+    if [ -e $CACHED ]; then
+        echo "Using cached module for $OUT"
+        # keep the access time fresh so old modules can be cleaned up
+        touch $CACHED
+        ln -sf $CACHED $OUT
+        exit 0
+    fi
+fi
+
+echo "Compiling module $OUT"
+
+# compile the sources of the module in parallel
+for src in $SOURCES; do
+    $CXX $CXXFLAGS $CXXOPTS $CXXINCLUDE -c $src -o $TMP_DIR/${src%.cc}.o &
+done
+
+for job in $(jobs -p); do
+    wait $job || exit 1
+done
+
+$CXX -rdynamic -shared -o $TMP_DIR/module.so $CXXFLAGS $CXXOPTS $TMP_DIR/*.o $CXXLINKFLAGS $CXXLIBS || exit 1
+
+if [ $failed != 0 ]; then
+    # no key, we cannot cache this one
+    mv -f $TMP_DIR/module.so $OUT
+    exit 0
+fi
+
+# rename is atomic so concurrent compilations of the same module are fine
+cp $TMP_DIR/module.so $CACHED.$$
+mv -f $CACHED.$$ $CACHED
+ln -sf $CACHED $OUT
+
+# evict the modules that were not used for a while. The hits touch the
+# modules, so only the ones no recent query needed go away. Modules already
+# loaded by a running datapath are not affected by the removal
+find $CACHE -maxdepth 1 -name '*.so' -mtime +${GROKIT_CODE_CACHE_DAYS:-30} -delete
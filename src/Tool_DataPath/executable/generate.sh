@@ -21,6 +21,7 @@ numParallelJobs=32
 
 dirPath=$1
 errFile=$(readlink -f ./grokit_error.json)
+moduleCompile=$(readlink -f ./compileModule.sh)
 
 cd $dirPath
 
@@ -29,8 +30,10 @@ echo "Compiling the code"
 # just in case the compiler is the intel compiler
 # source /opt/intel/Compiler/11.1/056/bin/iccvars.sh intel64
 
-[ -e Generated.so ] && rm Generated.so
-make -k -j ${numParallelJobs} Generated.so
+# every waypoint is compiled in its own module, unchanged waypoints come
+# from the cache of compiled modules
+[ -e Modules ] && rm Modules
+make -k -j ${numParallelJobs} MODULE_COMPILE=${moduleCompile} Modules
 
 if [ $? != 0 ]; then
     errText=$(cat <<EOT
@@ -35,8 +35,9 @@ numParallelJobs=32
 [ -e $GEN_DIR ] || mkdir $GEN_DIR
 cd $GEN_DIR
 
-# Remove the old Generated.so
+# Remove the old Generated.so and modules
 [ -e ./Generated.so ] && rm ./Generated.so
+[ -e ./Modules ] && rm ./Modules
 
 php --define include_path=$PHP_INC $SCRIPT $JSON $CONFIG_FILE
 if [ $? != 0 ]; then
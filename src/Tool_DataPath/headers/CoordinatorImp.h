@@ -25,6 +25,9 @@
 #include "TransMessages.h"
 #include "Tasks.h"
 
+#include <map>
+#include <list>
+
 
 /** This coordinator is designed to go together with the Translato
 
@@ -55,6 +58,25 @@ class CoordinatorImp : public EventProcessorImp {
 
         TaskList newTasks;
 
+        // the queries of the current graph
+        QueryIDSet cachedQueries;
+
+        // A plan whose code is loaded, waiting for memory to run
+        struct PendingPlan {
+            DataPathGraph graph;
+            WayPointConfigurationList configs;
+            TaskList tasks;
+            QueryIDSet queries;
+        };
+
+        // the plans are admitted in the order they arrive. A plan is held
+        // back while the running queries use more than the global memory
+        // budget, and admitted when some queries finish
+        std::list<PendingPlan> pendingPlans;
+
+        // queries sent to the execution engine and not finished yet
+        QueryIDSet runningQueries;
+
         char lastDir[1000];
 
         // timing facility
@@ -65,6 +87,10 @@ class CoordinatorImp : public EventProcessorImp {
         typedef Swapify<double> SW_double;
         EfficientMap<QueryID, SW_double > startTimes;
 
+        // when each running query started, in Tracer time. Only used when
+        // tracing, the trace of a query covers its whole run
+        std::map<QueryID, int64_t> traceStarts;
+
         bool compileOnly;
 
         // Whether or not to quit immediately after query completion
@@ -73,6 +99,9 @@ class CoordinatorImp : public EventProcessorImp {
         // Private methods
         void Quit();
 
+        // sends the pending plans to the execution engine while memory allows
+        void AdmitPlans();
+
     public:
         // constructor
         // metadataFile is the file containing metadata about the relation being read
@@ -27,6 +27,10 @@
 #include "MmapAllocator.h"
 #include "MMappedStorage.h"
 #include "NumaMemoryAllocator.h"
+#include "QueryManager.h"
+#include "Tracer.h"
+#include "QueryExit.h"
+#include "MemoryAccounting.h"
 
 #include <sys/stat.h>
 #include <sys/time.h>
@@ -83,16 +87,46 @@ void CoordinatorImp :: Quit() {
     Seppuku();
 }
 
+void CoordinatorImp :: AdmitPlans() {
+    QueryManager& qm = QueryManager::GetQueryManager();
+
+    while (!pendingPlans.empty() && (runningQueries.IsEmpty() || qm.CanAdmitQueries())) {
+        PendingPlan& plan = pendingPlans.front();
+
+        ConfigureExecEngineMessage_Factory (execEngine, plan.graph,
+                plan.configs, plan.tasks);
+        runningQueries.Union(plan.queries);
+
+        pendingPlans.pop_front();
+    }
+
+    if (!pendingPlans.empty()) {
+        cout << pendingPlans.size() << " plans wait for memory, "
+            << MemoryAccounting::OwnedBytes() << " bytes used by the queries, budget "
+            << MemoryAccounting::GlobalBudget() << endl;
+    }
+}
+
 MESSAGE_HANDLER_DEFINITION_BEGIN(CoordinatorImp, SymbolicQueriesProc,
         SymbolicQueryDescriptions){
 
+    // the queries start running now as far as their traces are concerned
+    if (Tracer::IsEnabled()) {
+        int64_t now = Tracer::Now();
+        FOREACH_TWL(qe, msg.newQueries){
+            if (evProc.traceStarts.find(qe.query) == evProc.traceStarts.end())
+                evProc.traceStarts[qe.query] = now;
+        }END_FOREACH
+    }
+
     // take over the graph
     evProc.cachedGraph.swap(msg.newGraph);
+    evProc.cachedQueries = QueryExitsToQueries(msg.newQueries);
 
     evProc.newTasks.SuckUp(msg.tasks);
 
-    string lastDir(evProc.lastDir);
-    LoadNewCodeMessage_Factory(evProc.codeLoader, lastDir, msg.wpDesc);
+    // the code is loaded from where the translator generated it
+    LoadNewCodeMessage_Factory(evProc.codeLoader, msg.codeDir, msg.wpDesc);
 
 }MESSAGE_HANDLER_DEFINITION_END
 
@@ -104,8 +138,15 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(CoordinatorImp, CodeProc, LoadedCodeMessage){
     } else {
         // allright. we got the code, we have the graph from the previous message
         // so we are ready to tell the execution engine about the new battle plan
-        ConfigureExecEngineMessage_Factory (evProc.execEngine, evProc.cachedGraph,
-                msg.configs, evProc.newTasks);
+        // as soon as there is memory for it
+        evProc.pendingPlans.emplace_back();
+        PendingPlan& plan = evProc.pendingPlans.back();
+        plan.graph.swap(evProc.cachedGraph);
+        plan.configs.swap(msg.configs);
+        plan.tasks.swap(evProc.newTasks);
+        plan.queries = evProc.cachedQueries;
+
+        evProc.AdmitPlans();
 
         // NOTE: the file scanners were configured by the Translator
     }
@@ -152,7 +193,27 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(CoordinatorImp, QueryFinishedProc, QueriesDoneM
         msg.completedQueries.Advance ();
     }
 
-    if( CoordinatorImp :: quitWhenDone ) {
+    // dump the timeline of the queries that finished
+    if (Tracer::IsEnabled()) {
+        int64_t now = Tracer::Now();
+        FOREACH_TWL(qe, msg.completedQueries){
+            auto it = evProc.traceStarts.find(qe.query);
+            if (it == evProc.traceStarts.end())
+                continue;
+
+            string queryName;
+            if (QueryManager::GetQueryManager().GetQueryName(qe.query, queryName)) {
+                Tracer::DumpQuery(queryName, qe.query, it->second, now);
+            }
+            evProc.traceStarts.erase(it);
+        }END_FOREACH
+    }
+
+    // the memory of the finished queries is free, let the waiting plans in
+    evProc.runningQueries.Difference(QueryExitsToQueries(msg.completedQueries));
+    evProc.AdmitPlans();
+
+    if( CoordinatorImp :: quitWhenDone && evProc.pendingPlans.empty() ) {
         sleep(2);
         exit(EXIT_SUCCESS);
     }
@@ -54,10 +54,13 @@ bool GlobalSettings::batchMode = false;
 #include "Profiler.h"
 #include "PCProfiler.h"
 #include "PerfTopProfiler.h"
+#include "Tracer.h"
+#include "MemoryAccounting.h"
 #include "ExternalCommands.h"
 #include "CommunicationFramework.h"
 
 #include "Catalog.h"
+#include "HashTable.h"
 
 #define DEBUG
 
@@ -93,6 +96,10 @@ int main(int argc, char** argv){
         cout << "\t-d\t run as deamon, listen on the EXECUTE pipe for commands" << endl;
         cout << "\t-e program\t execute program then exit" << endl;
         cout << "\t-r\t run in read-only mode, no changes to data on disk" << endl;
+        cout << "\t-H bits\t use 2^bits slots per hash table segment instead of sizing them from memory" << endl;
+        cout << "\t-T dir\t trace the execution, the timeline of each query goes in dir/trace_<query>.json" << endl;
+        cout << "\t-m MB\t memory budget of each query, its table scans slow down above it" << endl;
+        cout << "\t-M MB\t memory budget of all the queries together, new queries wait above it (memory of no query, like the hash segments, does not count)" << endl;
 
         return 1;
     }
@@ -121,17 +128,21 @@ int main(int argc, char** argv){
     }
 
     int c;
-    while ((c = getopt (argc, argv, "bde:rqost")) != -1){
+    while ((c = getopt (argc, argv, "bde:H:m:M:rqostT:")) != -1){
         switch(c){
             case 'b': GlobalSettings::batchMode = true; break;
             case 'd': isDaemon=true; break;
             case 'e': progToRun=optarg; break;
+            case 'H': HashTable::SetSlotBits(atoi(optarg)); break;
+            case 'm': MemoryAccounting::SetBudgets(atoll(optarg) << 20, MemoryAccounting::GlobalBudget()); break;
+            case 'M': MemoryAccounting::SetBudgets(MemoryAccounting::QueryBudget(), atoll(optarg) << 20); break;
             case 'r': rdOnly=true; break;
             case 'q': quitWhenDone=true; break;
             case 's': suppressOutput = true; break;
             case 't': compileOnly = true; break;
+            case 'T': Tracer::Enable(optarg); break;
             case '?':
-                      if (optopt == 'e')
+                      if (optopt == 'e' || optopt == 'H' || optopt == 'm' || optopt == 'M' || optopt == 'T')
                           fprintf (stderr, "Option -%c requires an argument.\n", optopt);
                       else if (isprint (optopt))
                           fprintf (stderr, "Unknown option `-%c'.\n", optopt);
@@ -258,11 +258,16 @@ grokit\create_data_type(
             queryColumnsMap: the mapping from query-exitWP to slots they need
             columnsToSlotsMap: the mapping from physical columns to slots
             storeColumnsToSlotsMap: the mapping from physical columns to slots for writing
+            filterRanges: ranges of the cluster attribute needed by each query
+            columnRanges: per query, the range each physical column has to intersect
+              for a chunk to be of any use to the query (pushed down from selections)
 */
 
 typedef std::pair<int64_t, int64_t> ScannerRange;
 typedef std::vector<ScannerRange> ScannerRangeList;
 typedef std::map<QueryID, ScannerRangeList> QueryToScannerRangeList;
+typedef std::map<int64_t, ScannerRange> ColumnToScannerRange;
+typedef std::map<QueryID, ColumnToScannerRange> QueryToColumnRanges;
 
 <?php
 grokit\create_data_type(
@@ -275,7 +280,8 @@ grokit\create_data_type(
         'columnsToSlotsMap' => 'SlotToSlotMap',
         'storeColumnsToSlotsMap' => 'SlotToSlotMap',
         'clusterAttribute' => 'SlotID',
-        'filterRanges' => 'QueryToScannerRangeList',]
+        'filterRanges' => 'QueryToScannerRangeList',
+        'columnRanges' => 'QueryToColumnRanges',]
     , true
 );
 ?>
@@ -9,8 +9,29 @@ function CleanerGenerate($wpName, $LHS, $RHS, $queries, $queryNames) {
     $rhs = $RHS;
     //$lhs = array_map('lookupAttribute', $LHS);
     //$rhs = array_map('lookupAttribute', $RHS);
+
+    // puts the value of a RHS attribute found at $ptr in the chunk going to disk
+    $sendRHS = function($att, $ptr, $indent) {
+        $ind = str_repeat(' ', $indent);
+?>
+<?=$ind?>// first, make sure that we are far enough along
+<?=$ind?>for (; <?=$att?>_Column_RHSIsUsed[index] < bitmapColumnRHSIsUsed[index] - 1; <?=$att?>_Column_RHSIsUsed[index]++) {
+<?=$ind?>    <?=$att->type()?> col; // TBD, some default value
+<?=$ind?>    <?=$att?>_ColumnIter_RHS[index].Insert (col);
+<?=$ind?>    <?=$att?>_ColumnIter_RHS[index].Advance ();
+<?=$ind?>}
+
+<?=$ind?>// Now put the data in
+<?=$ind?><?=$att->type()?> *<?=$att?>_ColumnPtr = ((<?=$att->type()?>*) <?=$ptr?>);
+<?=$ind?><?=$att?>_ColumnIter_RHS[index].Insert(*<?=$att?>_ColumnPtr);
+<?=$ind?><?=$att?>_ColumnIter_RHS[index].Advance();
+<?=$ind?><?=$att?>_Column_RHSIsUsed[index]++;
+<?
+    };
 ?>
 
+#include "PackedTupleLayout.h"
+
 // used to construct a lookup table to see what we need to do with each hash entry
 struct WayPointInformation {
     int isDying;
@@ -25,6 +46,7 @@ struct WayPointInformation {
 #define ZEROING_OUT_STEP_SIZE 2048
 
 #include <vector>
+#include <cstring>
 
 #include "ColumnIterator.h"
 #include "MMappedStorage.h"
@@ -37,6 +59,10 @@ int CleanerWorkFunc_<?=$wpName?>( WorkDescription & workDescription, ExecEngineD
     // 10K bytes are initially used for this
     void *serializeHere = (void *) malloc (10000);
 
+    // layout of the last packed RHS tuple that was sent to disk
+    PackedTupleLayout::LayoutID lastLayoutID = PackedTupleLayout::NO_LAYOUT;
+    const PackedTupleLayout *lastLayout = nullptr;
+
     // get the work description
     HashCleanerWorkDescription myWork;
     myWork.swap (workDescription);
@@ -230,7 +256,7 @@ int CleanerWorkFunc_<?=$wpName?>( WorkDescription & workDescription, ExecEngineD
             if (curSlot + ZEROING_OUT_STEP_SIZE > upperBound)  {
                 HT_INDEX_TYPE newUpperBound = curSlot + ZEROING_OUT_STEP_SIZE;
                 if (newUpperBound >= NUM_SLOTS_IN_SEGMENT)
-                    newUpperBound = ABSOLUTE_HARD_CAP;
+                    newUpperBound = newSegment.Capacity ();
                 newSegment.ZeroOut (upperBound, newUpperBound);
                 upperBound = newUpperBound;
             }
@@ -285,6 +311,36 @@ int CleanerWorkFunc_<?=$wpName?>( WorkDescription & workDescription, ExecEngineD
             }
 
             // if we finished the tuple, stop serializing
+            if (done)
+                goto end;
+
+            // the RHS tuples of some joins have all of their attributes packed in one
+            // piece right after the bitmap (see PackedTupleLayout.h)
+            lastLen = mySegment.Extract (serializeHere, curSlot, i, whichWayPoint, PACKED_TUPLE, dummy, done);
+            if (lastLen > 0 && state == DYING_AND_SEND && LHS) {
+                FATAL("Found packed attributes in a LHS tuple");
+            } else if (lastLen > 0 && state == DYING_AND_SEND && !LHS) {
+                // unpack the attributes into their columns, with the layout the tuple
+                // was written with
+                PackedTupleLayout::Header header;
+                memcpy (&header, serializeHere, sizeof (header));
+                if (header.layout != lastLayoutID) {
+                    lastLayoutID = header.layout;
+                    lastLayout = &PackedTupleLayout::Get (lastLayoutID);
+                }
+                int offset;
+<?  foreach( $rhs as $att ) { ?>
+
+                offset = lastLayout->Offset (<?=$att->slot()?>, header.present);
+                if (offset >= 0) {
+<?      $sendRHS($att, '((char *) serializeHere + offset)', 20); ?>
+                }
+<?  } // foreach RHS attribute ?>
+            } else if (lastLen > 0 && !bitstringPtr->IsEmpty () && state == ALIVE) {
+                // the packed tuple goes back into the hash table as it is
+                storage.Append (PACKED_TUPLE, serializeHere, lastLen);
+            }
+
             if (done)
                 goto end;
 
@@ -329,18 +385,7 @@ int CleanerWorkFunc_<?=$wpName?>( WorkDescription & workDescription, ExecEngineD
             if (lastLen > 0 && state == DYING_AND_SEND && LHS) {
                 FATAL("<?=$att?> is only used by the RHS, how did I find it in a LHS tuple?");
             } else if( lastLen > 0 && state == DYING_AND_SEND && !LHS ) {
-                // first, make sure that we are far enough along
-                for (; <?=$att?>_Column_RHSIsUsed[index] < bitmapColumnRHSIsUsed[index] - 1; <?=$att?>_Column_RHSIsUsed[index]++) {
-                    <?=$att->type()?> col; // TBD, some default value
-                    <?=$att?>_ColumnIter_RHS[index].Insert (col);
-                    <?=$att?>_ColumnIter_RHS[index].Advance ();
-                }
-
-                // Now put the data in
-                <?=$att->type()?> *<?=$att?>_ColumnPtr = ((<?=$att->type()?>*) serializeHere);
-                <?=$att?>_ColumnIter_RHS[index].Insert(*<?=$att?>_ColumnPtr);
-                <?=$att?>_ColumnIter_RHS[index].Advance();
-                <?=$att?>_Column_RHSIsUsed[index]++;
+<?      $sendRHS($att, 'serializeHere', 16); ?>
             } else if( lastLen > 0 && !bitstringPtr->IsEmpty() && state == ALIVE ) {
                 // in the last case, the data will go back into the hash table
                 storage.Append (columnID, serializeHere, lastLen);
@@ -386,7 +431,7 @@ end:        // AT THIS POINT, DONE WITH ALL OF THE COLUMNS!!
     }
 
     PROFILING(0.0, "Cleaner", "FindTuples", "%d", counter);
-    newSegment.ZeroOut (upperBound, ABSOLUTE_HARD_CAP);
+    newSegment.ZeroOut (upperBound, newSegment.Capacity ());
 
     // now we are at the final cleanup, where we build our output chunks... there could potentially be one
     // LHS chunk and one RHS chunk for each and every join waypoint
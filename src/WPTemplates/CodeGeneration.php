@@ -252,5 +252,27 @@ function cgExtractColumnFragment($att, $chunk, $start, $end, $wpName){ ?>
 <?
 }
 
+/****************************** Packed join tuples ****************************/
+
+// The hashed RHS attributes of a join are packed in a single attribute of the
+// hash table when they all have a fixed size (see PackedTupleLayout.h). This
+// gives them in slot order, which is the order they are packed in, or an empty
+// array if the tuples of the join are not packed.
+function joinPackedAttributes($jDesc) {
+    $atts = [];
+    foreach( $jDesc->hash_RHS_attr as $att ) {
+        if( !isFixedAtt($att) )
+            return [];
+        $atts[attSlot($att)] = $att;
+    }
+
+    // one bit per attribute in the header of the packed tuples
+    if( count($atts) > 32 )
+        return [];
+
+    ksort($atts);
+    return array_values($atts);
+}
+
 ?>
 
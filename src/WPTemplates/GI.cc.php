@@ -40,6 +40,18 @@ int GIProduceChunkWorkFunc_<?=$wpName?> ( WorkDescription &workDescription, Exec
     if( state_ptr.IsValid() ) {
         my_state = (<?=$type->value()?> *) state_ptr.get_glaPtr();
     } else {
+<?  if( !$type->is('splittable') ) { ?>
+        // This GI reads its stream to the end. The first range of a split
+        // file is extended to the whole file and the others are dropped.
+        if( !stream_info.at_file_start() ) {
+            ChunkContainer noChunk;
+            GIProduceChunkRez tempResult( stream_info, gi_state, noChunk );
+            result.swap(tempResult);
+            return 2;
+        }
+        stream_info.whole_file();
+
+<?  } // if GI not splittable ?>
         my_state = new <?=$type->value()?> ( <?=$constArgsStr?> );
         GLAPtr newPtr(<?=$type->cHash()?>, (void*) my_state);
         newPtr.swap(state_ptr);
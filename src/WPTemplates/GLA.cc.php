@@ -39,6 +39,7 @@ int GLAPreProcessWorkFunc_<?=$wpName?>
     QueryToGLASContMap & reqStates = myWork.get_requiredStates();
     QueryToGLAStateMap constStates;
     QueryIDSet produceIntermediates;
+    QueryIDSet partitionedMerge;
 
 <?
     cgDeclareQueryIDs($queries);
@@ -110,11 +111,14 @@ int GLAPreProcessWorkFunc_<?=$wpName?>
 <?      if( $gla->iterable() && $gla->intermediates() ) { ?>
             produceIntermediates.Union(<?=queryName($query)?>);
 <?  } // if GLA produces intermediate results ?>
+<?      if( $gla->partitioned_merge() ) { ?>
+            partitionedMerge.Union(<?=queryName($query)?>);
+<?      } // if GLA supports partitioned merge ?>
         } // If this query is query <?=queryName($query)?>.
 <?  } // foreach query ?>
     } END_FOREACH;
 
-    GLAPreProcessRez myRez( constStates, produceIntermediates );
+    GLAPreProcessRez myRez( constStates, produceIntermediates, partitionedMerge );
     myRez.swap(result);
 
     return WP_PREPROCESSING; // for PreProcess
@@ -135,6 +139,7 @@ int GLAMergeStatesWorkFunc_<?=$wpName?>
 
     QueryToGLASContMap& queryGLACont = myWork.get_glaStates();
     QueryExitContainer& queries = myWork.get_whichQueryExits();
+    QueryIDToInt& partitions = myWork.get_partitions();
 
 <?
     cgDeclareQueryIDs($queries);
@@ -146,6 +151,10 @@ int GLAMergeStatesWorkFunc_<?=$wpName?>
         GLAStateContainer& glaContainer = queryGLACont.Find(iter.query);
         GLAPtr mainState;
 
+        // partition to merge, only for the partitioned merge
+        bool isPartition = partitions.IsThere(iter.query);
+        int partition = isPartition ? partitions.Find(iter.query).GetData() : -1;
+
 <?
     foreach( $queries as $query => $info ) {
         $gla = $info['gla'];
@@ -159,6 +168,35 @@ int GLAMergeStatesWorkFunc_<?=$wpName?>
             FATALIF( mainState.get_glaType() != <?=$glaHashVal?>, "Got a GLA of a different type!");
             <?=$gla?> * mainGLA = (<?=$gla?> *) mainState.get_glaPtr();
 
+<?      if( $gla->partitioned_merge() ) { ?>
+            if( isPartition && partition >= 0 ) {
+                // Merge a single partition of all the states into the main
+                // one. The other jobs merge the other partitions of the
+                // same states at the same time so the states stay where
+                // they are.
+                FOREACH_TWL(g, glaContainer) {
+                    FATALIF( g.get_glaType() != <?=$glaHashVal?>, "Got a GLA of a different type!");
+                    GLAPtr localState;
+                    localState.copy(g);
+
+                    <?=$gla?> * localGLA = (<?=$gla?> *) localState.get_glaPtr();
+                    mainGLA->MergePartition(partition, GLA_MERGE_PARTITIONS, *localGLA);
+                } END_FOREACH
+            } else if( isPartition ) {
+                // All the partitions are merged, finish up the other states
+                FOREACH_TWL(g, glaContainer) {
+                    GLAPtr localState;
+                    localState.swap(g);
+                    FATALIF( localState.get_glaType() != <?=$glaHashVal?>, "Got a GLA of a different type!");
+
+                    <?=$gla?> * localGLA = (<?=$gla?> *) localState.get_glaPtr();
+                    mainGLA->FinishMerge(*localGLA);
+
+                    // localGLA eaten up. delete
+                    delete localGLA;
+                } END_FOREACH
+            } else {
+<?      } // if GLA supports partitioned merge ?>
             // scan remaining elements, convert and call AddState
             FOREACH_TWL(g, glaContainer) {
                 GLAPtr localState;
@@ -171,11 +209,17 @@ int GLAMergeStatesWorkFunc_<?=$wpName?>
                 // localGLA eaten up. delete
                 delete localGLA;
             } END_FOREACH
+<?      if( $gla->partitioned_merge() ) { ?>
+            } // if not a partitioned merge
+<?      } // if GLA supports partitioned merge ?>
         }
 <?
     } // foreach query
 ?>
-        resultQueryGLASt.Insert(iter.query, mainState);
+        // a partition job gives back nothing, the main state is still in
+        // the waypoint container
+        if( !isPartition || partition < 0 )
+            resultQueryGLASt.Insert(iter.query, mainState);
     } END_FOREACH;
 
     GLAStatesRez rez(resultQueryGLASt);
@@ -732,6 +776,41 @@ int GLAProcessChunkWorkFunc_<?=$wpName?>
 #ifdef PER_QUERY_PROFILE
     int64_t numTuples_<?=queryName($query)?> = 0;
 #endif // PER_QUERY_PROFILE
+<?
+    } // foreach query
+
+    // GLAs supporting batches get their inputs accumulated in contiguous
+    // arrays, only for the tuples selected for the query, and receive them
+    // GLA_BATCH_SIZE at a time through AddItems. This allows the GLA to run
+    // tight (vectorizable) loops over the values instead of a call per tuple.
+    // GLAs with batch 'count' only need the number of tuples: no buffers,
+    // AddItems(n) is called once per chunk.
+    $batchVars = [];
+    foreach( $queries as $query => $info ) {
+        $gla = $info['gla'];
+        if( ! $gla->batch() )
+            continue;
+
+        $input = $info['expressions'];
+        $glaInputs = array_values($gla->input());
+        $batchVars[$query] = [];
+?>
+    // Batch buffers for query <?=queryName($query)?>
+
+<?
+        if( $gla->batch() === 'count' )
+            $input = [];
+
+        foreach( array_values($input) as $index => $expr ) {
+            $bType = is_null($glaInputs[$index]) ? $expr->type() : $glaInputs[$index];
+            $bVar = 'batch_' . queryName($query) . '_' . $index;
+            $batchVars[$query][] = $bVar;
+?>
+    <?=$bType?> <?=$bVar?>[GLA_BATCH_SIZE];
+<?
+        } // foreach input expression
+?>
+    size_t batchSize_<?=queryName($query)?> = 0;
 <?
     } // foreach query
 ?>
@@ -759,7 +838,23 @@ int GLAProcessChunkWorkFunc_<?=$wpName?>
         // Declare preprocessing variables
         cgDeclarePreprocessing($input, 3);
 ?>
+<?      if( array_key_exists($query, $batchVars) && count($batchVars[$query]) == 0 ) { ?>
+            batchSize_<?=queryName($query)?>++;
+<?      } else if( array_key_exists($query, $batchVars) ) {
+            $bSize = 'batchSize_' . queryName($query);
+            foreach( array_values($input) as $index => $expr ) {
+?>
+            <?=$batchVars[$query][$index]?>[<?=$bSize?>] = <?=$expr?>;
+<?
+            } // foreach input expression
+?>
+            if( ++<?=$bSize?> == GLA_BATCH_SIZE ) {
+                <?=$glaVar?>->AddItems( <?=$bSize?>, <?=implode(', ', $batchVars[$query])?> );
+                <?=$bSize?> = 0;
+            }
+<?      } else { ?>
             <?=$glaVar?>->AddItem( <?=implode(', ', $input);?>);
+<?      } // if GLA does not support batches ?>
 
 #ifdef PER_QUERY_PROFILE
             numTuples_<?=queryName($query)?>++;
@@ -773,6 +868,16 @@ int GLAProcessChunkWorkFunc_<?=$wpName?>
     } // while not at end of input
 
 <?
+    // Hand the GLAs supporting batches whatever is left in the buffers
+    foreach( $batchVars as $query => $bVars ) {
+        $glaVar = $glaVars[$query];
+        $bSize = 'batchSize_' . queryName($query);
+?>
+    if( <?=$bSize?> > 0 )
+        <?=$glaVar?>->AddItems( <?=implode(', ', array_merge([$bSize], $bVars))?> );
+<?
+    } // foreach query with batches
+
     // Tell GLAs that wish to know about the chunk boundary.
     foreach( $queries as $query => $info ) {
         $gla = $info['gla'];
@@ -21,7 +21,14 @@ function JoinLHS($wpName, $jDesc) {
                                                     [lookupType('BASE::NULL')]);
 
     $jDesc->hash_RHS_attr = $rhsAttOrder;
+
+    // the RHS tuples may have their fixed size attributes packed, depending on
+    // the code that hashed them
+    $packedAtts = array_filter($jDesc->hash_RHS_attr, 'isFixedAtt');
 ?>
+#include "Timer.h"
+#include "PackedTupleLayout.h"
+#include <cstring>
 
 //+{"kind":"WPF", "name":"LHS Lookup", "action":"start"}
 extern "C"
@@ -95,10 +102,82 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
   <?=attType($att)?> <?=$att?>RHSobj;
 <?  } /*foreach*/ ?>
 
+  // where the attributes are in the packed RHS tuples (see PackedTupleLayout.h),
+  // for the layout and attributes of the last one seen
+  PackedTupleLayout::LayoutID packedLayoutID = PackedTupleLayout::NO_LAYOUT;
+  uint32_t packedPresent = 0;
+<?  foreach ($packedAtts as $att) { ?>
+  int <?=$att?>_PackedOffset = -1;
+<?  } /*foreach*/ ?>
+
+  // The probes are done in batches. Shallow copies of the bitstring and of
+  // the key columns run ahead of the main iterators; the hashes of the active
+  // tuples among the next JOIN_LHS_PROBE_BATCH are computed at once and their
+  // slots are prefetched so that the cache misses of the batch overlap
+  // instead of each probe waiting on its own.
+  BStringIterator myInBStringAhead;
+  myInBStringAhead.copy (myInBStringIter);
+<?  foreach ($jDesc->LHS_keys as $att) { ?>
+  <?=attIteratorType($att)?> <?=$att?>_Column_Ahead;
+  <?=$att?>_Column_Ahead.CreateShallowCopy (<?=$att?>_Column);
+<?  } /*foreach*/ ?>
+  HT_INDEX_TYPE probeHashes[JOIN_LHS_PROBE_BATCH] = { 0 };
+  int probePos = JOIN_LHS_PROBE_BATCH; // position of the current tuple in the batch
+
+  // The hashes that are not in the filter of the RHS hashes have no match.
+  // Their slots are not prefetched and the tuples do not probe at all.
+  // Inactive tuples are marked filtered, they are not probed either
+  JoinFilter &joinFilter = myWork.get_joinFilter ();
+  bool probeFiltered[JOIN_LHS_PROBE_BATCH];
+  int totalFiltered = 0;
+
   // now actually try to match up all of the tuples!
   int totalNum = 0;
+  Timer probeClock;
+  probeClock.Restart ();
   while (!myInBStringIter.AtEndOfColumn ()) { // TBD, probably this is not working TBD
 
+    // hash the next batch of keys and prefetch their slots. The ahead
+    // iterators move for every tuple to stay in step with the main ones
+    if (probePos == JOIN_LHS_PROBE_BATCH) {
+      int batchSize = 0;
+      for (; batchSize < JOIN_LHS_PROBE_BATCH && !myInBStringAhead.AtEndOfColumn (); batchSize++) {
+        QueryIDSet aheadBits = myInBStringAhead.GetCurrent ();
+        myInBStringAhead.Advance ();
+        probeFiltered[batchSize] = !aheadBits.Overlaps (queriesToRun);
+        if (probeFiltered[batchSize]) {
+<?  foreach ($jDesc->LHS_keys as $att) { ?>
+          <?=$att?>_Column_Ahead.Advance ();
+<?  } /*foreach*/ ?>
+          continue;
+        }
+
+        HT_INDEX_TYPE aheadHash = HASH_INIT;
+<?  foreach ($jDesc->LHS_keys as $att) { ?>
+        aheadHash = CongruentHash(Hash(<?=$att?>_Column_Ahead.GetCurrent()), aheadHash);
+        <?=$att?>_Column_Ahead.Advance ();
+<?  } /*foreach*/ ?>
+        probeHashes[batchSize] = aheadHash;
+        joinFilter.Prefetch (aheadHash);
+      }
+      for (int i = 0; i < batchSize; i++) {
+        if (probeFiltered[i])
+          continue;
+        probeFiltered[i] = !joinFilter.MayContain (probeHashes[i]);
+        if (!probeFiltered[i])
+          myEntries[WHICH_SEGMENT (probeHashes[i])].Prefetch (WHICH_SLOT (probeHashes[i]));
+      }
+      // the bitstring cannot end before the main loop does, but never leave
+      // the rest of the batch undefined
+      for (int i = batchSize; i < JOIN_LHS_PROBE_BATCH; i++) {
+        probeHashes[i] = 0;
+        probeFiltered[i] = true;
+      }
+      probePos = 0;
+    }
+    HT_INDEX_TYPE probeHash = probeHashes[probePos];
+    bool filtered = probeFiltered[probePos++];
+
     // counts how many matches for this query
     int numHits = 0;
 
@@ -117,12 +196,11 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
     if (!curBits.IsEmpty ()) {
 
       totalNum++;
+      if (filtered)
+        totalFiltered++;
 
-      // compute the hash for LHS
-      HT_INDEX_TYPE hashValue = HASH_INIT;
-<?  foreach ($jDesc->LHS_keys as $att) { ?>
-      hashValue = CongruentHash(Hash(<?=$att?>_Column.GetCurrent()), hashValue);
-<?  } /*foreach*/ ?>
+      // the hash for LHS was computed with the batch
+      HT_INDEX_TYPE hashValue = probeHash;
 
       // figure out which of the hash buckets it goes into
       unsigned int index = WHICH_SEGMENT (hashValue);
@@ -131,8 +209,9 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
       HT_INDEX_TYPE curSlot = WHICH_SLOT (hashValue);
       hashValue = curSlot;
 
-      // this loops through all of the possible RHS hits
-      while (1) {
+      // this loops through all of the possible RHS hits. A tuple that was
+      // filtered has none, it is treated as if the slot was empty
+      while (!filtered) {
 
         // this is the bitstring that will go in the output
         QueryIDSet bitstringLHS;
@@ -166,23 +245,58 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
         bitstringRHS = (QueryIDSet *) serializeHere;
         lenSoFar += lastLen;
 
-        // next look for other hashed attributes
-<?  foreach ($jDesc->hash_RHS_attr as $att) { ?>
+        // the other hashed attributes may come in one piece, usually in the
+        // entries right after the bitmap
         lastLen = myEntries[index].Extract(serializeHere + lenSoFar, curSlot,
                                            hashValue, wayPointID,
-                                           <?=attSlot($att)?>, dummy, done);
-
-        // see if we got attribute
+                                           PACKED_TUPLE, dummy, done);
         if (lastLen > 0) {
-          Deserialize(serializeHere + lenSoFar, <?=$att?>RHSobj);
-          //<?=attOptimizedDeserialize($att, $att."RHSobj", "serializeHere", "lenSoFar")?>;
-          <?=$att?>RHS = &<?=$att?>RHSobj;
-          lenSoFar += lastLen;
-        } else {
+          PackedTupleLayout::Header packedHeader;
+          memcpy(&packedHeader, serializeHere + lenSoFar, sizeof(packedHeader));
+          if (packedHeader.layout != packedLayoutID || packedHeader.present != packedPresent) {
+            packedLayoutID = packedHeader.layout;
+            packedPresent = packedHeader.present;
+            const PackedTupleLayout &packedLayout = PackedTupleLayout::Get(packedLayoutID);
+<?  foreach ($packedAtts as $att) { ?>
+            <?=$att?>_PackedOffset = packedLayout.Offset(<?=attSlot($att)?>, packedPresent);
+<?  } /*foreach*/ ?>
+          }
+
+<?  foreach ($jDesc->hash_RHS_attr as $att) { ?>
+<?      if (isFixedAtt($att)) { ?>
+          if (<?=$att?>_PackedOffset >= 0) {
+            memcpy(&<?=$att?>RHSobj, serializeHere + lenSoFar + <?=$att?>_PackedOffset,
+                   sizeof(<?=attType($att)?>));
+            <?=$att?>RHS = &<?=$att?>RHSobj;
+          } else {
+            FATALIF(<?=attQrys($att)?>_RHS.Overlaps(*bitstringRHS),
+                    "Did not find attribute <?=$att?> in active RHS tuple");
+          }
+<?      } else { ?>
           FATALIF(<?=attQrys($att)?>_RHS.Overlaps(*bitstringRHS),
                   "Did not find attribute <?=$att?> in active RHS tuple");
-        }
+<?      } /*if fixed size*/ ?>
 <?  } /*foreach*/ ?>
+          lenSoFar += lastLen;
+        } else {
+          // next look for other hashed attributes, one at a time
+<?  foreach ($jDesc->hash_RHS_attr as $att) { ?>
+          lastLen = myEntries[index].Extract(serializeHere + lenSoFar, curSlot,
+                                             hashValue, wayPointID,
+                                             <?=attSlot($att)?>, dummy, done);
+
+          // see if we got attribute
+          if (lastLen > 0) {
+            Deserialize(serializeHere + lenSoFar, <?=$att?>RHSobj);
+            //<?=attOptimizedDeserialize($att, $att."RHSobj", "serializeHere", "lenSoFar")?>;
+            <?=$att?>RHS = &<?=$att?>RHSobj;
+            lenSoFar += lastLen;
+          } else {
+            FATALIF(<?=attQrys($att)?>_RHS.Overlaps(*bitstringRHS),
+                    "Did not find attribute <?=$att?> in active RHS tuple");
+          }
+<?  } /*foreach*/ ?>
+        }
 
         // see if we have any query matches
         bitstringRHS->Intersect (curBits);
@@ -314,6 +428,8 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
     myInBStringIter.Advance ();
   }
 
+  double probeTime = probeClock.GetTime ();
+
   // The join is completed. The output chunk is now constructed.
 
   // if we are still shallow, put the original data into the output
@@ -355,6 +471,12 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
   PCounterList counterList;
   PCounter totalCnt("tpi lhs", totalNum, "<?=$wpName?>");
   counterList.Append(totalCnt);
+  // nanoseconds spent matching per probed tuple
+  PCounter timeCnt("npt lhs", totalNum > 0 ? int64_t(probeTime * 1e9 / totalNum) : 0, "<?=$wpName?>");
+  counterList.Append(timeCnt);
+  // probed tuples skipped thanks to the join filter
+  PCounter filteredCnt("flt lhs", totalFiltered, "<?=$wpName?>");
+  counterList.Append(filteredCnt);
 
   PROFILING2_SET(counterList, "<?=$wpName?>");
 
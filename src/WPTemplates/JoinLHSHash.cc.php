@@ -115,17 +115,21 @@ int JoinLHSHashWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngi
     // now we are done serializing the chunk
     free (serializeHere);
 
-    // so actually do the hashing... first set up the list of the guys we want to hash
+    // so actually do the hashing... first set up the list of the guys we want to hash;
+    // the tuples are already partitioned by segment, so the segments that get none of
+    // them are not even checked out
     int theseAreOK [NUM_SEGS];
+    int numToHash = 0;
     for (int i = 0; i < NUM_SEGS; i++) {
-        theseAreOK[i] = 1;
+        theseAreOK[i] = !serializedSegments[i].IsEmpty ();
+        numToHash += theseAreOK[i];
     }
 
     // this is the set of sample collisions taken from the over-full segments
     HashSegmentSample mySamples;
 
     // now go through and, one-at-a-time, add the data to each table segment
-    for (int i = 0; i < NUM_SEGS; i++) {
+    for (int i = 0; i < numToHash; i++) {
 
         // first get a segment to add data to
         HashTableSegment checkedOutCopy;
@@ -134,7 +138,8 @@ int JoinLHSHashWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngi
 
         // now add the data
         HashSegmentSample mySample;
-        if (checkedOutCopy.Insert (serializedSegments[whichOne], mySample)) {
+        int grew;
+        if (checkedOutCopy.Insert (serializedSegments[whichOne], mySample, grew)) {
 
             // if we are in here, it means that the segment was over-full, so note that we will
             // need to empty it out... we record all of the samples
@@ -143,8 +148,12 @@ int JoinLHSHashWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngi
             mySamples.SwapRights (mySample);
         }
 
-        // and then put the segment back in the hash table
-        myWork.get_centralHashTable ().CheckIn (whichOne);
+        // and then put the segment back in the hash table; if the insert moved it to a
+        // larger segment, the new one has to replace the old one
+        if (grew)
+            myWork.get_centralHashTable ().Replace (whichOne, checkedOutCopy);
+        else
+            myWork.get_centralHashTable ().CheckIn (whichOne);
     }
 
 <?  cgPutbackColumns($jDesc->attribute_queries_LHS, 'input', $wpName); ?>
@@ -153,7 +162,7 @@ int JoinLHSHashWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngi
     PROFILING(0.0, "HashTable", "fillrate", "%2.4f", HashTableSegment::globalFillRate.load());
 
     // now we are finally done!
-    JoinHashResult myResult (mySamples);
+    JoinHashResult myResult (-1, QueryToJoinKeyRange (), mySamples);
     myResult.swap (result);
     return 0;
 }
@@ -6,7 +6,30 @@
 
 function JoinRHS($wpName, $jDesc){
 
+    // the range of the key is tracked for the query classes joining on one
+    // integer key, it lets the scans of the LHS skip chunks
+    $lhsKey = count($jDesc->LHS_keys) == 1 ? reset($jDesc->LHS_keys) : null;
+    $lhsKeyType = is_null($lhsKey) ? null : lookupAttribute($lhsKey)->type();
+    $rangeKeys = [];
+    if (!is_null($lhsKeyType) && $lhsKeyType->is('_primative_') && $lhsKeyType->is('integral')) {
+        foreach ($jDesc->query_classes_hash as $i => $qClass) {
+            if (count($qClass->rhs_keys) != 1)
+                continue;
+            $rhsKey = reset($qClass->rhs_keys);
+            $rhsKeyType = lookupAttribute($rhsKey)->type();
+            if ($rhsKeyType->is('_primative_') && $rhsKeyType->is('integral'))
+                $rangeKeys[$i] = $rhsKey;
+        }
+    }
+
+    // the tuples with only fixed size attributes are packed
+    $packedAtts = joinPackedAttributes($jDesc);
 ?>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "PackedTupleLayout.h"
 
 //+{"kind":"WPF", "name":"RHS Hash", "action":"start"}
 extern "C"
@@ -33,6 +56,31 @@ int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineDa
 
     QueryIDSet queriesToRun = QueryExitsToQueries(myWork.get_whichQueryExits ());
 
+    // all the hashes go in the filter the LHS checks before probing
+    JoinFilter &joinFilter = myWork.get_joinFilter ();
+
+<?  if (count($packedAtts) > 0) { ?>
+    // all the RHS attributes have a fixed size, so they go in the hash table
+    // in one piece after the bitmap (see PackedTupleLayout.h)
+    PackedTupleLayout packedLayout;
+<?      foreach ($packedAtts as $att) { ?>
+    packedLayout.Add (<?=attSlot($att)?>, sizeof(<?=attType($att)?>));
+<?      } /*foreach packed attribute*/ ?>
+
+    // the tuples carry the ID of their layout, so that they can be read after
+    // the code of the join changes
+    PackedTupleLayout::LayoutID packedLayoutID = PackedTupleLayout::Register (packedLayout);
+
+    // the hash entries are filled sizeof (VAL_TYPE) bytes at a time
+    const int packedTupleMaxSize = sizeof (PackedTupleLayout::Header)<? foreach ($packedAtts as $att) { ?> + sizeof(<?=attType($att)?>)<? } ?>;
+    char packedTuple[(packedTupleMaxSize + sizeof (VAL_TYPE) - 1) / sizeof (VAL_TYPE) * sizeof (VAL_TYPE)] = { };
+
+<?  } /*if packed*/ ?>
+<?  foreach ($rangeKeys as $i => $att) { ?>
+    // range of <?=$att?> over the chunk
+    int64_t keyMin<?=$i?> = INT64_MAX, keyMax<?=$i?> = INT64_MIN;
+<?  } /*foreach range key*/ ?>
+
 <?  cgAccessColumns($jDesc->attribute_queries_RHS, 'input', $wpName); ?>
 
     // prepare bitstring iterator
@@ -59,7 +107,7 @@ int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineDa
 
         totalNum++;
 
-<? foreach($jDesc->query_classes_hash as $qClass) {
+<? foreach($jDesc->query_classes_hash as $i => $qClass) {
         $attOrder = [];
         foreach( $qClass->att_queries as $att => $qrys ) {
             $attr = lookupAttribute($att);
@@ -77,6 +125,12 @@ int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineDa
             hashValue = CongruentHash(Hash(<?=$att?>), hashValue);
     <? } /*foreach attribute*/ ?>
 
+            joinFilter.Insert (hashValue);
+<?  if (array_key_exists($i, $rangeKeys)) { ?>
+            keyMin<?=$i?> = std::min (keyMin<?=$i?>, (int64_t) <?=$rangeKeys[$i]?>);
+            keyMax<?=$i?> = std::max (keyMax<?=$i?>, (int64_t) <?=$rangeKeys[$i]?>);
+<?  } ?>
+
             // figure out which of the hash buckets it goes into
             unsigned int index = WHICH_SEGMENT (hashValue);
 
@@ -100,6 +154,23 @@ int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineDa
             // remember the serialized value
             serializedSegments[index].StartNew (WHICH_SLOT (hashValue), wayPointID, 1, location, bytesUsed);
 
+<?      if (count($packedAtts) > 0) { ?>
+            // pack the attributes used by the queries of the tuple
+            PackedTupleLayout::Header packedHeader = { packedLayoutID, 0 };
+            int packedSize = sizeof (packedHeader);
+<?          foreach ($packedAtts as $k => $att) {
+                if (!isset($qClass->att_queries->$att))
+                    continue;
+?>
+            if (myInBString.Overlaps(QueryIDSet(<?=$qClass->att_queries->$att?>, true))) {
+                memcpy (packedTuple + packedSize, &<?=$att?>, sizeof(<?=attType($att)?>));
+                packedSize += sizeof(<?=attType($att)?>);
+                packedHeader.present |= 1u << <?=$k?>;
+            }
+<?          } /*foreach packed attribute*/ ?>
+            memcpy (packedTuple, &packedHeader, sizeof (packedHeader));
+            serializedSegments[index].Append (PACKED_TUPLE, (void *) packedTuple, packedSize);
+<?      } else { ?>
             // now, go thru all of the attributes that are used
 <?      foreach($attOrder as $att => $slot) {
             $qrys = $qClass->att_queries->$att;
@@ -120,6 +191,7 @@ int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineDa
                 serializedSegments[index].Append (<?=$slot?>,(void *) serializeHere, bytesUsed);
             }
     <? } /*foreach attribute*/ ?>
+<?      } /*if packed*/ ?>
         }
 
 <? } /*foreach query class*/ ?>
@@ -130,17 +202,21 @@ int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineDa
     // now we are done serializing the chunk
     free (serializeHere);
 
-    // so actually do the hashing... first set up the list of the guys we want to hash
+    // so actually do the hashing... first set up the list of the guys we want to hash;
+    // the tuples are already partitioned by segment, so the segments that get none of
+    // them are not even checked out
     int theseAreOK [NUM_SEGS];
+    int numToHash = 0;
     for (int i = 0; i < NUM_SEGS; i++) {
-        theseAreOK[i] = 1;
+        theseAreOK[i] = !serializedSegments[i].IsEmpty ();
+        numToHash += theseAreOK[i];
     }
 
     // this is the set of sample collisions taken from the over-full segments
     HashSegmentSample mySamples;
 
     // now go through and, one-at-a-time, add the data to each table segment
-    for (int i = 0; i < NUM_SEGS; i++) {
+    for (int i = 0; i < numToHash; i++) {
         // first get a segment to add data to
         HashTableSegment checkedOutCopy;
         int whichOne = myWork.get_centralHashTable ().CheckOutOne (theseAreOK, checkedOutCopy);
@@ -148,7 +224,8 @@ int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineDa
 
         // now add the data
         HashSegmentSample mySample;
-        if (checkedOutCopy.Insert (serializedSegments[whichOne], mySample)) {
+        int grew;
+        if (checkedOutCopy.Insert (serializedSegments[whichOne], mySample, grew)) {
 
             // if we are in here, it means that the segment was over-full, so note that we will
             // need to empty it out... we record all of the samples
@@ -157,8 +234,12 @@ int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineDa
             mySamples.SwapRights (mySample);
         }
 
-        // and then put the segment back in the hash table
-        myWork.get_centralHashTable ().CheckIn (whichOne);
+        // and then put the segment back in the hash table; if the insert moved it to a
+        // larger segment, the new one has to replace the old one
+        if (grew)
+            myWork.get_centralHashTable ().Replace (whichOne, checkedOutCopy);
+        else
+            myWork.get_centralHashTable ().CheckIn (whichOne);
     }
 
 <?  cgPutbackColumns($jDesc->attribute_queries_RHS, 'input', $wpName); ?>
@@ -181,8 +262,24 @@ int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineDa
     int64_t hFillRate = int64_t(HashTableSegment::globalFillRate * 1000);
     PROFILING2_INSTANT("hfr", hFillRate, "global");
 
+    // the key ranges of the queries. The outer and anti joins need all the LHS
+    // tuples so they do not get one
+    QueryToJoinKeyRange keyRanges;
+<?  foreach ($rangeKeys as $i => $att) { ?>
+    {
+        QueryIDSet rangeQueries(<?=$jDesc->query_classes_hash[$i]->qClass?>, true);
+        rangeQueries.Intersect (queriesToRun);
+        rangeQueries.Difference (QueryIDSet(<?=$jDesc->not_exists_target?>, true));
+        rangeQueries.Difference (QueryIDSet(<?=$jDesc->left_target?>, true));
+        while (!rangeQueries.IsEmpty ()) {
+            QueryID query = rangeQueries.GetFirst ();
+            keyRanges[query] = JoinKeyRange (keyMin<?=$i?>, keyMax<?=$i?>);
+        }
+    }
+<?  } /*foreach range key*/ ?>
+
     // now we are finally done!
-    JoinHashResult myResult (mySamples);
+    JoinHashResult myResult (<?=count($rangeKeys) > 0 ? attSlot($lhsKey) : -1?>, keyRanges, mySamples);
     myResult.swap (result);
     return 0;
 
@@ -104,6 +104,19 @@ namespace grokit {
         $libs = $genInfo->libs();
 
         $cxxLibs = implode(' ', array_map(function($val) { return '-l' . $val; }, $libs));
+
+        // Each waypoint is also compiled into its own shared object, through the
+        // cache of compiled modules (see compileModule.sh). The Modules file lists
+        // the module of every waypoint for the code loader.
+        $filesPerWaypoint = $genInfo->filesPerWaypoint();
+        $modules = [];
+        foreach( $filesPerWaypoint as $wp => $files ) {
+            $modules[$wp] = $wp . '.so';
+        }
+
+        $codeCache = getenv('GROKIT_CODE_CACHE');
+        if( $codeCache === false )
+            $codeCache = realpath('..') . DIRECTORY_SEPARATOR . 'CodeCache';
 ?>
 CXX             := <?=$cxxCompiler?>
 
@@ -122,14 +135,35 @@ ifdef CPUPROFILE
 CXXLIBS += -lprofiler
 endif
 
+GROKIT_CODE_CACHE ?= <?=$codeCache?>
+
+MODULE_COMPILE  ?= ../compileModule.sh
+
+export CXX CXXOPTS CXXFLAGS CXXINCLUDE CXXLIBS CXXLINKFLAGS GROKIT_CODE_CACHE
+
+Modules: <?=implode(' ', $modules)?>
+
+	printf '%s\n' <?=implode(' ', array_map(function($wp, $mod) { return "'$wp $mod'"; }, array_keys($modules), $modules))?> > Modules
+
 Generated.so: <?=implode(' ', $oFiles)?>
 
 	$(CXX) -rdynamic -shared -o Generated.so $(CXXFLAGS) $(CXXOPTS) <?=implode(' ', $oFiles)?> $(CXXLINKFLAGS) $(CXXLIBS)
 
 clean:
-	rm <?=implode(' ', $oFiles)?>
+	rm <?=implode(' ', $oFiles)?> <?=implode(' ', $modules)?> Modules
 
 <?
+        foreach( $modules as $wp => $module ) {
+            $files = $filesPerWaypoint[$wp];
+?>
+<?=$module?> : <?=implode(' ', $files)?>
+
+	$(MODULE_COMPILE) <?=$module?> <?=implode(' ', $files)?>
+
+
+<?
+        } // end foreach module
+
         foreach( $ccFiles as $ccFile ) {
             $oFile = replaceExtension($ccFile, '.cc', '.o');
 ?>
@@ -11,6 +11,7 @@ function PrintGenerate($wpName, $queries, $attMap){
 #include <iostream>
 #include <string.h>
 #include "Profiling.h"
+#include "PrintBinary.h"
 
 //+{"kind":"WPF", "name":"Process Chunk", "action":"start"}
 extern "C"
@@ -48,7 +49,17 @@ int PrintWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineData
     Json::Value jsonRow;
     Json::FastWriter jsonWriter;
     std::string jsonString;
-<?      } // if type is json ?>
+<?      } // if type is json
+        else if( $type == 'binary' ) {
+            // The primitive values are copied as they are, the others as text
+            $valueSizes = [];
+            foreach( $val['expressions'] as $exp ) {
+                $valueSizes[] = $exp->type()->is('_primative_') ? 'sizeof(' . $exp->type() . ')' : '0';
+            }
+?>
+    // the rows of the chunk, written at once at the end (see PrintBinary.h)
+    PrintBinaryBatch batch_<?=queryName($query)?>({ <?=implode(', ', $valueSizes)?> });
+<?      } // if type is binary ?>
 
     PrintFileObj& pfo_<?=queryName($query)?> = streams.Find(<?=queryName($query)?>);
     DistributedCounter* counter_<?=queryName($query)?> = counters.Find(<?=queryName($query)?>);
@@ -74,7 +85,9 @@ int PrintWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineData
         queries.Advance();
 
 <?  cgAccessAttributes($attMap);
-    foreach($queries as $query=>$val){ ?>
+    foreach($queries as $query=>$val){
+        $type = $val["type"];
+?>
         // execute <?=queryName($query)?> code
         if (qry.Overlaps(<?=queryName($query)?>) && counter_<?=queryName($query)?>->Decrement(1)>=0){
 <?      cgPreprocess($val); ?>
@@ -110,7 +123,25 @@ int PrintWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineData
 
             // Now we print the buffer
             fprintf(file_<?=queryName($query)?>, "%s", buffer);
-<?      } // if output file is csv ?>
+<?      } // if output file is csv
+        else if( $type == 'binary' ) {
+            $col = 0;
+            foreach($val["expressions"] as $exp) {
+                if( $exp->type()->is('_primative_') ) {
+?>
+            {
+                <?=$exp->type()?> value = <?=$exp->value()?>;
+                batch_<?=queryName($query)?>.AppendValue(<?=$col?>, &value);
+            }
+<?              } else { ?>
+            curr = ToString(<?=$exp->value()?>, buffer);
+            batch_<?=queryName($query)?>.AppendText(<?=$col?>, buffer, curr - 1);
+<?              } // if value is not primitive
+                $col++;
+            } // for each expression
+?>
+            batch_<?=queryName($query)?>.EndRow();
+<?      } // if output file is binary ?>
         }
 <?  } // for each query ?>
 <?
@@ -118,6 +149,15 @@ int PrintWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineData
 ?>
     }
 
+<?  foreach($queries as $query=>$val){
+        if( $val['type'] == 'binary' ) {
+?>
+    FATALIF(!batch_<?=queryName($query)?>.Write(file_<?=queryName($query)?>),
+        "Print could not write the results of <?=queryName($query)?>");
+<?      } // if output file is binary
+    } // for each query
+?>
+
 <?  cgPutbackColumns($attMap, 'input', $wpName); ?>
 
     PROFILING2_END;
@@ -161,7 +201,7 @@ int PrintFinalizeWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEn
     foreach( $queries as $query => $val ) {
         $type = $val['type'];
 
-        if( $type == 'json' && !$jsonVarsDefined ) {
+        if( ($type == 'json' || $type == 'binary') && !$jsonVarsDefined ) {
             $jsonVarsDefined = true;
 ?>
     Json::Value json;
@@ -203,7 +243,27 @@ int PrintFinalizeWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEn
     fseek(file_<?=queryName($query)?>, -1, SEEK_CUR); // overwrite the last comma
     fprintf(file_<?=queryName($query)?>, " ], \"types\": %s }", jsonString.c_str());
 
-<?      } // if type is json ?>
+<?      } // if type is json
+        else if( $type == 'binary' ) {
+?>
+    // The types go after the batches, like in the JSON output
+    json = Json::Value(Json::arrayValue);
+
+<?          foreach( $val['expressions'] as $exp ) {
+                $describer = $exp->type()->describer('json');
+                grokit_assert(is_callable($describer), 'Invalid JSON describer for type ' . $exp->type());
+?>
+    {
+        Json::Value tmp;
+        <? $describer('tmp'); ?>
+        json.append(tmp);
+    }
+<?          } // for each expression ?>
+
+    jsonString = jsonWriter.write(json);
+    PrintBinaryBatch::WriteMessage(file_<?=queryName($query)?>, PrintBinaryBatch::TYPES, jsonString);
+
+<?      } // if type is binary ?>
 <?  } // for each query ?>
 
     return WP_FINALIZE;
@@ -0,0 +1,98 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef _GI_FILE_RANGE_H_
+#define _GI_FILE_RANGE_H_
+
+#include <streambuf>
+#include <string>
+#include <sys/types.h>
+
+/** Reader for a byte range [begin, end) of a text file, read with pread.
+
+    Large files are split by the GI waypoint in ranges that are read in
+    parallel. The ranges are aligned at record (line) boundaries: a range
+    starts right after the first new line at or after begin - 1 (at 0 for
+    the first range) and ends with the record that contains byte end - 1.
+    The records of the file are thus read by exactly one range.
+
+    The reader is a streambuf, so the GIs can read it through an istream,
+    and it also gives out the records in place (NextRecord) for the GIs
+    that can parse them without a copy.
+
+    The file is opened and the buffer allocated at the first read, so the
+    ranges waiting to be read do not hold any resources.
+*/
+class GIFileRange : public std::streambuf {
+    static const size_t BUFFER_SIZE = 1<<20;
+
+    std::string file_name;
+
+    // the range, as given
+    off_t begin;
+    off_t end;
+
+    int fd;
+    off_t file_size;
+
+    // file offset of the next byte to read
+    off_t read_pos;
+
+    // file offset where the range stops. -1 until the end of the last
+    // record is found
+    off_t stop_pos;
+
+    // true once the file is open and the partial first record skipped
+    bool started;
+
+    // the buffer has capacity + 1 bytes, to terminate the last record
+    char* buffer;
+    size_t capacity;
+
+    // opens the file and skips the record that belongs to the previous range
+    void Start(void);
+
+    // reads the next part of the range after the unread bytes, which are
+    // moved at the start of the buffer. Returns false if nothing was read
+    bool Fill(void);
+
+    GIFileRange(const GIFileRange&) = delete;
+    GIFileRange& operator = (const GIFileRange&) = delete;
+
+protected:
+    // streambuf interface
+    int_type underflow(void);
+
+public:
+    GIFileRange(const std::string& file, off_t begin, off_t end);
+
+    // gives the next record, without the new line and terminated by '\0'.
+    // The record stays valid until the next read. Returns false at the end
+    // of the range
+    bool NextRecord(char*& record, size_t& length);
+
+    // extends the range to the end of the file. Only before the first read
+    void ToEndOfFile(void);
+
+    // true if the range starts at the beginning of the file
+    bool AtFileStart(void) const { return begin == 0; }
+
+    // true if everything in the range was read
+    bool Done(void) const;
+
+    ~GIFileRange();
+};
+
+#endif // _GI_FILE_RANGE_H_
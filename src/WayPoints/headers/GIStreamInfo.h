@@ -23,6 +23,7 @@
 #include "Swap.h"
 #include "Config.h"
 #include "Logging.h"
+#include "GIFileRange.h"
 
 // Forward declaration
 class GIStreamInfo;
@@ -30,24 +31,27 @@ class GIStreamInfo;
 class GIStreamProxy {
     // Private members
     std::istream* stream;
+    GIFileRange* range; // NULL if the stream is not a range of a file
     off_t id;
     std::string file_name;
 
 public:
-    GIStreamProxy() : stream(NULL), id(-1), file_name("No File") {
+    GIStreamProxy() : stream(NULL), range(NULL), id(-1), file_name("No File") {
     }
 
 private:
-    GIStreamProxy( std::istream* _stream, const off_t _id, const std::string& _file_name ) : stream(_stream), id(_id), file_name(_file_name) {
+    GIStreamProxy( std::istream* _stream, GIFileRange* _range, const off_t _id, const std::string& _file_name ) :
+        stream(_stream), range(_range), id(_id), file_name(_file_name) {
     }
 
 public:
-    GIStreamProxy( const GIStreamProxy &other ) : stream(other.stream), id(other.id), file_name(other.file_name) {
+    GIStreamProxy( const GIStreamProxy &other ) : stream(other.stream), range(other.range), id(other.id), file_name(other.file_name) {
     }
 
 #ifdef _HAS_CPP_11
-    GIStreamProxy( GIStreamProxy &&other ) : stream(NULL), id(-1), file_name("No File") {
+    GIStreamProxy( GIStreamProxy &&other ) : stream(NULL), range(NULL), id(-1), file_name("No File") {
         SWAP_STD(stream, other.stream);
+        SWAP_STD(range, other.range);
         SWAP_STD(id, other.id);
         SWAP_STD(file_name, other.file_name)
     }
@@ -55,12 +59,14 @@ public:
 
     void swap( GIStreamProxy &other ) {
         SWAP_STD(stream, other.stream);
+        SWAP_STD(range, other.range);
         SWAP_STD(id, other.id);
         SWAP_STD(file_name, other.file_name);
     }
 
     void copy( const GIStreamProxy& other ) {
         stream = other.stream;
+        range = other.range;
         id = other.id;
         file_name = other.file_name;
     }
@@ -79,7 +85,28 @@ public:
         return file_name;
     }
 
+    // Returns the range of the file read by the stream, for the GIs that
+    // read the records in place. NULL if the stream is not a file range.
+    GIFileRange * get_range( void ) {
+        return range;
+    }
+
+    // True if the stream starts at the beginning of the file, i.e. it is
+    // not one of the later ranges of a file split by the GI waypoint.
+    bool at_file_start( void ) const {
+        return range == NULL || range->AtFileStart();
+    }
+
+    // Makes the stream read everything up to the end of the file, for the
+    // GIs that cannot deal with a file being split.
+    void whole_file( void ) {
+        if( range != NULL )
+            range->ToEndOfFile();
+    }
+
     bool done( void ) const {
+        if( range != NULL )
+            return range->Done();
         return (stream == NULL || !(stream->good()) );
     }
 
@@ -98,7 +125,8 @@ protected:
     static const std::streamsize BUFFER_SIZE = 1<<20;
 
     // Private members
-    ifstream * stream; // Hacky, due to lack of swap in libstdc++
+    std::istream * stream; // Hacky, due to lack of swap in libstdc++
+    GIFileRange * range;
     char * buffer;
     std::string file_name;
     off_t id;
@@ -106,28 +134,38 @@ protected:
 public:
 
     // Empty stream object.
-    GIStreamInfo() : stream(NULL), buffer(NULL), file_name("No File"), id(-1) {
+    GIStreamInfo() : stream(NULL), range(NULL), buffer(NULL), file_name("No File"), id(-1) {
     }
 
     // Creates a stream bound to a file with a non-standard buffer.
-    GIStreamInfo( const std::string& file, off_t _id ) : buffer(NULL), file_name(file),  id(_id) {
-        stream = new ifstream( file.c_str() );
+    GIStreamInfo( const std::string& file, off_t _id ) : range(NULL), buffer(NULL), file_name(file),  id(_id) {
+        ifstream * fStream = new ifstream( file.c_str() );
+        stream = fStream;
         if( stream->fail() ) {
             LOG_ENTRY_P(1, "Failed to open file %s", file.c_str());
         }
         else {
             buffer = new char[BUFFER_SIZE];
-            stream->rdbuf()->pubsetbuf( buffer, BUFFER_SIZE );
+            fStream->rdbuf()->pubsetbuf( buffer, BUFFER_SIZE );
         }
     }
 
+    // Creates a stream bound to the byte range [begin, end) of a file, aligned
+    // at record boundaries (see GIFileRange).
+    GIStreamInfo( const std::string& file, off_t _id, off_t begin, off_t end ) :
+        buffer(NULL), file_name(file), id(_id) {
+        range = new GIFileRange( file, begin, end );
+        stream = new std::istream( range );
+    }
+
     // Delete copy constructor
     GIStreamInfo( const GIStreamInfo& other ) = delete;
 
 #ifdef _HAS_CPP_11
     // Move constructor
-    GIStreamInfo( GIStreamInfo &&other ) : stream(NULL), buffer(NULL), file_name("No File"), id(-1) {
+    GIStreamInfo( GIStreamInfo &&other ) : stream(NULL), range(NULL), buffer(NULL), file_name("No File"), id(-1) {
         SWAP_STD( stream, other.stream );
+        SWAP_STD( range, other.range );
         SWAP_STD( buffer, other.buffer );
         SWAP_STD( file_name, other.file_name );
         SWAP_STD( id, other.id );
@@ -143,13 +181,16 @@ public:
     // Deallocate any buffer that was allocated and close open streams.
     ~GIStreamInfo( void ) {
         if( stream != NULL ) {
-            if( stream->is_open() )
-                stream->close();
-
+            // the file streams close their file when deleted
             delete stream;
             stream = NULL;
         }
 
+        if( range != NULL ) {
+            delete range;
+            range = NULL;
+        }
+
         if( buffer != NULL ) {
             delete [] buffer;
             buffer = NULL;
@@ -172,12 +213,15 @@ public:
     }
 
     bool done( void ) const {
+        if( range != NULL )
+            return range->Done();
         return stream != NULL ? !stream->good() : true;
     }
 
     // Swapping paradigm
     void swap( GIStreamInfo& other ) {
         SWAP_STD( stream, other.stream );
+        SWAP_STD( range, other.range );
         SWAP_STD( buffer, other.buffer );
         SWAP_STD( file_name, other.file_name );
         SWAP_STD( id, other.id );
@@ -185,7 +229,7 @@ public:
 
     GIStreamProxy get_proxy( void ) const {
         FATALIF( stream == NULL, "Error: Attempted to create proxy for invalid stream." );
-        return GIStreamProxy( stream, id, file_name );
+        return GIStreamProxy( stream, range, id, file_name );
     }
 };
 
@@ -22,6 +22,7 @@
 #include "EfficientMap.h"
 #include "ExecEngineData.h"
 #include "TableScanID.h"
+#include "SpeedCtrl.h"
 
 class GIWayPointImp : public WayPointImp {
 
@@ -58,13 +59,11 @@ class GIWayPointImp : public WayPointImp {
     // the scan id we created for ourselves to tag our chunks
     TableScanID tID;
 
-    ///// BEGIN TEMPORARY SOLUTION /////
-    // System time we last sent out a cached chunk. Used for throttling.
-    double last_cache_send;
+    // The queries of myExits
+    QueryIDSet myQueries;
 
-    // Number of seconds in between sent chunks when caching
-    static const double CACHE_INTERVAL;
-    ///// END TEMPORARY SOLUTION /////
+    // Bounds the chunks in flight, produced or cached ones sent again
+    SpeedCtrl speedCtrl;
 
     // Shallow copies of chunks sent out
     typedef EfficientMap<ChunkID, ChunkContainer> ChunkMap;
@@ -83,6 +82,13 @@ class GIWayPointImp : public WayPointImp {
     // function to set up the streams
     void SetUpStreams();
 
+    // function to add a stream for a file, or for the range [begin, end) of
+    // it if begin is not negative
+    void AddStream( const std::string& file, off_t stream_id, off_t begin, off_t end );
+
+    // function to forget about a stream that is done
+    void RemoveStream( GIStreamProxy& stream );
+
 public:
 
     // Constructor and destructor
@@ -51,6 +51,11 @@ class GLAWayPointImp : public GPWayPointImp {
     // 0 = done, >0 = in progress
     QueryIDToInt mergeInProgress;
 
+    // For the queries merged with the partitioned merge, the next partition
+    // to schedule. GLA_MERGE_PARTITIONS means all partitions are scheduled
+    // and the states can be finished once they are all done.
+    QueryIDToInt nextPartition;
+
     // last fragment we generated to ensure a circular list behavior
     off_t lastFragmentId;
 
@@ -61,6 +66,7 @@ class GLAWayPointImp : public GPWayPointImp {
     QueryIDSet queriesToPreprocess;
     QueryIDSet queriesProcessing;
     QueryIDSet queriesMerging;
+    QueryIDSet queriesPartitionMerging;
     QueryIDSet queriesCounting;
     QueryIDSet queriesFinalizing;
     QueryIDSet queriesToPostFinalize;
@@ -72,6 +78,9 @@ class GLAWayPointImp : public GPWayPointImp {
     // Queries that should produce intermediate results when iterating
     QueryIDSet queriesProducingIntermediates;
 
+    // Queries whose GLA supports the partitioned merge
+    QueryIDSet queriesPartitioned;
+
     typedef EfficientMap<QueryID, HoppingUpstreamMsg> QueryIDToUpstreamMsg;
     QueryIDToUpstreamMsg cachedProducingMessages;
 
@@ -79,6 +88,7 @@ class GLAWayPointImp : public GPWayPointImp {
     //bool MergeDone();
     void FinishQueries( QueryIDSet queries );
     void RestartQueries( QueryIDSet queries );
+    bool PartitionMergePossible( CPUWorkToken& token );
 
     // Overwritten virtual methods
     void GotChunkToProcess( CPUWorkToken & token, QueryExitContainer& whichOnes, ChunkContainer& chunk, HistoryList& lineage);
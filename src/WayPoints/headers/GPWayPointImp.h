@@ -138,6 +138,12 @@ protected:
     // additional tokens should be generated.
     virtual bool ReceivedStartProducingMsg( HoppingUpstreamMsg& message, QueryExit& whichOne );
 
+    // This method is called when a join sends us the range of its key for
+    // one of our query exits. The range is about the tuples we produce, so
+    // by default it stops here. Waypoints that only drop tuples (and keep the
+    // values of the attributes they receive) can forward it upstream.
+    virtual void ReceivedJoinKeyRangeMsg( HoppingUpstreamMsg& message );
+
     /*************************************************************************/
     // The following methods are used for configuring the GLAWayPoint
     /*************************************************************************/
@@ -20,6 +20,7 @@
 
 #include "WayPointImp.h"
 #include "HashTable.h"
+#include "JoinFilter.h"
 
 class JoinWayPointImp : public WayPointImp {
     private:
@@ -60,9 +61,21 @@ class JoinWayPointImp : public WayPointImp {
         HashTable centralHashTable;
         bool hashTableReady;
 
+        // filter of the hashes of the RHS tuples, checked by the LHS before probing.
+        // It is only reset when no query is running through us
+        JoinFilter joinFilter;
+
+        // range of the join key over the RHS of each query, merged as the RHS chunks
+        // are hashed, and the LHS slot they apply to (-1 if the join does not have one)
+        int keySlot;
+        QueryToJoinKeyRange keyRanges;
+
         // this is the identifier of the cleaner waypoint
         WayPointID hashTableCleaner;
 
+        // tells the LHS scans the range of the join key of the query, before it starts
+        void SendKeyRange (QueryExit &whereTo);
+
     public:
 
         // constructor and destructor
@@ -0,0 +1,115 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef PRINT_BINARY_H
+#define PRINT_BINARY_H
+
+#include <cstdio>
+#include <cstring>
+#include <cinttypes>
+#include <string>
+#include <vector>
+#include <initializer_list>
+
+/** Binary columnar output of the Print waypoint (type "binary").
+
+    The file is a stream of messages in the spirit of the Arrow IPC stream
+    format, so the results can be loaded without parsing text:
+
+        file    := magic message*
+        magic   := "GRKCOL01"
+        message := uint32 marker (0xFFFFFFFF), uint32 kind, uint64 length, body
+
+    All integers are in the native byte order and the bodies are padded to
+    a multiple of 8 bytes (length includes the padding). The messages are:
+
+    - HEADER, first: the JSON of the header of the query
+    - BATCH: the rows of one chunk, column by column:
+          uint64 numRows, uint32 numColumns, uint32 0,
+          then for each column: uint32 valueSize, uint32 0, uint64 length, data
+      A column with valueSize > 0 holds numRows values of valueSize bytes,
+      their memory image. A column with valueSize 0 holds numRows+1 uint64
+      offsets followed by the text of the values, the text of row i being
+      between offsets i and i+1
+    - TYPES: the JSON array of the types of the columns, like the "types" of
+      the JSON output
+    - END, last, empty
+
+    Each Print work function builds the batch of its chunk in memory and
+    appends it with a single write, so the chunks are formatted in parallel
+    and their batches never interleave. The batches are in the order the
+    chunks finish.
+*/
+class PrintBinaryBatch {
+    public:
+        static const char MAGIC[8];
+        static const uint32_t MARKER = 0xFFFFFFFF;
+
+        enum MessageKind {
+            END = 0,
+            HEADER = 1,
+            BATCH = 2,
+            TYPES = 3
+        };
+
+    private:
+        struct Column {
+            uint32_t valueSize; // 0 for text
+            std::vector<char> data;
+            std::vector<uint64_t> offsets;
+        };
+
+        std::vector<Column> columns;
+        uint64_t numRows;
+
+    public:
+        // one entry per column, the size of its values or 0 for text
+        PrintBinaryBatch(std::initializer_list<uint32_t> valueSizes);
+
+        // appends the value of a fixed size column
+        void AppendValue(int col, const void* value);
+
+        // appends the text of a value of a text column
+        void AppendText(int col, const char* text, size_t length);
+
+        // called once all the columns of a row are in
+        void EndRow(void) { numRows++; }
+
+        uint64_t NumRows(void) const { return numRows; }
+
+        // appends the batch to file with a single write if it has any rows,
+        // and empties it. Returns false if the write failed
+        bool Write(FILE* file);
+
+        // writes a message with the given body
+        static bool WriteMessage(FILE* file, MessageKind kind, const std::string& body);
+};
+
+
+// Inlined methods
+
+inline void PrintBinaryBatch::AppendValue(int col, const void* value) {
+    Column& column = columns[col];
+    const char* bytes = (const char*) value;
+    column.data.insert(column.data.end(), bytes, bytes + column.valueSize);
+}
+
+inline void PrintBinaryBatch::AppendText(int col, const char* text, size_t length) {
+    Column& column = columns[col];
+    column.data.insert(column.data.end(), text, text + length);
+    column.offsets.push_back(column.data.size());
+}
+
+#endif // PRINT_BINARY_H
@@ -48,6 +48,8 @@ class SelectionWayPointImp : public GPWayPointImp {
 
     bool ReceivedStartProducingMsg( HoppingUpstreamMsg& message, QueryExit& whichOne );
 
+    void ReceivedJoinKeyRangeMsg( HoppingUpstreamMsg& message );
+
 public:
 
     // const and destr
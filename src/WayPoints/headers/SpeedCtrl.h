@@ -16,46 +16,84 @@
 #ifndef _SPEED_CONTROL_H_
 #define _SPEED_CONTROL_H_
 
+#include <deque>
+#include <vector>
+
 #include "Bitstring.h"
 #include "Logging.h" // for global clock
 #include "QueryID.h"
+#include "Constants.h"
 
 /** Auxiliary class that encapsulates per query decisions
-http://www.faqs.org/rfcs/rfc5348.html
+
+    The controller keeps a window: the number of chunks that can be in
+    flight for the query, produced and neither acknowledged nor dropped.
+    It works like the congestion control of TCP (Vegas flavor), with the
+    acks and drops of the chunks as feedback:
+
+    - every ack grows the window by one chunk while it is small (slow
+      start) and by one chunk per window of acks after that
+    - every drop halves the window, the downstream waypoint had no room
+    - when the chunks take more than SPEED_CTRL_LATENCY_FACTOR times the
+      lowest latency seen to be acknowledged the chunks are queuing
+      downstream, the window shrinks by one chunk per window of acks
+
+    The latency of a chunk is the time from its production to its ack or
+    drop. Chunks are assumed to be acknowledged in the order they are
+    produced, close enough since they all go through the same waypoints.
 */
 
 class SpeedQ {
-    //???????
-    // time internal at which we should produce the next chunk
-    //default 28.5chunks/sec, or ~35ms per chunk = 0.035 seconds per chunk
-    double prodInterval;
-    // time at which chunk  is produced
-    double lastProduce;
-    long long int count;
+    // number of chunks that can be in flight
+    double window;
+    // the window at which the slow start stops
+    double threshold;
+
+    // production times of the chunks in flight, oldest first
+    std::deque<double> inFlight;
+
+    // lowest latency seen and average latency of the recent chunks
+    double minLatency;
+    double avgLatency;
+
+    // removes the oldest chunk in flight and updates the latencies
+    void Arrived(double time);
 
     public:
 
     // all interfaces mimic the SpeedCtrl class
+
+    // back to the initial window, with no latency seen
+    void Reset(void);
+
     // the extra argument is the time when it happened
-    void Reset(double time);
-    //every Ack, prodInterval is decreased by 10%, thus producing more chunks per sec
     void Ack(double time);
-    //every Drop, prodInterval is increased by 20%, thus producing less chunks per sec
     void Drop(double time);
 
-    // returns true if a chunk for this query can be produced, false otherwise
-    // The system WILL produce the chunk (otherwise why ask) so bookkeeping can use this
-    bool CanProduce(double time);
+    // a chunk was produced
+    void Produce(double time);
+    // the last chunk produced was not sent after all, forget it
+    void Cancel(void);
+
+    // number of chunks that can still be produced, can be negative
+    int Room(void);
 
-    double GetInterval(void);
+    double GetWindow(void);
+    double GetLatency(void);
 
 };
 
-/** Class that can determine the speed at which chunk production can work */
+/** Class that can determine the speed at which chunk production can work
+
+    Used by the producers of chunks to bound the number of chunks in
+    flight for each query. The producer asks Room() before it starts a
+    chunk, tells Produce() about the queries the chunk goes to, and passes
+    along the acks and drops it gets.
+*/
 
 class SpeedCtrl {
     // vector of speed controllers, one for each possible query.
-    SpeedQ sVec[BITS_PER_WORD];
+    std::vector<SpeedQ> sVec;
 
     // kill the copy constructor
     SpeedCtrl(const SpeedCtrl&);
@@ -63,126 +101,189 @@ class SpeedCtrl {
     public:
 
     SpeedCtrl();
-    // reset some of the parts
+    // reset all the queries
     void Reset();
+    // reset some of the queries, i.e. new ones
+    void Reset(QueryIDSet qrys);
     // ReceivedAck
-    void Ack(int i);
+    void Ack(QueryIDSet qrys);
     // Received Drop
-    void Drop(int i);
+    void Drop(QueryIDSet qrys);
 
-    /* Compute the set of queries for thich we can produce a chunk
+    /* Number of chunks that can still be produced for all the queries,
+       the smallest room among them. Chunks go to all the queries of a
+       shared scan, so the slowest query sets the pace
+       */
+    int Room(QueryIDSet qrys);
+
+    /* Compute the set of queries for which we can produce a chunk
        at this time
+       The system WILL produce the chunk for them (otherwise why ask) so
+       they get the chunk in flight
        */
     QueryIDSet Produce(QueryIDSet candidate);
+
+    // a chunk given to Produce was not sent after all
+    void Cancel(QueryIDSet qrys);
+
     bool CanProduce(int i);
-    double GetInterval(int i);
+    double GetWindow(int i);
 
 };
 
 /***************** INLINE FUNCTIONS ************************/
-inline SpeedCtrl::SpeedCtrl(){
-
+inline SpeedCtrl::SpeedCtrl():
+    sVec(QueryIDSet::MaxSize())
+{
+    Reset();
 }
 
 inline void SpeedCtrl::Reset(){
-    double time = global_clock.GetTime();
-    for (unsigned int i = 0; i < BITS_PER_WORD; i++) {
-        //        if (qrys.IsMember (i)) {
-        sVec[i].Reset(time);
-        //        }
+    for (unsigned int i = 0; i < sVec.size(); i++) {
+        sVec[i].Reset();
     }
 }
 
-inline void SpeedCtrl::Ack(int i){
-    double time = global_clock.GetTime();
-    //    for (unsigned int i = 0; i < BITS_PER_WORD; i++) {
-    //        if (qrys.IsMember (i)) {
-    sVec[i].Ack(time);
-    //        }
-    //    }
+inline void SpeedCtrl::Reset(QueryIDSet qrys){
+    for (unsigned int i = 0; i < sVec.size(); i++) {
+        if (qrys.IsMember (i)) {
+            sVec[i].Reset();
+        }
+    }
 }
 
-inline void SpeedCtrl::Drop(int i){
+inline void SpeedCtrl::Ack(QueryIDSet qrys){
     double time = global_clock.GetTime();
-    //    for (unsigned int i = 0; i < BITS_PER_WORD; i++) {
-    //        if (qrys.IsMember (i)) {
-    sVec[i].Drop(time);
-    //        }
-    //    }
+    for (unsigned int i = 0; i < sVec.size(); i++) {
+        if (qrys.IsMember (i)) {
+            sVec[i].Ack(time);
+        }
+    }
 }
 
-inline bool SpeedCtrl::CanProduce(int i){
+inline void SpeedCtrl::Drop(QueryIDSet qrys){
     double time = global_clock.GetTime();
-    //    for (unsigned int i = 0; i < BITS_PER_WORD; i++) {
-    //        if (qrys.IsMember (i)) {
-    return sVec[i].CanProduce(time);
-    //        }
-    //    }
-    //    return false;
+    for (unsigned int i = 0; i < sVec.size(); i++) {
+        if (qrys.IsMember (i)) {
+            sVec[i].Drop(time);
+        }
+    }
 }
 
-inline double SpeedCtrl::GetInterval(int i){
-    double time = global_clock.GetTime();
-    //    for (unsigned int i = 0; i < BITS_PER_WORD; i++) {
-    //        if (qrys.IsMember (i)) {
-    return sVec[i].GetInterval();
-    //        }
-    //    }
-    //    return 0;
+inline int SpeedCtrl::Room(QueryIDSet qrys){
+    int room = SPEED_CTRL_MAX_WINDOW;
+    for (unsigned int i = 0; i < sVec.size(); i++) {
+        if (qrys.IsMember (i) && sVec[i].Room() < room) {
+            room = sVec[i].Room();
+        }
+    }
+    return room;
 }
 
-inline     QueryIDSet SpeedCtrl::Produce(QueryIDSet candidate){
+inline QueryIDSet SpeedCtrl::Produce(QueryIDSet candidate){
     double time = global_clock.GetTime();
     QueryIDSet rez;
-    //    for (unsigned int i = 0; i < BITS_PER_WORD; i++) {
-    //        if (candidate.IsMember (i)) {
-    //            if (sVec[i].CanProduce(time)){
-    //                rez.AddMember(i);
-    //            }
-    //        }
-    //    }
+    for (unsigned int i = 0; i < sVec.size(); i++) {
+        if (candidate.IsMember (i) && sVec[i].Room() > 0) {
+            sVec[i].Produce(time);
+            rez.AddMember(i);
+        }
+    }
     return rez;
 }
 
-inline void SpeedQ::Reset(double time){
-    prodInterval = 0.03;
-    lastProduce = time;
-    count = 0;
+inline void SpeedCtrl::Cancel(QueryIDSet qrys){
+    for (unsigned int i = 0; i < sVec.size(); i++) {
+        if (qrys.IsMember (i)) {
+            sVec[i].Cancel();
+        }
+    }
+}
+
+inline bool SpeedCtrl::CanProduce(int i){
+    return sVec[i].Room() > 0;
+}
+
+inline double SpeedCtrl::GetWindow(int i){
+    return sVec[i].GetWindow();
+}
+
+inline void SpeedQ::Reset(void){
+    window = SPEED_CTRL_INITIAL_WINDOW;
+    threshold = SPEED_CTRL_MAX_WINDOW;
+    inFlight.clear();
+    minLatency = 0.0;
+    avgLatency = 0.0;
+}
+
+inline void SpeedQ::Arrived(double time){
+    double latency = time - inFlight.front();
+    inFlight.pop_front();
+
+    if (minLatency == 0.0 || latency < minLatency)
+        minLatency = latency;
+
+    // same smoothing as the round trip time of TCP
+    if (avgLatency == 0.0)
+        avgLatency = latency;
+    else
+        avgLatency += (latency - avgLatency) / 8;
 }
 
 inline void SpeedQ::Ack(double time){
+    // chunk produced before a reset
+    if (inFlight.empty())
+        return;
 
-    if(count == 0 ){
-        lastProduce = time;
-    }
-    else if(count == 1){
-        prodInterval = time - lastProduce;
-    }
-    else {
-        if(prodInterval > 0){
-            double currentInterval = time - lastProduce;
-            prodInterval -= (currentInterval - prodInterval)/count;
-        }
+    Arrived(time);
+
+    if (avgLatency > SPEED_CTRL_LATENCY_FACTOR * minLatency) {
+        // chunks are queuing downstream, back off slowly
+        window -= 1.0 / window;
+        if (window < 1.0)
+            window = 1.0;
+        threshold = window;
+    } else if (window < threshold) {
+        window += 1.0;
+    } else {
+        window += 1.0 / window;
     }
-    count++;
+
+    if (window > SPEED_CTRL_MAX_WINDOW)
+        window = SPEED_CTRL_MAX_WINDOW;
 }
 
 inline void SpeedQ::Drop(double time){
-    prodInterval += prodInterval*0.50;
-    lastProduce = time;
+    if (inFlight.empty())
+        return;
+
+    Arrived(time);
+
+    window /= 2;
+    if (window < 1.0)
+        window = 1.0;
+    threshold = window;
 }
 
-inline double SpeedQ::GetInterval(){
-    return prodInterval;
+inline void SpeedQ::Produce(double time){
+    inFlight.push_back(time);
 }
 
-inline bool SpeedQ::CanProduce(double time){
-    if((time-lastProduce) >= prodInterval){
-        return true;
-    }
-    else{
-        return false;
-    }
+inline void SpeedQ::Cancel(void){
+    if (!inFlight.empty())
+        inFlight.pop_back();
+}
+
+inline int SpeedQ::Room(void){
+    return (int) window - (int) inFlight.size();
+}
+
+inline double SpeedQ::GetWindow(){
+    return window;
+}
+
+inline double SpeedQ::GetLatency(){
+    return avgLatency;
 }
 
 #endif //  _SPEED_CONTROL_H_
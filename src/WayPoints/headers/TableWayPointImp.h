@@ -21,6 +21,7 @@
 #include "ID.h"
 #include "EfficientMap.h"
 #include "DiskPool.h"
+#include "SpeedCtrl.h"
 
 #include <string>
 
@@ -29,6 +30,8 @@ class TableWayPointImp : public WayPointImp {
 
         typedef DiskPool::ClusterRange ClusterRange;
         typedef DiskPool::ClusterRangeList ClusterRangeList;
+        typedef DiskPool::ZoneRange ZoneRange;
+        typedef DiskPool::ZoneRangeList ZoneRangeList;
 
         //id of the FileScanner object
         TableScanID fileId;
@@ -61,6 +64,10 @@ class TableWayPointImp : public WayPointImp {
         // monitor number of token requests out to make sure we are as aggressive as we can
         int numRequestsOut;
 
+        // bounds the chunks in flight for each query. Indexed like
+        // doneQueries, by the bits of qeTranslator
+        SpeedCtrl speedCtrl;
+
         // last chunk we generated to ensure a circular list behavior
         int lastChunkId;
 
@@ -72,9 +79,27 @@ class TableWayPointImp : public WayPointImp {
 
         QueryToScannerRangeList queryClusterRanges;
 
+        // zone maps of the chunks, indexed by chunk then physical column
+        // chunks written since we started have none
+        ZoneRangeList zoneRanges;
+
+        // the ranges of the columns each query can use
+        QueryToColumnRanges queryColumnRanges;
+
+        // the ranges of the join keys pushed up by the joins. Kept for the
+        // query exit that feeds the LHS of the join, the other exits of the
+        // query (the RHS of a self join for instance) need all the chunks
+        std::map<QueryExit, ColumnToScannerRange> exitColumnRanges;
+
+        // physical column of each slot we produce, so that the key ranges
+        // pushed up by the joins can be turned into column ranges
+        std::map<int, int64_t> slotsToColumns;
+
         /// AUXILIARY FUNCTIONS
         // look for queries that can tag chunk _chunkId
         Bitstring FindQueries(off_t _chunkId);
+        // the queries (bits of qeTranslator) we still produce chunks for
+        Bitstring ActiveQueries(void);
         // funtion to keep a constant suply of write tokens so we can do agressive IO
         void GenerateTokenRequests();
         // function to find a chunk that needs to be generated
@@ -83,6 +108,13 @@ class TableWayPointImp : public WayPointImp {
 
         void AcknowledgeChunk(int chunkID, QueryIDSet queries);
 
+        // can the chunk contain tuples for the query exit (a bit of
+        // qeTranslator) according to the zone maps?
+        bool ChunkMatchesZones(off_t _chunkId, Bitstring exitBit);
+
+        // restricts the column ranges of a query exit with the range of a join key
+        void AddJoinKeyRange(QueryExit& exit, int keySlot, ScannerRange keyRange);
+
 
     public:
 
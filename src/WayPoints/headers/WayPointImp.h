@@ -274,6 +274,9 @@ protected:
     // Helper method to send a start producing message for a query exit
     void SendStartProducingMsg( QueryExit whichOne );
 
+    // Helper method to send the range of a join key upstream along a query exit
+    void SendJoinKeyRangeMsg( QueryExit whichOne, int keySlot, JoinKeyRange keyRange );
+
     // Helper method that sets the number of particular kind of work token that
     // is desired by the waypoint. This will determine how many tokens of each
     // type that the waypoint will attempt to acquire when GenerateTokenRequests
@@ -0,0 +1,195 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#include "GIFileRange.h"
+#include "CharScan.h"
+#include "Errors.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+GIFileRange :: GIFileRange (const std::string& file, off_t _begin, off_t _end) :
+    file_name(file),
+    begin(_begin),
+    end(_end),
+    fd(-1),
+    file_size(0),
+    read_pos(0),
+    stop_pos(-1),
+    started(false),
+    buffer(NULL),
+    capacity(BUFFER_SIZE)
+{
+    FATALIF (begin < 0 || end <= begin, "Invalid range [%jd, %jd) of file %s",
+        (intmax_t) begin, (intmax_t) end, file.c_str());
+}
+
+void GIFileRange :: Start () {
+    started = true;
+
+    fd = open (file_name.c_str(), O_RDONLY);
+    struct stat fileStat;
+    if (fd < 0 || fstat (fd, &fileStat) != 0) {
+        LOG_ENTRY_P(1, "Failed to open file %s", file_name.c_str());
+        stop_pos = 0;
+        return;
+    }
+    file_size = fileStat.st_size;
+
+    buffer = new char[capacity + 1];
+    setg (buffer, buffer, buffer);
+
+    if (end >= file_size)
+        stop_pos = file_size;
+
+    if (begin == 0)
+        return;
+
+    // the record that contains byte begin - 1 belongs to the previous range
+    read_pos = begin - 1;
+    while (Fill ()) {
+        char* newline = FindChar (gptr(), egptr(), '\n');
+        if (newline != egptr()) {
+            setg (buffer, newline + 1, egptr());
+            return;
+        }
+
+        setg (buffer, egptr(), egptr());
+    }
+}
+
+bool GIFileRange :: Fill () {
+    if (fd < 0)
+        return false;
+
+    size_t left = egptr() - gptr();
+    off_t limit = stop_pos >= 0 ? stop_pos : file_size;
+    if (read_pos >= limit)
+        return false;
+
+    if (left == capacity) {
+        // the record does not fit in the buffer
+        char* bigger = new char[2 * capacity + 1];
+        memcpy (bigger, gptr(), left);
+        delete [] buffer;
+        buffer = bigger;
+        capacity *= 2;
+    } else {
+        memmove (buffer, gptr(), left);
+    }
+
+    char* fillFrom = buffer + left;
+    size_t toRead = std::min ((off_t) (capacity - left), limit - read_pos);
+
+    ssize_t got;
+    do {
+        got = pread (fd, fillFrom, toRead, read_pos);
+    } while (got < 0 && errno == EINTR);
+
+    if (got <= 0) {
+        // the file got shorter under us
+        WARNINGIF (got < 0, "Error reading file %s: %s", file_name.c_str(), strerror (errno));
+        stop_pos = read_pos;
+        setg (buffer, buffer, fillFrom);
+        return false;
+    }
+
+    off_t fillPos = read_pos;
+    read_pos += got;
+    size_t valid = got;
+
+    if (stop_pos < 0) {
+        // the range ends with the record that contains byte end - 1
+        off_t searchPos = std::max (fillPos, end - 1);
+        if (searchPos < read_pos) {
+            char* newline = FindChar (fillFrom + (searchPos - fillPos), fillFrom + got, '\n');
+            if (newline != fillFrom + got) {
+                valid = newline + 1 - fillFrom;
+                stop_pos = fillPos + valid;
+                read_pos = stop_pos;
+            }
+        }
+
+        if (stop_pos < 0 && read_pos >= file_size)
+            stop_pos = file_size;
+    }
+
+    setg (buffer, buffer, fillFrom + valid);
+    return true;
+}
+
+GIFileRange :: int_type GIFileRange :: underflow () {
+    if (!started)
+        Start ();
+
+    if (gptr() == egptr() && !Fill ())
+        return traits_type::eof();
+
+    return traits_type::to_int_type (*gptr());
+}
+
+bool GIFileRange :: NextRecord (char*& record, size_t& length) {
+    if (!started)
+        Start ();
+
+    // part of the buffer already known not to contain a new line
+    size_t searched = 0;
+    while (true) {
+        char* newline = FindChar (gptr() + searched, egptr(), '\n');
+        if (newline != egptr()) {
+            record = gptr();
+            length = newline - gptr();
+            *newline = '\0';
+            setg (eback(), newline + 1, egptr());
+            return true;
+        }
+
+        searched = egptr() - gptr();
+        if (!Fill ())
+            break;
+    }
+
+    if (gptr() == egptr())
+        return false;
+
+    // last record of the file, without a new line
+    record = gptr();
+    length = egptr() - gptr();
+    *egptr() = '\0';
+    setg (eback(), egptr(), egptr());
+    return true;
+}
+
+void GIFileRange :: ToEndOfFile () {
+    FATALIF (started, "Extending the range of file %s after reading it", file_name.c_str());
+    end = std::numeric_limits<off_t>::max();
+}
+
+bool GIFileRange :: Done () const {
+    return started && gptr() == egptr() && stop_pos >= 0 && read_pos >= stop_pos;
+}
+
+GIFileRange :: ~GIFileRange () {
+    if (fd >= 0)
+        close (fd);
+
+    delete [] buffer;
+}
@@ -23,14 +23,12 @@
 #include "Logging.h"
 #include "Swap.h"
 #include "Stl.h"
+#include "QueryExit.h"
 
-// TEMPORARY
-#include "Timer.h"
+#include <sys/stat.h>
 
 using namespace std;
 
-const double GIWayPointImp::CACHE_INTERVAL = 0.2;
-
 GIWayPointImp :: GIWayPointImp () :
     WayPointImp(),
     open_streams(),
@@ -42,7 +40,8 @@ GIWayPointImp :: GIWayPointImp () :
     next_chunk_no(0),
     tokensRequested(0),
     tID(),
-    last_cache_send(0.0),
+    myQueries(),
+    speedCtrl(),
     chunkMap(),
     chunkCache()
 {
@@ -52,9 +51,6 @@ GIWayPointImp :: GIWayPointImp () :
     num_open_streams = 0;
     num_chunks_out = 0;
     next_chunk_no = 0;
-
-    // TEMPORARY
-    last_cache_send = 0.0;
 }
 
 GIWayPointImp :: ~GIWayPointImp () {
@@ -76,6 +72,12 @@ void GIWayPointImp :: RequestTokens(){
 
     FATALIF (noReq < 0, "GI somehow attempting to request a negative number of tokens.");
 
+    // no more than the chunks the speed control lets out, the acks and
+    // drops bring us back here
+    int room = speedCtrl.Room(myQueries) - (int) tokensRequested;
+    if (noReq > room)
+        noReq = room < 0 ? 0 : room;
+
     // is that too many?
     //WARNINGIF(noReq > dblBuf, "Too many request: %d\n", noReq);
 
@@ -94,6 +96,7 @@ void GIWayPointImp :: SendCachedChunk( CachedChunk& chunk ) {
     ChunkContainer &chunkCont = chunk.get_myChunk();
 
     num_chunks_in_flight++;
+    speedCtrl.Produce(QueryExitsToQueries(whichOnes));
 
     // Send the message
     SendHoppingDataMsg( whichOnes, lineage, chunkCont );
@@ -107,6 +110,8 @@ void GIWayPointImp :: TypeSpecificConfigure( WayPointConfigureData &configData )
 
     // Store query exits
     myExits.swap(tempConfig.get_queries());
+    myQueries = QueryExitsToQueries(myExits);
+    speedCtrl.Reset();
 
     // Invent a tID for ourselves.
     TableScanID newID(this->GetName().c_str());
@@ -119,23 +124,48 @@ void GIWayPointImp :: SetUpStreams() {
     // For each string in the input, create a new task
     off_t stream_id = 0;
     FOREACH_STL(file, my_files) {
-        off_t my_stream_id = stream_id++;
-        GIStreamInfo nInfo( file, my_stream_id );
-        GLAState nState;
-
-        GIStreamProxy sProxy = nInfo.get_proxy();
-        GITask nTask( sProxy, nState );
-        tasks.Append(nTask);
-        ++num_open_streams;
+        // Regular files are read with pread in ranges of GI_SPLIT_BYTES,
+        // anything else (pipes, devices) as a stream.
+        struct stat fileStat;
+        bool isRegular = stat( file.c_str(), &fileStat ) == 0 && S_ISREG(fileStat.st_mode);
+        off_t fileSize = isRegular ? fileStat.st_size : 0;
+        off_t rangeSize = GI_SPLIT_BYTES > 0 ? GI_SPLIT_BYTES : fileSize;
+
+        if( !isRegular || fileSize == 0 ) {
+            AddStream( file, stream_id++, -1, -1 );
+        } else {
+            for( off_t begin = 0; begin < fileSize; begin += rangeSize ) {
+                off_t end = begin + rangeSize < fileSize ? begin + rangeSize : fileSize;
+                AddStream( file, stream_id++, begin, end );
+            }
+        }
 
         LOG_ENTRY_P(1, "GI Stated for File %s", file.c_str());
-
-        // Add stream to mapping
-        StreamKey key(my_stream_id);
-        open_streams.Insert(key, nInfo);
     } END_FOREACH;
 }
 
+void GIWayPointImp :: AddStream( const std::string& file, off_t stream_id, off_t begin, off_t end ) {
+    GIStreamInfo nInfo;
+    if( begin < 0 ) {
+        GIStreamInfo fileInfo( file, stream_id );
+        nInfo.swap(fileInfo);
+    } else {
+        GIStreamInfo rangeInfo( file, stream_id, begin, end );
+        nInfo.swap(rangeInfo);
+    }
+
+    GLAState nState;
+
+    GIStreamProxy sProxy = nInfo.get_proxy();
+    GITask nTask( sProxy, nState );
+    tasks.Append(nTask);
+    ++num_open_streams;
+
+    // Add stream to mapping
+    StreamKey key(stream_id);
+    open_streams.Insert(key, nInfo);
+}
+
 void GIWayPointImp :: RequestGranted( GenericWorkToken &returnVal ) {
     PDEBUG("GIWayPointImp :: RequestGranted()");
 
@@ -145,17 +175,16 @@ void GIWayPointImp :: RequestGranted( GenericWorkToken &returnVal ) {
     --tokensRequested;
 
     // If we have chunks cached, serve those first and return the token.
+    // The drops that filled the cache shrank the window, the chunks go
+    // out again as the acks make room for them
     if( chunkCache.Length() > 0 ) {
-        double curTime = global_clock.GetTime();
-
-        if( curTime > last_cache_send + CACHE_INTERVAL ) {
+        if( speedCtrl.Room(myQueries) > 0 ) {
             CachedChunk myChunk;
             chunkCache.MoveToStart();
             chunkCache.Remove( myChunk );
 
             // Send cached chunk
             SendCachedChunk( myChunk );
-            last_cache_send = curTime;
         }
 
         GiveBackToken( myToken );
@@ -169,6 +198,12 @@ void GIWayPointImp :: RequestGranted( GenericWorkToken &returnVal ) {
         return;
     }
 
+    // Drops may have shrunk the window since we asked for the token
+    if( speedCtrl.Room(myQueries) <= 0 ) {
+        GiveBackToken( myToken );
+        return;
+    }
+
     // Do we even have some work to do?
     // We *should* always have some work at this point.
     FATALIF( tasks.Length() == 0, "GI got a token but had no work to do!" );
@@ -192,6 +227,9 @@ void GIWayPointImp :: RequestGranted( GenericWorkToken &returnVal ) {
     HistoryList tempList;
     tempList.Insert( myHistory );
 
+    // the chunk is in flight from now on
+    speedCtrl.Produce( queriesCovered );
+
     // Set up the work description
     GIProduceChunkWD workDesc( task.get_gi(), task.get_stream(), queriesCovered );
 
@@ -205,6 +243,10 @@ void GIWayPointImp :: RequestGranted( GenericWorkToken &returnVal ) {
 void GIWayPointImp :: ProcessHoppingUpstreamMsg( HoppingUpstreamMsg &message ) {
     PDEBUG("GIWayPointImp :: ProcessHoppingUpstreamMsg()");
 
+    // we cannot skip anything based on the key ranges of the joins
+    if( CHECK_DATA_TYPE(message.get_msg(), JoinKeyRangeMsg) )
+        return;
+
     CONVERT_SWAP(message.get_msg(), myMessage, StartProducingMsg);
 
     FATALIF(!tasks.IsEmpty(), "GIWP got start producing message with streams still open!");
@@ -225,6 +267,7 @@ void GIWayPointImp :: ProcessDropMsg( QueryExitContainer &whichExits, HistoryLis
     PROFILING2_INSTANT("chn", 1, GetName());
 
     num_chunks_in_flight--;
+    speedCtrl.Drop( QueryExitsToQueries(whichExits) );
 
     // Get chunk from mapping
     EXTRACT_HISTORY_ONLY( lineage, myHistory, GIHistory );
@@ -256,6 +299,27 @@ void GIWayPointImp :: DoneProducing( QueryExitContainer &whichOnes, HistoryList
     GIProduceChunkRez tempResult;
     tempResult.swap(data);
 
+    if( result == 2 ) {
+        // The GI cannot read a range of a split file. Nothing was produced.
+        speedCtrl.Cancel( myQueries );
+        GIStreamProxy& stream = tempResult.get_stream();
+        RemoveStream( stream );
+
+        if( num_chunks_out == 0 && num_open_streams == 0 ) {
+            QueryExitContainer allComplete;
+            allComplete.copy( myExits );
+
+            LOG_ENTRY_P(2, "GI %s finished processing ALL files.", GetName().c_str());
+            DictionaryManager::Flush();
+
+            SendQueryDoneMsg( allComplete );
+        } else {
+            RequestTokens();
+        }
+
+        return;
+    }
+
     // For the chunk that goes out
     ChunkContainer &chkCont = tempResult.get_chunk();
 
@@ -279,25 +343,32 @@ void GIWayPointImp :: DoneProducing( QueryExitContainer &whichOnes, HistoryList
 
     if( result == 1 ) {
         // Done processing this file
-        num_open_streams--;
-
-        // Remove this stream from the mapping.
-        off_t id_no = stream.get_id();
-        StreamKey id_no_key(id_no);
-        StreamKey key;
-        GIStreamInfo sInfo;
-        open_streams.Remove(id_no_key, key, sInfo);
+        RemoveStream( stream );
 
         LOG_ENTRY_P(2, "GI %s finished processing file %s.", GetName().c_str(), stream.get_file_name().c_str());
     } else {
-        // Repackage the GI and stream into a task and add it to the list
+        // Repackage the GI and stream into a task and put it in front of the
+        // list, so the streams that were started are finished first and the
+        // ranges of large files are not all open at once.
         GITask nTask(stream, gi);
-        tasks.Append(nTask);
+        tasks.MoveToStart();
+        tasks.Insert(nTask);
     }
 
     RequestTokens();
 }
 
+void GIWayPointImp :: RemoveStream( GIStreamProxy& stream ) {
+    num_open_streams--;
+
+    // Remove this stream from the mapping.
+    off_t id_no = stream.get_id();
+    StreamKey id_no_key(id_no);
+    StreamKey key;
+    GIStreamInfo sInfo;
+    open_streams.Remove(id_no_key, key, sInfo);
+}
+
 void GIWayPointImp :: ProcessAckMsg( QueryExitContainer &whichExits, HistoryList &lineage ) {
     PDEBUG("GIWayPointImp :: ProcessAckMsg()");
 
@@ -308,6 +379,7 @@ void GIWayPointImp :: ProcessAckMsg( QueryExitContainer &whichExits, HistoryList
 
     num_chunks_out--; // one less chunk un-acked
     num_chunks_in_flight--;
+    speedCtrl.Ack( QueryExitsToQueries(whichExits) );
 
     // Remove chunk from mapping
     ChunkID cID = myHistory.get_whichChunk();
@@ -30,11 +30,13 @@ GLAWayPointImp :: GLAWayPointImp ():
     queryFragmentMap(),
     fragmentsLeft(),
     mergeInProgress(),
+    nextPartition(),
     lastFragmentId(0),
     resultIsState(),
     queriesToPreprocess(),
     queriesProcessing(),
     queriesMerging(),
+    queriesPartitionMerging(),
     queriesCounting(),
     queriesToPostFinalize(),
     queriesFinalizing(),
@@ -115,8 +117,82 @@ bool GLAWayPointImp::PreProcessingPossible( CPUWorkToken& token ) {
 }
 
 
+bool GLAWayPointImp::PartitionMergePossible( CPUWorkToken& token ) {
+    PDEBUG ("GLAWayPointImp :: PartitionMergePossible()");
+
+    QueryIDSet iter = queriesPartitionMerging;
+    while( !iter.IsEmpty() ) {
+        QueryID q = iter.GetFirst();
+        int& nextPart = nextPartition.Find(q).GetData();
+        int& mCount = mergeInProgress.Find(q).GetData();
+
+        int partition;
+        if( nextPart < GLA_MERGE_PARTITIONS ) {
+            partition = nextPart;
+        } else if( nextPart == GLA_MERGE_PARTITIONS && mCount == 0 ) {
+            // all partitions merged, finish the states
+            partition = -1;
+        } else {
+            // wait for the partitions in flight
+            continue;
+        }
+        nextPart++;
+        mCount++;
+
+        FATALIF(!myQueryToGLAStates.IsThere(q), "Why I am having a query to merge but no GLA state container?");
+        GLAStateContainer& cont = myQueryToGLAStates.Find(q);
+
+        GLAStateContainer tempCont;
+        if( partition >= 0 ) {
+            // all the partition jobs work on the same states, they stay here
+            FOREACH_TWL(st, cont) {
+                GLAState stateCopy;
+                stateCopy.copy(st);
+                tempCont.Append(stateCopy);
+            } END_FOREACH;
+        } else {
+            tempCont.swap(cont);
+        }
+
+        QueryToGLASContMap stateM;
+        QueryID key = q;
+        stateM.Insert(key, tempCont);
+
+        QueryIDToInt partM;
+        key = q;
+        Swapify<int> val(partition);
+        partM.Insert(key, val);
+
+        QueryExitContainer whichOnes;
+        QueryExit qe = GetExit(q);
+        whichOnes.Insert(qe);
+
+        QueryExitContainer whichOnes1;
+        whichOnes1.copy (whichOnes);
+
+        //dummy fragmentNo for merge
+        GLAHistory hist (GetID (), -1);
+        HistoryList lineage;
+        lineage.Insert(hist);
+
+        GLAMergeStatesWD workDesc (whichOnes1, stateM, partM);
+
+        WayPointID myID = GetID();
+        WorkFunc myFunc = GetWorkFunction( GLAMergeStatesWorkFunc :: type );
+
+        myCPUWorkers.DoSomeWork( myID, lineage, whichOnes, token, workDesc, myFunc );
+
+        return true;
+    }
+
+    return false;
+}
+
 bool GLAWayPointImp::PostProcessingPossible( CPUWorkToken& token ) {
     PDEBUG ("GLAWayPointImp :: PostProcessingPossible()");
+    if( PartitionMergePossible(token) )
+        return true;
+
     if( queriesMerging.IsEmpty() )
         return false;
 
@@ -176,7 +252,8 @@ bool GLAWayPointImp::PostProcessingPossible( CPUWorkToken& token ) {
         lineage.Insert(hist);
 
         // now, actually get the work done!
-        GLAMergeStatesWD workDesc (whichOnes1, stateM);
+        QueryIDToInt noPartitions;
+        GLAMergeStatesWD workDesc (whichOnes1, stateM, noPartitions);
 
         WayPointID myID = GetID();
         WorkFunc myFunc = GetWorkFunction( GLAMergeStatesWorkFunc :: type );
@@ -356,6 +433,7 @@ bool GLAWayPointImp :: PreProcessingComplete( QueryExitContainer& whichOnes, His
     QueryIDSet& produceIntermediates = temp.get_produceIntermediates();
 
     queriesProducingIntermediates.Union(produceIntermediates);
+    queriesPartitioned.Union(temp.get_partitionedMerge());
 
     AddConstStates( rezConstStates );
 
@@ -397,6 +475,31 @@ bool GLAWayPointImp :: PostProcessingComplete( QueryExitContainer& whichOnes, Hi
     rez.swap(data);
 
     QueryToGLAStateMap& tempGlaStates = rez.get_glaStates();
+
+    // Partitioned merges. Only the finishing job gives back a state
+    FOREACH_TWL(qe, whichOnes) {
+        QueryID q = qe.query;
+        if( q.Overlaps(queriesPartitionMerging) ) {
+            int& mCount = mergeInProgress.Find(q).GetData();
+            mCount--;
+
+            if( tempGlaStates.IsThere(q) ) {
+                FATALIF(mCount != 0, "Finished the partitioned merge with partitions in flight");
+                QueryID foo;
+                GLAState mystate;
+                tempGlaStates.Remove(q, foo, mystate);
+                mergedStates.Insert(foo, mystate);
+
+                QueryID key;
+                Swapify<int> val;
+                nextPartition.Remove(q, key, val);
+
+                queriesPartitionMerging.Difference(q);
+                queriesCounting.Union(q);
+            }
+        }
+    } END_FOREACH;
+
     for(tempGlaStates.MoveToStart(); !tempGlaStates.AtEnd();){
         QueryID q = tempGlaStates.CurrentKey();
         int& mCount = mergeInProgress.Find(q).GetData();
@@ -529,6 +632,8 @@ void GLAWayPointImp :: GotAllStates( QueryID query ) {
 
 bool GLAWayPointImp :: ReceivedQueryDoneMsg( QueryExitContainer& whichOnes ) {
     PDEBUG ("GLAWayPointImp :: ReceivedQueryDoneMsg()");
+    // number of merge jobs that can run in parallel right away
+    int mergeJobs = 0;
     // extract the queries that are done, add them to the list of those to complete
     FOREACH_TWL( myExit, whichOnes ) {
         QueryID currentID = myExit.query;
@@ -550,9 +655,21 @@ bool GLAWayPointImp :: ReceivedQueryDoneMsg( QueryExitContainer& whichOnes ) {
         GLAStateContainer& myStates = myQueryToGLAStates.Find(qID);
         myStates.MoveToStart();
 
-        if( myStates.Length() > 1 ) {
+        if( myStates.Length() > 1 && qID.Overlaps(queriesPartitioned) ) {
+            // Each partition of all the states is merged by a different job
+            queriesPartitionMerging.Union(qID);
+
+            QueryID key = qID;
+            Swapify<int> first(0);
+            nextPartition.Insert(key, first);
+
+            mergeJobs += GLA_MERGE_PARTITIONS;
+        }
+        else if( myStates.Length() > 1 ) {
             // More than one state, merge them
             queriesMerging.Union(qID);
+
+            mergeJobs += myStates.Length() / 2;
         }
         else if( myStates.Length() == 1 ){
             // Only one state, skip to pre-finalize.
@@ -573,8 +690,17 @@ bool GLAWayPointImp :: ReceivedQueryDoneMsg( QueryExitContainer& whichOnes ) {
         }
     } END_FOREACH;
 
+    // The pairs of states are merged as a tree (the merged state goes to the
+    // back of the list) so all the pairs of a level can be merged at the same
+    // time. Ask for enough tokens to do so instead of waiting for the ramp up.
+    int curReqs = GetTokensRequested(CPUWorkToken::type);
+    int toReq = std::min(NUM_EXEC_ENGINE_THREADS / 2, mergeJobs);
+    if (toReq > curReqs) {
+        SetTokensRequested(CPUWorkToken::type, toReq);
+    }
+
     // ask for a worker, if we have not already asked
-    if (!queriesCounting.IsEmpty() || !queriesMerging.IsEmpty() )
+    if (!queriesCounting.IsEmpty() || !queriesMerging.IsEmpty() || !queriesPartitionMerging.IsEmpty() )
         return true;
     else
         return false;
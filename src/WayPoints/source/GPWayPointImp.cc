@@ -424,6 +424,9 @@ void GPWayPointImp :: ProcessHoppingUpstreamMsg( HoppingUpstreamMsg& message) {
 
         retVal = ReceivedStartProducingMsg( message, whichOne );
     }
+    else if( CHECK_DATA_TYPE( message.get_msg(), JoinKeyRangeMsg) ) {
+        ReceivedJoinKeyRangeMsg( message );
+    }
     else {
         SendHoppingUpstreamMsg( message );
     }
@@ -439,6 +442,10 @@ bool GPWayPointImp :: ReceivedStartProducingMsg(HoppingUpstreamMsg& message, Que
     return false;
 }
 
+void GPWayPointImp :: ReceivedJoinKeyRangeMsg(HoppingUpstreamMsg& message ) {
+    // Default behavior: our inputs are not what the join sees, drop it.
+}
+
 void GPWayPointImp :: GotState( StateContainer& state ) {
     PDEBUG("GPWayPointImp :: GotState()");
     // Extract information from the state container.
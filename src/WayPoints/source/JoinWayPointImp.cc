@@ -19,6 +19,8 @@
 #include "HashTableCleanerWayPointImp.h"
 #include "Properties.h"
 
+#include <algorithm>
+
 using namespace std;
 
 JoinWayPointImp :: JoinWayPointImp () :
@@ -30,6 +32,9 @@ JoinWayPointImp :: JoinWayPointImp () :
     waitingOnRHS(),
     centralHashTable(),
     hashTableReady(false),
+    joinFilter(),
+    keySlot(-1),
+    keyRanges(),
     hashTableCleaner()
 {
     PDEBUG ("JoinWayPointImp :: JoinWayPointImp ()");
@@ -110,6 +115,9 @@ void JoinWayPointImp :: TypeSpecificConfigure (WayPointConfigureData &configData
         QueryExit tempExit = endingOnes.Current (), tempExitCopy = endingOnes.Current ();
         WayPointID myID = GetID (), myIDCopy = GetID ();
 
+        // query IDs get recycled, forget the key range of the old query
+        keyRanges.erase (tempExit.query);
+
         // create the actual notification first
         if( hashTableReady ) {
             SendStartProducingMsg(tempExit);
@@ -126,6 +134,11 @@ void JoinWayPointImp :: TypeSpecificConfigure (WayPointConfigureData &configData
     // remember the identifier for the hash tbale cleaner
     hashTableCleaner = tempConfig.get_hashTableCleaner ();
 
+#if JOIN_RUNTIME_FILTERS
+    if (!joinFilter.IsAllocated ())
+        joinFilter.Allocate ();
+#endif
+
     // set our special join waypoint ID
     WayPointID myID = GetID ();
     myJoinWayPointID = HashTableCleanerWayPointImp :: metaData.NewJoinWaypoint (
@@ -229,6 +242,7 @@ void JoinWayPointImp :: ProcessHoppingDownstreamMsg (HoppingDownstreamMsg &messa
                             whereTo.Print ();
                             cout << " to start in response to a RHS finish.\n";
                             cout << "\n";
+                            SendKeyRange (whereTo);
                             HoppingUpstreamMsg newMsg (curPos, whereTo, startMsg);
                             SendHoppingUpstreamMsg (newMsg);
 
@@ -255,6 +269,7 @@ void JoinWayPointImp :: ProcessHoppingDownstreamMsg (HoppingDownstreamMsg &messa
                     QueryExit tempExit;
                     tempExit.exit = GetID ();
                     tempExit.query = temp.get_whichOnes ().Current ().query;
+                    keyRanges.erase (tempExit.query);
                     cout << "Sending ";
                     tempExit.Print ();
                     cout << "\n";
@@ -277,6 +292,15 @@ void JoinWayPointImp :: ProcessHoppingDownstreamMsg (HoppingDownstreamMsg &messa
 
             }
 
+            // if nothing runs through us anymore, the hashes in the join filter are all
+            // stale. Start over with an empty one
+            stillGoing.MoveToStart ();
+            if (!stillGoing.RightLength () && joinFilter.IsAllocated ()) {
+                JoinFilter emptyFilter;
+                emptyFilter.Allocate ();
+                joinFilter.swap (emptyFilter);
+            }
+
             // lastly, send out a query done message to all of the people down the graph
             temp.swap (message.get_msg ());
             SendHoppingDownstreamMsg (message);
@@ -326,6 +350,21 @@ void JoinWayPointImp :: DoneProducing (QueryExitContainer &whichOnes, HistoryLis
         // and then take a look and see if we got back any over-full segments
         JoinHashResult temp;
         temp.swap (message);
+
+        // merge the key ranges of the chunk into the ones of the queries
+        if (temp.get_keySlot () >= 0) {
+            keySlot = temp.get_keySlot ();
+            QueryToJoinKeyRange &chunkRanges = temp.get_keyRanges ();
+            for (QueryToJoinKeyRange::iterator it = chunkRanges.begin (); it != chunkRanges.end (); it++) {
+                QueryToJoinKeyRange::iterator cur = keyRanges.find (it->first);
+                if (cur == keyRanges.end ()) {
+                    keyRanges[it->first] = it->second;
+                } else {
+                    cur->second.first = std::min (cur->second.first, it->second.first);
+                    cur->second.second = std::max (cur->second.second, it->second.second);
+                }
+            }
+        }
         temp.get_sampledQueries ().MoveToStart ();
         if (temp.get_sampledQueries ().RightLength ()) {
 
@@ -418,7 +457,9 @@ void JoinWayPointImp :: ProcessHoppingDataMsg (HoppingDataMsg &data) {
             // clone our copy of the central hash table
             HashTable tempTable;
             tempTable.Clone (centralHashTable);
-            JoinLHSWorkDescription workDesc (myJoinWayPointID, whichOnes, temp.get_myChunk (), tempTable);
+            JoinFilter tempFilter;
+            tempFilter.Clone (joinFilter);
+            JoinLHSWorkDescription workDesc (myJoinWayPointID, whichOnes, temp.get_myChunk (), tempTable, tempFilter);
 
             // and get the work done!
             WayPointID myID;
@@ -486,7 +527,9 @@ void JoinWayPointImp :: ProcessHoppingDataMsg (HoppingDataMsg &data) {
         // clone our copy of the central hash table
         HashTable tempTable;
         tempTable.Clone (centralHashTable);
-        JoinRHSWorkDescription workDesc (myJoinWayPointID, whichOnes, temp.get_myChunk (), tempTable);
+        JoinFilter tempFilter;
+        tempFilter.Clone (joinFilter);
+        JoinRHSWorkDescription workDesc (myJoinWayPointID, whichOnes, temp.get_myChunk (), tempTable, tempFilter);
 
         // and get the work done!
         WayPointID myID;
@@ -546,6 +589,9 @@ void JoinWayPointImp :: ProcessHoppingUpstreamMsg (HoppingUpstreamMsg &message)
     // start up the query even if we have not finished the LHS)
     if (forwardItOn || state != FINE) {
 
+        if (state == FINE)
+            SendKeyRange (queryToStart);
+
         // put myMessage back in message
         myMessage.swap (message.get_msg ());
 
@@ -564,3 +610,14 @@ void JoinWayPointImp :: ProcessHoppingUpstreamMsg (HoppingUpstreamMsg &message)
     PDEBUG ("JoinWayPointImp :: ProcessHoppingUpstreamMsg - finished ()");
 }
 
+void JoinWayPointImp :: SendKeyRange (QueryExit &whereTo) {
+    PDEBUG ("JoinWayPointImp :: SendKeyRange ()");
+
+    if (keySlot < 0 || !JOIN_RUNTIME_FILTERS)
+        return;
+
+    // the message hops along the LHS of the query, in front of the start producing one
+    QueryToJoinKeyRange::iterator it = keyRanges.find (whereTo.query);
+    if (it != keyRanges.end ())
+        SendJoinKeyRangeMsg (whereTo, keySlot, it->second);
+}
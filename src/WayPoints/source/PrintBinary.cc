@@ -0,0 +1,102 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#include "PrintBinary.h"
+
+using namespace std;
+
+const char PrintBinaryBatch::MAGIC[8] = { 'G', 'R', 'K', 'C', 'O', 'L', '0', '1' };
+
+namespace {
+    inline uint64_t Padded(uint64_t length) {
+        return (length + 7) & ~((uint64_t) 7);
+    }
+
+    template<class T>
+    inline void Put(vector<char>& out, T value) {
+        const char* bytes = (const char*) &value;
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    inline void PutPadding(vector<char>& out) {
+        out.resize(Padded(out.size()), '\0');
+    }
+}
+
+PrintBinaryBatch::PrintBinaryBatch(initializer_list<uint32_t> valueSizes):
+    columns(valueSizes.size()),
+    numRows(0)
+{
+    int col = 0;
+    for (uint32_t size : valueSizes) {
+        columns[col].valueSize = size;
+        if (size == 0)
+            columns[col].offsets.push_back(0);
+        col++;
+    }
+}
+
+bool PrintBinaryBatch::Write(FILE* file) {
+    if (numRows == 0)
+        return true;
+
+    uint64_t bodyLength = 2 * sizeof(uint64_t);
+    for (Column& column : columns) {
+        uint64_t length = column.data.size() + column.offsets.size() * sizeof(uint64_t);
+        bodyLength += 2 * sizeof(uint64_t) + Padded(length);
+    }
+
+    vector<char> out;
+    out.reserve(2 * sizeof(uint64_t) + bodyLength);
+
+    Put<uint32_t>(out, MARKER);
+    Put<uint32_t>(out, BATCH);
+    Put<uint64_t>(out, bodyLength);
+
+    Put<uint64_t>(out, numRows);
+    Put<uint32_t>(out, columns.size());
+    Put<uint32_t>(out, 0);
+
+    for (Column& column : columns) {
+        uint64_t offsetsLength = column.offsets.size() * sizeof(uint64_t);
+        Put<uint32_t>(out, column.valueSize);
+        Put<uint32_t>(out, 0);
+        Put<uint64_t>(out, Padded(offsetsLength + column.data.size()));
+
+        const char* offsets = (const char*) column.offsets.data();
+        out.insert(out.end(), offsets, offsets + offsetsLength);
+        out.insert(out.end(), column.data.begin(), column.data.end());
+        PutPadding(out);
+
+        column.data.clear();
+        if (column.valueSize == 0)
+            column.offsets.resize(1);
+    }
+    numRows = 0;
+
+    // a single write, stdio keeps the writes of the threads apart
+    return fwrite(out.data(), 1, out.size(), file) == out.size();
+}
+
+bool PrintBinaryBatch::WriteMessage(FILE* file, MessageKind kind, const string& body) {
+    vector<char> out;
+    Put<uint32_t>(out, MARKER);
+    Put<uint32_t>(out, kind);
+    Put<uint64_t>(out, Padded(body.size()));
+    out.insert(out.end(), body.begin(), body.end());
+    PutPadding(out);
+
+    return fwrite(out.data(), 1, out.size(), file) == out.size();
+}
@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "PrintWayPointImp.h"
+#include "PrintBinary.h"
 #include "CPUWorkerPool.h"
 #include "EEExternMessages.h"
 #include "EventProcessor.h"
@@ -97,6 +98,25 @@ namespace {
         fprintf(file, "\n");
     }
 
+    void BeginBinary( FILE * file, PrintFileInfo & info ) {
+        PrintHeader & header = info.get_header();
+
+        Json::Value hVal;
+        header.toJson(hVal);
+
+        Json::FastWriter writer;
+        std::string hStr = writer.write(hVal);
+
+        fwrite(PrintBinaryBatch::MAGIC, 1, sizeof(PrintBinaryBatch::MAGIC), file);
+        PrintBinaryBatch::WriteMessage(file, PrintBinaryBatch::HEADER, hStr);
+    }
+
+    void EndBinary( PrintFileObj & info ) {
+        FILE * file = info.get_file();
+
+        PrintBinaryBatch::WriteMessage(file, PrintBinaryBatch::END, std::string());
+    }
+
     FILE * BeginFile( PrintFileInfo & info ) {
         string& fName = info.get_file();
         string& fType = info.get_type();
@@ -114,6 +134,9 @@ namespace {
         else if( fType == "json" ) {
             BeginJSON( str, info );
         }
+        else if( fType == "binary" ) {
+            BeginBinary( str, info );
+        }
         else {
             FATAL("File %s has unknown type %s in Print", fName.c_str(), fType.c_str());
         }
@@ -128,6 +151,8 @@ namespace {
             EndCSV( info );
         } else if( fType == "json" ) {
             EndJSON( info );
+        } else if( fType == "binary" ) {
+            EndBinary( info );
         } else {
             FATAL("File has unknown type %s in Print", fType.c_str());
         }
@@ -48,6 +48,25 @@ bool SelectionWayPointImp :: ReceivedStartProducingMsg( HoppingUpstreamMsg& mess
     return true;
 }
 
+void SelectionWayPointImp :: ReceivedJoinKeyRangeMsg( HoppingUpstreamMsg& message ) {
+    PDEBUG( "SelectionWayPointImp :: ReceivedJoinKeyRangeMsg ()" );
+
+    CONVERT_SWAP(message.get_msg(), rangeMsg, JoinKeyRangeMsg);
+
+    // we only drop tuples, so the range holds for our input as well. Pass it
+    // on to the query exits that end here
+    QueryID qID = rangeMsg.get_whichOne().query;
+
+    QueryExitContainer termExits;
+    GetEndingQueryExits(termExits);
+
+    FOREACH_TWL(iter, termExits) {
+        if( iter.query.Overlaps(qID) ) {
+            SendJoinKeyRangeMsg( iter, rangeMsg.get_keySlot(), rangeMsg.get_keyRange() );
+        }
+    } END_FOREACH;
+}
+
 void SelectionWayPointImp :: GotAllStates( QueryID query ) {
     PDEBUG( "SelectionWayPointImp :: GotAllStates ()");
 
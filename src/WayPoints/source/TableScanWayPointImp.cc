@@ -138,6 +138,10 @@ void TableScanWayPointImp :: RequestGranted (GenericWorkToken &returnVal) {
 
 void TableScanWayPointImp :: ProcessHoppingUpstreamMsg (HoppingUpstreamMsg &message) {
 
+	// no zone maps here, the key ranges of the joins are of no use
+	if (CHECK_DATA_TYPE (message.get_msg (), JoinKeyRangeMsg))
+		return;
+
 	FATALIF (!CHECK_DATA_TYPE (message.get_msg (), StartProducingMsg),
 		"Strange, why did a table scan get a HUS of a type that was not 'Start Producing'?");
 
@@ -41,6 +41,18 @@ Bitstring TableWayPointImp::FindQueries(off_t _chunkId){
     return queryChunkMap->GetBits(_chunkId);
 }
 
+Bitstring TableWayPointImp::ActiveQueries(void){
+    QueryExitContainer exits;
+    for (QECounters::iterator it = qeCounters.begin(); it != qeCounters.end(); ++it) {
+        QueryExit qe = it->first;
+        exits.Append(qe);
+    }
+
+    Bitstring queries = qeTranslator.queryExitToBitstring(exits);
+    queries.Difference(doneQueries);
+    return queries;
+}
+
 TableWayPointImp :: TableWayPointImp () :
     WayPointImp(),
     fileId(),
@@ -55,7 +67,11 @@ TableWayPointImp :: TableWayPointImp () :
     lastChunkId(0),
     numChunks(0),
     clusterRanges(),
-    queryClusterRanges()
+    queryClusterRanges(),
+    zoneRanges(),
+    queryColumnRanges(),
+    exitColumnRanges(),
+    slotsToColumns()
 {
     PDEBUG ("TableWayPointImp :: TableWayPointImp ()");
 }
@@ -88,6 +104,7 @@ void TableWayPointImp :: TypeSpecificConfigure (WayPointConfigureData &configDat
 
         numChunks = globalDiskPool.NumChunks(fileId);
         clusterRanges = globalDiskPool.ClusterRanges(fileId);
+        zoneRanges = globalDiskPool.ZoneRanges(fileId);
 
         PDEBUG("Relation %s has %d chunks", myName.c_str(), numChunks);
         queryChunkMap =  new QueryChunkMap(numChunks);
@@ -100,11 +117,29 @@ void TableWayPointImp :: TypeSpecificConfigure (WayPointConfigureData &configDat
         queryClusterRanges[elem.first] = elem.second;
     }
 
+    // and the column ranges pushed down from the selections. Query IDs get
+    // recycled so forget whatever the new queries had before
+    QueryExitContainer& startQueries = tempConfig.get_newQE();
+    for (startQueries.MoveToStart(); !startQueries.AtEnd(); startQueries.Advance()){
+        queryColumnRanges.erase(startQueries.Current().query);
+        exitColumnRanges.erase(startQueries.Current());
+    }
+
+    QueryToColumnRanges& newColumnRanges = tempConfig.get_columnRanges();
+    for(auto elem : newColumnRanges) {
+        queryColumnRanges[elem.first] = elem.second;
+    }
+
+    FOREACH_EM(column, slot, tempConfig.get_columnsToSlotsMap()){
+        slotsToColumns[slot.GetInt()] = column.GetInt();
+    }END_FOREACH;
+
     // delete queryExits first from the query termination trackers
     // NOTE: we delete before adding since the queryExits could have been recycled
     QueryExitContainer& delQueries = tempConfig.get_deletedQE();
     for (delQueries.MoveToStart(); !delQueries.AtEnd(); delQueries.Advance()){
         qeCounters.erase(delQueries.Current());
+        exitColumnRanges.erase(delQueries.Current());
     }
 
 
@@ -122,9 +157,12 @@ void TableWayPointImp :: TypeSpecificConfigure (WayPointConfigureData &configDat
     }
 
     // tell the translator its part of the config
-    Bitstring dummy = qeTranslator.queryExitToBitstring(queries, true);
+    Bitstring newQueries = qeTranslator.queryExitToBitstring(queries, true);
     qeTranslator.deleteQueryExits(tempConfig.get_deletedQE());
 
+    // the bits may have been used by finished queries
+    speedCtrl.Reset(newQueries);
+
     // tell the column manager its part of the config
     colManager.ChangeMapping(tempConfig.get_queryColumnsMap(),
             tempConfig.get_columnsToSlotsMap(),
@@ -150,9 +188,89 @@ void TableWayPointImp :: TypeSpecificConfigure (WayPointConfigureData &configDat
     }
 }
 
+// do the column ranges intersect the zones of the chunk?
+static bool RangesMatchZones(const ColumnToScannerRange& ranges,
+        const std::vector<DiskPool::ZoneRange>& chunkZones) {
+    for( auto& elem : ranges ) {
+        if( elem.first < 0 || (size_t) elem.first >= chunkZones.size() )
+            continue;
+
+        int64_t zMin = chunkZones[elem.first].first;
+        int64_t zMax = chunkZones[elem.first].second;
+
+        // no zone map for this column
+        if( zMin > zMax )
+            continue;
+
+        // same trick as for the cluster ranges
+        if( std::min(elem.second.second, zMax) < std::max(elem.second.first, zMin) )
+            return false;
+    }
+
+    return true;
+}
+
+bool TableWayPointImp::ChunkMatchesZones(off_t _chunkId, Bitstring exitBit) {
+    if( (size_t) _chunkId >= zoneRanges.size() )
+        return true;
+
+    QueryExitContainer exits;
+    qeTranslator.bitstringToQueryExitContainer(exitBit, exits);
+    exits.MoveToStart();
+    if( exits.AtEnd() )
+        return true;
+    QueryExit& exit = exits.Current();
+
+    const std::vector<ZoneRange>& chunkZones = zoneRanges[_chunkId];
+
+    // the ranges of the selections hold for all the exits of the query
+    auto qIt = queryColumnRanges.find(exit.query);
+    if( qIt != queryColumnRanges.end() && !RangesMatchZones(qIt->second, chunkZones) )
+        return false;
+
+    // the ranges of the join keys only for the exit going to the join
+    auto eIt = exitColumnRanges.find(exit);
+    if( eIt != exitColumnRanges.end() && !RangesMatchZones(eIt->second, chunkZones) )
+        return false;
+
+    return true;
+}
+
+void TableWayPointImp::AddJoinKeyRange(QueryExit& exit, int keySlot, ScannerRange keyRange) {
+    auto sIt = slotsToColumns.find(keySlot);
+    if( sIt == slotsToColumns.end() )
+        return;
+
+    ColumnToScannerRange& ranges = exitColumnRanges[exit];
+    auto cur = ranges.find(sIt->second);
+    if( cur == ranges.end() ) {
+        ranges[sIt->second] = keyRange;
+    } else {
+        // a join further down pushed a range as well, intersect them
+        cur->second.first = std::max(cur->second.first, keyRange.first);
+        cur->second.second = std::min(cur->second.second, keyRange.second);
+    }
+}
+
 void TableWayPointImp::GenerateTokenRequests(){
     PDEBUG ("TableWayPointImp :: GenerateTokenRequests()");
-    for (; numRequestsOut < FILE_SCANNER_MAX_NO_CHUNKS_REQUEST; numRequestsOut++) {
+
+    // while our queries are over their memory budget keep fewer chunks in
+    // flight. At least one, the chunks already out can only be freed if
+    // the queries make progress
+    QueryIDSet queries;
+    for (QECounters::iterator it = qeCounters.begin(); it != qeCounters.end(); ++it)
+        queries.Union(it->first.query);
+
+    int maxRequests = FILE_SCANNER_MAX_NO_CHUNKS_REQUEST;
+    if (QueryManager::GetQueryManager().ShouldThrottle(queries))
+        maxRequests = FILE_SCANNER_THROTTLED_NO_CHUNKS_REQUEST;
+
+    // no room for more chunks, the acks will bring us back here
+    if (speedCtrl.Room(ActiveQueries()) <= 0)
+        maxRequests = 0;
+
+    for (; numRequestsOut < maxRequests; numRequestsOut++) {
         RequestTokenDelayOK (DiskWorkToken::type);
     }
 }
@@ -169,6 +287,13 @@ void TableWayPointImp :: RequestGranted (GenericWorkToken &returnVal) {
     DiskWorkToken myToken;
     myToken.swap (returnVal);
 
+    // the downstream waypoints may have fallen behind since we asked
+    if (speedCtrl.Room(ActiveQueries()) <= 0) {
+        numRequestsOut--;
+        GiveBackToken (myToken);
+        return;
+    }
+
     bool sentRequest = false;
 
     off_t _chunkId;
@@ -215,6 +340,8 @@ void TableWayPointImp :: RequestGranted (GenericWorkToken &returnVal) {
                 keep = std::min(max, cMax) >= std::max(min, cMin);
             }
 
+            keep = keep && ChunkMatchesZones(_chunkId, qid);
+
             if( !keep ) {
                 filteredOut.Union(qid);
                 queries.Difference(qid);
@@ -253,14 +380,14 @@ void TableWayPointImp :: RequestGranted (GenericWorkToken &returnVal) {
         int numAvailableCPUs = myCPUWorkers.NumAvailable();
         // use uncompressed if less than USE_UNCOMPRESSED_THRESHOLD
         // fraction of threads available
-        // bool useUncompressed = (numAvailableCPUs < USE_UNCOMPRESSED_THRESHOLD*NUM_EXEC_ENGINE_THREADS);
-        bool useUncompressed = true;
+        bool useUncompressed = (numAvailableCPUs < USE_UNCOMPRESSED_THRESHOLD*NUM_EXEC_ENGINE_THREADS);
 
         // send the request
         WayPointID tempID = GetID ();
         ChunkID chunkID(_chunkId, fileId);
         globalDiskPool.ReadRequest(chunkID, tempID, useUncompressed, lineage, myOutputExitsCopy, myToken, colsToRead);
         sentRequest = true;
+        speedCtrl.Produce(queries);
 
         LOG_ENTRY_P(2, "CHUNK %d of %s REQUESTED for queries %s",
                 _chunkId, myName.c_str(), queries.GetStr().c_str()) ;
@@ -351,6 +478,15 @@ void TableWayPointImp :: ProcessHoppingUpstreamMsg (HoppingUpstreamMsg &message)
             SendHoppingDownstreamMsg (myOutMsg);
         }
     }
+    // a join tells us the range of its key over the RHS, the chunks outside of
+    // it have nothing that can join
+    else if (msg.Type() == JoinKeyRangeMsg::type) {
+        JoinKeyRangeMsg myMessage;
+        msg.swap (myMessage);
+
+        AddJoinKeyRange(myMessage.get_whichOne(), myMessage.get_keySlot(),
+                myMessage.get_keyRange());
+    }
     // this is where new messages go, such as write chunk
     else {
         FATAL( 	"Strange, why did a table scan get a HUS of a type that was not 'Start Producing'?");
@@ -380,6 +516,9 @@ void TableWayPointImp :: ProcessDropMsg (QueryExitContainer &whichExits,
     Bitstring toKill = qeTranslator.queryExitToBitstring(whichExits);
     ChunkID cnkID = myHistory.get_whichChunk ();
 
+    // the chunk is out of flight, and we produce too fast
+    speedCtrl.Drop(toKill);
+
     Bitstring ackedQ = ackQueries->GetBits(cnkID.GetInt());
     ackedQ.Intersect(toKill);
     WARNINGIF(!ackedQ.IsEmpty(),
@@ -431,10 +570,8 @@ void TableWayPointImp :: ProcessDropMsg (QueryExitContainer &whichExits,
 }
 
 /**
-  The implementation of the method is very simplistic at this moment.
-  If the size of the request pool is less than the maximum number of allowed chunks, a new request is possible.
-  In the future this should be like a control system that regulates the amount of chunks that are produced.
-  Profiling information is required for this more complicated behavior.
+  Finds the next chunk some query needs, going around the relation.
+  The number of chunks produced is regulated by speedCtrl before we get here.
   */
 bool TableWayPointImp::ChunkRequestIsPossible(off_t &_chunkId) {
     lastChunkId = queryChunkMap->FindFirstSet(lastChunkId);
@@ -524,6 +661,7 @@ void TableWayPointImp :: ProcessAckMsg (QueryExitContainer &whichExits, HistoryL
     FATALIF( whichExits.Length()==0, "You sent me a chunk without any query exits.");
 
     Bitstring toAck = qeTranslator.queryExitToBitstring(whichExits);
+    speedCtrl.Ack(toAck);
 
     AcknowledgeChunk(cnkID.GetInt(), toAck);
 
@@ -194,6 +194,10 @@ void TextLoaderWayPointImp :: RequestGranted (GenericWorkToken &returnVal) {
 void TextLoaderWayPointImp :: ProcessHoppingUpstreamMsg (HoppingUpstreamMsg &message) {
     PDEBUG ("TextLoaderWayPointImp :: ProcessHoppingUpstreamMsg ()");
 
+    // we cannot skip anything based on the key ranges of the joins
+    if (CHECK_DATA_TYPE (message.get_msg (), JoinKeyRangeMsg))
+        return;
+
     FATALIF (!CHECK_DATA_TYPE (message.get_msg (), StartProducingMsg),
             "Strange, why did a text loader get a HUS of a type that was not 'Start Producing'?");
 
@@ -263,6 +263,14 @@ void WayPointImp :: SendStartProducingMsg( QueryExit whichOne ) {
     SendHoppingUpstreamMsg( outMsg );
 }
 
+void WayPointImp :: SendJoinKeyRangeMsg( QueryExit whichOne, int keySlot, JoinKeyRange keyRange ) {
+    QueryExit whichOneCopy = whichOne;
+
+    JoinKeyRangeMsg rangeMsg( GetID(), keySlot, keyRange, whichOne );
+    HoppingUpstreamMsg outMsg( GetID(), whichOneCopy, rangeMsg );
+    SendHoppingUpstreamMsg( outMsg );
+}
+
 void WayPointImp :: SetTokensRequested( off_t requestType, int numTokens, int priority ) {
     tokensToRequest[requestType] = pair<int,int>( numTokens, priority );
 }